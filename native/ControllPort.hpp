@@ -18,6 +18,7 @@
 #include <sstream>
 #include "port.hpp"
 #include "messages.hpp"
+#include "jniRegistry.hpp"
 
 using namespace std;
 
@@ -44,7 +45,7 @@ private:
 
   /** the timecode of the next java buffer */
   jlong timeCodeStartDeprecated;
-  jack_nframes_t timeCodeDurationDeprecated;
+  unsigned long timeCodeDurationDeprecated;
 
 public:
 
@@ -93,24 +94,20 @@ protected:
     if (systemListener == NULL) {
       THROW("Call to NewGlobalRef function failed.")
     }
-    // --- cache the method IDs of the callback functions in the java port.
-    jclass listenerClass = env->GetObjectClass(systemListener);
-
-    if (listenerClass == NULL) {
-      THROW("MidiSystemListener class not found.")
-    }
-    onOpenMid = env->GetMethodID(listenerClass, "onOpen", "()V");
+    // --- the method IDs of the callback functions (see jniRegistry.hpp).
+    const JniRegistry& registry = jniRegistry();
+    onOpenMid = registry.onOpenMid;
     if (isInput()) {
       // Note: it might not be very clean to map two different java procedures
       // to one and the same identifier. But as the two procedures
       // must have the same signature, this works nicely and avoids
       // to have to make the distinction between input- and output- port in
       // the execJavaProcess_impl function.
-      onCycleMid = env->GetMethodID(listenerClass, "onCycleStart", "(JJZ)V");
+      onCycleMid = registry.onCycleStartMid;
     } else {
-      onCycleMid = env->GetMethodID(listenerClass, "onCycleEnd", "(JJZ)V");
+      onCycleMid = registry.onCycleEndMid;
     }
-    onCloseMid = env->GetMethodID(listenerClass, "onClose", "()V");
+    onCloseMid = registry.onCloseMid;
     if ((onOpenMid == NULL) || (onCycleMid == NULL) || (onCloseMid == NULL)) {
       THROW("Method-identifier not found.")
     }
@@ -125,8 +122,6 @@ protected:
     if (client == nullptr) {
       THROW("Client was NULL.")
     }
-    jack_client_t * jackClient = static_cast<jack_client_t *> (client);
-
   }
 
   virtual void start_impl()override {
@@ -145,6 +140,18 @@ protected:
   virtual void execNativeProcess_impl(unsigned long _timeCodeStart, unsigned long _timeCodeDuration, void * client)override {
   }
 
+  /**
+   * In batched dispatch the java dispatcher calls onCycleStart (onCycleEnd)
+   * on the system listener.
+   */
+  virtual CycleEntry::Kind getDispatchKind() const override {
+    return isInput() ? CycleEntry::cycleStart : CycleEntry::cycleEnd;
+  }
+
+  virtual jobject getDispatchPeer() const override {
+    return systemListener;
+  }
+
   virtual void stop_impl()override {
   }
 
@@ -14,47 +14,129 @@
 #endif
 
 #ifdef WITH_JACK
-#include <jack/jack.h>
-#include <jack/midiport.h>
 #include <string>
 #include <sstream>
+#include <memory>
 #include "port.hpp"
+#include "midiBackend.hpp"
+#include "spscRing.hpp"
+#include "midiEventArena.hpp"
+#include "midiProcessor.hpp"
 #include "messages.hpp"
+#include "jniRegistry.hpp"
 
 using namespace std;
 
+/** The default number of events per cycle (the arena may grow beyond). */
 #define	MaxMidiEvents 255
 
 class JackInputPort : public Port {
 private:
+
+  /**
+   * A Midi event as it is passed through the ring of an asynchronous port.
+   * Events of up to three bytes are carried in the event itself; the bytes
+   * of longer events (SysEx) are passed through the byteRing.
+   */
+  struct RingEvent {
+    /** the absolute time code of the event. */
+    unsigned long time;
+    int length;
+    uint8_t midi[3];
+  };
+
   const string name;
   jobject javaPort;
   jmethodID onOpenMid;
-  jmethodID processMid;
   jmethodID onCloseMid;
-  jack_port_t* jackPort;
-  /** The rawMidiData will store triplets of "status "data1 "data2" */
-  jint bufferRawMidi[3 * MaxMidiEvents];
-  jint bufferDeltaTimes[MaxMidiEvents];
-  int bufferEventCount;
+  MidiBackend::PortHandle jackPort;
+  /** The events of the current cycle. */
+  unique_ptr<MidiEventArena> arena;
   jlong timestampDeprecated;
 
+  /** The overflow policy, the overflow statistics and the growth of the arena. */
+  EventOverflow overflow;
+
+  /**
+   * The native processing stages the incoming events run through before
+   * they are stored (see setProcessors).
+   */
+  ProcessorSlot processors;
+
+  /**
+   * Synchronous mode with the "spill" policy only: the events that did not fit
+   * into the arena; they are delivered at the start of the next cycle
+   * (delta-time 0).
+   */
+  unique_ptr<MidiEventArena> spillArena;
+
+  /**
+   * Synchronous mode with the "merge" xrun policy only: the events of the
+   * cycles in which the java thread was late; they are delivered at the start
+   * of the next cycle (delta-time 0). Only the native thread touches this
+   * arena, so it does not grow.
+   */
+  unique_ptr<MidiEventArena> lateArena;
+
+  /**
+   * Asynchronous mode only: the native thread pushes the incoming events into
+   * this ring and the java thread drains it at its own pace.
+   */
+  unique_ptr<SpscRing<RingEvent> > ring;
+
+  /**
+   * Asynchronous mode only: the Midi bytes of the events longer than three bytes.
+   */
+  unique_ptr<SpscRing<uint8_t> > byteRing;
+
+  /**
+   * Asynchronous mode only: an event taken from the ring that did not fit into
+   * the arena; it is the first event of the next cycle.
+   */
+  bool hasHeldEvent;
+  RingEvent heldEvent;
+
+  /**
+   * The index and the byte arena are handed to java once (as direct byte
+   * buffers), so no java arrays need to be created nor filled in the
+   * process cycles.
+   */
+  jmethodID processDirectMid;
+  jmethodID setEventBuffersMid;
+
 public:
 
   /**
    * 
    * @param _name
    * @param internalId
+   * @param ringCapacity if positive, the port is asynchronous and buffers up to 
+   * the given number of events for the java thread; zero for a synchronous port.
+   * @param eventCapacity the number of events per cycle the port can take
+   * initially (zero for the default).
+   * @param policy what to do with events that do not fit (synchronous mode;
+   * an asynchronous port drops new events when the ring is full).
    */
-  JackInputPort(const string& _name, long internalId) :
+  JackInputPort(const string& _name, long internalId, int ringCapacity = 0,
+          int eventCapacity = 0, OverflowPolicy policy = OverflowPolicy::dropNewest) :
   Port(false, internalId),
   name(_name),
   javaPort(NULL),
   onOpenMid(NULL),
-  processMid(NULL),
   onCloseMid(NULL),
   jackPort(nullptr),
-  bufferEventCount(0) {
+  arena(EventOverflow::makeArena((eventCapacity > 0) ? eventCapacity : MaxMidiEvents)),
+  overflow(policy),
+  hasHeldEvent(false),
+  processDirectMid(NULL),
+  setEventBuffersMid(NULL) {
+    if (ringCapacity > 0) {
+      ring.reset(new SpscRing<RingEvent>(ringCapacity));
+      byteRing.reset(new SpscRing<uint8_t>(arena->getByteCapacity()));
+      setAsynchronous(true);
+    } else if (policy == OverflowPolicy::spill) {
+      spillArena = EventOverflow::makeArena(arena->getEventCapacity());
+    }
   }
 
   JackInputPort(JackInputPort && other) = default;
@@ -65,16 +147,80 @@ public:
 
   }
 
+  /**
+   * @return the number of events the ring can hold (zero for a synchronous port).
+   */
+  int getRingCapacity() const {
+    return ring ? ring->getCapacity() : 0;
+  }
+
+  /**
+   * @return the highest number of events that waited in the ring at once.
+   */
+  int getRingHighWaterMark() const {
+    return ring ? ring->getHighWaterMark() : 0;
+  }
+
+  /**
+   * @return the number of events dropped because the ring (or, for SysEx
+   * events, the byte ring) was full.
+   */
+  long getRingOverflowCount() const {
+    return ring ? ring->getOverflowCount() + byteRing->getOverflowCount() : 0;
+  }
+
+  /**
+   * @return the overflow statistics of this port.
+   */
+  const EventOverflow& getOverflow() const {
+    return overflow;
+  }
+
+  /**
+   * @return the number of events per cycle the port can currently take.
+   */
+  int getEventCapacity() const {
+    return arena->getEventCapacity();
+  }
+
+  /**
+   * Replaces the native processing chain of this port (see midiProcessor.hpp),
+   * can be called at any time.
+   * @param chain the new chain, empty to let all events pass unchanged.
+   */
+  void setProcessors(unique_ptr<ProcessorChain> && chain) {
+    processors.set(move(chain));
+  }
+
+  /**
+   * The events a route forwards are taken straight from the Jack buffer
+   * (without the processing of this port).
+   */
+  virtual void* getNativeBuffer(unsigned long timeCodeDuration, void * client)override {
+    if ((jackPort == nullptr) || !isRunningState() || isNativeIdle()) {
+      return nullptr; // an idle port has received nothing.
+    }
+    return static_cast<MidiBackend *> (client)->getBuffer(jackPort, timeCodeDuration);
+  }
+
 protected:
 
+  /**
+   * @return the events handed to java in the current cycle.
+   */
+  const MidiEventArena& getEvents() const {
+    return *arena;
+  }
+
   /**
    * 1) Store the pointer to the listener (this will exclude it from garbage collection).
-   * 2) cache the method-identifiers of the listeners methods.
-   * 3) execute the listeners onOpen method.
+   * 2) take the method-identifiers of the listeners methods.
+   * 3) hand the arena to java as direct byte buffers.
+   * 4) execute the listeners onOpen method.
    * @param env
    * @param 
    * @param _javaPort a reference to the listener. It is a Java object of 
-   * class MidiIO4Java.Implementation.MidiJackNative$MidiInputPort
+   * class MidiIO4Java.Implementation.MidiJackNative$DirectMidiInputPort
    */
   virtual void initialize_impl(JNIEnv * env, jstring /*name*/, jobject _javaPort)override {
     // pin the java-port
@@ -82,18 +228,16 @@ protected:
     if (javaPort == NULL) {
       THROW("Call to NewGlobalRef function failed.")
     }
-    // --- cache the method IDs of the callback functions in the java port.
-    jclass javaPortClass = env->GetObjectClass(javaPort);
-
-    if (javaPortClass == NULL) {
-      THROW("MidiInputPortListener class not found.")
-    }
-    onOpenMid = env->GetMethodID(javaPortClass, "onOpen", "()V");
-    processMid = env->GetMethodID(javaPortClass, "process", "(JJZ[I[I)V");
-    onCloseMid = env->GetMethodID(javaPortClass, "onClose", "()V");
-    if ((onOpenMid == NULL) || (processMid == NULL) || (onCloseMid == NULL)) {
+    // --- the method IDs of the callback functions (see jniRegistry.hpp).
+    const JniRegistry::DirectPortMethods& methods = jniRegistry().directInputPort;
+    onOpenMid = methods.onOpen;
+    onCloseMid = methods.onClose;
+    processDirectMid = methods.processDirect;
+    setEventBuffersMid = methods.setEventBuffers;
+    if ((onOpenMid == NULL) || (onCloseMid == NULL) || (processDirectMid == NULL) || (setEventBuffersMid == NULL)) {
       THROW("Method-identifier not found.")
     }
+    shareArena(env);
     // --- call javaPort.onOpen()
     env->CallVoidMethod(javaPort, onOpenMid);
     jthrowable jexception = env->ExceptionOccurred();
@@ -102,82 +246,368 @@ protected:
     }
   }
 
+  /**
+   * Hands the arena to java as direct byte buffers (once, and again whenever the arena has grown).
+   */
+  void shareArena(JNIEnv * env) {
+    jobject indexBuffer = env->NewDirectByteBuffer(arena->getEntries(), arena->getEventCapacity() * MidiEventArena::entrySize);
+    jobject byteBuffer = env->NewDirectByteBuffer(arena->getBytes(), arena->getByteCapacity());
+    if ((indexBuffer == NULL) || (byteBuffer == NULL)) {
+      THROW("Direct byte buffers not supported.")
+    }
+    env->CallVoidMethod(javaPort, setEventBuffersMid, indexBuffer, byteBuffer);
+    env->DeleteLocalRef(indexBuffer);
+    env->DeleteLocalRef(byteBuffer);
+    jthrowable jexception = env->ExceptionOccurred();
+    if (jexception != NULL) {
+      THROW_JAVA(env, jexception)
+    }
+  }
+
+  /**
+   * Replaces the arena by a larger one if the demand has come close to its
+   * capacity. Called by the java thread after java has consumed the events of
+   * the cycle; the native thread does not touch the arena meanwhile (the
+   * sub-state hand-shake keeps both threads apart).
+   */
+  void growIfNeeded(JNIEnv * env) {
+    if (!overflow.needsGrowth(*arena)) {
+      return;
+    }
+    arena = overflow.makeGrownArena(*arena);
+    if (spillArena) {
+      unique_ptr<MidiEventArena> grownSpill = EventOverflow::makeArena(arena->getEventCapacity());
+      grownSpill->appendAll(*spillArena, 0);
+      spillArena = move(grownSpill);
+    }
+    shareArena(env);
+  }
+
   virtual void register_impl(void * client)override {
     if (client == nullptr) {
       THROW("Client was NULL.")
     }
-    jack_client_t * jackClient = static_cast<jack_client_t *> (client);
+    MidiBackend * backend = static_cast<MidiBackend *> (client);
 
-    jackPort = jack_port_register(jackClient, name.c_str(), JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+    jackPort = backend->registerPort(name, true);
     if (jackPort == nullptr) {
       ostringstream ost;
-      ost << AT "JACK error creating port (" << name << ").";
+      ost << AT "Error creating port (" << name << ").";
       throw runtime_error(ost.str());
     }
   }
 
   virtual void start_impl()override {
+    if ((!ring) && (getXrunPolicy() == XrunPolicy::merge) && (!lateArena)) {
+      lateArena = EventOverflow::makeArena(arena->getEventCapacity());
+    }
   }
 
-  virtual void execJavaProcess_impl(JNIEnv * env, unsigned long timeCodeStart, unsigned long timeCodeDuration, bool lastCycle)override {
-    if (bufferEventCount > MaxMidiEvents) {
-      THROW("Buffer overflow.")
+  virtual int getConnectionCount_impl(void * client) override {
+    if (jackPort == nullptr) {
+      return -1;
     }
-    jintArray rawEvents = env->NewIntArray(3 * bufferEventCount);
-    jintArray deltaTimes = env->NewIntArray(bufferEventCount);
+    return static_cast<MidiBackend *> (client)->getConnectionCount(jackPort);
+  }
 
-    if ((rawEvents == NULL) || (deltaTimes == NULL)) {
-      THROW("Out of memory.")
+  /**
+   * @return true if events of earlier cycles are still waiting for java
+   * (an idle cycle must hand them over nonetheless).
+   */
+  bool hasPendingEvents() const {
+    if (ring) {
+      return hasHeldEvent || !ring->isEmpty();
     }
-    env->SetIntArrayRegion(rawEvents, 0, 3 * bufferEventCount, bufferRawMidi);
-    env->SetIntArrayRegion(deltaTimes, 0, bufferEventCount, bufferDeltaTimes);
+    return arena->size() > 0;
+  }
 
-    // call Java method wit java-signature:
-    // "public void process(long timeCodeStart, long timeCodeDuration, boolean lastCycle,int[] rawEvents, int[] deltaTimes)throws Throwable "
-    env->CallVoidMethod(javaPort, processMid,
+  virtual void execJavaProcess_impl(JNIEnv * env, unsigned long timeCodeStart, unsigned long timeCodeDuration, bool lastCycle)override {
+    if (idleCycle && !hasPendingEvents()) {
+      return; // nothing is connected, there is nothing to tell java.
+    }
+    if (ring) {
+      drainRing(timeCodeStart, timeCodeDuration);
+    }
+    // the events are already in the direct buffers, java only needs to know how many.
+    // java signature: "public void processDirect(long timeCodeStart, long timeCodeDuration, boolean lastCycle, int eventCount)throws Throwable"
+    env->CallVoidMethod(javaPort, processDirectMid,
             (jlong) timeCodeStart,
             (jlong) timeCodeDuration,
             (jboolean) lastCycle,
-            rawEvents,
-            deltaTimes);
-
+            (jint) arena->size());
     jthrowable jexception = env->ExceptionOccurred();
     if (jexception != NULL) {
       THROW_JAVA(env, jexception)
     }
+    growIfNeeded(env);
+  }
+
+  /**
+   * The port can be served by the java dispatcher (batched dispatch);
+   * the entry tells java how many events are in the arena.
+   */
+  virtual CycleEntry::Kind getDispatchKind() const override {
+    return CycleEntry::inputPort;
+  }
+
+  virtual jobject getDispatchPeer() const override {
+    return javaPort;
+  }
+
+  virtual void beforeDispatch_impl(JNIEnv * env, CycleEntry& entry) override {
+    if (ring) {
+      drainRing(static_cast<unsigned long> (entry.timeCodeStart),
+              static_cast<unsigned long> (entry.timeCodeDuration));
+    }
+    entry.eventCount = arena->size();
+  }
+
+  virtual void afterDispatch_impl(JNIEnv * env, const CycleEntry& entry) override {
+    growIfNeeded(env);
+  }
+
+  /**
+   * Asynchronous mode: moves the waiting events of the cycle java is processing
+   * (and of the cycles before) from the ring into the arena. The delta-times
+   * are relative to the given time-code; events delayed from earlier cycles
+   * are delivered at the start of the cycle (delta-time 0), so every delta-time
+   * lies within the cycle. Events of later cycles and events that do not fit
+   * into the arena wait for the next cycle.
+   * @param timeCodeStart the start of the cycle java is processing.
+   * @param timeCodeDuration the length of this cycle.
+   */
+  void drainRing(unsigned long timeCodeStart, unsigned long timeCodeDuration) {
+    arena->clear();
+    RingEvent event;
+    while (nextRingEvent(event)) {
+      long offset = static_cast<long> (event.time - timeCodeStart);
+      if (offset >= static_cast<long> (timeCodeDuration)) {
+        // the native thread is already in a later cycle, java gets this event then.
+        heldEvent = event;
+        hasHeldEvent = true;
+        break;
+      }
+      int32_t deltaTime = (offset < 0) ? 0 : static_cast<int32_t> (offset);
+      uint8_t* target = arena->reserve(deltaTime, event.length);
+      if (target == nullptr) {
+        heldEvent = event;
+        hasHeldEvent = true;
+        overflow.recordDemand(arena->size() + 1, arena->getByteCount() + event.length);
+        return;
+      }
+      if (event.length <= 3) {
+        memcpy(target, event.midi, event.length);
+      } else if (!byteRing->popAll(target, event.length)) {
+        THROW("Byte ring out of sync.")
+      }
+    }
+    overflow.recordDemand(arena->size(), arena->getByteCount());
+  }
+
+  /**
+   * Asynchronous mode: takes the next event, the held event first.
+   * @return false if there is no event waiting.
+   */
+  bool nextRingEvent(RingEvent& event) {
+    if (hasHeldEvent) {
+      event = heldEvent;
+      hasHeldEvent = false;
+      return true;
+    }
+    return ring->pop(event);
+  }
+
+  /**
+   * Asynchronous mode: pushes the events of the current cycle into the ring.
+   * When the ring is full, the event is dropped (and counted by the ring).
+   */
+  void fillRing(MidiBackend * backend, void* jackBuffer, unsigned long timeCodeStart) {
+    ProcessorSlot::Accessor chain(processors);
+    uint8_t scratch[3];
+    int jackEventCount = backend->getEventCount(jackBuffer);
+    for (int i = 0; i < jackEventCount; ++i) {
+      MidiBackend::Event jackEvent;
+      int error = backend->getEvent(jackEvent, jackBuffer, i);
+      if (error != 0) {
+        FAIL_NATIVE(eventRetrieval)
+      }
+      if (jackEvent.size == 0) {
+        continue;
+      }
+      const uint8_t* midi = chain.apply(jackEvent.buffer, static_cast<int> (jackEvent.size), scratch);
+      if (midi == nullptr) {
+        continue; // dropped by a processor.
+      }
+      RingEvent event;
+      event.time = timeCodeStart + jackEvent.time;
+      event.length = static_cast<int> (jackEvent.size);
+      if (jackEvent.size <= 3) {
+        memcpy(event.midi, midi, jackEvent.size);
+      } else if (ring->isFull()) {
+        ring->push(event); // fails, but counts the dropped event.
+        continue;
+      } else if (!byteRing->pushAll(jackEvent.buffer, jackEvent.size)) {
+        continue; // dropped, counted by the byte ring.
+      }
+      // the bytes (if any) are in the byte ring before the event becomes visible.
+      ring->push(event);
+    }
   }
 
   virtual void execNativeProcess_impl(unsigned long timeCodeStart, unsigned long timeCodeDuration, void * client)override {
     if (jackPort == nullptr) {
-      THROW("jackPort was NULL.")
+      FAIL_NATIVE(nullPort)
+    }
+    MidiBackend * backend = static_cast<MidiBackend *> (client);
+    if (ring) {
+      if (!isNativeIdle()) {
+        fillRing(backend, backend->getBuffer(jackPort, timeCodeDuration), timeCodeStart);
+      }
+      return;
+    }
+    if (isNativeIdle() && !(spillArena && (spillArena->size() > 0)) && !(lateArena && (lateArena->size() > 0))) {
+      arena->clear(); // the Jack buffer of an unconnected port is empty.
+      return;
     }
 
-    bufferEventCount = 0;
-    void* jackBuffer = jack_port_get_buffer(jackPort, timeCodeDuration);
-    int jackEventCount = jack_midi_get_event_count(jackBuffer);
-    for (int i = 0; i < jackEventCount; ++i) {
+    readJackEvents(backend, backend->getBuffer(jackPort, timeCodeDuration), timeCodeStart);
+  }
+
+  /**
+   * Synchronous mode: copies the events of the current cycle into the arena.
+   * Events that do not fit are handled according to the overflow policy.
+   */
+  void readJackEvents(MidiBackend * backend, void* jackBuffer, unsigned long timeCodeStart) {
+    arena->clear();
+    int demandEvents = 0;
+    int demandBytes = 0;
+    if (spillArena && (spillArena->size() > 0)) {
+      // the events spilled in the previous cycle come first (at delta-time 0).
+      arena->appendAll(*spillArena, 0);
+      demandEvents = spillArena->size();
+      demandBytes = spillArena->getByteCount();
+      spillArena->clear();
+    }
+    if (lateArena && (lateArena->size() > 0)) {
+      // then come the events of the cycles java has missed (at delta-time 0).
+      int before = arena->size();
+      if (!arena->appendAll(*lateArena, 0)) {
+        overflow.countDropped(lateArena->size() - (arena->size() - before));
+      }
+      demandEvents += lateArena->size();
+      demandBytes += lateArena->getByteCount();
+      lateArena->clear();
+    }
 
-      jack_midi_event_t jackEvent;
-      int error = jack_midi_event_get(&jackEvent, jackBuffer, i);
-      if (error == 0) {
-        if (jackEvent.size == 3) {
-          if (bufferEventCount >= MaxMidiEvents) {
-            THROW("Buffer overflow.")
-          }
-          int rawIdx = 3 * bufferEventCount;
-          bufferDeltaTimes[bufferEventCount] = jackEvent.time;
-          bufferRawMidi[rawIdx] = static_cast<jint> (jackEvent.buffer[0]);
-          bufferRawMidi[rawIdx + 1] = static_cast<jint> (jackEvent.buffer[1]);
-          bufferRawMidi[rawIdx + 2] = static_cast<jint> (jackEvent.buffer[2]);
-          bufferEventCount++;
+    int jackEventCount = backend->getEventCount(jackBuffer);
+    ProcessorSlot::Accessor chain(processors);
+    uint8_t scratch[3];
+    int first = 0;
+    if (overflow.getPolicy() == OverflowPolicy::dropOldest) {
+      first = firstFittingEvent(backend, jackBuffer, jackEventCount, chain);
+    }
+    bool spilling = false;
+    for (int i = 0; i < jackEventCount; ++i) {
+      MidiBackend::Event jackEvent;
+      int error = backend->getEvent(jackEvent, jackBuffer, i);
+      if (error != 0) {
+        FAIL_NATIVE(eventRetrieval)
+      }
+      if (jackEvent.size == 0) {
+        continue;
+      }
+      const uint8_t* midi = chain.apply(jackEvent.buffer, static_cast<int> (jackEvent.size), scratch);
+      if (midi == nullptr) {
+        continue; // dropped by a processor.
+      }
+      demandEvents++;
+      demandBytes += jackEvent.size;
+      if (i < first) {
+        overflow.countDropped(1);
+        continue;
+      }
+      int32_t deltaTime = static_cast<int32_t> (jackEvent.time);
+      if (!spilling && arena->add(deltaTime, midi, jackEvent.size)) {
+        continue;
+      }
+      if (spillArena) {
+        // once spilling has started, all later events are spilled to keep them in order.
+        spilling = true;
+        if (spillArena->add(0, midi, jackEvent.size)) {
+          overflow.countSpilled(1);
+          continue;
         }
-      } else {
-        /** @Todo better error handling.*/
-        THROW("Error retrieving Midi Events.")
       }
+      overflow.countDropped(1);
     }
+    overflow.recordDemand(demandEvents, demandBytes);
+  }
 
+  /**
+   * The java thread is late (see XrunPolicy::merge): keeps the events of the
+   * current cycle for the next cycle java gets. They are kept at delta-time 0,
+   * as they will be delivered at the start of that cycle (in their order).
+   * Events that do not fit are dropped.
+   */
+  virtual void execNativeLate_impl(unsigned long timeCodeStart, unsigned long timeCodeDuration, void * client)override {
+    if (jackPort == nullptr) {
+      FAIL_NATIVE(nullPort)
+    }
+    if (!lateArena || isNativeIdle()) {
+      return;
+    }
+    MidiBackend * backend = static_cast<MidiBackend *> (client);
+    void* jackBuffer = backend->getBuffer(jackPort, timeCodeDuration);
+    ProcessorSlot::Accessor chain(processors);
+    uint8_t scratch[3];
+    int jackEventCount = backend->getEventCount(jackBuffer);
+    for (int i = 0; i < jackEventCount; ++i) {
+      MidiBackend::Event jackEvent;
+      if (backend->getEvent(jackEvent, jackBuffer, i) != 0) {
+        FAIL_NATIVE(eventRetrieval)
+      }
+      if (jackEvent.size == 0) {
+        continue;
+      }
+      const uint8_t* midi = chain.apply(jackEvent.buffer, static_cast<int> (jackEvent.size), scratch);
+      if (midi == nullptr) {
+        continue; // dropped by a processor.
+      }
+      if (!lateArena->add(0, midi, jackEvent.size)) {
+        overflow.countDropped(1);
+      }
+    }
+  }
 
+  /**
+   * Synchronous mode with the "dropOldest" policy: finds the oldest event from
+   * which on all events of the cycle fit into the arena. Only the events that
+   * pass the processing chain take room, so the chain is applied here as well
+   * (its stages are stateless, they give the same result in the second pass).
+   * @return the index of the first jack event to keep.
+   */
+  int firstFittingEvent(MidiBackend * backend, void* jackBuffer, int jackEventCount, const ProcessorSlot::Accessor& chain) {
+    int freeEvents = arena->getEventCapacity() - arena->size();
+    int freeBytes = arena->getByteCapacity() - arena->getByteCount();
+    uint8_t scratch[3];
+    for (int i = jackEventCount - 1; i >= 0; --i) {
+      MidiBackend::Event jackEvent;
+      if (backend->getEvent(jackEvent, jackBuffer, i) != 0) {
+        FAIL_NATIVE_RETURN(eventRetrieval, jackEventCount)
+      }
+      if (jackEvent.size == 0) {
+        continue;
+      }
+      if (chain.apply(jackEvent.buffer, static_cast<int> (jackEvent.size), scratch) == nullptr) {
+        continue; // dropped by a processor, takes no room.
+      }
+      freeEvents--;
+      freeBytes -= jackEvent.size;
+      if ((freeEvents < 0) || (freeBytes < 0)) {
+        return i + 1;
+      }
+    }
+    return 0;
   }
 
   virtual void stop_impl()override {
@@ -191,11 +621,11 @@ protected:
       THROW("jackPort was NULL.")
     }
 
-    jack_client_t * jackClient = static_cast<jack_client_t *> (client);
+    MidiBackend * backend = static_cast<MidiBackend *> (client);
 
-    int err = jack_port_unregister(jackClient, jackPort);
+    int err = backend->unregisterPort(jackPort);
     if (err != 0) {
-      THROW("JACK error while unregistering port.")
+      THROW("Error while unregistering port.")
     }
     jackPort = nullptr;
   }
@@ -213,8 +643,9 @@ protected:
     env->DeleteGlobalRef(javaPort);
     javaPort = NULL;
     onOpenMid = NULL;
-    processMid = NULL;
     onCloseMid = NULL;
+    processDirectMid = NULL;
+    setEventBuffersMid = NULL;
   }
 
 
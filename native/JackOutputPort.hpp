@@ -14,15 +14,19 @@
 #endif
 
 #ifdef WITH_JACK
-#include <jack/jack.h>
-#include <jack/midiport.h>
 #include <string>
 #include <sstream>
+#include <memory>
 #include "port.hpp"
+#include "midiBackend.hpp"
+#include "midiEventArena.hpp"
+#include "midiProcessor.hpp"
 #include "messages.hpp"
+#include "jniRegistry.hpp"
 
 using namespace std;
 
+/** The default number of events per cycle (the arena may grow beyond). */
 #define	MaxMidiEvents 255
 
 class JackOutputPort : public Port {
@@ -30,22 +34,47 @@ private:
   const string name;
   jobject javaPort;
   jmethodID onOpenMid;
-  jmethodID processMid;
   jmethodID onCloseMid;
-  jack_port_t* jackPort;
-  /** The rawMidiData will store "integer-triplets" of "status "data1 "data2" */
-  jint bufferRawMidi[3 * MaxMidiEvents];
-  jint bufferDeltaTimes[MaxMidiEvents];
-  jint bufferEventSizes[MaxMidiEvents];
-  int bufferEventCount;
-
-  /** the java arrays will be used to transfer the "integer-triplets" into the java environments*/
-  jintArray javaRawMidi;
-  jintArray javaDeltaTimes;
-  jintArray javaEventSizes;
+  MidiBackend::PortHandle jackPort;
+  /** The events of the current cycle. */
+  unique_ptr<MidiEventArena> arena;
+
+  /**
+   * The overflow statistics and the growth of the arena. Events that java
+   * cannot store are dropped on the java side (the newest ones); events that
+   * do not fit into the Jack buffer are dropped here.
+   */
+  EventOverflow overflow;
+
+  /**
+   * The native processing stages the outgoing events run through before
+   * they are written to Jack (see setProcessors).
+   */
+  ProcessorSlot processors;
+
+  /**
+   * Routes only (see execNativeMerge_impl): the events of the current cycle,
+   * one sorted list after the other, before they are merged. Allocated when
+   * the first route to this port is set.
+   */
+  unique_ptr<MidiEventArena> mergeArena;
+
+  /**
+   * Owned by the native thread: the Jack buffer has been written in the current
+   * cycle (by the native process or by a skip).
+   */
+  bool bufferWritten;
+
+  /**
+   * Java writes the events straight into the arena (handed over as direct
+   * byte buffers), so nothing is copied in the java cycle and only the 
+   * produced bytes are copied into the Jack buffer.
+   */
+  jmethodID processDirectMid;
+  jmethodID setEventBuffersMid;
 
   jlong timestampDeprecated;
-  jack_nframes_t jackBufferSizeDeprecated;
+  unsigned long jackBufferSizeDeprecated;
 
 public:
 
@@ -53,19 +82,21 @@ public:
    * 
    * @param _name
    * @param internalId
+   * @param eventCapacity the number of events per cycle the port can take
+   * initially (zero for the default).
    */
-  JackOutputPort(const string& _name, long internalId) :
+  JackOutputPort(const string& _name, long internalId, int eventCapacity = 0) :
   Port(true, internalId),
   name(_name),
   javaPort(NULL),
   onOpenMid(NULL),
-  processMid(NULL),
   onCloseMid(NULL),
   jackPort(nullptr),
-  bufferEventCount(0),
-  javaRawMidi(NULL),
-  javaDeltaTimes(NULL),
-  javaEventSizes(NULL) {
+  arena(EventOverflow::makeArena((eventCapacity > 0) ? eventCapacity : MaxMidiEvents)),
+  overflow(OverflowPolicy::dropNewest),
+  bufferWritten(false),
+  processDirectMid(NULL),
+  setEventBuffersMid(NULL) {
   }
 
   JackOutputPort(JackOutputPort && other) = default;
@@ -76,17 +107,47 @@ public:
 
   }
 
+  /**
+   * @return the overflow statistics of this port.
+   */
+  const EventOverflow& getOverflow() const {
+    return overflow;
+  }
+
+  /**
+   * @return the number of events per cycle the port can currently take.
+   */
+  int getEventCapacity() const {
+    return arena->getEventCapacity();
+  }
+
+  /**
+   * Replaces the native processing chain of this port (see midiProcessor.hpp),
+   * can be called at any time.
+   * @param chain the new chain, empty to let all events pass unchanged.
+   */
+  void setProcessors(unique_ptr<ProcessorChain> && chain) {
+    processors.set(move(chain));
+  }
+
 protected:
 
+  /**
+   * @return the events java delivers in the current cycle.
+   */
+  MidiEventArena& getEvents() {
+    return *arena;
+  }
+
   /**
    * 1) Store the pointer to the listener (this will exclude it from garbage collection).
-   * 2) cache the method-identifiers of the listeners methods.
-   * 3) prepare a number of Java Arrays that we'll use to transfer data from Java to native
+   * 2) take the method-identifiers of the listeners methods.
+   * 3) hand the arena to java as direct byte buffers.
    * 4) execute the listeners onOpen method.
    * @param env the java environment pointer
    * @param name is ignored (the name is given in the constructor)
    * @param _javaPort a reference to the listener. It is a Java object of 
-   * class MidiIO4Java.Implementation.MidiJackNative$MidiOutputPort
+   * class MidiIO4Java.Implementation.MidiJackNative$DirectMidiOutputPort
    */
   virtual void initialize_impl(JNIEnv * env, jstring /*name*/, jobject _javaPort)override {
     // pin the java-port
@@ -94,26 +155,16 @@ protected:
     if (javaPort == NULL) {
       THROW("Call to NewGlobalRef function failed.")
     }
-    // --- cache the method IDs of the callback functions in the java port.
-    jclass javaPortClass = env->GetObjectClass(javaPort);
-
-    if (javaPortClass == NULL) {
-      THROW("MidiOutputPortListener class not found.")
-    }
-    onOpenMid = env->GetMethodID(javaPortClass, "onOpen", "()V");
-    processMid = env->GetMethodID(javaPortClass, "process", "(JJZ[I[I[I)I");
-    onCloseMid = env->GetMethodID(javaPortClass, "onClose", "()V");
-    if ((onOpenMid == NULL) || (processMid == NULL) || (onCloseMid == NULL)) {
+    // --- the method IDs of the callback functions (see jniRegistry.hpp).
+    const JniRegistry::DirectPortMethods& methods = jniRegistry().directOutputPort;
+    onOpenMid = methods.onOpen;
+    onCloseMid = methods.onClose;
+    processDirectMid = methods.processDirect;
+    setEventBuffersMid = methods.setEventBuffers;
+    if ((onOpenMid == NULL) || (onCloseMid == NULL) || (processDirectMid == NULL) || (setEventBuffersMid == NULL)) {
       THROW("Method-identifier not found.")
     }
-
-    //----- prepare the buffers to transfer the raw-data from java to native
-    javaRawMidi = static_cast<jintArray> (env->NewGlobalRef(env->NewIntArray(3 * MaxMidiEvents)));
-    javaDeltaTimes = static_cast<jintArray> (env->NewGlobalRef(env->NewIntArray(MaxMidiEvents)));
-    javaEventSizes = static_cast<jintArray> (env->NewGlobalRef(env->NewIntArray(MaxMidiEvents)));
-    if ((javaRawMidi == NULL) || (javaDeltaTimes == NULL) || (javaEventSizes == NULL)) {
-      THROW("Out of memory.")
-    }
+    shareArena(env);
     // --- call javaPort.onOpen()
     env->CallVoidMethod(javaPort, onOpenMid);
     jthrowable jexception = env->ExceptionOccurred();
@@ -122,16 +173,67 @@ protected:
     }
   }
 
+  /**
+   * Hands the arena to java as direct byte buffers (once, and again whenever
+   * the arena has grown).
+   */
+  void shareArena(JNIEnv * env) {
+    jobject indexBuffer = env->NewDirectByteBuffer(arena->getEntries(), arena->getEventCapacity() * MidiEventArena::entrySize);
+    jobject byteBuffer = env->NewDirectByteBuffer(arena->getBytes(), arena->getByteCapacity());
+    if ((indexBuffer == NULL) || (byteBuffer == NULL)) {
+      THROW("Direct byte buffers not supported.")
+    }
+    env->CallVoidMethod(javaPort, setEventBuffersMid, indexBuffer, byteBuffer);
+    env->DeleteLocalRef(indexBuffer);
+    env->DeleteLocalRef(byteBuffer);
+    jthrowable jexception = env->ExceptionOccurred();
+    if (jexception != NULL) {
+      THROW_JAVA(env, jexception)
+    }
+  }
+
+  /**
+   * Replaces the arena by a larger one if the demand has come close to its
+   * capacity. Called by the java thread before java produces the events of
+   * the next cycle; the native thread does not touch the arena meanwhile.
+   */
+  void growIfNeeded(JNIEnv * env) {
+    if (!overflow.needsGrowth(*arena)) {
+      return;
+    }
+    arena = overflow.makeGrownArena(*arena);
+    shareArena(env);
+  }
+
+  /**
+   * Books the result of a java cycle.
+   * @param result the value returned by java: the number of events java
+   * has stored in the lower 32 bits, the number of events the listener has
+   * produced in the upper 32 bits.
+   * @return the number of events stored.
+   */
+  jint recordJavaResult(jlong result) {
+    jint stored = static_cast<jint> (result & 0xFFFFFFFFL);
+    jint produced = static_cast<jint> (result >> 32);
+    if ((stored < 0) || (stored > arena->getEventCapacity()) || (produced < stored)) {
+      THROW("Invalid number of Midi Events.")
+    }
+    if (produced > stored) {
+      overflow.countDropped(produced - stored);
+    }
+    return stored;
+  }
+
   virtual void register_impl(void * client)override {
     if (client == nullptr) {
       THROW("Client was NULL.")
     }
-    jack_client_t * jackClient = static_cast<jack_client_t *> (client);
+    MidiBackend * backend = static_cast<MidiBackend *> (client);
 
-    jackPort = jack_port_register(jackClient, name.c_str(), JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+    jackPort = backend->registerPort(name, false);
     if (jackPort == nullptr) {
       ostringstream ost;
-      ost << AT "JACK error creating port (" << name << ").";
+      ost << AT "Error creating port (" << name << ").";
       throw runtime_error(ost.str());
     }
 
@@ -140,56 +242,238 @@ protected:
   virtual void start_impl()override {
   }
 
-  virtual void execJavaProcess_impl(JNIEnv * env, unsigned long timeCodeStart, unsigned long timeCodeDuration, bool lastCycle)override {
-
+  virtual int getConnectionCount_impl(void * client) override {
+    if (jackPort == nullptr) {
+      return -1;
+    }
+    return static_cast<MidiBackend *> (client)->getConnectionCount(jackPort);
+  }
 
-    // obtain Midi events from java listener. 
-    // java signature :"public int process(long timeCodeStart, long timeCodeDuration, boolean lastCycle, int[] rawEventsOut,int[] deltaTimesOut,int[] eventSizeOut)throws Throwable"
-    bufferEventCount = env->CallIntMethod(javaPort, processMid,
+  virtual void execJavaProcess_impl(JNIEnv * env, unsigned long timeCodeStart, unsigned long timeCodeDuration, bool lastCycle)override {
+    if (idleCycle) {
+      arena->clear(); // nobody listens, java is not asked.
+      return;
+    }
+    growIfNeeded(env);
+    arena->clear();
+    // java writes the events into the arena and only returns their number. The arena 
+    // stays untouched until the native thread has written them into the Jack buffer
+    // (the sub-state hand-shake keeps both threads apart).
+    // java signature :"public long processDirect(long timeCodeStart, long timeCodeDuration, boolean lastCycle)throws Throwable"
+    jlong result = env->CallLongMethod(javaPort, processDirectMid,
             (jlong) timeCodeStart,
             (jlong) timeCodeDuration,
-            (jboolean) lastCycle,
-            javaRawMidi, // java signature: int[] rawEventsOut,
-            javaDeltaTimes, // java signature: int[] deltaTimesOut,
-            javaEventSizes); // java signature: int[] eventSizeOut
+            (jboolean) lastCycle);
     jthrowable jexception = env->ExceptionOccurred();
     if (jexception != NULL) {
-      //THROW_JAVA(env, jexception)
-      bufferEventCount = 0; /**@ToDo consider to write "all-sounds-off" to the buffer**/
+      /**@ToDo consider to write "all-sounds-off" to the buffer**/
       THROW_JAVA(env, jexception)
     }
+    takeDirectResult(result);
+  }
+
+  /**
+   * Takes over the events java has written into the arena.
+   * @param result the value returned by java (see recordJavaResult).
+   */
+  void takeDirectResult(jlong result) {
+    arena->setEventCount(recordJavaResult(result));
+    long byteCount = 0;
+    for (int i = 0; i < arena->size(); i++) {
+      byteCount += arena->getLength(i);
+    }
+    recordDemand(result, byteCount);
+  }
+
+  /**
+   * The port can be served by the java dispatcher (batched dispatch);
+   * the events go through the arena, as in execJavaProcess_impl.
+   */
+  virtual CycleEntry::Kind getDispatchKind() const override {
+    return CycleEntry::outputPort;
+  }
+
+  virtual jobject getDispatchPeer() const override {
+    return javaPort;
+  }
 
-    // transfer raw midi events from java arrays into native arrays.
-    env->GetIntArrayRegion(javaRawMidi, 0, 3 * MaxMidiEvents, bufferRawMidi);
-    env->GetIntArrayRegion(javaDeltaTimes, 0, MaxMidiEvents, bufferDeltaTimes);
-    env->GetIntArrayRegion(javaEventSizes, 0, MaxMidiEvents, bufferEventSizes);
+  virtual void beforeDispatch_impl(JNIEnv * env, CycleEntry& entry) override {
+    growIfNeeded(env);
+    arena->clear();
+  }
+
+  virtual void afterDispatch_impl(JNIEnv * env, const CycleEntry& entry) override {
+    takeDirectResult(entry.result);
+  }
+
+  /**
+   * Records the demand of a java cycle. When events were dropped, java
+   * does not tell how many bytes they would have needed; the byte demand is
+   * then taken as "full" so that the arena grows in both dimensions.
+   */
+  void recordDemand(jlong result, long byteCount) {
+    jint produced = static_cast<jint> (result >> 32);
+    jint stored = static_cast<jint> (result & 0xFFFFFFFFL);
+    int bytes = (produced > stored) ? arena->getByteCapacity() : static_cast<int> (byteCount);
+    overflow.recordDemand(produced, bytes);
   }
 
   virtual void execNativeProcess_impl(unsigned long timeCodeStart, unsigned long timeCodeDuration, void * client)override {
     if (jackPort == nullptr) {
-      THROW("jackPort is NULL.")
+      FAIL_NATIVE(nullPort)
+    }
+
+    if (idleCycle && isNativeIdle()) {
+      // still unconnected; once connected the buffer is cleared before it is used.
+      bufferWritten = false;
+      return;
+    }
+    MidiBackend * backend = static_cast<MidiBackend *> (client);
+    void* jackBuffer = backend->getBuffer(jackPort, timeCodeDuration);
+    backend->clearBuffer(jackBuffer);
+    bufferWritten = true;
+
+    ProcessorSlot::Accessor chain(processors);
+    uint8_t scratch[3];
+    int32_t offset = 0;
+    for (int i = 0; i < arena->size(); i++) {
+      if (!arena->isValid(i)) {
+        FAIL_NATIVE(invalidEvent)
+      }
+      int32_t deltaTime = arena->getDeltaTime(i);
+      if (deltaTime < offset) {
+        FAIL_NATIVE(eventOutOfOrder)
+      }
+      if (static_cast<unsigned long> (deltaTime) >= timeCodeDuration) {
+        FAIL_NATIVE(eventBeyondCycle)
+      }
+      offset = deltaTime;
+      int eventSize = arena->getLength(i);
+      const uint8_t* midi = chain.apply(arena->getMidi(i), eventSize, scratch);
+      if (midi == nullptr) {
+        continue; // dropped by a processor.
+      }
+      uint8_t* eventBuffer = backend->reserveEvent(jackBuffer, offset, eventSize);
+      if (eventBuffer == NULL) {
+        // the Jack buffer is full, the remaining events are lost.
+        overflow.countDropped(arena->size() - i);
+        return;
+      }
+      memcpy(eventBuffer, midi, eventSize);
+    }
+  }
+
+  /**
+   * The java thread has not delivered in time (lock-free mode), so this cycle
+   * stays silent.
+   */
+  virtual void execNativeSkip_impl(unsigned long timeCodeDuration, void * client)override {
+    if (jackPort == nullptr) {
+      FAIL_NATIVE(nullPort)
+    }
+    if (isNativeIdle()) {
+      bufferWritten = false;
+      return;
     }
+    MidiBackend * backend = static_cast<MidiBackend *> (client);
+    backend->clearBuffer(backend->getBuffer(jackPort, timeCodeDuration));
+    bufferWritten = true;
+  }
 
-    void* jackBuffer = jack_port_get_buffer(jackPort, timeCodeDuration);
-    jack_midi_clear_buffer(jackBuffer);
+  virtual void prepareMerge_impl()override {
+    if (!mergeArena) {
+      mergeArena = EventOverflow::makeArena(2 * MaxMidiEvents);
+    }
+  }
 
-    int rawMidiIdx = 0;
-    int offset = 0;
-    for (int i = 0; i < bufferEventCount; i++) {
-      int eventSize = bufferEventSizes[i];
-      if (bufferDeltaTimes[i] < offset) {
-        THROW("Midi-Event was out of order.")
+  /**
+   * Merges the events of the routes into the Jack buffer: the events already in 
+   * the buffer (the output of java) and the events of each source form sorted lists,
+   * these lists are merged by time (on equal times the earlier list comes first).
+   */
+  virtual void execNativeMerge_impl(Port* const* sources, const ProcessorChain* const* chains, int count,
+          unsigned long timeCodeDuration, void * client)override {
+    if (jackPort == nullptr) {
+      FAIL_NATIVE(nullPort)
+    }
+    if (!mergeArena || isNativeIdle()) {
+      return;
+    }
+    MidiBackend * backend = static_cast<MidiBackend *> (client);
+    void* jackBuffer = backend->getBuffer(jackPort, timeCodeDuration);
+    mergeArena->clear();
+    int bounds[maxMergeSources + 2];
+    int lists = 0;
+    bounds[0] = 0;
+    int dropped = 0;
+    if (bufferWritten) {
+      dropped += appendEvents(backend, jackBuffer, nullptr);
+    }
+    bufferWritten = false;
+    bounds[++lists] = mergeArena->size();
+    for (int s = 0; s < count; s++) {
+      void* sourceBuffer = sources[s]->getNativeBuffer(timeCodeDuration, client);
+      if (sourceBuffer != nullptr) {
+        dropped += appendEvents(backend, sourceBuffer, chains[s]);
       }
-      offset = bufferDeltaTimes[i];
-      jack_midi_data_t* eventBuffer = jack_midi_event_reserve(jackBuffer, offset, eventSize);
+      bounds[++lists] = mergeArena->size();
+    }
+
+    backend->clearBuffer(jackBuffer);
+    int cursors[maxMergeSources + 1];
+    for (int l = 0; l < lists; l++) {
+      cursors[l] = bounds[l];
+    }
+    for (int written = 0; written < mergeArena->size(); written++) {
+      int next = -1;
+      for (int l = 0; l < lists; l++) {
+        if ((cursors[l] < bounds[l + 1]) && ((next < 0)
+                || (mergeArena->getDeltaTime(cursors[l]) < mergeArena->getDeltaTime(cursors[next])))) {
+          next = l;
+        }
+      }
+      int i = cursors[next]++;
+      int eventSize = mergeArena->getLength(i);
+      uint8_t* eventBuffer = backend->reserveEvent(jackBuffer, mergeArena->getDeltaTime(i), eventSize);
       if (eventBuffer == NULL) {
-        THROW("Not enough space to write Midi Events.")
+        // the Jack buffer is full, the remaining events are lost.
+        dropped += mergeArena->size() - written;
+        break;
+      }
+      memcpy(eventBuffer, mergeArena->getMidi(i), eventSize);
+    }
+    if (dropped > 0) {
+      overflow.countDropped(dropped);
+    }
+  }
+
+  /**
+   * Routes only: appends the events of the given Jack buffer to the merge arena.
+   * @param chain the processing of the events (nullptr for none).
+   * @return the number of events that did not fit.
+   */
+  int appendEvents(MidiBackend * backend, void* jackBuffer, const ProcessorChain* chain) {
+    uint8_t scratch[3];
+    int dropped = 0;
+    int eventCount = backend->getEventCount(jackBuffer);
+    for (int i = 0; i < eventCount; ++i) {
+      MidiBackend::Event event;
+      if (backend->getEvent(event, jackBuffer, i) != 0) {
+        reportNativeError(NativeErrorCode::eventRetrieval, __FILE__, __LINE__);
+        return dropped;
+      }
+      const uint8_t* midi = event.buffer;
+      if (chain != nullptr) {
+        midi = chain->apply(event.buffer, static_cast<int> (event.size), scratch);
+        if (midi == nullptr) {
+          continue; // dropped by a processor.
+        }
       }
-      for (int j = 0; j < eventSize; j++) {
-        eventBuffer[j] = static_cast<jack_midi_data_t> (bufferRawMidi[rawMidiIdx + j]);
+      if (!mergeArena->add(static_cast<int32_t> (event.time), midi, static_cast<int> (event.size))) {
+        dropped++;
       }
-      rawMidiIdx = rawMidiIdx + 3;
     }
+    return dropped;
   }
 
   virtual void stop_impl()override {
@@ -203,11 +487,11 @@ protected:
       THROW("jackPort was NULL.")
     }
 
-    jack_client_t * jackClient = static_cast<jack_client_t *> (client);
+    MidiBackend * backend = static_cast<MidiBackend *> (client);
 
-    int err = jack_port_unregister(jackClient, jackPort);
+    int err = backend->unregisterPort(jackPort);
     if (err != 0) {
-      THROW("JACK error while unregistering port.")
+      THROW("Error while unregistering port.")
     }
     jackPort = nullptr;
   }
@@ -223,16 +507,11 @@ protected:
     }
     env->CallVoidMethod(javaPort, onCloseMid);
     env->DeleteGlobalRef(javaPort);
-    env->DeleteGlobalRef(javaRawMidi);
-    env->DeleteGlobalRef(javaDeltaTimes);
-    env->DeleteGlobalRef(javaEventSizes);
     javaPort = NULL;
     onOpenMid = NULL;
-    processMid = NULL;
     onCloseMid = NULL;
-    javaRawMidi = NULL;
-    javaDeltaTimes = NULL;
-    javaEventSizes = NULL;
+    processDirectMid = NULL;
+    setEventBuffersMid = NULL;
   }
 
 
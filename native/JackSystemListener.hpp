@@ -36,15 +36,23 @@
 #endif
 #endif
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include <string>
 #include <sstream>
 #include <iostream>
 #include <stdexcept>
 #include "messages.hpp"
 #include "util.hpp"
+#include "rtLog.hpp"
+#include "jniRegistry.hpp"
+#include "spscRing.hpp"
+#include "cycleSignal.hpp"
+#include "midiGraph.hpp"
 
 
 using namespace std;
@@ -58,8 +66,53 @@ static bool ignoreCallback = true;
  * <p>
  * The implementation is very similar to the port class.
  * </p>
+ * <p>
+ * The jack server reports a connection change on its notification thread.
+ * This thread only appends a ConnectionRecord to a lock-free ring and wakes
+ * the notifier. The notifier is a single thread, attached to the java virtual
+ * machine for as long as the listener is activated; it drains the ring in
+ * batches and calls "onConnectionChanged" once per batch. So a burst of
+ * connection changes (a patch-bay reloading a session) costs one java call
+ * instead of one thread attachment per change.
+ * </p>
+ * <p>
+ * In the debounced mode (see "initialize") the notifier keeps collecting the
+ * changes for a fixed window after the first one, port registrations included.
+ * If the java listener is a MidiGraphListener it then receives one
+ * "onGraphChanged" call with a new snapshot of the MIDI connection graph and
+ * the delta to the previous snapshot; otherwise it receives one
+ * "onConnectionChanged" call.
+ * </p>
  */
 class JackSystemListener {
+public:
+
+  enum Change {
+    connected, ///< the ports "a" and "b" were connected.
+    disconnected, ///< the ports "a" and "b" were disconnected.
+    registered, ///< the port "a" has been registered ("b" equals "a").
+    unregistered ///< the port "a" has been unregistered ("b" equals "a").
+  };
+
+  /**
+   * A change of the connection graph as reported by the jack server.
+   */
+  struct ConnectionRecord {
+    jack_port_id_t a; ///< one of the two ports.
+    jack_port_id_t b; ///< the other port.
+    Change change;
+  };
+
+  /** The number of connection changes that can be pending at once. */
+  static constexpr size_t connectionRecordCapacity = 1024;
+
+  /**
+   * How long (in microseconds) the notifier keeps collecting after
+   * "resumeNotifications"; the server reports our own connections
+   * asynchronously, possibly after "jack_connect" has returned.
+   */
+  static constexpr long resumeSettleMicros = 50000;
+
 private:
 
 
@@ -120,6 +173,55 @@ private:
 
   exception_ptr nativeProcessException;
 
+  /** The connection changes not yet reported to java (jack thread to notifier). */
+  SpscRing<ConnectionRecord> connectionRecords;
+
+  /** Set by the jack thread when the ring was full and a change has been dropped. */
+  atomic<bool> connectionRecordsLost;
+
+  /** Wakes the notifier when connection records are pending. */
+  CycleSignal recordsPending;
+
+  /** The notifier thread (runs while the listener is activated). */
+  thread notifier;
+
+  /** Tells the notifier to drain the ring a last time and to terminate. */
+  atomic<bool> notifierStopping;
+
+  /** The records drained in the current batch (only used by the notifier). */
+  vector<ConnectionRecord> batch;
+
+  /** The window over which changes are collected, zero for no debouncing. */
+  chrono::microseconds debounce;
+
+  /** True if the java listener implements MidiGraphListener. */
+  bool graphListener;
+
+  jmethodID onGraphChangedMid;
+
+  /** The client the graph is read from (set in activate). */
+  jack_client_t * jackClient;
+
+  /** The latest snapshot published (only used by the notifier once activated). */
+  MidiGraph graph;
+
+  /** The number of "suspendNotifications" not yet resumed. */
+  atomic<int> suspendCount;
+
+  /** Until when (steady clock, in microseconds) the notifier holds back after a resume. */
+  atomic<long long> heldUntilMicros;
+
+  static long long nowMicros() {
+    return chrono::duration_cast<chrono::microseconds> (chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * @return true while the notifications are suspended or settling.
+   */
+  bool isHeld() const {
+    return (suspendCount.load() > 0) || (nowMicros() < heldUntilMicros.load());
+  }
+
   /**
    * This function will register the
    * given Java-listener-object 
@@ -134,13 +236,11 @@ private:
     if (systemListener == NULL) {
       THROW("Call to NewGlobalRef function failed.")
     }
-    // --- cache the method IDs of the callback functions provided by the systemListener.
-    jclass listenerClass = env->GetObjectClass(systemListener);
-
-    if (listenerClass == NULL) {
-      THROW("MidiSystemListener class not found.")
-    }
-    onConnectionChangedMid = env->GetMethodID(listenerClass, "onConnectionChanged", "()V");
+    // --- the method ID of the callback function (see jniRegistry.hpp).
+    onConnectionChangedMid = jniRegistry().onConnectionChangedMid;
+    onGraphChangedMid = jniRegistry().onGraphChangedMid;
+    graphListener = (debounce.count() > 0) && (jniRegistry().graphListenerClass != NULL)
+            && env->IsInstanceOf(systemListener, jniRegistry().graphListenerClass);
 
     if ((onConnectionChangedMid == NULL)) {
       THROW("Method-identifier not found.")
@@ -160,12 +260,18 @@ private:
    */
   void activate_impl(void * client) {
 
-    jack_client_t * jackClient = static_cast<jack_client_t *> (client);
+    jackClient = static_cast<jack_client_t *> (client);
 
     int err = jack_set_port_connect_callback(jackClient, onPortConnect, this);
     if (err != 0) {
       THROW("jack_set_port_connect_callback failed.")
     }
+    if (graphListener) {
+      // the first delta is relative to the graph found when the system was opened.
+      captureGraph(graph);
+      graph.version = 0;
+    }
+    startNotifier();
     ignoreCallback = false;
   }
 
@@ -180,6 +286,8 @@ private:
     env->DeleteGlobalRef(systemListener);
     systemListener = NULL;
     onConnectionChangedMid = NULL;
+    onGraphChangedMid = NULL;
+    graphListener = false;
 
 
   }
@@ -195,6 +303,214 @@ private:
     // will be ignored because "onPortConnect_impl" will always check 
     // the state variable before accessing the java listener.
     ignoreCallback = true;
+    stopNotifier();
+    jackClient = nullptr;
+  }
+
+  void startNotifier() {
+    ConnectionRecord stale;
+    while (connectionRecords.pop(stale)) {
+    }
+    connectionRecordsLost.store(false);
+    notifierStopping.store(false);
+    notifier = thread(&JackSystemListener::runNotifier, this);
+  }
+
+  /**
+   * Stops the notifier and waits until it has terminated. Changes still pending
+   * are reported before the notifier ends.
+   * Note: the java listener must not wait for the midi system to close within
+   * "onConnectionChanged", the notifier could never terminate.
+   */
+  void stopNotifier() {
+    if (!notifier.joinable()) {
+      return;
+    }
+    notifierStopping.store(true);
+    recordsPending.signal();
+    notifier.join();
+  }
+
+  /**
+   * The body of the notifier thread. The thread is attached once (as a daemon,
+   * so it does not keep the virtual machine alive) and detached when it ends.
+   */
+  void runNotifier() {
+    JNIEnv * env;
+    if (jvm->AttachCurrentThreadAsDaemon((void**) &env, NULL) != 0) {
+      rtLog().log(RtLogLevel::severe, "Notifier could not attach to the java VM.");
+      return;
+    }
+    batch.reserve(connectionRecordCapacity);
+    while (true) {
+      uint32_t seen = recordsPending.getSequence();
+      bool stopping = notifierStopping.load();
+      if (drainConnectionRecords(false)) {
+        if (((debounce.count() > 0) || isHeld()) && !stopping) {
+          collectWithinWindow();
+        }
+        notifyJava(env);
+      }
+      if (stopping) {
+        break;
+      }
+      recordsPending.waitFor(seen, chrono::milliseconds(100));
+    }
+    jvm->DetachCurrentThread();
+  }
+
+  /**
+   * Moves the pending connection records into "batch".
+   * @param append true to add to the records already in "batch".
+   * @return true if there was any change (also a dropped one).
+   */
+  bool drainConnectionRecords(bool append) {
+    if (!append) {
+      batch.clear();
+    }
+    ConnectionRecord record;
+    while (connectionRecords.pop(record)) {
+      batch.push_back(record);
+    }
+    bool lost = connectionRecordsLost.exchange(false);
+    return lost || !batch.empty();
+  }
+
+  /**
+   * Keeps adding records to "batch" until the debounce window, counted from
+   * the first change of the batch, has expired and the notifications are no
+   * longer held (see suspendNotifications). The window does not slide, so
+   * a steady stream of changes still gets reported once per window.
+   */
+  void collectWithinWindow() {
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + debounce;
+    while (!notifierStopping.load()) {
+      uint32_t seen = recordsPending.getSequence();
+      drainConnectionRecords(true);
+      chrono::steady_clock::duration left = deadline - chrono::steady_clock::now();
+      if (left <= chrono::steady_clock::duration::zero()) {
+        if (!isHeld()) {
+          break;
+        }
+        // woken by "resumeNotifications" or by the end of the settle time.
+        left = chrono::milliseconds(10);
+      }
+      recordsPending.waitFor(seen, chrono::duration_cast<chrono::microseconds> (left) + chrono::microseconds(1));
+    }
+    drainConnectionRecords(true);
+  }
+
+  /**
+   * Reads the MIDI ports and the connections of their outputs in one pass.
+   * @param target receives the (normalized) snapshot, the version is not touched.
+   */
+  void captureGraph(MidiGraph& target) const {
+    target.ports.clear();
+    target.connections.clear();
+    const char** names = jack_get_ports(jackClient, NULL, JACK_DEFAULT_MIDI_TYPE, 0);
+    if (names == NULL) {
+      return;
+    }
+    for (const char** name = names; *name != NULL; name++) {
+      target.ports.push_back(*name);
+      jack_port_t* port = jack_port_by_name(jackClient, *name);
+      if ((port == NULL) || ((jack_port_flags(port) & JackPortIsOutput) == 0)) {
+        continue;
+      }
+      const char** peers = jack_port_get_all_connections(jackClient, port);
+      if (peers != NULL) {
+        for (const char** peer = peers; *peer != NULL; peer++) {
+          target.connections.push_back(MidiConnection(*name, *peer));
+        }
+        jack_free(peers);
+      }
+    }
+    jack_free(names);
+    target.normalize();
+  }
+
+  static jobjectArray toJavaArray(JNIEnv * env, const vector<string>& names) {
+    jobjectArray result = env->NewObjectArray(static_cast<jsize> (names.size()), jniRegistry().stringClass, NULL);
+    if (result == NULL) {
+      THROW("Out of memory.")
+    }
+    for (size_t i = 0; i < names.size(); i++) {
+      jstring name = env->NewStringUTF(names[i].c_str());
+      env->SetObjectArrayElement(result, static_cast<jsize> (i), name);
+      env->DeleteLocalRef(name);
+    }
+    return result;
+  }
+
+  /**
+   * @return the connections as one array of names: source, destination, source...
+   */
+  static jobjectArray toJavaArray(JNIEnv * env, const vector<MidiConnection>& connections) {
+    vector<string> names;
+    names.reserve(2 * connections.size());
+    for (const MidiConnection& connection : connections) {
+      names.push_back(connection.source);
+      names.push_back(connection.destination);
+    }
+    return toJavaArray(env, names);
+  }
+
+  /**
+   * Publishes a new snapshot of the graph to the java listener, unless the
+   * changes of the batch have cancelled each other out.
+   */
+  void notifyGraph(JNIEnv * env) {
+    MidiGraph current;
+    captureGraph(current);
+    MidiGraphDelta delta = MidiGraphDelta::between(graph, current);
+    if (delta.isEmpty()) {
+      return;
+    }
+    current.version = graph.version + 1;
+    graph = move(current);
+
+    // the notifier has no java frame, so its local references must be freed explicitly.
+    if (env->PushLocalFrame(8) != 0) {
+      THROW("Out of memory.")
+    }
+    try {
+      jobjectArray ports = toJavaArray(env, graph.ports);
+      jobjectArray connections = toJavaArray(env, graph.connections);
+      jobjectArray addedPorts = toJavaArray(env, delta.addedPorts);
+      jobjectArray removedPorts = toJavaArray(env, delta.removedPorts);
+      jobjectArray addedConnections = toJavaArray(env, delta.addedConnections);
+      jobjectArray removedConnections = toJavaArray(env, delta.removedConnections);
+      jobject jGraph = env->NewObject(jniRegistry().graphClass, jniRegistry().graphInit,
+              static_cast<jlong> (graph.version), ports, connections,
+              addedPorts, removedPorts, addedConnections, removedConnections);
+      if (jGraph != NULL) {
+        env->CallVoidMethod(systemListener, onGraphChangedMid, jGraph);
+      }
+    } catch (...) {
+      env->PopLocalFrame(NULL);
+      throw;
+    }
+    env->PopLocalFrame(NULL);
+  }
+
+  /**
+   * Reports one batch of connection changes to the java listener.
+   */
+  void notifyJava(JNIEnv * env) {
+    if (graphListener) {
+      try {
+        notifyGraph(env);
+      } catch (std::exception&) {
+        rtLog().log(RtLogLevel::warning, "Could not publish the connection graph.");
+      }
+    } else {
+      env->CallVoidMethod(systemListener, onConnectionChangedMid);
+    }
+    if (env->ExceptionCheck()) {
+      // the listener is not part of the process cycle, its errors do not stop the system.
+      env->ExceptionClear();
+      rtLog().log(RtLogLevel::warning, "Exception in the connection listener.", static_cast<long> (batch.size()));
+    }
   }
 
   void throwCannot(const string& attemptedAction, int lineNumber, State state) {
@@ -238,20 +554,23 @@ private:
     }
   }
 
+  /**
+   * Hands the change to the notifier. Neither locks nor allocates, so the jack
+   * notification thread is never held up by java.
+   */
   void onPortConnect_impl(jack_port_id_t a, jack_port_id_t b, int connect) {
-    Lock lock(stateMutex);
+    ConnectionRecord record;
+    record.a = a;
+    record.b = b;
+    record.change = (connect != 0) ? connected : disconnected;
+    pushRecord(record);
+  }
 
-    JNIEnv * env;
-    jint errCode = jvm->AttachCurrentThread((void**)&env, NULL);
-    if (errCode != 0) {
-      THROW("AttachCurrentThread failed.")
+  void pushRecord(const ConnectionRecord& record) {
+    if (!connectionRecords.push(record)) {
+      connectionRecordsLost.store(true);
     }
-
-    env->CallVoidMethod(systemListener, onConnectionChangedMid);
-
-    /** @TODO error handling when java call fails*/
-
-    jvm->DetachCurrentThread();
+    recordsPending.signal();
   }
 
 public:
@@ -263,7 +582,16 @@ public:
   state(uninitialized),
   systemListener(NULL),
   onConnectionChangedMid(NULL),
-  jvm(NULL) {
+  jvm(NULL),
+  connectionRecords(connectionRecordCapacity),
+  connectionRecordsLost(false),
+  notifierStopping(false),
+  debounce(0),
+  graphListener(false),
+  onGraphChangedMid(NULL),
+  jackClient(nullptr),
+  suspendCount(0),
+  heldUntilMicros(0) {
   }
   /**
    * The move constructor is inhibited.
@@ -279,7 +607,7 @@ public:
     if (state != uninitialized) {
       // it is not wise to throw an exception in the destructor.
       // At least we can leave a message.
-      cerr << "### A Port is deleted in wrong state!!!!" << endl;
+      rtLog().log(RtLogLevel::warning, "A system-listener is deleted in wrong state.");
     }
   }
 
@@ -287,12 +615,16 @@ public:
    * Initializes this system-listener for use. Once a system-listener is initialized it is
    * capable to cooperate with the Java environment.
    * @param env pointer to the java thread 
+   * @param listener the java listener (a MidiIO4Java.MidiSystemListener).
+   * @param _debounce the window over which changes are collected before the
+   * listener is called, zero to call the listener as soon as possible.
    */
-  void initialize(JNIEnv * env, jobject listener) {
+  void initialize(JNIEnv * env, jobject listener, chrono::microseconds _debounce = chrono::microseconds(0)) {
     Lock lock(stateMutex);
     if (state != uninitialized) {
       throwCannot("initialize", __LINE__, state);
     }
+    debounce = _debounce;
     initialize_impl(env, listener);
     state = initialized;
   }
@@ -371,6 +703,45 @@ public:
     return (state == deactivateted);
   }
 
+  /**
+   * To be called by the port registration call-back of the client (jack only
+   * permits one such call-back per client).
+   * Note: called on the jack notification thread.
+   * @param port the port registered or unregistered.
+   * @param isRegistered non-zero if the port has been registered.
+   */
+  void onPortRegistration(jack_port_id_t port, int isRegistered) {
+    if (ignoreCallback || (debounce.count() == 0)) {
+      // without debouncing only connections are reported, as ever.
+      return;
+    }
+    ConnectionRecord record;
+    record.a = port;
+    record.b = port;
+    record.change = (isRegistered != 0) ? registered : unregistered;
+    pushRecord(record);
+  }
+
+  /**
+   * Holds back the notifications, for example while a whole patch is being
+   * connected. The changes are collected and reported together after
+   * "resumeNotifications". Calls can be nested.
+   */
+  void suspendNotifications() {
+    suspendCount.fetch_add(1);
+  }
+
+  /**
+   * Undoes one "suspendNotifications". The changes collected are reported
+   * once the server had some time (see resumeSettleMicros) to report the
+   * last of them.
+   */
+  void resumeNotifications() {
+    heldUntilMicros.store(nowMicros() + resumeSettleMicros);
+    suspendCount.fetch_sub(1);
+    recordsPending.signal();
+  }
+
   /**
    * Returns true if the system-listener has encountered an exception in one of its worker
    * threads.
@@ -380,6 +751,14 @@ public:
     return static_cast<bool> (nativeProcessException);
   }
 
+  /**
+   * @return the number of connection changes dropped because the notifier
+   * fell behind (they are still reported, merged into the next batch).
+   */
+  unsigned long getLostConnectionRecords() const {
+    return connectionRecords.getOverflowCount();
+  }
+
 
 };
 
@@ -0,0 +1,80 @@
+/*
+ * File:   cycleDescriptor.hpp
+ *
+ * Created on October 16, 2026, 9:05 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CYCLEDESCRIPTOR_HPP
+#define	CYCLEDESCRIPTOR_HPP
+
+#include <cstdint>
+
+/**
+ * In batched dispatch mode (see PortChain::setBatchedDispatch) the java
+ * thread does not call every port's listener through its own JNI call.
+ * Instead it fills one CycleEntry per port and makes a single call into the
+ * java dispatcher (MidiIO4Java.Implementation.CycleDispatcher), which fans
+ * out to the listeners.
+ * </p>
+ * <p>
+ * The entries of a chain lie one after the other in a block shared with java
+ * as a direct byte buffer; the entry of a port has the same index as the port
+ * in the active snapshot of the chain. The layout (32 bytes, native byte
+ * order) must match CycleDispatcher.java:
+ * <pre>
+ *  offset  0: the time-code at the start of the cycle (64 bit)
+ *  offset  8: the duration of the cycle (32 bit)
+ *  offset 12: the kind of the entry (32 bit, see Kind)
+ *  offset 16: flags (32 bit, see Flags)
+ *  offset 20: input ports: the number of events in the arena (32 bit)
+ *  offset 24: written by java: output ports: the events produced (high 32 bit)
+ *             and stored (low 32 bit), see JackOutputPort::recordJavaResult
+ *             (64 bit)
+ * </pre>
+ * </p>
+ */
+struct CycleEntry {
+
+  /**
+   * Tells the java dispatcher what to call.
+   */
+  enum Kind : int32_t {
+    notDispatched = 0, ///< the port does not take part in this cycle's dispatch.
+    cycleStart = 1, ///< the start-control port, calls MidiSystemListener.onCycleStart.
+    cycleEnd = 2, ///< the end-control port, calls MidiSystemListener.onCycleEnd.
+    inputPort = 3, ///< a (direct) input port.
+    outputPort = 4 ///< a (direct) output port.
+  };
+
+  enum Flags : int32_t {
+    lastCycleFlag = 1, ///< this is the last cycle before shutdown.
+    failedFlag = 2 ///< written by java: the listener has thrown an exception.
+  };
+
+  int64_t timeCodeStart;
+  int32_t timeCodeDuration;
+  int32_t kind;
+  int32_t flags;
+  int32_t eventCount;
+  int64_t result;
+};
+
+static_assert(sizeof (CycleEntry) == 32, "the java side expects 32 byte entries.");
+
+#endif	/* CYCLEDESCRIPTOR_HPP */
+
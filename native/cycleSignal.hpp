@@ -0,0 +1,145 @@
+/*
+ * File:   cycleSignal.hpp
+ *
+ * Created on October 16, 2026, 2:05 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CYCLESIGNAL_HPP
+#define	CYCLESIGNAL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <time.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+using namespace std;
+
+/**
+ * The CycleSignal permits the native thread to wake up the java thread
+ * directly (instead of letting the java thread poll).
+ * </p>
+ * <p>
+ * The signal is a sequence number. A waiting thread first reads the
+ * sequence number, then checks its own wake-up condition and, if the
+ * condition is not yet met, waits until the sequence number changes.
+ * So no signal can get lost between the check and the wait.
+ * </p>
+ * <p>
+ * On Linux the signal is a futex: "signal" never takes a lock and
+ * makes a system call only if a thread is actually waiting, so it can be used
+ * from within the real-time thread. On other systems a condition variable
+ * is used.
+ * </p>
+ */
+class CycleSignal {
+private:
+#ifdef __linux__
+  /** The futex word. */
+  atomic<uint32_t> sequence;
+
+  /** The number of threads currently in "waitFor". */
+  atomic<int> waiters;
+#else
+  atomic<uint32_t> sequence;
+  mutex sequenceMutex;
+  condition_variable sequenceChanged;
+#endif
+
+public:
+
+#ifdef __linux__
+
+  CycleSignal() :
+  sequence(0),
+  waiters(0) {
+    static_assert(sizeof (atomic<uint32_t>) == sizeof (uint32_t), "futex word must be 32 bit.");
+  }
+#else
+
+  CycleSignal() :
+  sequence(0) {
+  }
+#endif
+
+  CycleSignal(const CycleSignal&) = delete;
+
+  /**
+   * @return the current sequence number, to be passed to "waitFor".
+   */
+  uint32_t getSequence() const {
+    return sequence.load();
+  }
+
+  /**
+   * Advances the sequence number and wakes all waiting threads.
+   */
+  void signal() {
+#ifdef __linux__
+    sequence.fetch_add(1);
+    if (waiters.load() > 0) {
+      syscall(SYS_futex, reinterpret_cast<uint32_t*> (&sequence), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+    }
+#else
+    {
+      lock_guard<mutex> lock(sequenceMutex);
+      sequence.fetch_add(1);
+    }
+    sequenceChanged.notify_all();
+#endif
+  }
+
+  /**
+   * Blocks the calling thread until the sequence number differs from the
+   * given one or until the timeout has expired.
+   * @param seen the sequence number read before the wake-up condition was checked.
+   * @param timeout the longest time to wait.
+   * @return true if the sequence number has changed.
+   */
+  bool waitFor(uint32_t seen, chrono::microseconds timeout) {
+#ifdef __linux__
+    if (sequence.load() != seen) {
+      return true;
+    }
+    timespec relative;
+    relative.tv_sec = static_cast<time_t> (timeout.count() / 1000000);
+    relative.tv_nsec = static_cast<long> ((timeout.count() % 1000000) * 1000);
+    waiters.fetch_add(1);
+    // the kernel only puts us to sleep if the sequence is still "seen".
+    syscall(SYS_futex, reinterpret_cast<uint32_t*> (&sequence), FUTEX_WAIT_PRIVATE, seen, &relative, nullptr, 0);
+    waiters.fetch_sub(1);
+    return sequence.load() != seen;
+#else
+    unique_lock<mutex> lock(sequenceMutex);
+    return sequenceChanged.wait_for(lock, timeout, [this, seen]() {
+      return sequence.load() != seen;
+    });
+#endif
+  }
+};
+
+#endif	/* CYCLESIGNAL_HPP */
+
@@ -0,0 +1,347 @@
+/*
+ * File:   epochEnvelope.hpp
+ *
+ * Created on October 16, 2026, 4:20 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef EPOCHENVELOPE_HPP
+#define	EPOCHENVELOPE_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include "port.hpp"
+#include "messages.hpp"
+
+/**
+ * The EpochDomain keeps track of the threads that currently read an EpochEnvelope.
+ * </p>
+ * <p>
+ * Every reading thread owns a slot in which it announces the global epoch it has
+ * seen when it started to read (zero while it does not read). A writer that has
+ * unpublished an item advances the global epoch and waits until every slot
+ * is either zero or newer (the grace period); from then on no reader can hold the item.
+ * </p>
+ * <p>
+ * Entering and leaving are wait-free (a thread takes a slot once, on its first read).
+ * </p>
+ */
+class EpochDomain {
+public:
+  /** The maximum number of threads that can read concurrently. */
+  static const int maxReaders = 64;
+
+  /**
+   * @return the domain shared by all EpochEnvelopes.
+   */
+  static EpochDomain& instance() {
+    static EpochDomain domain;
+    return domain;
+  }
+
+  /**
+   * Marks the calling thread as reader. Calls can be nested.
+   */
+  void enter() {
+    ThreadRecord& record = threadRecord();
+    if (record.depth == 0) {
+      if (record.slot == nullptr) {
+        record.slot = claimSlot();
+      }
+      record.slot->epoch.store(globalEpoch.load());
+    }
+    record.depth++;
+  }
+
+  /**
+   * Ends the read of the calling thread (when the outermost enter is left).
+   */
+  void leave() {
+    ThreadRecord& record = threadRecord();
+    record.depth--;
+    if (record.depth == 0) {
+      record.slot->epoch.store(0);
+    }
+  }
+
+  /**
+   * Blocks until all threads that were reading when this function was called
+   * have stopped reading.
+   * @param timeout the longest time to wait.
+   * @return false if the timeout has expired.
+   */
+  bool waitForGracePeriod(chrono::milliseconds timeout) {
+    uint64_t target = globalEpoch.fetch_add(1) + 1;
+    auto deadline = chrono::steady_clock::now() + timeout;
+    for (auto &slot : slots) {
+      int round = 0;
+      while (true) {
+        uint64_t seen = slot.epoch.load();
+        if ((seen == 0) || (seen >= target)) {
+          break;
+        }
+        if (chrono::steady_clock::now() > deadline) {
+          return false;
+        }
+        if (round++ < 64) {
+          this_thread::yield();
+        } else {
+          this_thread::sleep_for(chrono::microseconds(100));
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+
+  struct ReaderSlot {
+    atomic<bool> claimed;
+    /** the epoch seen when the owning thread started to read, zero when it does not read. */
+    atomic<uint64_t> epoch;
+  };
+
+  /**
+   * The slot of the calling thread. The slot is given back when the thread ends.
+   */
+  struct ThreadRecord {
+    ReaderSlot* slot;
+    int depth;
+
+    ThreadRecord() :
+    slot(nullptr),
+    depth(0) {
+    }
+
+    ~ThreadRecord() {
+      if (slot != nullptr) {
+        slot->epoch = 0;
+        slot->claimed = false;
+      }
+    }
+  };
+
+  atomic<uint64_t> globalEpoch;
+  ReaderSlot slots[maxReaders];
+
+  EpochDomain() :
+  globalEpoch(1) {
+    for (auto &slot : slots) {
+      slot.claimed = false;
+      slot.epoch = 0;
+    }
+  }
+
+  EpochDomain(const EpochDomain&) = delete;
+
+  static ThreadRecord& threadRecord() {
+    thread_local ThreadRecord record;
+    return record;
+  }
+
+  ReaderSlot* claimSlot() {
+    for (auto &slot : slots) {
+      bool expected = false;
+      if (slot.claimed.compare_exchange_strong(expected, true)) {
+        return &slot;
+      }
+    }
+    THROW("Too many threads reading EpochEnvelopes.")
+  }
+};
+
+/**
+ * The class EpochEnvelope is a lock-free variant of the PtrEnvelope.
+ * Readers neither lock nor maintain a use count; they enter an epoch of the
+ * EpochDomain instead. "setItemWait" and "removeItemWait" wait for a grace period of the
+ * domain (that is, until every thread that was reading has finished) instead of
+ * waiting for a zero use count.
+ * </p>
+ * <p>
+ * Note: the grace period covers all EpochEnvelopes; a writer also waits for
+ * readers of other envelopes. Readers must therefore not hold an Accessor
+ * for a long time, and a thread must not write while it holds an Accessor.
+ * </p>
+ */
+class EpochEnvelope {
+public:
+
+  /**
+   * The accessor is the only way to get access to the pointer envelopped
+   * by the EpochEnvelope class. While it exists, the calling thread is a reader
+   * of the EpochDomain (RAII).
+   */
+  class Accessor {
+  private:
+    Port* item;
+  protected:
+    friend class EpochEnvelope;
+
+    Accessor(const EpochEnvelope& owner) {
+      EpochDomain::instance().enter();
+      item = owner.item.load();
+    }
+
+  public:
+
+    Accessor(const Accessor& other) :
+    item(other.item) {
+      EpochDomain::instance().enter();
+    }
+
+    Accessor& operator=(const Accessor&) = delete;
+
+    /**
+     * Indicates whether the pointer holds an existing item.
+     * @return false if the pointer points to nothing.
+     */
+    bool hasItem() const {
+      return item != nullptr;
+    }
+
+    /**
+     * Indicates whether the pointer holds a null pointer
+     * (the result is the inverse of "hasItem").
+     * @return false if the pointer points to nothing.
+     */
+    bool isEmpty() const {
+      return item == nullptr;
+    }
+
+    /**
+     * Accesses the enveloped item.
+     * @return a pointer to the item (valid as long as the Accessor exists).
+     */
+    Port* get() const {
+      return item;
+    }
+
+    /**
+     * Destroys the Accessor and leaves the epoch.
+     */
+    ~Accessor() {
+      EpochDomain::instance().leave();
+    }
+
+  }; //end Accessor ------
+
+  friend class Accessor;
+
+  /**
+   * Constructs a new envelope holding an empty pointer.
+   */
+  EpochEnvelope() :
+  maxWaitingTime(500),
+  item(nullptr) {
+  }
+
+  /**
+   * Constructs a new envelope holding an empty pointer.
+   * @param _maxWaitingTime permits to set a shorter waiting time for testing
+   * purposes.
+   */
+  EpochEnvelope(int _maxWaitingTime) :
+  maxWaitingTime(_maxWaitingTime),
+  item(nullptr) {
+  }
+
+  virtual ~EpochEnvelope() {
+    delete item.load();
+  }
+
+  EpochEnvelope(const EpochEnvelope&) = delete;
+
+  EpochEnvelope(EpochEnvelope &&) = delete;
+
+private:
+  const chrono::milliseconds maxWaitingTime;
+  atomic<Port*> item;
+  /** serializes the writers, readers never touch it. */
+  mutex writerMutex;
+
+public:
+
+  /**
+   * Constructs an Accessor that permits to access the pointer
+   * hidden within the envelope.
+   * @return a new Accessor.
+   */
+  Accessor makeAccessor() const {
+    return Accessor(*this);
+  }
+
+  /**
+   * Moves a new item into the pointer. The calling thread is blocked until
+   * all threads that were reading have finished.
+   * @param newItem the new item to be moved into the pointer (left untouched on failure).
+   */
+  void setItemWait(unique_ptr<Port> && newItem) {
+    lock_guard<mutex> lock(writerMutex);
+    if (!static_cast<bool> (newItem)) {
+      THROW("Programming error: newItem is null (nothing to add).")
+    }
+    if (item.load() != nullptr) {
+      THROW("Programming error: envelope not empty, cannot add a new item.")
+    }
+    if (!EpochDomain::instance().waitForGracePeriod(maxWaitingTime)) {
+      THROW_TIMEOUT("Timeout in setItemWait().")
+    }
+    item.store(newItem.release());
+  }
+
+  /**
+   * Removes the item from the pointer. The calling thread is blocked until
+   * all threads that might still read the item have finished.
+   * @return the removed item
+   */
+  unique_ptr<Port> removeItemWait() {
+    lock_guard<mutex> lock(writerMutex);
+    Port* removed = item.exchange(nullptr);
+    if (removed == nullptr) {
+      THROW("Programming error: envelope is empty, cannot remove the item.")
+    }
+    if (!EpochDomain::instance().waitForGracePeriod(maxWaitingTime)) {
+      item.store(removed); // give it back, it might still be in use.
+      THROW_TIMEOUT("Timeout in removeItemWait().")
+    }
+    return unique_ptr<Port > (removed);
+  }
+
+  /**
+   * Indicates whether the pointer holds an existing item.
+   * @return false if the pointer points to nothing.
+   */
+  bool hasItem() const {
+    return item.load() != nullptr;
+  }
+
+  /**
+   * Indicates whether the envelope holds a null pointer
+   * (the result is the inverse of "hasItem").
+   * @return false if the pointer points to nothing.
+   */
+  bool isEmpty() const {
+    return item.load() == nullptr;
+  }
+};
+
+#endif	/* EPOCHENVELOPE_HPP */
+
@@ -0,0 +1,99 @@
+/*
+ * File:   jackBackend.hpp
+ *
+ * Created on October 16, 2026, 10:32 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef JACKBACKEND_HPP
+#define	JACKBACKEND_HPP
+
+#include <jack/jack.h>
+#include <jack/midiport.h>
+#include "midiBackend.hpp"
+#include "messages.hpp"
+
+/**
+ * The MidiBackend of a client connected to the Jack server.
+ */
+class JackBackend : public MidiBackend {
+private:
+  jack_client_t * const client;
+
+public:
+
+  /**
+   * @param _client a client connected to the Jack server (not owned by the backend).
+   */
+  explicit JackBackend(jack_client_t * _client) :
+  client(_client) {
+    if (_client == nullptr) {
+      THROW("Client was NULL.")
+    }
+  }
+
+  JackBackend(const JackBackend&) = delete;
+
+  jack_client_t * getClient() const {
+    return client;
+  }
+
+  virtual unsigned long getFrameRate() override {
+    return jack_get_sample_rate(client);
+  }
+
+  virtual PortHandle registerPort(const string& name, bool isInput) override {
+    return jack_port_register(client, name.c_str(), JACK_DEFAULT_MIDI_TYPE,
+            isInput ? JackPortIsInput : JackPortIsOutput, 0);
+  }
+
+  virtual int unregisterPort(PortHandle port) override {
+    return jack_port_unregister(client, static_cast<jack_port_t*> (port));
+  }
+
+  virtual void* getBuffer(PortHandle port, unsigned long frames) override {
+    return jack_port_get_buffer(static_cast<jack_port_t*> (port), frames);
+  }
+
+  virtual int getEventCount(void* buffer) override {
+    return jack_midi_get_event_count(buffer);
+  }
+
+  virtual int getEvent(Event& event, void* buffer, int index) override {
+    jack_midi_event_t jackEvent;
+    int error = jack_midi_event_get(&jackEvent, buffer, index);
+    event.time = jackEvent.time;
+    event.size = jackEvent.size;
+    event.buffer = jackEvent.buffer;
+    return error;
+  }
+
+  virtual void clearBuffer(void* buffer) override {
+    jack_midi_clear_buffer(buffer);
+  }
+
+  virtual uint8_t* reserveEvent(void* buffer, uint32_t time, size_t size) override {
+    return jack_midi_event_reserve(buffer, time, size);
+  }
+
+  virtual int getConnectionCount(PortHandle port) override {
+    return jack_port_connected(static_cast<jack_port_t*> (port));
+  }
+};
+
+#endif	/* JACKBACKEND_HPP */
+
@@ -26,6 +26,8 @@
 #include <exception>
 #include <memory>
 #include <atomic>
+#include <chrono>
+#include <vector>
 
 #include "portchain.hpp"
 #include "port.hpp"
@@ -34,12 +36,38 @@
 #include "util.hpp"
 #include "ControllPort.hpp"
 #include "JackSystemListener.hpp"
+#include "midiBackend.hpp"
+#include "jackBackend.hpp"
+#include "simulatedBackend.hpp"
 #include "messages.hpp"
+#include "rtLog.hpp"
+#include "jniRegistry.hpp"
 
 
 using namespace std;
 static jack_client_t * clientId = nullptr;
 
+/**
+ * The audio system the ports of the current session work with (the "client"
+ * handed to the port-chain). Either a JackBackend wrapping the clientId, or
+ * the simulated driver.
+ */
+static shared_ptr<MidiBackend> backend;
+/**
+ * The simulated driver of the current session (the same object as "backend"),
+ * empty when connected to the Jack server. Java threads take their own
+ * reference (see getSimulatedBackend), so a concurrent close cannot delete
+ * the driver under their feet.
+ */
+static shared_ptr<SimulatedBackend> simulatedBackend;
+
+/**
+ * The number of frames per cycle and the period of the simulated driver for
+ * the next session; a buffer size of zero selects the Jack server.
+ */
+static atomic<jint> simulatedBufferSize(0);
+static atomic<jlong> simulatedPeriodMicros(0);
+
 /**
  * The "isConnected" flag indicates whether a conection to the Jack server
  * is estabished.
@@ -51,14 +79,140 @@ static atomic<bool> isConnected(false);
  */
 static atomic<bool> isActivated(false);
 
+/**
+ * The "lockFreeHandshake" flag selects the lock-free hand-shake between the native
+ * and the java thread (see Port::setLockFree) for the next session.
+ */
+static atomic<bool> lockFreeHandshake(false);
+
+/**
+ * What the ports do when the java thread is late (see XrunPolicy) in the next
+ * session; the policies other than "delay" imply the lock-free hand-shake.
+ */
+static atomic<jint> xrunPolicy(static_cast<jint> (XrunPolicy::delay));
+
+/**
+ * The window (in microseconds) over which the system-listener collects
+ * connection changes in the next session, zero for no debouncing
+ * (see JackSystemListener).
+ */
+static atomic<jlong> graphDebounceMicros(0);
+
 typedef unique_lock<mutex> Lock;
 static mutex activatedMutex;
 
 class JackPortChain : public PortChain {
+private:
+  /** the java dispatcher (MidiIO4Java.Implementation.CycleDispatcher), NULL unless batched. */
+  jobject dispatcher;
+  jmethodID setPortsMid;
+  jmethodID dispatchMid;
+  jmethodID getFailureMid;
+  /** java.lang.Object (pinned by the registry). */
+  jclass objectClass;
+
 public:
 
   JackPortChain() :
-  PortChain() {
+  PortChain(),
+  dispatcher(NULL),
+  setPortsMid(NULL),
+  dispatchMid(NULL),
+  getFailureMid(NULL),
+  objectClass(NULL) {
+  }
+
+  /**
+   * Selects the batched dispatch through the given java dispatcher: pins the
+   * dispatcher, takes its method identifiers from the registry and hands it
+   * the cycle entries as a direct byte buffer.
+   * @param env the java environment pointer
+   * @param _dispatcher a MidiIO4Java.Implementation.CycleDispatcher
+   */
+  void setDispatcher(JNIEnv * env, jobject _dispatcher) {
+    setBatchedDispatch(true);
+    dispatcher = env->NewGlobalRef(_dispatcher);
+    if (dispatcher == NULL) {
+      THROW("Call to NewGlobalRef function failed.")
+    }
+    const JniRegistry& registry = jniRegistry();
+    objectClass = registry.objectClass;
+    jmethodID setDescriptorMid = registry.setDescriptorMid;
+    setPortsMid = registry.setPortsMid;
+    dispatchMid = registry.dispatchMid;
+    getFailureMid = registry.getFailureMid;
+    if ((objectClass == NULL) || (setDescriptorMid == NULL) || (setPortsMid == NULL)
+            || (dispatchMid == NULL) || (getFailureMid == NULL)) {
+      THROW("Method-identifier not found.")
+    }
+    jobject descriptor = env->NewDirectByteBuffer(dispatchEntries.get(), (jlong) MAX_PORTS * sizeof (CycleEntry));
+    if (descriptor == NULL) {
+      THROW("Could not create a direct byte buffer.")
+    }
+    // java signature: "void setDescriptor(ByteBuffer descriptor)"
+    env->CallVoidMethod(dispatcher, setDescriptorMid, descriptor);
+    jthrowable jexception = env->ExceptionOccurred();
+    if (jexception != NULL) {
+      THROW_JAVA(env, jexception)
+    }
+    env->DeleteLocalRef(descriptor);
+  }
+
+  /**
+   * Releases the java dispatcher (if any).
+   * @param env the java environment pointer
+   */
+  void releaseDispatcher(JNIEnv * env) {
+    if (dispatcher != NULL) {
+      env->DeleteGlobalRef(dispatcher);
+      dispatcher = NULL;
+    }
+    objectClass = NULL;
+  }
+
+protected:
+
+  virtual void dispatchPorts_impl(JNIEnv * env, Port* const* ports, int count) override {
+    jobjectArray peers = env->NewObjectArray(count, objectClass, NULL);
+    if (peers == NULL) {
+      THROW("Out of memory.")
+    }
+    for (int i = 0; i < count; i++) {
+      env->SetObjectArrayElement(peers, i, ports[i]->getDispatchPeer());
+    }
+    // java signature: "void setPorts(Object[] peers)"
+    env->CallVoidMethod(dispatcher, setPortsMid, peers);
+    jthrowable jexception = env->ExceptionOccurred();
+    if (jexception != NULL) {
+      THROW_JAVA(env, jexception)
+    }
+    env->DeleteLocalRef(peers);
+  }
+
+  virtual void dispatchCycle_impl(JNIEnv * env, int count) override {
+    // java signature: "void dispatch(int count)"
+    env->CallVoidMethod(dispatcher, dispatchMid, (jint) count);
+    jthrowable jexception = env->ExceptionOccurred();
+    if (jexception != NULL) {
+      THROW_JAVA(env, jexception)
+    }
+  }
+
+  virtual exception_ptr dispatchFailure_impl(JNIEnv * env, int index) override {
+    try {
+      // java signature: "Throwable getFailure(int index)"
+      jthrowable failure = static_cast<jthrowable> (env->CallObjectMethod(dispatcher, getFailureMid, (jint) index));
+      jthrowable jexception = env->ExceptionOccurred();
+      if (jexception != NULL) {
+        THROW_JAVA(env, jexception)
+      }
+      if (failure == NULL) {
+        THROW("Java dispatch failed.")
+      }
+      THROW_JAVA(env, failure)
+    } catch (...) {
+      return current_exception();
+    }
   }
 };
 
@@ -66,6 +220,105 @@ static unique_ptr<JackPortChain> jackPortChain = unique_ptr<JackPortChain > (new
 
 static JackSystemListener jackSystemListener;
 
+/**
+ * The Midi ports of the Jack server. The lists are fetched (with one call to
+ * "jack_get_ports" per direction) when they are first needed and then served
+ * from memory, until the Jack server reports that a port has been registered
+ * or unregistered (see onPortRegistration).
+ * Note: the lists are seen from the Jack side; our input ports read from Jack's
+ * output ports and vice-versa.
+ */
+class PortListCache {
+private:
+  mutex cacheMutex;
+  atomic<bool> stale;
+  vector<string> jackOutputs;
+  vector<string> jackInputs;
+
+  static void fetch(vector<string>& names, unsigned long flags) {
+    names.clear();
+    const char **ports = jack_get_ports(clientId, nullptr, JACK_DEFAULT_MIDI_TYPE, flags);
+    if (ports == nullptr) {
+      return; // no ports of this kind.
+    }
+    for (int i = 0; ports[i] != nullptr; i++) {
+      names.push_back(ports[i]);
+    }
+    jack_free(ports);
+  }
+
+  /**
+   * Must be called with the cacheMutex locked.
+   */
+  const vector<string>& list(bool jackOutput) {
+    // a registration that arrives while fetching leaves the cache stale.
+    if (stale.exchange(false)) {
+      fetch(jackOutputs, JackPortIsOutput);
+      fetch(jackInputs, JackPortIsInput);
+    }
+    return jackOutput ? jackOutputs : jackInputs;
+  }
+
+public:
+
+  PortListCache() :
+  stale(true) {
+  }
+
+  /**
+   * Marks the lists as outdated. Can be called from any thread (also from
+   * the notification thread of the Jack server).
+   */
+  void invalidate() {
+    stale = true;
+  }
+
+  /**
+   * @param jackOutput true for the output ports of the Jack server (our inputs).
+   * @return the number of ports.
+   */
+  int getCount(bool jackOutput) {
+    Lock lock(cacheMutex);
+    return static_cast<int> (list(jackOutput).size());
+  }
+
+  /**
+   * @param jackOutput true for the output ports of the Jack server (our inputs).
+   * @return the names of all ports.
+   */
+  vector<string> getNames(bool jackOutput) {
+    Lock lock(cacheMutex);
+    return list(jackOutput);
+  }
+
+  /**
+   * @param jackOutput true for the output ports of the Jack server (our inputs).
+   * @param index the index of the port.
+   * @param name receives the name of the port.
+   * @return false if the index is invalid.
+   */
+  bool getName(bool jackOutput, int index, string& name) {
+    Lock lock(cacheMutex);
+    const vector<string>& names = list(jackOutput);
+    if ((index < 0) || (index >= static_cast<int> (names.size()))) {
+      return false;
+    }
+    name = names[index];
+    return true;
+  }
+};
+
+static PortListCache portListCache;
+
+/**
+ * Called by the Jack server (in its notification thread) whenever a port
+ * is registered or unregistered.
+ */
+static void onPortRegistration(jack_port_id_t port, int isRegistered, void*) {
+  portListCache.invalidate();
+  jackSystemListener.onPortRegistration(port, isRegistered);
+}
+
 #endif
 
 /*
@@ -106,27 +359,89 @@ JNIEXPORT jboolean JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1isOp
   return isConnected;
 }
 
-int nativeProcess(jack_nframes_t timeCodeDuration, void* arg) {
+/*
+ * Class:     MidiIO4Java_Implementation_MidiJackNative
+ * Method:    _setLockFreeHandshake
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1setLockFreeHandshake
+(JNIEnv *, jclass, jboolean value) {
+  lockFreeHandshake = value;
+}
+
+/*
+ * Class:     MidiIO4Java_Implementation_MidiJackNative
+ * Method:    _setXrunPolicy
+ * Signature: (I)V
+ * @param policy the ordinal of an XrunPolicy.
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1setXrunPolicy
+(JNIEnv * env, jclass, jint policy) {
+  if ((policy < static_cast<jint> (XrunPolicy::delay)) || (policy > static_cast<jint> (XrunPolicy::merge))) {
+    Util::throwProcessException(env, "Invalid xrun policy.", nullptr);
+    return;
+  }
+  xrunPolicy = policy;
+}
+
+/*
+ * Class:     MidiIO4Java_Implementation_MidiJackNative
+ * Method:    _setGraphDebounce
+ * Signature: (J)V
+ * @param micros the debounce window of the system-listener, zero to report
+ * each batch of changes as soon as possible.
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1setGraphDebounce
+(JNIEnv * env, jclass, jlong micros) {
+  if (micros < 0) {
+    Util::throwProcessException(env, "Invalid debounce window.", nullptr);
+    return;
+  }
+  graphDebounceMicros = micros;
+}
+
+/*
+ * Class:     MidiIO4Java_Implementation_MidiJackNative
+ * Method:    _setSimulatedDriver
+ * Signature: (IJ)V
+ * @param bufferSize the number of frames per cycle, zero to connect to the
+ * Jack server.
+ * @param periodMicros the time between two cycles, zero to run the cycles
+ * back-to-back.
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1setSimulatedDriver
+(JNIEnv *, jclass, jint bufferSize, jlong periodMicros) {
+  simulatedBufferSize = bufferSize;
+  simulatedPeriodMicros = periodMicros;
+}
+
+/**
+ * Executes one native cycle (called by the Jack server or by the simulated driver).
+ */
+static void execNativeCycle(unsigned long timeCodeStart, unsigned long timeCodeDuration) {
   Lock lock(activatedMutex);
   try {
     if (isActivated) {
-      jack_nframes_t timeCodeStart = jack_last_frame_time(clientId);
-      jackPortChain->execNativeCycle(timeCodeStart, timeCodeDuration, clientId);
+      jackPortChain->execNativeCycle(timeCodeStart, timeCodeDuration, backend.get());
     } else {
-      cerr << "!!! Oh my!!! Port-chain not activated in native process\n";
+      rtLog().log(RtLogLevel::warning, "Port-chain not activated in native process.");
     }
   } catch (...) {
-    cerr << "!!! Exception in nativeProcess\n";
+    // should not happen, the ports report their errors through NativeErrorRecords.
+    rtLog().log(RtLogLevel::severe, "Exception in native process.");
   }
+}
 
+int nativeProcess(jack_nframes_t timeCodeDuration, void* arg) {
+  execNativeCycle(jack_last_frame_time(clientId), timeCodeDuration);
   return 0;
-
 }
 
 /**
  * Implements the _open method of the java class
  * MidiIO4Java.Implementation.MidiJackNative.
- * This method connects to the Jack server and registers the portchain,
+ * This method connects to the Jack server (or sets up the simulated driver,
+ * see _setSimulatedDriver) and registers the portchain,
  * but does not activate the Native callback (this will happen in the run method).
  * The calling thread will execute the onOpen callback on the port-listeners.
  * At the end of this procedure:
@@ -135,10 +450,12 @@ int nativeProcess(jack_nframes_t timeCodeDuration, void* arg) {
  * 3) the system listener is in state activated.
  * Class:     MidiIO4Java_Implementation_MidiJackNative
  * Method:    _open
- * Signature: (Ljava/lang/String;)I
+ * Signature: (Ljava/lang/String;LMidiIO4Java/MidiSystemListener;LMidiIO4Java/Implementation/CycleDispatcher;)I
+ * @param jDispatcher selects the batched dispatch (see PortChain::setBatchedDispatch),
+ * NULL to call every port through its own JNI call.
  */
 JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1open
-(JNIEnv * env, jclass, jstring jClientName, jobject jSystemListener) {
+(JNIEnv * env, jclass, jstring jClientName, jobject jSystemListener, jobject jDispatcher) {
   // Note: this procedure is NOT thread safe, it must be protected against
   // concurrent access on open() and close() at the Java side.
   try {
@@ -151,31 +468,56 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1open
     isActivated = false;
 
     clientId = nullptr;
+    atomic_store(&simulatedBackend, shared_ptr<SimulatedBackend>());
+
+    if (simulatedBufferSize > 0) {
+      shared_ptr<SimulatedBackend> simulated =
+              make_shared<SimulatedBackend>(simulatedBufferSize, chrono::microseconds(simulatedPeriodMicros));
+      backend = simulated;
+      atomic_store(&simulatedBackend, simulated);
+      isConnected = true;
+    } else {
+      jack_status_t status;
 
-    jack_status_t status;
-
-    const char* cClientName = env->GetStringUTFChars(jClientName, nullptr);
+      const char* cClientName = env->GetStringUTFChars(jClientName, nullptr);
 
-    clientId = jack_client_open(cClientName, JackNoStartServer, &status);
-    if (status == 0) {
-      if (clientId != nullptr) {
-        isConnected = true;
+      clientId = jack_client_open(cClientName, JackNoStartServer, &status);
+      if (status == 0) {
+        if (clientId != nullptr) {
+          backend = make_shared<JackBackend>(clientId);
+          isConnected = true;
+        }
       }
+      env->ReleaseStringUTFChars(jClientName, cClientName);
     }
-    env->ReleaseStringUTFChars(jClientName, cClientName);
 
 
     if (isConnected) {
-      jack_set_process_callback(clientId, nativeProcess, nullptr);
+      if (clientId != nullptr) {
+        jack_set_process_callback(clientId, nativeProcess, nullptr);
+        portListCache.invalidate();
+        jack_set_port_registration_callback(clientId, onPortRegistration, nullptr);
+      }
 
+      // the batched dispatch and the xrun policies build on the lock-free hand-shake.
+      XrunPolicy policy = static_cast<XrunPolicy> (xrunPolicy.load());
+      jackPortChain->setLockFree(lockFreeHandshake || (jDispatcher != NULL) || (policy != XrunPolicy::delay));
+      jackPortChain->setXrunPolicy(policy);
+      if (jDispatcher != NULL) {
+        jackPortChain->setDispatcher(env, jDispatcher);
+      }
       jackPortChain->initialize(env, jSystemListener,
               unique_ptr<ControlPort > (new ControlPort(false, string("startPort"), -1)), //start control
               unique_ptr<ControlPort > (new ControlPort(true, string("endPort"), -2))); //end control
 
-      jackPortChain->registerAtServer(clientId);
+      jackPortChain->registerAtServer(backend.get());
+      jackPortChain->setFrameRate(backend->getFrameRate());
 
-      jackSystemListener.initialize(env, jSystemListener);
-      jackSystemListener.activate(clientId);
+      jackSystemListener.initialize(env, jSystemListener, chrono::microseconds(graphDebounceMicros.load()));
+      if (clientId != nullptr) {
+        // the simulated driver has no connection graph to report.
+        jackSystemListener.activate(clientId);
+      }
 
       return MidiIO4Java_Implementation_MidiJackNative_noError;
     } else {
@@ -184,6 +526,8 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1open
   } catch (std::exception& ex) {
     isConnected = false;
     clientId = nullptr;
+    atomic_store(&simulatedBackend, shared_ptr<SimulatedBackend>());
+    backend.reset();
     Util::throwProcessException(env, ex.what(), nullptr);
   }
   return -1; // there was an error...
@@ -200,7 +544,7 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1close
   //concurrent access on open() and close() at the Java side.
   //Please note: even after this procedure has ended the nativeProcess-callback
   //might be invoked , therefore do not nullify the jackPortChain-pointer
-  // nor the clientId here.
+  // nor the clientId here (the backend is only released under the activatedMutex).
   try {
     if (!isConnected) {
       return MidiIO4Java_Implementation_MidiJackNative_errorNotOpen;
@@ -213,13 +557,15 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1close
     }
     // disconnect the client from the jack server
     int errorDeactivate = 0;
-    if (isActivated) {
+    if (simulatedBackend) {
+      simulatedBackend->stop();
+    } else if (isActivated) {
       errorDeactivate = jack_deactivate(clientId);
     }
     isActivated = false;
 
     // close the port-chain 
-    jackPortChain->shutdown(env, clientId);
+    jackPortChain->shutdown(env, backend.get());
     exception_ptr processException = jackPortChain->retrieveProcessException();
     isConnected = false;
 
@@ -227,10 +573,19 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1close
     {
       Lock lock(activatedMutex);
       jackSystemListener.shutdown(env, clientId);
+      jackPortChain->releaseDispatcher(env);
       jackPortChain = unique_ptr<JackPortChain > (new JackPortChain());
     }
 
-    int errorClose = jack_client_close(clientId);
+    int errorClose = 0;
+    if (clientId != nullptr) {
+      errorClose = jack_client_close(clientId);
+    }
+    {
+      Lock lock(activatedMutex);
+      atomic_store(&simulatedBackend, shared_ptr<SimulatedBackend>());
+      backend.reset();
+    }
     if (errorClose != 0) {
       THROW("JACK ERROR while closing client")
     }
@@ -250,6 +605,80 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1close
   return -1; // there was an error...
 }
 
+/**
+ * The field identifiers of MidiIO4Java.Implementation.InfoImpl (taken from the
+ * registry) and the constant strings of the port infos. The strings are
+ * created once (see getInfoFields) and pinned for the life-time of the library.
+ */
+struct InfoFields {
+  jfieldID indexFid;
+  jfieldID versionFid;
+  jfieldID descriptionFid;
+  jfieldID vendorFid;
+  jfieldID inputFid;
+  jfieldID nameFid;
+  jstring versionJ;
+  jstring vendorJ;
+  jstring midiInJ;
+  jstring midiOutJ;
+};
+
+static mutex infoFieldsMutex;
+static bool infoFieldsValid = false;
+static InfoFields infoFields;
+
+static jstring newGlobalString(JNIEnv * env, const char* text) {
+  jstring local = env->NewStringUTF(text);
+  if (local == NULL) {
+    THROW("Call to NewStringUTF function failed.")
+  }
+  jstring global = static_cast<jstring> (env->NewGlobalRef(local));
+  env->DeleteLocalRef(local);
+  if (global == NULL) {
+    THROW("Call to NewGlobalRef function failed.")
+  }
+  return global;
+}
+
+/**
+ * @return the field identifiers of InfoImpl and the constant strings.
+ */
+static const InfoFields& getInfoFields(JNIEnv * env) {
+  Lock lock(infoFieldsMutex);
+  if (!infoFieldsValid) {
+    const JniRegistry& registry = jniRegistry();
+    if (!registry.loaded) {
+      THROW("JNI registry not loaded.")
+    }
+    infoFields.indexFid = registry.infoIndexFid;
+    infoFields.versionFid = registry.infoVersionFid;
+    infoFields.descriptionFid = registry.infoDescriptionFid;
+    infoFields.vendorFid = registry.infoVendorFid;
+    infoFields.inputFid = registry.infoInputFid;
+    infoFields.nameFid = registry.infoNameFid;
+    infoFields.versionJ = newGlobalString(env, "0.0");
+    infoFields.vendorJ = newGlobalString(env, "Jack Audio");
+    infoFields.midiInJ = newGlobalString(env, "MIDI_In");
+    infoFields.midiOutJ = newGlobalString(env, "MIDI_Out");
+    infoFieldsValid = true;
+  }
+  return infoFields;
+}
+
+/**
+ * Releases the pinned strings. Called when the library is unloaded.
+ */
+static void releaseInfoFields(JNIEnv * env) {
+  Lock lock(infoFieldsMutex);
+  if (infoFieldsValid) {
+    env->DeleteGlobalRef(infoFields.versionJ);
+    env->DeleteGlobalRef(infoFields.vendorJ);
+    env->DeleteGlobalRef(infoFields.midiInJ);
+    env->DeleteGlobalRef(infoFields.midiOutJ);
+    infoFieldsValid = false;
+  }
+}
+
 /**
  * Fill out the given info-object with data about the given port
  * @param port
@@ -273,25 +702,16 @@ jobject completeInfo(JNIEnv * env, const jack_port_t* port, jobject info) {
     else
       isMineInput = !isJackInput;
 
-    jclass infoCls = env->GetObjectClass(info);
-    jfieldID indexFid = Util::getFieldID(env, infoCls, "index", "I");
-    jfieldID versionFid = Util::getFieldID(env, infoCls, "version", "Ljava/lang/String;");
-    jfieldID descriptionFid = Util::getFieldID(env, infoCls, "description", "Ljava/lang/String;");
-    jfieldID vendorFid = Util::getFieldID(env, infoCls, "vendor", "Ljava/lang/String;");
-    jfieldID inputFid = Util::getFieldID(env, infoCls, "input", "Z");
-    jfieldID nameFid = Util::getFieldID(env, infoCls, "name", "Ljava/lang/String;");
-
+    const InfoFields& fields = getInfoFields(env);
     jstring portNameJ = env->NewStringUTF(portNameC);
-    jstring versionJ = env->NewStringUTF("0.0");
     jstring descriptionJ = env->NewStringUTF(portTypeC);
-    jstring vendorJ = env->NewStringUTF("Jack Audio");
 
-    env->SetIntField(info, indexFid, -1);
-    env->SetBooleanField(info, inputFid, isMineInput);
-    env->SetObjectField(info, nameFid, portNameJ);
-    env->SetObjectField(info, versionFid, versionJ);
-    env->SetObjectField(info, descriptionFid, descriptionJ);
-    env->SetObjectField(info, vendorFid, vendorJ);
+    env->SetIntField(info, fields.indexFid, -1);
+    env->SetBooleanField(info, fields.inputFid, isMineInput);
+    env->SetObjectField(info, fields.nameFid, portNameJ);
+    env->SetObjectField(info, fields.versionFid, fields.versionJ);
+    env->SetObjectField(info, fields.descriptionFid, descriptionJ);
+    env->SetObjectField(info, fields.vendorFid, fields.vendorJ);
 
     // the normal exit, now the template is not empty any more....
     return info;
@@ -313,18 +733,8 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getMidiI
     //synchronized on java side
     return 0;
   }
-  int count = 0;
-
-  // List of available ports (note our inputs are Jack's outputs)
-  const char **ports = jack_get_ports(clientId, nullptr, JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput);
-
-  if (ports == nullptr) return 0;
-  while (ports[count] != nullptr)
-    count++;
-
-  jack_free(ports);
-
-  return count;
+  // (note our inputs are Jack's outputs)
+  return portListCache.getCount(true);
 }
 
 /*
@@ -338,18 +748,34 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getMidiO
     //synchronized on java side
     return 0;
   }
-  int count = 0;
-
-  // List of available ports (note our outputs are Jack's inputs)
-  const char **ports = jack_get_ports(clientId, nullptr, JACK_DEFAULT_MIDI_TYPE, JackPortIsInput);
-
-  if (ports == nullptr) return 0;
-  while (ports[count] != nullptr)
-    count++;
-
-  jack_free(ports);
+  // (note our outputs are Jack's inputs)
+  return portListCache.getCount(false);
+}
 
-  return count;
+/**
+ * Fills the given template with the info of the port at the given index.
+ * @param input true for an input port (a port that Jack lists as output).
+ */
+static jobject fillPortInfo(JNIEnv * env, jint infoIndex, jobject emptyTemplate, bool input) {
+  string portName;
+  if (!portListCache.getName(input, infoIndex, portName)) {
+    ostringstream ost;
+    ost << AT "The 'infoIndex' argument (" << infoIndex << ") is invalid.";
+    throw runtime_error(ost.str());
+  }
+  const InfoFields& fields = getInfoFields(env);
+  jstring nameJ = env->NewStringUTF(portName.c_str());
+
+  env->SetIntField(emptyTemplate, fields.indexFid, infoIndex);
+  env->SetBooleanField(emptyTemplate, fields.inputFid, input);
+  env->SetObjectField(emptyTemplate, fields.nameFid, nameJ);
+  env->SetObjectField(emptyTemplate, fields.versionFid, fields.versionJ);
+  env->SetObjectField(emptyTemplate, fields.descriptionFid, input ? fields.midiInJ : fields.midiOutJ);
+  env->SetObjectField(emptyTemplate, fields.vendorFid, fields.vendorJ);
+  env->DeleteLocalRef(nameJ);
+
+  // the normal exit, now the template is not empty any more....
+  return emptyTemplate;
 }
 
 /*
@@ -364,57 +790,8 @@ JNIEXPORT jobject JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getMi
     //synchronized on java side
     return nullptr;
   }
-
-  ostringstream ost;
-  string retStr("");
-
   try {
-
-    // List of available ports
-    const char **ports = jack_get_ports(clientId, nullptr,
-            JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput);
-
-    // Check port validity
-    if (ports == nullptr) {
-      THROW("Call to System function failed.")
-    }
-    int count = 0;
-    while (ports[count] != nullptr)
-      count++;
-    if ((infoIndex >= count) || (infoIndex < 0)) {
-      ost << AT "The 'infoIndex' argument (" << infoIndex << ") is invalid.";
-      throw runtime_error(ost.str());
-    }
-
-    if (ports[infoIndex] == nullptr) {
-      ost << AT "The 'infoIndex' argument (" << infoIndex << ") is invalid.";
-      throw runtime_error(ost.str());
-    } else retStr.assign(ports[infoIndex]);
-    jack_free(ports);
-
-
-    jclass emptyTemplateCls = env->GetObjectClass(emptyTemplate);
-    jfieldID indexFid = Util::getFieldID(env, emptyTemplateCls, "index", "I");
-    jfieldID versionFid = Util::getFieldID(env, emptyTemplateCls, "version", "Ljava/lang/String;");
-    jfieldID descriptionFid = Util::getFieldID(env, emptyTemplateCls, "description", "Ljava/lang/String;");
-    jfieldID vendorFid = Util::getFieldID(env, emptyTemplateCls, "vendor", "Ljava/lang/String;");
-    jfieldID inputFid = Util::getFieldID(env, emptyTemplateCls, "input", "Z");
-    jfieldID nameFid = Util::getFieldID(env, emptyTemplateCls, "name", "Ljava/lang/String;");
-
-    jstring namej = env->NewStringUTF(retStr.c_str());
-    jstring versionj = env->NewStringUTF("0.0");
-    jstring descriptionj = env->NewStringUTF("MIDI_In");
-    jstring vendorj = env->NewStringUTF("Jack Audio");
-
-    env->SetIntField(emptyTemplate, indexFid, infoIndex);
-    env->SetBooleanField(emptyTemplate, inputFid, true);
-    env->SetObjectField(emptyTemplate, nameFid, namej);
-    env->SetObjectField(emptyTemplate, versionFid, versionj);
-    env->SetObjectField(emptyTemplate, descriptionFid, descriptionj);
-    env->SetObjectField(emptyTemplate, vendorFid, vendorj);
-
-    // the normal exit, now the template is not empty any more....
-    return emptyTemplate;
+    return fillPortInfo(env, infoIndex, emptyTemplate, true);
   } catch (std::exception& ex) {
     Util::throwProcessException(env, ex.what(), nullptr);
   }
@@ -433,70 +810,124 @@ JNIEXPORT jobject JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getMi
     //synchronized on java side
     return nullptr;
   }
-
-  ostringstream ost;
-  string portNameC("");
-
   try {
+    return fillPortInfo(env, infoIndex, emptyTemplate, false);
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+  return nullptr; // there was an error...
+}
 
-    // List of available ports
-    const char **ports = jack_get_ports(clientId, nullptr,
-            JACK_DEFAULT_MIDI_TYPE, JackPortIsInput);
-
-    // Check port validity
-    if (ports == nullptr) {
-      THROW("Call to System function failed.")
+/**
+ * Lists the names of all Midi input ports or of all Midi output ports at once
+ * (a snapshot, see PortListCache).
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._getMidiPortNames
+ * Signature: (Z)[Ljava/lang/String;
+ * @param env pointer to calling the Java thread.
+ * @param input true for the ports an input port can connect to.
+ * @return the names, an empty array if not connected to the Jack server.
+ */
+JNIEXPORT jobjectArray JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getMidiPortNames
+(JNIEnv * env, jclass, jboolean input) {
+  try {
+    vector<string> names;
+    if (clientId != nullptr) {
+      //synchronized on java side
+      names = portListCache.getNames(input);
     }
-    int count = 0;
-    while (ports[count] != nullptr)
-      count++;
-    if ((infoIndex >= count) || (infoIndex < 0)) {
-      ost << AT "The 'infoIndex' argument (" << infoIndex << ") is invalid.";
-      throw runtime_error(ost.str());
+    jclass stringCls = jniRegistry().stringClass;
+    if (stringCls == NULL) {
+      THROW("String class not found.")
     }
+    jobjectArray result = env->NewObjectArray(static_cast<jsize> (names.size()), stringCls, NULL);
+    if (result == NULL) {
+      THROW("Call to NewObjectArray function failed.")
+    }
+    for (size_t i = 0; i < names.size(); i++) {
+      jstring nameJ = env->NewStringUTF(names[i].c_str());
+      env->SetObjectArrayElement(result, static_cast<jsize> (i), nameJ);
+      env->DeleteLocalRef(nameJ);
+    }
+    return result;
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+  return nullptr; // there was an error...
+}
 
-    if (ports[infoIndex] == nullptr) {
-      ost << "MidiJackNative.cpp: the 'infoIndex' argument (" << infoIndex << ") is invalid.";
-      throw runtime_error(ost.str());
-    } else portNameC.assign(ports[infoIndex]);
-    jack_free(ports);
-
-
-    jclass emptyTemplateCls = env->GetObjectClass(emptyTemplate);
-    jfieldID indexFid = Util::getFieldID(env, emptyTemplateCls, "index", "I");
-    jfieldID versionFid = Util::getFieldID(env, emptyTemplateCls, "version", "Ljava/lang/String;");
-    jfieldID descriptionFid = Util::getFieldID(env, emptyTemplateCls, "description", "Ljava/lang/String;");
-    jfieldID vendorFid = Util::getFieldID(env, emptyTemplateCls, "vendor", "Ljava/lang/String;");
-    jfieldID inputFid = Util::getFieldID(env, emptyTemplateCls, "input", "Z");
-    jfieldID nameFid = Util::getFieldID(env, emptyTemplateCls, "name", "Ljava/lang/String;");
-
-    jstring portNameJ = env->NewStringUTF(portNameC.c_str());
-    jstring versionJ = env->NewStringUTF("0.0");
-    jstring descriptionJ = env->NewStringUTF("MIDI_Out");
-    jstring vendorJ = env->NewStringUTF("Jack Audio");
+/**
+ * Connects or disconnects many pairs of ports with one call. The system-listener
+ * is held back while the pairs are processed, so the whole patch is reported
+ * as one change.
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._connectAll
+ * Signature: ([Ljava/lang/String;Z)[I
+ * @param env pointer to calling the Java thread.
+ * @param jPairs the port names: source, destination, source, destination...
+ * @param connect true to connect the pairs, false to disconnect them.
+ * @return for each pair the result of "jack_connect" or "jack_disconnect"
+ * (zero on success, EEXIST if the ports were already connected).
+ */
+JNIEXPORT jintArray JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1connectAll
+(JNIEnv * env, jclass, jobjectArray jPairs, jboolean connect) {
+  try {
+    //synchronized on java side
+    if (clientId == nullptr) {
+      THROW("Connections need the Jack server.")
+    }
+    if (jPairs == nullptr) {
+      THROW("Port names are null.")
+    }
+    jsize nameCount = env->GetArrayLength(jPairs);
+    if ((nameCount % 2) != 0) {
+      THROW("Port names must come in pairs.")
+    }
+    jsize pairCount = nameCount / 2;
+    vector<string> names;
+    names.reserve(2 * pairCount);
+    for (jsize i = 0; i < 2 * pairCount; i++) {
+      jstring nameJ = static_cast<jstring> (env->GetObjectArrayElement(jPairs, i));
+      if (nameJ == NULL) {
+        THROW("Port name is null.")
+      }
+      const char* name = env->GetStringUTFChars(nameJ, nullptr);
+      if (name == nullptr) {
+        env->DeleteLocalRef(nameJ);
+        THROW("Out of memory.")
+      }
+      names.push_back(name);
+      env->ReleaseStringUTFChars(nameJ, name);
+      env->DeleteLocalRef(nameJ);
+    }
 
-    env->SetIntField(emptyTemplate, indexFid, infoIndex);
-    env->SetBooleanField(emptyTemplate, inputFid, false);
-    env->SetObjectField(emptyTemplate, nameFid, portNameJ);
-    env->SetObjectField(emptyTemplate, versionFid, versionJ);
-    env->SetObjectField(emptyTemplate, descriptionFid, descriptionJ);
-    env->SetObjectField(emptyTemplate, vendorFid, vendorJ);
+    vector<jint> results(pairCount);
+    jackSystemListener.suspendNotifications();
+    for (jsize i = 0; i < pairCount; i++) {
+      const char* source = names[2 * i].c_str();
+      const char* destination = names[2 * i + 1].c_str();
+      results[i] = connect ? jack_connect(clientId, source, destination)
+              : jack_disconnect(clientId, source, destination);
+    }
+    jackSystemListener.resumeNotifications();
 
-    // the normal exit, now the template is not empty any more....
-    return emptyTemplate;
+    jintArray result = env->NewIntArray(pairCount);
+    if (result == NULL) {
+      THROW("Call to NewIntArray function failed.")
+    }
+    env->SetIntArrayRegion(result, 0, pairCount, results.data());
+    return result;
   } catch (std::exception& ex) {
     Util::throwProcessException(env, ex.what(), nullptr);
   }
-  return nullptr; // there was an error...
+  return nullptr;
 }
 
 /*
  * Class:     MidiIO4Java_Implementation_MidiJackNative
  * Method:    _createOutputPort
- * Signature: (JLMidiIO4Java/Implementation/InfoImpl;Ljava/lang/String;LMidiIO4Java/Implementation/MidiJackNative/MidiOutputPort;)I
+ * Signature: (JLMidiIO4Java/Implementation/InfoImpl;Ljava/lang/String;LMidiIO4Java/Implementation/MidiJackNative$AbstractOutputPort;I)I
  */
 JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1createOutputPort
-(JNIEnv * env, jclass, jlong portID, jobject emptyTemplate, jstring portNameJ, jobject javaPort) {
+(JNIEnv * env, jclass, jlong portID, jobject emptyTemplate, jstring portNameJ, jobject javaPort, jint eventCapacity) {
   // Note: this procedure is NOT thread safe, it must be protected against
   // concurrent access on open() and close() at the Java side.
   try {
@@ -510,11 +941,11 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1createOu
     const char * portNameC = env->GetStringUTFChars(portNameJ, nullptr);
 
     unique_ptr<Port> newPort =
-            unique_ptr<JackOutputPort > (new JackOutputPort(string(portNameC), portID));
+            unique_ptr<JackOutputPort > (new JackOutputPort(string(portNameC), portID, eventCapacity));
     newPort->initialize(env, portNameJ, javaPort);
     env->ReleaseStringUTFChars(portNameJ, portNameC);
 
-    jackPortChain->addPort(move(newPort), clientId);
+    jackPortChain->addPort(move(newPort), backend.get());
 
 
     /**@ToDo fill-in the template...*/
@@ -532,10 +963,11 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1createOu
 /*
  * Class:     MidiIO4Java_Implementation_MidiJackNative
  * Method:    _createInputPort
- * Signature: (JLMidiIO4Java/Implementation/InfoImpl;Ljava/lang/String;LMidiIO4Java/Implementation/MidiJackNative/JackMidiPort;)I
+ * Signature: (JLMidiIO4Java/Implementation/InfoImpl;Ljava/lang/String;LMidiIO4Java/Implementation/MidiJackNative$AbstractInputPort;III)I
  */
 JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1createInputPort
-(JNIEnv * env, jclass, jlong portID, jobject emptyTemplate, jstring portNameJ, jobject javaPort) {
+(JNIEnv * env, jclass, jlong portID, jobject emptyTemplate, jstring portNameJ, jobject javaPort, jint ringCapacity,
+        jint eventCapacity, jint overflowPolicy) {
   // Note: this procedure is NOT thread safe, it must be protected against
   // concurrent access on open() and close() at the Java side.
   try {
@@ -545,15 +977,20 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1createIn
     if (!static_cast<bool> (jackPortChain)) {
       THROW("Port-chain NULL pointer exception.")
     }
+    if ((overflowPolicy < static_cast<jint> (OverflowPolicy::dropNewest))
+            || (overflowPolicy > static_cast<jint> (OverflowPolicy::spill))) {
+      THROW("Invalid overflow policy.")
+    }
 
     const char * portNameC = env->GetStringUTFChars(portNameJ, nullptr);
 
     unique_ptr<Port> newPort =
-            unique_ptr<JackInputPort > (new JackInputPort(string(portNameC), portID));
+            unique_ptr<JackInputPort > (new JackInputPort(string(portNameC), portID, ringCapacity,
+            eventCapacity, static_cast<OverflowPolicy> (overflowPolicy)));
     newPort->initialize(env, portNameJ, javaPort);
     env->ReleaseStringUTFChars(portNameJ, portNameC);
 
-    jackPortChain->addPort(move(newPort), clientId);
+    jackPortChain->addPort(move(newPort), backend.get());
 
 
     /**@ToDo fill-in the template...*/
@@ -567,6 +1004,344 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1createIn
   return -1; // there was an error...
 }
 
+/**
+ * Retrieves the ring statistics of an asynchronous input port.
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._getRingStatistics
+ * @param env pointer to calling the Java thread.
+ * @param internalPortId the internal identifier of the port 
+ * @param statistics an array of (at least) three elements that receives the 
+ * capacity, the high-water mark and the overflow count of the ring.
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getRingStatistics
+(JNIEnv * env, jclass, jlong internalPortId, jlongArray statistics) {
+  try {
+    if (!static_cast<bool> (jackPortChain)) {
+      THROW("Port-chain NULL pointer exception.")
+    }
+    if ((statistics == nullptr) || (env->GetArrayLength(statistics) < 3)) {
+      THROW("Statistics array too short.")
+    }
+    jlong values[3] = {0, 0, 0};
+    jackPortChain->withPort(internalPortId, [&values](Port & port) {
+      JackInputPort* inputPort = dynamic_cast<JackInputPort*> (&port);
+      if (inputPort != nullptr) {
+        values[0] = inputPort->getRingCapacity();
+        values[1] = inputPort->getRingHighWaterMark();
+        values[2] = inputPort->getRingOverflowCount();
+      }
+    });
+    env->SetLongArrayRegion(statistics, 0, 3, values);
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+}
+
+/**
+ * Retrieves the overflow statistics of an input or an output port.
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._getOverflowStatistics
+ * @param env pointer to calling the Java thread.
+ * @param internalPortId the internal identifier of the port 
+ * @param statistics an array of (at least) five elements that receives the 
+ * current event capacity, the high-water mark of the events per cycle, the
+ * number of dropped events, the number of spilled events and the number of
+ * times the capacity has grown.
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getOverflowStatistics
+(JNIEnv * env, jclass, jlong internalPortId, jlongArray statistics) {
+  try {
+    if (!static_cast<bool> (jackPortChain)) {
+      THROW("Port-chain NULL pointer exception.")
+    }
+    if ((statistics == nullptr) || (env->GetArrayLength(statistics) < 5)) {
+      THROW("Statistics array too short.")
+    }
+    jlong values[5] = {0, 0, 0, 0, 0};
+    auto collect = [&values](int capacity, const EventOverflow & overflow) {
+      values[0] = capacity;
+      values[1] = overflow.getEventHighWaterMark();
+      values[2] = overflow.getDroppedCount();
+      values[3] = overflow.getSpilledCount();
+      values[4] = overflow.getGrowCount();
+    };
+    jackPortChain->withPort(internalPortId, [&collect](Port & port) {
+      JackInputPort* inputPort = dynamic_cast<JackInputPort*> (&port);
+      if (inputPort != nullptr) {
+        collect(inputPort->getEventCapacity(), inputPort->getOverflow());
+      }
+      JackOutputPort* outputPort = dynamic_cast<JackOutputPort*> (&port);
+      if (outputPort != nullptr) {
+        collect(outputPort->getEventCapacity(), outputPort->getOverflow());
+      }
+    });
+    env->SetLongArrayRegion(statistics, 0, 5, values);
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+}
+
+/**
+ * Retrieves the xrun statistics of the port-chain.
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._getXrunStatistics
+ * @param env pointer to calling the Java thread.
+ * @param statistics an array of (at least) 2 + PortChain::recentXrunCapacity 
+ * elements that receives the number of cycles, the number of xruns and
+ * the cycle numbers of the latest xruns (the oldest first, -1 for unused elements).
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getXrunStatistics
+(JNIEnv * env, jclass, jlongArray statistics) {
+  try {
+    if (!static_cast<bool> (jackPortChain)) {
+      THROW("Port-chain NULL pointer exception.")
+    }
+    const int valueCount = 2 + PortChain::recentXrunCapacity;
+    if ((statistics == nullptr) || (env->GetArrayLength(statistics) < valueCount)) {
+      THROW("Statistics array too short.")
+    }
+    unsigned long cycles[PortChain::recentXrunCapacity];
+    int stored = jackPortChain->getRecentXruns(cycles);
+    jlong values[valueCount];
+    values[0] = jackPortChain->getCycleCount();
+    values[1] = jackPortChain->getXrunCount();
+    for (int i = 0; i < PortChain::recentXrunCapacity; i++) {
+      values[2 + i] = (i < stored) ? static_cast<jlong> (cycles[i]) : -1;
+    }
+    env->SetLongArrayRegion(statistics, 0, valueCount, values);
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+}
+
+/**
+ * Retrieves the timing statistics of the cycles of a port (see CycleTiming).
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._getCycleTiming
+ * @param env pointer to calling the Java thread.
+ * @param internalPortId the internal identifier of the port 
+ * @param statistics an array of (at least) 24 elements; for every phase of
+ * the cycle (java delay, java process, native process, slack) six elements
+ * receive the count, the mean, the minimum, the median, the 99th percentile
+ * and the maximum (all durations in nanoseconds).
+ * @param reset if true, the statistics are cleared after being read.
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getCycleTiming
+(JNIEnv * env, jclass, jlong internalPortId, jlongArray statistics, jboolean reset) {
+  try {
+    if (!static_cast<bool> (jackPortChain)) {
+      THROW("Port-chain NULL pointer exception.")
+    }
+    const int valueCount = 6 * CycleTiming::phaseCount;
+    if ((statistics == nullptr) || (env->GetArrayLength(statistics) < valueCount)) {
+      THROW("Statistics array too short.")
+    }
+    jlong values[valueCount] = {};
+    jackPortChain->withPort(internalPortId, [&values, reset](Port & port) {
+      const CycleTiming& timing = port.getCycleTiming();
+      for (int phase = 0; phase < CycleTiming::phaseCount; phase++) {
+        const LatencyHistogram& histogram = timing.get(static_cast<CycleTiming::Phase> (phase));
+        jlong* phaseValues = values + 6 * phase;
+        phaseValues[0] = histogram.getCount();
+        phaseValues[1] = histogram.getMean();
+        phaseValues[2] = histogram.getMin();
+        phaseValues[3] = histogram.getPercentile(50.0);
+        phaseValues[4] = histogram.getPercentile(99.0);
+        phaseValues[5] = histogram.getMax();
+      }
+      if (reset) {
+        port.resetCycleTiming();
+      }
+    });
+    env->SetLongArrayRegion(statistics, 0, valueCount, values);
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+}
+
+/**
+ * Lets a port skip the cycles in which it has no connection (see Port::setSkipWhenIdle).
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._setSkipWhenIdle
+ * Signature: (JZ)V
+ * @param env pointer to calling the Java thread.
+ * @param internalPortId the internal identifier of the port 
+ * @param value true to skip idle cycles.
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1setSkipWhenIdle
+(JNIEnv * env, jclass, jlong internalPortId, jboolean value) {
+  try {
+    if (!static_cast<bool> (jackPortChain)) {
+      THROW("Port-chain NULL pointer exception.")
+    }
+    bool found = jackPortChain->withPort(internalPortId, [value](Port & port) {
+      port.setSkipWhenIdle(value);
+    });
+    if (!found) {
+      THROW("Port not found.")
+    }
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+}
+
+/**
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._getIdleCycleCount
+ * Signature: (J)J
+ * @param env pointer to calling the Java thread.
+ * @param internalPortId the internal identifier of the port 
+ * @return the number of cycles the port has skipped because it was idle.
+ */
+JNIEXPORT jlong JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getIdleCycleCount
+(JNIEnv * env, jclass, jlong internalPortId) {
+  try {
+    if (!static_cast<bool> (jackPortChain)) {
+      THROW("Port-chain NULL pointer exception.")
+    }
+    jlong count = 0;
+    bool found = jackPortChain->withPort(internalPortId, [&count](Port & port) {
+      count = static_cast<jlong> (port.getIdleCycleCount());
+    });
+    if (!found) {
+      THROW("Port not found.")
+    }
+    return count;
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+  return 0;
+}
+
+/**
+ * Replaces the native processing chain of an input or an output port (see midiProcessor.hpp).
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._setProcessors
+ * Signature: (J[I)V
+ * @param env pointer to calling the Java thread.
+ * @param internalPortId the internal identifier of the port 
+ * @param description for every stage, the kind followed by its parameters
+ * (see ProcessorChain::fromDescription); an empty array removes all stages.
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1setProcessors
+(JNIEnv * env, jclass, jlong internalPortId, jintArray description) {
+  try {
+    if (!static_cast<bool> (jackPortChain)) {
+      THROW("Port-chain NULL pointer exception.")
+    }
+    if (description == nullptr) {
+      THROW("Processor description is null.")
+    }
+    jsize length = env->GetArrayLength(description);
+    vector<jint> values(length);
+    env->GetIntArrayRegion(description, 0, length, values.data());
+    unique_ptr<ProcessorChain> chain = ProcessorChain::fromDescription(values.data(), length);
+    bool found = jackPortChain->withPort(internalPortId, [&chain](Port & port) {
+      JackInputPort* inputPort = dynamic_cast<JackInputPort*> (&port);
+      if (inputPort != nullptr) {
+        inputPort->setProcessors(move(chain));
+      }
+      JackOutputPort* outputPort = dynamic_cast<JackOutputPort*> (&port);
+      if (outputPort != nullptr) {
+        outputPort->setProcessors(move(chain));
+      }
+    });
+    if (!found) {
+      THROW("Port not found.")
+    }
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+}
+
+/**
+ * Sets (or replaces) a native thru-route from an input port to an output port
+ * (see PortChain::setRoute).
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._setRoute
+ * Signature: (JJ[I)V
+ * @param env pointer to calling the Java thread.
+ * @param inputPortId the internal identifier of the input port
+ * @param outputPortId the internal identifier of the output port
+ * @param description the processing of the routed events (see ProcessorChain::fromDescription);
+ * an empty array routes the events unchanged.
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1setRoute
+(JNIEnv * env, jclass, jlong inputPortId, jlong outputPortId, jintArray description) {
+  try {
+    if (!static_cast<bool> (jackPortChain)) {
+      THROW("Port-chain NULL pointer exception.")
+    }
+    if (description == nullptr) {
+      THROW("Processor description is null.")
+    }
+    jsize length = env->GetArrayLength(description);
+    vector<jint> values(length);
+    env->GetIntArrayRegion(description, 0, length, values.data());
+    jackPortChain->setRoute(inputPortId, outputPortId, ProcessorChain::fromDescription(values.data(), length));
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+}
+
+/**
+ * Removes a native thru-route.
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._removeRoute
+ * Signature: (JJ)Z
+ * @param env pointer to calling the Java thread.
+ * @param inputPortId the internal identifier of the input port
+ * @param outputPortId the internal identifier of the output port
+ * @return false if there was no such route.
+ */
+JNIEXPORT jboolean JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1removeRoute
+(JNIEnv * env, jclass, jlong inputPortId, jlong outputPortId) {
+  try {
+    if (!static_cast<bool> (jackPortChain)) {
+      THROW("Port-chain NULL pointer exception.")
+    }
+    return jackPortChain->removeRoute(inputPortId, outputPortId) ? JNI_TRUE : JNI_FALSE;
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+  return JNI_FALSE;
+}
+
+/**
+ * The number of lost log records that have already been reported.
+ */
+static unsigned long reportedLostLogRecords = 0;
+
+/**
+ * Takes the oldest record of the native log (see rtLog.hpp). Must not be
+ * called concurrently (the java side serializes the calls).
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._takeLogRecord
+ * Signature: ([I)Ljava/lang/String;
+ * @param env pointer to calling the Java thread.
+ * @param level an array of (at least) one element that receives the ordinal of the RtLogLevel.
+ * @return the text of the record, null if the log is empty.
+ */
+JNIEXPORT jstring JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1takeLogRecord
+(JNIEnv * env, jclass, jintArray level) {
+  try {
+    if ((level == nullptr) || (env->GetArrayLength(level) < 1)) {
+      THROW("Level array too short.")
+    }
+    string text;
+    jint levelValue;
+    RtLogRecord record;
+    unsigned long lost = rtLog().getDroppedCount();
+    if (lost > reportedLostLogRecords) {
+      ostringstream message;
+      message << (lost - reportedLostLogRecords) << " native log records lost (log full).";
+      reportedLostLogRecords = lost;
+      text = message.str();
+      levelValue = static_cast<jint> (RtLogLevel::warning);
+    } else if (rtLog().take(record)) {
+      text = record.toString();
+      levelValue = static_cast<jint> (record.level);
+    } else {
+      return nullptr;
+    }
+    env->SetIntArrayRegion(level, 0, 1, &levelValue);
+    return env->NewStringUTF(text.c_str());
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+  return nullptr;
+}
+
 /**
  * Close a Port. It is assumed that the given portId belongs to a port hooked
  * into the current portchain. The given portId is searched in the portchain.
@@ -587,7 +1362,7 @@ JNIEXPORT jint JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1closePor
       THROW("Port-chain NULL pointer exception.")
     }
 
-    unique_ptr<Port> removedPort = move(jackPortChain->removePort(env, clientId, internalPortId));
+    unique_ptr<Port> removedPort = move(jackPortChain->removePort(env, backend.get(), internalPortId));
     if (removedPort->hasProcessException()) {
       rethrow_exception(removedPort->getProcessException());
     }
@@ -652,7 +1427,11 @@ JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1run
       Lock lock(activatedMutex);
       //start the Native callback loop
       jackPortChain->start();
-      err = jack_activate(clientId);
+      if (simulatedBackend) {
+        simulatedBackend->start(execNativeCycle);
+      } else {
+        err = jack_activate(clientId);
+      }
       if (err != 0) {
         THROW("Could not activate client.");
       }
@@ -683,8 +1462,271 @@ JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1waitForC
   }
 }
 
+/**
+ * @return the simulated driver of the current session.
+ */
+static shared_ptr<SimulatedBackend> getSimulatedBackend() {
+  shared_ptr<SimulatedBackend> simulated = atomic_load(&simulatedBackend);
+  if (!simulated) {
+    THROW("The simulated driver is not open.")
+  }
+  return simulated;
+}
+
+/**
+ * Schedules an event for an input port of the simulated driver.
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._injectSimulatedEvent
+ * Signature: (Ljava/lang/String;J[B)Z
+ * @param portNameJ the name of the input port.
+ * @param timeCode the (absolute) time-code of the event.
+ * @param midi the Midi bytes of the event.
+ * @return false if there is no input port of this name.
+ */
+JNIEXPORT jboolean JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1injectSimulatedEvent
+(JNIEnv * env, jclass, jstring portNameJ, jlong timeCode, jbyteArray midi) {
+  try {
+    shared_ptr<SimulatedBackend> simulated = getSimulatedBackend();
+    if ((portNameJ == nullptr) || (midi == nullptr)) {
+      THROW("Invalid null pointer.")
+    }
+    jsize length = env->GetArrayLength(midi);
+    vector<uint8_t> bytes(length);
+    env->GetByteArrayRegion(midi, 0, length, reinterpret_cast<jbyte*> (bytes.data()));
+
+    const char * portNameC = env->GetStringUTFChars(portNameJ, nullptr);
+    string portName(portNameC);
+    env->ReleaseStringUTFChars(portNameJ, portNameC);
+
+    return simulated->inject(portName, static_cast<unsigned long> (timeCode), bytes.data(), bytes.size());
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+  return false;
+}
+
+/**
+ * Hands out the events the simulated driver has captured on an output port.
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._takeSimulatedOutput
+ * Signature: (Ljava/lang/String;)[B
+ * @param portNameJ the name of the output port.
+ * @return the events one after the other, each one as the time-code (8 bytes,
+ * big endian), the length (4 bytes, big endian) and the Midi bytes.
+ */
+JNIEXPORT jbyteArray JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1takeSimulatedOutput
+(JNIEnv * env, jclass, jstring portNameJ) {
+  try {
+    shared_ptr<SimulatedBackend> simulated = getSimulatedBackend();
+    if (portNameJ == nullptr) {
+      THROW("Port-name is null.")
+    }
+    const char * portNameC = env->GetStringUTFChars(portNameJ, nullptr);
+    string portName(portNameC);
+    env->ReleaseStringUTFChars(portNameJ, portNameC);
+
+    vector<uint8_t> packed;
+    for (const SimulatedBackend::TimedEvent& event : simulated->takeCaptured(portName)) {
+      uint64_t time = event.time;
+      for (int shift = 56; shift >= 0; shift -= 8) {
+        packed.push_back(static_cast<uint8_t> (time >> shift));
+      }
+      uint32_t length = static_cast<uint32_t> (event.midi.size());
+      for (int shift = 24; shift >= 0; shift -= 8) {
+        packed.push_back(static_cast<uint8_t> (length >> shift));
+      }
+      packed.insert(packed.end(), event.midi.begin(), event.midi.end());
+    }
+    jbyteArray result = env->NewByteArray(static_cast<jsize> (packed.size()));
+    if (result == NULL) {
+      THROW("Out of memory.")
+    }
+    env->SetByteArrayRegion(result, 0, static_cast<jsize> (packed.size()), reinterpret_cast<const jbyte*> (packed.data()));
+    return result;
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+  return nullptr;
+}
+
+/**
+ * Retrieves the cycle statistics of the simulated driver.
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._getSimulatedStatistics
+ * Signature: ([J)V
+ * @param statistics an array of (at least) three elements that receives the
+ * number of cycles, the longest and the total time (in nanoseconds) spent
+ * in the native cycle.
+ */
+JNIEXPORT void JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getSimulatedStatistics
+(JNIEnv * env, jclass, jlongArray statistics) {
+  try {
+    shared_ptr<SimulatedBackend> simulated = getSimulatedBackend();
+    if ((statistics == nullptr) || (env->GetArrayLength(statistics) < 3)) {
+      THROW("Invalid statistics array.")
+    }
+    jlong values[3];
+    values[0] = static_cast<jlong> (simulated->getCycleCount());
+    values[1] = static_cast<jlong> (simulated->getLongestCycle().count());
+    values[2] = static_cast<jlong> (simulated->getTotalCycleTime().count());
+    env->SetLongArrayRegion(statistics, 0, 3, values);
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+}
+
+/**
+ * Lists the ports registered at the simulated driver.
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._getSimulatedPortNames
+ * Signature: (Z)[Ljava/lang/String;
+ * @param input true to list the input ports, false for the output ports.
+ * @return the names of the ports, in the order they have been created.
+ */
+JNIEXPORT jobjectArray JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1getSimulatedPortNames
+(JNIEnv * env, jclass, jboolean input) {
+  try {
+    shared_ptr<SimulatedBackend> simulated = getSimulatedBackend();
+    vector<string> names = simulated->getPortNames(input);
+    jclass stringClass = jniRegistry().stringClass;
+    if (stringClass == NULL) {
+      THROW("Class String not found.")
+    }
+    jobjectArray result = env->NewObjectArray(static_cast<jsize> (names.size()), stringClass, NULL);
+    if (result == NULL) {
+      THROW("Out of memory.")
+    }
+    for (size_t i = 0; i < names.size(); i++) {
+      jstring name = env->NewStringUTF(names[i].c_str());
+      env->SetObjectArrayElement(result, static_cast<jsize> (i), name);
+      env->DeleteLocalRef(name);
+    }
+    return result;
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+  return nullptr;
+}
+
+/**
+ * Blocks until the simulated driver has processed all cycles up to the given
+ * time-code.
+ * Implements: MidiIO4Java.Implementation.MidiJackNative._waitForSimulatedTimeCode
+ * Signature: (JJ)Z
+ * @param timeCode the time-code to wait for.
+ * @param timeoutMillis the maximum time to wait.
+ * @return false if the time-code has not been reached within the timeout.
+ */
+JNIEXPORT jboolean JNICALL Java_MidiIO4Java_Implementation_MidiJackNative__1waitForSimulatedTimeCode
+(JNIEnv * env, jclass, jlong timeCode, jlong timeoutMillis) {
+  try {
+    shared_ptr<SimulatedBackend> simulated = getSimulatedBackend();
+    return simulated->waitForTimeCode(static_cast<unsigned long> (timeCode), chrono::milliseconds(timeoutMillis));
+  } catch (std::exception& ex) {
+    Util::throwProcessException(env, ex.what(), nullptr);
+  }
+  return false;
+}
+
 #endif // with Jack
 
+#define NATIVE_METHOD(name, signature) \
+  {const_cast<char*> (#name), const_cast<char*> (signature), reinterpret_cast<void*> (Java_MidiIO4Java_Implementation_MidiJackNative_##name)}
+
+#define INFO "LMidiIO4Java/Implementation/InfoImpl;"
+#define STRING "Ljava/lang/String;"
 
+/**
+ * The native methods of MidiIO4Java.Implementation.MidiJackNative. They are
+ * registered explicitly in JNI_OnLoad, so the virtual machine does not have to
+ * search the library for the symbols on the first call of each method.
+ * (The JNI name-mangling turns "_open" into "_1open", hence the "1" below.)
+ */
+static JNINativeMethod jackNativeMethods[] = {
+  NATIVE_METHOD(_1isAvailable, "()Z"),
+#ifdef WITH_JACK
+  NATIVE_METHOD(_1isOpen, "()Z"),
+  NATIVE_METHOD(_1setLockFreeHandshake, "(Z)V"),
+  NATIVE_METHOD(_1setXrunPolicy, "(I)V"),
+  NATIVE_METHOD(_1setGraphDebounce, "(J)V"),
+  NATIVE_METHOD(_1setSimulatedDriver, "(IJ)V"),
+  NATIVE_METHOD(_1open, "(" STRING "LMidiIO4Java/MidiSystemListener;LMidiIO4Java/Implementation/CycleDispatcher;)I"),
+  NATIVE_METHOD(_1close, "()I"),
+  NATIVE_METHOD(_1getMidiInputPortCount, "()I"),
+  NATIVE_METHOD(_1getMidiOutputPortCount, "()I"),
+  NATIVE_METHOD(_1getMidiInputPortInfo, "(I" INFO ")LMidiIO4Java/MidiPort$Info;"),
+  NATIVE_METHOD(_1getMidiOutputPortInfo, "(I" INFO ")LMidiIO4Java/MidiPort$Info;"),
+  NATIVE_METHOD(_1getMidiPortNames, "(Z)[" STRING),
+  NATIVE_METHOD(_1connectAll, "([" STRING "Z)[I"),
+  NATIVE_METHOD(_1createOutputPort, "(J" INFO STRING "LMidiIO4Java/Implementation/MidiJackNative$AbstractOutputPort;I)I"),
+  NATIVE_METHOD(_1createInputPort, "(J" INFO STRING "LMidiIO4Java/Implementation/MidiJackNative$AbstractInputPort;III)I"),
+  NATIVE_METHOD(_1getRingStatistics, "(J[J)V"),
+  NATIVE_METHOD(_1getOverflowStatistics, "(J[J)V"),
+  NATIVE_METHOD(_1getXrunStatistics, "([J)V"),
+  NATIVE_METHOD(_1getCycleTiming, "(J[JZ)V"),
+  NATIVE_METHOD(_1setProcessors, "(J[I)V"),
+  NATIVE_METHOD(_1setSkipWhenIdle, "(JZ)V"),
+  NATIVE_METHOD(_1getIdleCycleCount, "(J)J"),
+  NATIVE_METHOD(_1setRoute, "(JJ[I)V"),
+  NATIVE_METHOD(_1removeRoute, "(JJ)Z"),
+  NATIVE_METHOD(_1takeLogRecord, "([I)" STRING),
+  NATIVE_METHOD(_1closePort, "(J)I"),
+  NATIVE_METHOD(_1isClosedPort, "(J)Z"),
+  NATIVE_METHOD(_1run, "()V"),
+  NATIVE_METHOD(_1waitForCycleDone, "()V"),
+  NATIVE_METHOD(_1injectSimulatedEvent, "(" STRING "J[B)Z"),
+  NATIVE_METHOD(_1takeSimulatedOutput, "(" STRING ")[B"),
+  NATIVE_METHOD(_1getSimulatedStatistics, "([J)V"),
+  NATIVE_METHOD(_1getSimulatedPortNames, "(Z)[" STRING),
+  NATIVE_METHOD(_1waitForSimulatedTimeCode, "(JJ)Z"),
+#endif // with Jack
+};
 
+#undef STRING
+#undef INFO
+#undef NATIVE_METHOD
 
+/**
+ * Called by the virtual machine when the library is loaded. Resolves the
+ * java identifiers (see jniRegistry.hpp) and registers the native methods.
+ * @return the JNI version needed, or JNI_ERR if a class or method is missing.
+ */
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM * vm, void *) {
+  JNIEnv * env = nullptr;
+  if (vm->GetEnv(reinterpret_cast<void**> (&env), JNI_VERSION_1_6) != JNI_OK) {
+    return JNI_ERR;
+  }
+  jclass nativeClass = env->FindClass("MidiIO4Java/Implementation/MidiJackNative");
+  if (nativeClass == nullptr) {
+    return JNI_ERR;
+  }
+  jint registered = env->RegisterNatives(nativeClass, jackNativeMethods,
+          static_cast<jint> (sizeof (jackNativeMethods) / sizeof (jackNativeMethods[0])));
+  env->DeleteLocalRef(nativeClass);
+  if (registered != JNI_OK) {
+    return JNI_ERR;
+  }
+#ifdef WITH_JACK
+  try {
+    jniRegistry().load(env);
+  } catch (std::exception&) {
+    if (env->ExceptionCheck()) {
+      env->ExceptionClear();
+    }
+    rtLog().log(RtLogLevel::severe, "Could not resolve the java identifiers in JNI_OnLoad.");
+    return JNI_ERR;
+  }
+#endif // with Jack
+  return JNI_VERSION_1_6;
+}
+
+/**
+ * Called by the virtual machine when the class-loader of the library is
+ * garbage collected.
+ */
+JNIEXPORT void JNICALL JNI_OnUnload(JavaVM * vm, void *) {
+  JNIEnv * env = nullptr;
+  if (vm->GetEnv(reinterpret_cast<void**> (&env), JNI_VERSION_1_6) != JNI_OK) {
+    return;
+  }
+#ifdef WITH_JACK
+  releaseInfoFields(env);
+  jniRegistry().unload(env);
+#endif // with Jack
+}
@@ -0,0 +1,238 @@
+/*
+ * File:   jniRegistry.hpp
+ *
+ * Created on October 16, 2026, 11:20 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef JNIREGISTRY_HPP
+#define	JNIREGISTRY_HPP
+
+#include <jni.h>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+/**
+ * The java classes, methods and fields the native library uses. They are
+ * resolved once, when the library is loaded (see JNI_OnLoad in jackNative.cpp);
+ * the classes are pinned, so the identifiers stay valid as long as the library
+ * is loaded. So neither the creation of a port nor the report of an error
+ * needs to look anything up, and no thread has to call "FindClass" (which
+ * would search the wrong class-loader on a thread attached by the native side).
+ * </p>
+ * <p>
+ * Until "load" has succeeded (for example in the unit tests) all entries are NULL.
+ * </p>
+ */
+class JniRegistry {
+public:
+
+  /** The call-backs of a direct port (MidiJackNative$DirectMidiInputPort or $DirectMidiOutputPort). */
+  struct DirectPortMethods {
+    jmethodID onOpen;
+    jmethodID onClose;
+    jmethodID processDirect;
+    jmethodID setEventBuffers;
+  };
+
+  bool loaded;
+
+  jclass objectClass;
+  jclass stringClass;
+  jclass exceptionClass;
+
+  /** MidiIO4Java.MidiProcessException and its constructor (String message, Throwable cause). */
+  jclass processExceptionClass;
+  jmethodID processExceptionInit;
+
+  /** the fields of MidiIO4Java.Implementation.InfoImpl. */
+  jclass infoClass;
+  jfieldID infoIndexFid;
+  jfieldID infoVersionFid;
+  jfieldID infoDescriptionFid;
+  jfieldID infoVendorFid;
+  jfieldID infoInputFid;
+  jfieldID infoNameFid;
+
+  /** the call-backs of MidiIO4Java.MidiSystemListener. */
+  jclass systemListenerClass;
+  jmethodID onOpenMid;
+  jmethodID onCycleStartMid;
+  jmethodID onCycleEndMid;
+  jmethodID onCloseMid;
+  jmethodID onConnectionChangedMid;
+
+  /** MidiIO4Java.MidiGraphListener and MidiIO4Java.MidiGraph (see JackSystemListener). */
+  jclass graphListenerClass;
+  jmethodID onGraphChangedMid;
+  jclass graphClass;
+  jmethodID graphInit;
+
+  jclass directInputPortClass;
+  DirectPortMethods directInputPort;
+  jclass directOutputPortClass;
+  DirectPortMethods directOutputPort;
+
+  /** the methods of MidiIO4Java.Implementation.CycleDispatcher. */
+  jclass dispatcherClass;
+  jmethodID setDescriptorMid;
+  jmethodID setPortsMid;
+  jmethodID dispatchMid;
+  jmethodID getFailureMid;
+
+private:
+
+  /**
+   * Finds and pins a class.
+   */
+  static jclass pinClass(JNIEnv * env, const char* name) {
+    jclass local = env->FindClass(name);
+    if (local == NULL) {
+      throw runtime_error("No such class: " + string(name));
+    }
+    jclass global = static_cast<jclass> (env->NewGlobalRef(local));
+    env->DeleteLocalRef(local);
+    if (global == NULL) {
+      throw runtime_error("Call to NewGlobalRef function failed.");
+    }
+    return global;
+  }
+
+  static jmethodID method(JNIEnv * env, jclass cls, const char* name, const char* sig) {
+    jmethodID result = env->GetMethodID(cls, name, sig);
+    if (result == NULL) {
+      throw runtime_error("No such method: Name(" + string(name) + ")");
+    }
+    return result;
+  }
+
+  static jfieldID field(JNIEnv * env, jclass cls, const char* name, const char* sig) {
+    jfieldID result = env->GetFieldID(cls, name, sig);
+    if (result == NULL) {
+      throw runtime_error("No such field: Name(" + string(name) + ")");
+    }
+    return result;
+  }
+
+  static DirectPortMethods directPortMethods(JNIEnv * env, jclass cls, const char* processDirectSig) {
+    DirectPortMethods methods;
+    methods.onOpen = method(env, cls, "onOpen", "()V");
+    methods.onClose = method(env, cls, "onClose", "()V");
+    methods.processDirect = method(env, cls, "processDirect", processDirectSig);
+    methods.setEventBuffers = method(env, cls, "setEventBuffers", "(Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;)V");
+    return methods;
+  }
+
+  void clear() {
+    loaded = false;
+    objectClass = stringClass = exceptionClass = processExceptionClass = NULL;
+    infoClass = systemListenerClass = graphListenerClass = graphClass = directInputPortClass = directOutputPortClass = dispatcherClass = NULL;
+    processExceptionInit = NULL;
+    infoIndexFid = infoVersionFid = infoDescriptionFid = infoVendorFid = infoInputFid = infoNameFid = NULL;
+    onOpenMid = onCycleStartMid = onCycleEndMid = onCloseMid = onConnectionChangedMid = NULL;
+    onGraphChangedMid = graphInit = NULL;
+    directInputPort = directOutputPort = DirectPortMethods{NULL, NULL, NULL, NULL};
+    setDescriptorMid = setPortsMid = dispatchMid = getFailureMid = NULL;
+  }
+
+public:
+
+  JniRegistry() {
+    clear();
+  }
+
+  JniRegistry(const JniRegistry&) = delete;
+
+  /**
+   * Resolves all entries. To be called once, when the library is loaded.
+   * @param env the environment of the thread that loads the library.
+   * @throw runtime_error if a class, a method or a field is missing.
+   */
+  void load(JNIEnv * env) {
+    try {
+      objectClass = pinClass(env, "java/lang/Object");
+      stringClass = pinClass(env, "java/lang/String");
+      exceptionClass = pinClass(env, "java/lang/Exception");
+
+      processExceptionClass = pinClass(env, "MidiIO4Java/MidiProcessException");
+      processExceptionInit = method(env, processExceptionClass, "<init>", "(Ljava/lang/String;Ljava/lang/Throwable;)V");
+
+      infoClass = pinClass(env, "MidiIO4Java/Implementation/InfoImpl");
+      infoIndexFid = field(env, infoClass, "index", "I");
+      infoVersionFid = field(env, infoClass, "version", "Ljava/lang/String;");
+      infoDescriptionFid = field(env, infoClass, "description", "Ljava/lang/String;");
+      infoVendorFid = field(env, infoClass, "vendor", "Ljava/lang/String;");
+      infoInputFid = field(env, infoClass, "input", "Z");
+      infoNameFid = field(env, infoClass, "name", "Ljava/lang/String;");
+
+      systemListenerClass = pinClass(env, "MidiIO4Java/MidiSystemListener");
+      onOpenMid = method(env, systemListenerClass, "onOpen", "()V");
+      onCycleStartMid = method(env, systemListenerClass, "onCycleStart", "(JJZ)V");
+      onCycleEndMid = method(env, systemListenerClass, "onCycleEnd", "(JJZ)V");
+      onCloseMid = method(env, systemListenerClass, "onClose", "()V");
+      onConnectionChangedMid = method(env, systemListenerClass, "onConnectionChanged", "()V");
+
+      graphListenerClass = pinClass(env, "MidiIO4Java/MidiGraphListener");
+      onGraphChangedMid = method(env, graphListenerClass, "onGraphChanged", "(LMidiIO4Java/MidiGraph;)V");
+      graphClass = pinClass(env, "MidiIO4Java/MidiGraph");
+      graphInit = method(env, graphClass, "<init>", "(J[Ljava/lang/String;[Ljava/lang/String;"
+              "[Ljava/lang/String;[Ljava/lang/String;[Ljava/lang/String;[Ljava/lang/String;)V");
+
+      directInputPortClass = pinClass(env, "MidiIO4Java/Implementation/MidiJackNative$DirectMidiInputPort");
+      directInputPort = directPortMethods(env, directInputPortClass, "(JJZI)V");
+      directOutputPortClass = pinClass(env, "MidiIO4Java/Implementation/MidiJackNative$DirectMidiOutputPort");
+      directOutputPort = directPortMethods(env, directOutputPortClass, "(JJZ)J");
+
+      dispatcherClass = pinClass(env, "MidiIO4Java/Implementation/CycleDispatcher");
+      setDescriptorMid = method(env, dispatcherClass, "setDescriptor", "(Ljava/nio/ByteBuffer;)V");
+      setPortsMid = method(env, dispatcherClass, "setPorts", "([Ljava/lang/Object;)V");
+      dispatchMid = method(env, dispatcherClass, "dispatch", "(I)V");
+      getFailureMid = method(env, dispatcherClass, "getFailure", "(I)Ljava/lang/Throwable;");
+    } catch (...) {
+      unload(env);
+      throw;
+    }
+    loaded = true;
+  }
+
+  /**
+   * Releases the pinned classes. To be called when the library is unloaded.
+   */
+  void unload(JNIEnv * env) {
+    jclass pinned[] = {objectClass, stringClass, exceptionClass, processExceptionClass, infoClass,
+      systemListenerClass, graphListenerClass, graphClass, directInputPortClass, directOutputPortClass, dispatcherClass};
+    for (jclass cls : pinned) {
+      if (cls != NULL) {
+        env->DeleteGlobalRef(cls);
+      }
+    }
+    clear();
+  }
+};
+
+/**
+ * @return the registry of the native library.
+ */
+inline JniRegistry& jniRegistry() {
+  static JniRegistry registry;
+  return registry;
+}
+
+#endif	/* JNIREGISTRY_HPP */
+
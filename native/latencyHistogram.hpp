@@ -0,0 +1,244 @@
+/*
+ * File:   latencyHistogram.hpp
+ *
+ * Created on October 16, 2026, 6:40 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef LATENCYHISTOGRAM_HPP
+#define	LATENCYHISTOGRAM_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+using namespace std;
+
+/**
+ * A histogram of durations (in nanoseconds) in the manner of the HdrHistogram:
+ * the buckets are log-linear, every power of two is divided into 16 buckets,
+ * so a recorded value is known with a precision of about 6 percent over
+ * the whole range (up to about 18 minutes).
+ * </p>
+ * <p>
+ * The buckets are allocated with the histogram; "record" only increments
+ * atomic counters, it never allocates, never locks and never waits, so it can
+ * be used from within the real-time thread. The reading functions can be called
+ * from any thread at any time; while the histogram is being recorded they
+ * see a slightly inconsistent state (e.g. a count that is one higher than
+ * the sum of the buckets).
+ * </p>
+ */
+class LatencyHistogram {
+private:
+  /** Every power of two is divided into 2^subBucketBits buckets. */
+  static const int subBucketBits = 4;
+  static const int subBucketCount = 1 << subBucketBits;
+  /** Values with more significant bits are recorded as the highest value. */
+  static const int valueBits = 40;
+  static const uint64_t highestValue = (uint64_t(1) << valueBits) - 1;
+
+public:
+  static const int bucketCount = (valueBits - subBucketBits) * subBucketCount + subBucketCount;
+
+private:
+  atomic<uint64_t> buckets[bucketCount];
+  atomic<uint64_t> count;
+  atomic<uint64_t> sum;
+  atomic<uint64_t> minimum;
+  atomic<uint64_t> maximum;
+
+  static int mostSignificantBit(uint64_t value) {
+#ifdef __GNUC__
+    return 63 - __builtin_clzll(value);
+#else
+    int msb = 0;
+    while (value >>= 1) {
+      msb++;
+    }
+    return msb;
+#endif
+  }
+
+public:
+
+  LatencyHistogram() {
+    reset();
+  }
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+
+  /**
+   * @param value a duration in nanoseconds.
+   * @return the index of the bucket that counts the given value.
+   */
+  static int indexOf(uint64_t value) {
+    if (value > highestValue) {
+      value = highestValue;
+    }
+    if (value < 2 * subBucketCount) {
+      return static_cast<int> (value);
+    }
+    int shift = mostSignificantBit(value) - subBucketBits;
+    return shift * subBucketCount + static_cast<int> (value >> shift);
+  }
+
+  /**
+   * @param index a bucket index.
+   * @return the highest value that is counted in the given bucket.
+   */
+  static uint64_t highestEquivalent(int index) {
+    if (index < 2 * subBucketCount) {
+      return index;
+    }
+    int shift = index / subBucketCount - 1;
+    uint64_t mantissa = index % subBucketCount + subBucketCount;
+    return ((mantissa + 1) << shift) - 1;
+  }
+
+  /**
+   * Counts the given duration (real-time safe).
+   * @param nanos a duration in nanoseconds.
+   */
+  void record(uint64_t nanos) {
+    buckets[indexOf(nanos)].fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(nanos, memory_order_relaxed);
+    uint64_t current = maximum.load(memory_order_relaxed);
+    while ((nanos > current) && !maximum.compare_exchange_weak(current, nanos, memory_order_relaxed)) {
+    }
+    current = minimum.load(memory_order_relaxed);
+    while ((nanos < current) && !minimum.compare_exchange_weak(current, nanos, memory_order_relaxed)) {
+    }
+    count.fetch_add(1, memory_order_release);
+  }
+
+  /**
+   * Counts the given duration, negative durations count as zero.
+   */
+  template<class Rep, class Period>
+  void record(chrono::duration<Rep, Period> duration) {
+    auto nanos = chrono::duration_cast<chrono::nanoseconds>(duration).count();
+    record(static_cast<uint64_t> (nanos < 0 ? 0 : nanos));
+  }
+
+  /**
+   * Clears the histogram. Values that are recorded concurrently might
+   * partly survive.
+   */
+  void reset() {
+    for (auto &bucket : buckets) {
+      bucket.store(0, memory_order_relaxed);
+    }
+    sum.store(0, memory_order_relaxed);
+    minimum.store(numeric_limits<uint64_t>::max(), memory_order_relaxed);
+    maximum.store(0, memory_order_relaxed);
+    count.store(0, memory_order_release);
+  }
+
+  /** @return the number of recorded values. */
+  uint64_t getCount() const {
+    return count.load(memory_order_acquire);
+  }
+
+  /** @return the smallest recorded value (zero if nothing was recorded). */
+  uint64_t getMin() const {
+    uint64_t value = minimum.load(memory_order_relaxed);
+    return (value == numeric_limits<uint64_t>::max()) ? 0 : value;
+  }
+
+  /** @return the highest recorded value. */
+  uint64_t getMax() const {
+    return maximum.load(memory_order_relaxed);
+  }
+
+  /** @return the average of the recorded values (zero if nothing was recorded). */
+  uint64_t getMean() const {
+    uint64_t n = getCount();
+    return (n == 0) ? 0 : sum.load(memory_order_relaxed) / n;
+  }
+
+  /**
+   * @param percent a number between 0 and 100.
+   * @return a value that is not exceeded by the given percentage of the
+   * recorded values (exact within the precision of the buckets).
+   */
+  uint64_t getPercentile(double percent) const {
+    uint64_t total = 0;
+    for (auto &bucket : buckets) {
+      total += bucket.load(memory_order_relaxed);
+    }
+    if (total == 0) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t> (percent / 100.0 * total + 0.5);
+    if (rank < 1) {
+      rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < bucketCount; i++) {
+      seen += buckets[i].load(memory_order_relaxed);
+      if (seen >= rank) {
+        // the bucket bound, but never outside the recorded range.
+        uint64_t value = highestEquivalent(i);
+        uint64_t max = getMax();
+        uint64_t min = getMin();
+        return (value > max) ? max : ((value < min) ? min : value);
+      }
+    }
+    return getMax();
+  }
+};
+
+/**
+ * The timing of the cycles of one port.
+ */
+class CycleTiming {
+public:
+
+  enum Phase {
+    javaDelay, ///< from the initiation of the cycle until the java thread starts on the port.
+    javaProcess, ///< the duration of the java callback.
+    nativeProcess, ///< the duration of the native process.
+    slack, ///< the time left in the cycle when the native process has ended.
+    phaseCount
+  };
+
+  typedef chrono::steady_clock Clock;
+
+private:
+  LatencyHistogram histograms[phaseCount];
+
+public:
+
+  void record(Phase phase, Clock::duration duration) {
+    histograms[phase].record(duration);
+  }
+
+  const LatencyHistogram& get(Phase phase) const {
+    return histograms[phase];
+  }
+
+  void reset() {
+    for (auto &histogram : histograms) {
+      histogram.reset();
+    }
+  }
+};
+
+#endif	/* LATENCYHISTOGRAM_HPP */
+
@@ -0,0 +1,133 @@
+/*
+ * File:   midiBackend.hpp
+ *
+ * Created on October 16, 2026, 10:20 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MIDIBACKEND_HPP
+#define	MIDIBACKEND_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+/**
+ * The MidiBackend is the audio system the ports work with (the Jack server,
+ * or a simulated driver). The "client" pointer that the port-chain hands to
+ * Port::register_impl, Port::execNativeProcess_impl etc. points to a MidiBackend.
+ * </p>
+ * <p>
+ * The per-cycle functions follow the Jack Midi API (jack/midiport.h): a port has
+ * one buffer per cycle, the events in the buffer are ordered by time, the
+ * time of an event is the frame offset within the cycle. The per-cycle functions
+ * are called in the native process thread and must not block.
+ * </p>
+ */
+class MidiBackend {
+public:
+
+  /**
+   * An event found in an input buffer (compare jack_midi_event_t).
+   */
+  struct Event {
+    /** the frame offset within the cycle. */
+    uint32_t time;
+    /** the number of Midi bytes. */
+    size_t size;
+    /** the Midi bytes (valid until the end of the cycle). */
+    uint8_t* buffer;
+  };
+
+  /**
+   * Identifies a port registered at the backend.
+   */
+  typedef void* PortHandle;
+
+  virtual ~MidiBackend() {
+  }
+
+  /**
+   * Registers a new Midi port.
+   * @param name the short name of the port.
+   * @param isInput true for a port that receives Midi events.
+   * @return the handle of the new port, nullptr if the port could not be registered.
+   */
+  virtual PortHandle registerPort(const string& name, bool isInput) = 0;
+
+  /**
+   * Removes a port registered by "registerPort".
+   * @param port the handle of the port.
+   * @return zero on success.
+   */
+  virtual int unregisterPort(PortHandle port) = 0;
+
+  /**
+   * @param port the handle of the port.
+   * @param frames the number of frames in the current cycle.
+   * @return the buffer of the port for the current cycle.
+   */
+  virtual void* getBuffer(PortHandle port, unsigned long frames) = 0;
+
+  /**
+   * @return the number of events in the given input buffer.
+   */
+  virtual int getEventCount(void* buffer) = 0;
+
+  /**
+   * Retrieves an event from an input buffer.
+   * @param event receives the event.
+   * @param buffer the input buffer.
+   * @param index the index of the event.
+   * @return zero on success.
+   */
+  virtual int getEvent(Event& event, void* buffer, int index) = 0;
+
+  /**
+   * Removes all events from an output buffer (must be called once per cycle
+   * before events are written).
+   */
+  virtual void clearBuffer(void* buffer) = 0;
+
+  /**
+   * Appends an event to an output buffer. Events must be written in the order
+   * of their time.
+   * @param buffer the output buffer.
+   * @param time the frame offset within the cycle.
+   * @param size the number of Midi bytes.
+   * @return where the caller shall write the Midi bytes, nullptr if the buffer is full.
+   */
+  virtual uint8_t* reserveEvent(void* buffer, uint32_t time, size_t size) = 0;
+
+  /**
+   * @return the number of frames per second, zero if the frames are not
+   * bound to real time.
+   */
+  virtual unsigned long getFrameRate() = 0;
+
+  /**
+   * Called from the native cycle; must be real-time safe.
+   * @param port the handle of the port.
+   * @return the number of connections the port currently has.
+   */
+  virtual int getConnectionCount(PortHandle port) = 0;
+};
+
+#endif	/* MIDIBACKEND_HPP */
+
@@ -0,0 +1,352 @@
+/*
+ * File:   midiEventArena.hpp
+ *
+ * Created on October 16, 2026, 6:40 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MIDIEVENTARENA_HPP
+#define	MIDIEVENTARENA_HPP
+
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "messages.hpp"
+
+using namespace std;
+
+/**
+ * The MidiEventArena holds the Midi events of one process cycle. Events
+ * may have any length (one-byte real-time messages, two-byte messages like
+ * program change, and SysEx messages of any size).
+ * </p>
+ * <p>
+ * The Midi bytes of all events are stored one after the other in a contiguous
+ * byte arena; an index holds the time, the offset and the length of every
+ * event. Both memory blocks are allocated once, in the constructor, so the
+ * arena can be filled within the real-time thread.
+ * </p>
+ * <p>
+ * The layout of an index entry (12 bytes, native byte order) is also
+ * used by the java side (see MidiIO4Java.MidiEventBuffer):
+ * <pre>
+ *  offset 0: the delta-time (32 bit)
+ *  offset 4: the offset of the first Midi byte within the byte arena (32 bit)
+ *  offset 8: the number of Midi bytes (32 bit)
+ * </pre>
+ * </p>
+ */
+class MidiEventArena {
+public:
+
+  struct Entry {
+    int32_t deltaTime;
+    int32_t offset;
+    int32_t length;
+  };
+
+  static const int entrySize = 12;
+
+private:
+  const int eventCapacity;
+  const int byteCapacity;
+  unique_ptr<Entry[] > entries;
+  unique_ptr<uint8_t[] > bytes;
+  int eventCount;
+  int byteCount;
+
+public:
+
+  /**
+   * Creates an empty arena.
+   * @param _eventCapacity the maximum number of events per cycle.
+   * @param _byteCapacity the maximum number of Midi bytes per cycle.
+   */
+  MidiEventArena(int _eventCapacity, int _byteCapacity) :
+  eventCapacity(_eventCapacity),
+  byteCapacity(_byteCapacity),
+  entries(new Entry[_eventCapacity]),
+  bytes(new uint8_t[_byteCapacity]),
+  eventCount(0),
+  byteCount(0) {
+    static_assert(sizeof (Entry) == entrySize, "the java side expects 12 byte entries.");
+    if ((_eventCapacity <= 0) || (_byteCapacity <= 0)) {
+      THROW("Arena capacity must be positive.")
+    }
+  }
+
+  MidiEventArena(const MidiEventArena&) = delete;
+
+  /**
+   * Removes all events.
+   */
+  void clear() {
+    eventCount = 0;
+    byteCount = 0;
+  }
+
+  /**
+   * Appends an event and reserves space for its Midi bytes. The bytes of
+   * successive events follow each other without gaps.
+   * @param deltaTime the time of the event relative to the start of the cycle.
+   * @param length the number of Midi bytes.
+   * @return where the caller shall write the Midi bytes, nullptr if the
+   * arena is full (nothing has been appended).
+   */
+  uint8_t* reserve(int32_t deltaTime, int length) {
+    if ((eventCount >= eventCapacity) || (length > byteCapacity - byteCount)) {
+      return nullptr;
+    }
+    Entry& entry = entries[eventCount];
+    entry.deltaTime = deltaTime;
+    entry.offset = byteCount;
+    entry.length = length;
+    eventCount++;
+    byteCount += length;
+    return bytes.get() + entry.offset;
+  }
+
+  /**
+   * Appends an event.
+   * @param deltaTime the time of the event relative to the start of the cycle.
+   * @param midi the Midi bytes.
+   * @param length the number of Midi bytes.
+   * @return false if the arena is full (nothing has been appended).
+   */
+  bool add(int32_t deltaTime, const uint8_t* midi, int length) {
+    uint8_t* target = reserve(deltaTime, length);
+    if (target == nullptr) {
+      return false;
+    }
+    memcpy(target, midi, length);
+    return true;
+  }
+
+  /**
+   * Appends all events of another arena.
+   * @param other the arena to copy from.
+   * @param timeShift is added to the delta-times of the copied events.
+   * @return false if not all events could be copied.
+   */
+  bool appendAll(const MidiEventArena& other, int32_t timeShift) {
+    for (int i = 0; i < other.size(); i++) {
+      if (!add(other.getDeltaTime(i) + timeShift, other.getMidi(i), other.getLength(i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Takes over the events that have been written directly into the index
+   * and the byte arena (by java). The entries are not trusted; use "isValid"
+   * before reading an event.
+   * @param count the number of events written.
+   */
+  void setEventCount(int count) {
+    if ((count < 0) || (count > eventCapacity)) {
+      THROW("Invalid number of Midi Events.")
+    }
+    eventCount = count;
+    byteCount = 0;
+  }
+
+  /**
+   * @return true if the event lies within the byte arena and is not empty.
+   */
+  bool isValid(int index) const {
+    const Entry& entry = entries[index];
+    return (entry.length > 0) && (entry.offset >= 0)
+            && (entry.offset <= byteCapacity - entry.length);
+  }
+
+  int size() const {
+    return eventCount;
+  }
+
+  /**
+   * @return the number of Midi bytes appended since the last "clear".
+   */
+  int getByteCount() const {
+    return byteCount;
+  }
+
+  int getEventCapacity() const {
+    return eventCapacity;
+  }
+
+  int getByteCapacity() const {
+    return byteCapacity;
+  }
+
+  int32_t getDeltaTime(int index) const {
+    return entries[index].deltaTime;
+  }
+
+  int getLength(int index) const {
+    return entries[index].length;
+  }
+
+  const uint8_t* getMidi(int index) const {
+    return bytes.get() + entries[index].offset;
+  }
+
+  /**
+   * @return the start of the index (to be shared with java).
+   */
+  Entry* getEntries() {
+    return entries.get();
+  }
+
+  /**
+   * @return the start of the byte arena (to be shared with java).
+   */
+  uint8_t* getBytes() {
+    return bytes.get();
+  }
+};
+
+/**
+ * What a port does with events that do not fit into its arena.
+ * The values must match MidiIO4Java.Implementation.MidiJackNative.OverflowPolicy.
+ */
+enum class OverflowPolicy : int {
+  /** the events that arrive when the arena is full are dropped. */
+  dropNewest = 0,
+  /** the oldest events of the cycle are dropped so that the newest fit. */
+  dropOldest = 1,
+  /** the events that do not fit are delivered in the next cycle. */
+  spill = 2
+};
+
+/**
+ * The EventOverflow keeps the overflow statistics of a port and decides
+ * when its arena should grow.
+ * </p>
+ * <p>
+ * The process threads record how many events (and Midi bytes) they would have
+ * liked to store per cycle; when this high-water mark crosses three quarters
+ * of the capacity, the arena is replaced by one of twice the size. The new
+ * arena is allocated by the java thread, never by the real-time thread.
+ * </p>
+ * <p>
+ * All counters can be read from any thread.
+ * </p>
+ */
+class EventOverflow {
+public:
+  /** The largest number of events per cycle an arena can grow to. */
+  static const int maxEventCapacity = 8192;
+  /** The Midi bytes reserved per event, on average. */
+  static const int bytesPerEvent = 128;
+
+private:
+  const OverflowPolicy policy;
+  atomic<int> eventHighWaterMark;
+  atomic<int> byteHighWaterMark;
+  atomic<unsigned long> droppedCount;
+  atomic<unsigned long> spilledCount;
+  atomic<int> growCount;
+
+public:
+
+  explicit EventOverflow(OverflowPolicy _policy) :
+  policy(_policy),
+  eventHighWaterMark(0),
+  byteHighWaterMark(0),
+  droppedCount(0),
+  spilledCount(0),
+  growCount(0) {
+  }
+
+  EventOverflow(const EventOverflow&) = delete;
+
+  OverflowPolicy getPolicy() const {
+    return policy;
+  }
+
+  /**
+   * Records how many events and bytes were offered in one cycle (including
+   * those that did not fit).
+   */
+  void recordDemand(int events, int bytes) {
+    if (events > eventHighWaterMark.load(memory_order_relaxed)) {
+      eventHighWaterMark.store(events, memory_order_relaxed);
+    }
+    if (bytes > byteHighWaterMark.load(memory_order_relaxed)) {
+      byteHighWaterMark.store(bytes, memory_order_relaxed);
+    }
+  }
+
+  void countDropped(int events) {
+    droppedCount.fetch_add(events, memory_order_relaxed);
+  }
+
+  void countSpilled(int events) {
+    spilledCount.fetch_add(events, memory_order_relaxed);
+  }
+
+  /**
+   * @return true if the demand has come close to the capacity of the given
+   * arena and the arena can still grow.
+   */
+  bool needsGrowth(const MidiEventArena& arena) const {
+    if (arena.getEventCapacity() >= maxEventCapacity) {
+      return false;
+    }
+    return (4L * eventHighWaterMark.load(memory_order_relaxed) > 3L * arena.getEventCapacity())
+            || (4L * byteHighWaterMark.load(memory_order_relaxed) > 3L * arena.getByteCapacity());
+  }
+
+  /**
+   * Creates an arena for the given number of events (and the corresponding
+   * number of bytes).
+   */
+  static unique_ptr<MidiEventArena> makeArena(int eventCapacity) {
+    return unique_ptr<MidiEventArena > (new MidiEventArena(eventCapacity, eventCapacity * bytesPerEvent));
+  }
+
+  /**
+   * Creates the arena that replaces the given one (to be called outside the
+   * real-time thread).
+   */
+  unique_ptr<MidiEventArena> makeGrownArena(const MidiEventArena& arena) {
+    growCount++;
+    return makeArena(min(2 * arena.getEventCapacity(), static_cast<int> (maxEventCapacity)));
+  }
+
+  int getEventHighWaterMark() const {
+    return eventHighWaterMark.load(memory_order_relaxed);
+  }
+
+  unsigned long getDroppedCount() const {
+    return droppedCount.load(memory_order_relaxed);
+  }
+
+  unsigned long getSpilledCount() const {
+    return spilledCount.load(memory_order_relaxed);
+  }
+
+  int getGrowCount() const {
+    return growCount.load();
+  }
+};
+
+#endif	/* MIDIEVENTARENA_HPP */
+
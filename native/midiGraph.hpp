@@ -0,0 +1,122 @@
+/*
+ * File:   midiGraph.hpp
+ *
+ * Created on October 17, 2026, 9:05 AM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MIDIGRAPH_HPP
+#define	MIDIGRAPH_HPP
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A connection from the output port "source" to the input port "destination"
+ * (both named as the server names them, "client:port").
+ */
+struct MidiConnection {
+  string source;
+  string destination;
+
+  MidiConnection() {
+  }
+
+  MidiConnection(const string& _source, const string& _destination) :
+  source(_source),
+  destination(_destination) {
+  }
+
+  bool operator<(const MidiConnection& other) const {
+    if (source != other.source) {
+      return source < other.source;
+    }
+    return destination < other.destination;
+  }
+
+  bool operator==(const MidiConnection& other) const {
+    return (source == other.source) && (destination == other.destination);
+  }
+};
+
+/**
+ * A snapshot of the MIDI connection graph: all MIDI ports known to the server
+ * and all connections between them. The version is advanced by the owner of
+ * the snapshot each time a changed graph is published.
+ */
+class MidiGraph {
+public:
+  unsigned long version;
+  vector<string> ports;
+  vector<MidiConnection> connections;
+
+  MidiGraph() :
+  version(0) {
+  }
+
+  /**
+   * Sorts the ports and the connections and removes duplicates, as needed
+   * by MidiGraphDelta::between.
+   */
+  void normalize() {
+    sort(ports.begin(), ports.end());
+    ports.erase(unique(ports.begin(), ports.end()), ports.end());
+    sort(connections.begin(), connections.end());
+    connections.erase(unique(connections.begin(), connections.end()), connections.end());
+  }
+};
+
+/**
+ * The difference between two snapshots of the connection graph.
+ */
+struct MidiGraphDelta {
+  vector<string> addedPorts;
+  vector<string> removedPorts;
+  vector<MidiConnection> addedConnections;
+  vector<MidiConnection> removedConnections;
+
+  bool isEmpty() const {
+    return addedPorts.empty() && removedPorts.empty()
+            && addedConnections.empty() && removedConnections.empty();
+  }
+
+  /**
+   * Compares two normalized snapshots (see MidiGraph::normalize).
+   * @param before the older snapshot.
+   * @param after the newer snapshot.
+   * @return what has to be applied to "before" to get "after".
+   */
+  static MidiGraphDelta between(const MidiGraph& before, const MidiGraph& after) {
+    MidiGraphDelta delta;
+    set_difference(after.ports.begin(), after.ports.end(),
+            before.ports.begin(), before.ports.end(), back_inserter(delta.addedPorts));
+    set_difference(before.ports.begin(), before.ports.end(),
+            after.ports.begin(), after.ports.end(), back_inserter(delta.removedPorts));
+    set_difference(after.connections.begin(), after.connections.end(),
+            before.connections.begin(), before.connections.end(), back_inserter(delta.addedConnections));
+    set_difference(before.connections.begin(), before.connections.end(),
+            after.connections.begin(), after.connections.end(), back_inserter(delta.removedConnections));
+    return delta;
+  }
+};
+
+#endif	/* MIDIGRAPH_HPP */
+
@@ -0,0 +1,426 @@
+/*
+ * File:   midiProcessor.hpp
+ *
+ * Created on October 16, 2026, 10:02 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MIDIPROCESSOR_HPP
+#define	MIDIPROCESSOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include "messages.hpp"
+
+using namespace std;
+
+/**
+ * A stage of a native processing chain. A stage works on one Midi event at a
+ * time, inside the native (real-time) thread; it must neither block nor allocate.
+ */
+class MidiProcessor {
+public:
+
+  virtual ~MidiProcessor() {
+  }
+
+  /**
+   * Processes an event in place. Only channel messages are modified, they
+   * are never longer than three bytes.
+   * @param midi the bytes of the event (for events longer than three bytes
+   * only the status byte is given).
+   * @param length the number of bytes in "midi".
+   * @return false if the event shall be dropped.
+   */
+  virtual bool process(uint8_t* midi, int length) = 0;
+
+protected:
+
+  static bool isNote(uint8_t status) {
+    uint8_t command = status & 0xF0;
+    return (command == 0x80) || (command == 0x90) || (command == 0xA0);
+  }
+
+  static bool isChannelMessage(uint8_t status) {
+    return (status >= 0x80) && (status < 0xF0);
+  }
+};
+
+/**
+ * Shifts the key of the note messages (note-on, note-off, polyphonic
+ * aftertouch); notes shifted out of the Midi range are dropped.
+ */
+class TransposeProcessor : public MidiProcessor {
+private:
+  const int semitones;
+public:
+
+  explicit TransposeProcessor(int _semitones) :
+  semitones(_semitones) {
+  }
+
+  virtual bool process(uint8_t* midi, int length)override {
+    if ((length < 2) || !isNote(midi[0])) {
+      return true;
+    }
+    int key = midi[1] + semitones;
+    if ((key < 0) || (key > 127)) {
+      return false;
+    }
+    midi[1] = static_cast<uint8_t> (key);
+    return true;
+  }
+};
+
+/**
+ * Moves the channel messages to other channels.
+ */
+class ChannelMapProcessor : public MidiProcessor {
+private:
+  /** the new channel for every channel, -1 to drop the messages. */
+  int channels[16];
+public:
+
+  explicit ChannelMapProcessor(const int* _channels) {
+    for (int i = 0; i < 16; i++) {
+      if ((_channels[i] < -1) || (_channels[i] > 15)) {
+        THROW("Invalid channel in channel map.")
+      }
+      channels[i] = _channels[i];
+    }
+  }
+
+  virtual bool process(uint8_t* midi, int length)override {
+    if (!isChannelMessage(midi[0])) {
+      return true;
+    }
+    int channel = channels[midi[0] & 0x0F];
+    if (channel < 0) {
+      return false;
+    }
+    midi[0] = static_cast<uint8_t> ((midi[0] & 0xF0) | channel);
+    return true;
+  }
+};
+
+/**
+ * Replaces the velocity of the note-on messages through a table.
+ */
+class VelocityCurveProcessor : public MidiProcessor {
+private:
+  uint8_t velocities[128];
+public:
+
+  /**
+   * @param _velocities the new velocity for every velocity (1 to 127, the
+   * entry for zero is ignored because a note-on with zero velocity is a note-off).
+   */
+  explicit VelocityCurveProcessor(const int* _velocities) {
+    velocities[0] = 0;
+    for (int i = 1; i < 128; i++) {
+      if ((_velocities[i] < 1) || (_velocities[i] > 127)) {
+        THROW("Invalid velocity in velocity curve.")
+      }
+      velocities[i] = static_cast<uint8_t> (_velocities[i]);
+    }
+  }
+
+  virtual bool process(uint8_t* midi, int length)override {
+    if ((length >= 3) && ((midi[0] & 0xF0) == 0x90) && (midi[2] > 0)) {
+      midi[2] = velocities[midi[2] & 0x7F];
+    }
+    return true;
+  }
+};
+
+/**
+ * Lets pass the messages of selected kinds on selected channels.
+ */
+class FilterProcessor : public MidiProcessor {
+private:
+  /** bit "n" passes the status 0x80 + n * 0x10 (0x80 note-off ... 0xF0 system). */
+  const int statusMask;
+  /** bit "n" passes the channel messages on channel "n". */
+  const int channelMask;
+public:
+
+  FilterProcessor(int _statusMask, int _channelMask) :
+  statusMask(_statusMask),
+  channelMask(_channelMask) {
+  }
+
+  virtual bool process(uint8_t* midi, int length)override {
+    if (midi[0] < 0x80) {
+      return true; // not a status byte.
+    }
+    if ((statusMask & (1 << ((midi[0] >> 4) - 8))) == 0) {
+      return false;
+    }
+    return !isChannelMessage(midi[0]) || ((channelMask & (1 << (midi[0] & 0x0F))) != 0);
+  }
+};
+
+/**
+ * Splits the keyboard: the note messages below the split key go to one
+ * channel, the others to another channel.
+ */
+class SplitProcessor : public MidiProcessor {
+private:
+  const int splitKey;
+  const int lowerChannel;
+  const int upperChannel;
+public:
+
+  SplitProcessor(int _splitKey, int _lowerChannel, int _upperChannel) :
+  splitKey(_splitKey),
+  lowerChannel(_lowerChannel),
+  upperChannel(_upperChannel) {
+    if ((lowerChannel < 0) || (lowerChannel > 15) || (upperChannel < 0) || (upperChannel > 15)) {
+      THROW("Invalid channel in split.")
+    }
+  }
+
+  virtual bool process(uint8_t* midi, int length)override {
+    if ((length < 2) || !isNote(midi[0])) {
+      return true;
+    }
+    int channel = (midi[1] < splitKey) ? lowerChannel : upperChannel;
+    midi[0] = static_cast<uint8_t> ((midi[0] & 0xF0) | channel);
+    return true;
+  }
+};
+
+/**
+ * An immutable sequence of processing stages. The chain is built by the
+ * administrative side and handed to the native thread through a ProcessorSlot.
+ */
+class ProcessorChain {
+public:
+
+  /**
+   * The kinds of stages. The ordinals must match "MidiJackNative.java".
+   */
+  enum Kind {
+    transpose = 0, ///< parameters: semitones.
+    channelMap = 1, ///< parameters: 16 channels (-1 drops the channel).
+    velocityCurve = 2, ///< parameters: 128 velocities.
+    filter = 3, ///< parameters: status mask, channel mask.
+    split = 4 ///< parameters: split key, lower channel, upper channel.
+  };
+
+private:
+  vector<unique_ptr<MidiProcessor> > stages;
+
+  static int parameterCount(int kind) {
+    switch (kind) {
+      case transpose: return 1;
+      case channelMap: return 16;
+      case velocityCurve: return 128;
+      case filter: return 2;
+      case split: return 3;
+    }
+    THROW("Invalid kind of Midi-processor.")
+  }
+
+public:
+
+  ProcessorChain() {
+  }
+
+  ProcessorChain(const ProcessorChain&) = delete;
+
+  /**
+   * Builds a chain from its description (not real-time safe).
+   * @param description for every stage, the kind followed by the parameters.
+   * @param length the number of elements in "description".
+   * @return the new chain.
+   */
+  static unique_ptr<ProcessorChain> fromDescription(const int32_t* description, int length) {
+    unique_ptr<ProcessorChain> chain(new ProcessorChain());
+    int position = 0;
+    while (position < length) {
+      int kind = description[position];
+      int count = parameterCount(kind);
+      if (position + 1 + count > length) {
+        THROW("Incomplete description of a Midi-processor.")
+      }
+      const int32_t* parameters = description + position + 1;
+      switch (kind) {
+        case transpose:
+          chain->add(unique_ptr<MidiProcessor>(new TransposeProcessor(parameters[0])));
+          break;
+        case channelMap:
+          chain->add(unique_ptr<MidiProcessor>(new ChannelMapProcessor(parameters)));
+          break;
+        case velocityCurve:
+          chain->add(unique_ptr<MidiProcessor>(new VelocityCurveProcessor(parameters)));
+          break;
+        case filter:
+          chain->add(unique_ptr<MidiProcessor>(new FilterProcessor(parameters[0], parameters[1])));
+          break;
+        case split:
+          chain->add(unique_ptr<MidiProcessor>(new SplitProcessor(parameters[0], parameters[1], parameters[2])));
+          break;
+      }
+      position += 1 + count;
+    }
+    return chain;
+  }
+
+  void add(unique_ptr<MidiProcessor> && stage) {
+    stages.push_back(move(stage));
+  }
+
+  bool isEmpty() const {
+    return stages.empty();
+  }
+
+  /**
+   * Runs an event through all stages (real-time safe). The given event
+   * is left untouched.
+   * @param midi the bytes of the event.
+   * @param length the number of bytes.
+   * @param scratch receives the processed bytes of a short event.
+   * @return the bytes to be used instead of "midi" ("scratch" or "midi"),
+   * nullptr if the event has been dropped.
+   */
+  const uint8_t* apply(const uint8_t* midi, int length, uint8_t(&scratch)[3]) const {
+    if (length <= 0) {
+      return midi;
+    }
+    // long events (SysEx) are never modified, the stages only see the status.
+    int processed = (length <= 3) ? length : 1;
+    memcpy(scratch, midi, processed);
+    for (auto &stage : stages) {
+      if (!stage->process(scratch, processed)) {
+        return nullptr;
+      }
+    }
+    return (length <= 3) ? scratch : midi;
+  }
+};
+
+/**
+ * Holds the processing chain of a port. The administrative side replaces
+ * the chain at any time ("set"), the native thread reads it through an
+ * Accessor without locking (read-copy-update in the manner of the
+ * snapshots of the PortChain). A replaced chain is deleted as soon as the
+ * native thread no longer uses it.
+ */
+class ProcessorSlot {
+private:
+  atomic<ProcessorChain*> active;
+  /** the chain the native thread currently uses (nullptr outside a process). */
+  atomic<ProcessorChain*> inUse;
+  /** replaced chains that might still be in use (guarded by the writerMutex). */
+  vector<ProcessorChain*> retired;
+  mutex writerMutex;
+
+  void reclaim() {
+    ProcessorChain* used = inUse.load();
+    auto firstReclaimable = stable_partition(retired.begin(), retired.end(),
+            [used](ProcessorChain * chain) {
+              return chain == used;
+            });
+    for (auto it = firstReclaimable; it != retired.end(); ++it) {
+      delete *it;
+    }
+    retired.erase(firstReclaimable, retired.end());
+  }
+
+public:
+
+  /**
+   * Gives the native thread access to the active chain for the duration of
+   * its life-time (RAII), the chain will not be deleted meanwhile.
+   */
+  class Accessor {
+  private:
+    ProcessorSlot& owner;
+    ProcessorChain* chain;
+  public:
+
+    explicit Accessor(ProcessorSlot& _owner) :
+    owner(_owner),
+    chain(_owner.active.load()) {
+      // announce the chain, and make sure it has not been replaced meanwhile.
+      while (true) {
+        owner.inUse.store(chain);
+        ProcessorChain* current = owner.active.load();
+        if (current == chain) {
+          break;
+        }
+        chain = current;
+      }
+    }
+
+    Accessor(const Accessor&) = delete;
+
+    ~Accessor() {
+      owner.inUse.store(nullptr);
+    }
+
+    /**
+     * See ProcessorChain::apply; without a chain the event passes unchanged.
+     */
+    const uint8_t* apply(const uint8_t* midi, int length, uint8_t(&scratch)[3]) const {
+      return (chain == nullptr) ? midi : chain->apply(midi, length, scratch);
+    }
+  };
+
+  ProcessorSlot() :
+  active(nullptr),
+  inUse(nullptr) {
+  }
+
+  ProcessorSlot(const ProcessorSlot&) = delete;
+
+  ~ProcessorSlot() {
+    delete active.load();
+    for (ProcessorChain* chain : retired) {
+      delete chain;
+    }
+  }
+
+  /**
+   * Replaces the chain (administrative side only, does not wait for the native thread).
+   * @param chain the new chain, empty to let all events pass unchanged.
+   */
+  void set(unique_ptr<ProcessorChain> && chain) {
+    lock_guard<mutex> lock(writerMutex);
+    ProcessorChain* fresh = (chain && !chain->isEmpty()) ? chain.release() : nullptr;
+    ProcessorChain* replaced = active.exchange(fresh);
+    if (replaced != nullptr) {
+      retired.push_back(replaced);
+    }
+    reclaim();
+  }
+
+  /**
+   * @return true if a chain is set.
+   */
+  bool hasChain() const {
+    return active.load() != nullptr;
+  }
+};
+
+#endif	/* MIDIPROCESSOR_HPP */
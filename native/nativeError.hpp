@@ -0,0 +1,132 @@
+/*
+ * File:   nativeError.hpp
+ *
+ * Created on October 16, 2026, 8:10 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef NATIVEERROR_HPP
+#define	NATIVEERROR_HPP
+
+#include <stdexcept>
+#include <string>
+#include <sstream>
+
+using namespace std;
+
+/**
+ * The errors the native (real-time) thread can run into.
+ */
+enum class NativeErrorCode : int {
+  none = 0,
+  nullPort, ///< the port is not registered at the backend.
+  eventRetrieval, ///< the backend could not deliver an input event.
+  invalidEvent, ///< an output event lies outside the arena.
+  eventOutOfOrder, ///< the output events are not ordered by time.
+  eventBeyondCycle, ///< an output event lies beyond the end of the cycle.
+  ringOutOfSync, ///< the event ring and the byte ring of an asynchronous port disagree.
+  wrongState, ///< the hand-shake has found the port in an unexpected state.
+  lockTimeout, ///< the native thread could not acquire the state of the port in time.
+  noEndControl ///< the port-chain has no end-control port.
+};
+
+/**
+ * Describes an error of the native thread. The record holds no pointers
+ * except to string literals, so the native thread can fill it in without
+ * allocating anything; the text of the error is only put together on the
+ * administrative side (see toString).
+ */
+struct NativeErrorRecord {
+  NativeErrorCode code;
+  /** the port that has failed (-1 for the port-chain). */
+  long portId;
+  /** the source file that has detected the error (a string literal). */
+  const char* file;
+  int line;
+  /** the time-code start of the cycle in which the error occurred. */
+  unsigned long timeCodeStart;
+  /** wrongState only: the state and the sub-state found. */
+  int state;
+  int substate;
+
+  static const char* describe(NativeErrorCode code) {
+    switch (code) {
+      case NativeErrorCode::none: return "No error.";
+      case NativeErrorCode::nullPort: return "Port not registered.";
+      case NativeErrorCode::eventRetrieval: return "Error retrieving Midi Events.";
+      case NativeErrorCode::invalidEvent: return "Invalid Midi-Event.";
+      case NativeErrorCode::eventOutOfOrder: return "Midi-Event was out of order.";
+      case NativeErrorCode::eventBeyondCycle: return "Midi-Event beyond the end of the cycle.";
+      case NativeErrorCode::ringOutOfSync: return "Byte ring out of sync.";
+      case NativeErrorCode::wrongState: return "Unexpected state in the native process.";
+      case NativeErrorCode::lockTimeout: return "Timeout in the native process.";
+      case NativeErrorCode::noEndControl: return "No End-Control port in port-chain.";
+    }
+    return "Unknown error.";
+  }
+
+  /**
+   * Not real-time safe.
+   * @return the message for the exception that reports this error.
+   */
+  string toString() const {
+    ostringstream message;
+    message << file << "(" << line << "):";
+    if (portId != -1) {
+      message << "Port(" << portId << ") ";
+    }
+    message << describe(code) << " (time-code " << timeCodeStart;
+    if (code == NativeErrorCode::wrongState) {
+      message << ", state " << state << ", sub-state " << substate;
+    }
+    message << ")";
+    return message.str();
+  }
+};
+
+/**
+ * The exception that the administrative side raises for an error of the
+ * native thread.
+ */
+class NativeError : public runtime_error {
+private:
+  const NativeErrorRecord record;
+
+public:
+
+  explicit NativeError(const NativeErrorRecord& _record) :
+  runtime_error(_record.toString()),
+  record(_record) {
+  }
+
+  const NativeErrorRecord& getRecord() const {
+    return record;
+  }
+};
+
+/**
+ * Reports an error of the native thread (through "reportNativeError" of the
+ * enclosing port) and leaves the current function.
+ */
+#define FAIL_NATIVE(errorCode) \
+  { reportNativeError(NativeErrorCode::errorCode, __FILE__, __LINE__); return; }
+
+#define FAIL_NATIVE_RETURN(errorCode, value) \
+  { reportNativeError(NativeErrorCode::errorCode, __FILE__, __LINE__); return value; }
+
+#endif	/* NATIVEERROR_HPP */
+
@@ -46,7 +46,15 @@ TESTFILES= \
 	${TESTDIR}/TestFiles/f2 \
 	${TESTDIR}/TestFiles/f3 \
 	${TESTDIR}/TestFiles/f1 \
-	${TESTDIR}/TestFiles/f4
+	${TESTDIR}/TestFiles/f4 \
+	${TESTDIR}/TestFiles/f5 \
+	${TESTDIR}/TestFiles/f6 \
+	${TESTDIR}/TestFiles/f7 \
+	${TESTDIR}/TestFiles/f8 \
+	${TESTDIR}/TestFiles/f9 \
+	${TESTDIR}/TestFiles/f10 \
+	${TESTDIR}/TestFiles/f11 \
+	${TESTDIR}/TestFiles/f12
 
 # C Compiler Flags
 CFLAGS=
@@ -103,6 +111,38 @@ ${TESTDIR}/TestFiles/f4: ${TESTDIR}/tests/ptrEnvelopeTest.o ${TESTDIR}/tests/ptr
 	${MKDIR} -p ${TESTDIR}/TestFiles
 	${LINK.cc}   -o ${TESTDIR}/TestFiles/f4 $^ ${LDLIBSOPTIONS} -lcppunit 
 
+${TESTDIR}/TestFiles/f5: ${TESTDIR}/tests/spscRingTest.o ${TESTDIR}/tests/spscRingTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f5 $^ ${LDLIBSOPTIONS} -lcppunit 
+
+${TESTDIR}/TestFiles/f6: ${TESTDIR}/tests/cycleSignalTest.o ${TESTDIR}/tests/cycleSignalTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f6 $^ ${LDLIBSOPTIONS} -lcppunit 
+
+${TESTDIR}/TestFiles/f7: ${TESTDIR}/tests/midiEventArenaTest.o ${TESTDIR}/tests/midiEventArenaTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f7 $^ ${LDLIBSOPTIONS} -lcppunit 
+
+${TESTDIR}/TestFiles/f8: ${TESTDIR}/tests/simulatedBackendTest.o ${TESTDIR}/tests/simulatedBackendTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f8 $^ ${LDLIBSOPTIONS} -lcppunit 
+
+${TESTDIR}/TestFiles/f9: ${TESTDIR}/tests/latencyHistogramTest.o ${TESTDIR}/tests/latencyHistogramTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f9 $^ ${LDLIBSOPTIONS} -lcppunit 
+
+${TESTDIR}/TestFiles/f10: ${TESTDIR}/tests/rtLogTest.o ${TESTDIR}/tests/rtLogTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f10 $^ ${LDLIBSOPTIONS} -lcppunit 
+
+${TESTDIR}/TestFiles/f11: ${TESTDIR}/tests/midiProcessorTest.o ${TESTDIR}/tests/midiProcessorTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f11 $^ ${LDLIBSOPTIONS} -lcppunit 
+
+${TESTDIR}/TestFiles/f12: ${TESTDIR}/tests/midiGraphTest.o ${TESTDIR}/tests/midiGraphTestRunner.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.cc}   -o ${TESTDIR}/TestFiles/f12 $^ ${LDLIBSOPTIONS} -lcppunit 
+
 
 ${TESTDIR}/tests/portTest.o: tests/portTest.cpp 
 	${MKDIR} -p ${TESTDIR}/tests
@@ -151,6 +191,86 @@ ${TESTDIR}/tests/ptrEnvelopeTestRunner.o: tests/ptrEnvelopeTestRunner.cpp
 	${RM} $@.d
 	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/ptrEnvelopeTestRunner.o tests/ptrEnvelopeTestRunner.cpp
 
+${TESTDIR}/tests/spscRingTest.o: tests/spscRingTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/spscRingTest.o tests/spscRingTest.cpp
+
+${TESTDIR}/tests/spscRingTestRunner.o: tests/spscRingTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/spscRingTestRunner.o tests/spscRingTestRunner.cpp
+
+${TESTDIR}/tests/cycleSignalTest.o: tests/cycleSignalTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/cycleSignalTest.o tests/cycleSignalTest.cpp
+
+${TESTDIR}/tests/cycleSignalTestRunner.o: tests/cycleSignalTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/cycleSignalTestRunner.o tests/cycleSignalTestRunner.cpp
+
+${TESTDIR}/tests/midiEventArenaTest.o: tests/midiEventArenaTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/midiEventArenaTest.o tests/midiEventArenaTest.cpp
+
+${TESTDIR}/tests/midiEventArenaTestRunner.o: tests/midiEventArenaTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/midiEventArenaTestRunner.o tests/midiEventArenaTestRunner.cpp
+
+${TESTDIR}/tests/simulatedBackendTest.o: tests/simulatedBackendTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/simulatedBackendTest.o tests/simulatedBackendTest.cpp
+
+${TESTDIR}/tests/simulatedBackendTestRunner.o: tests/simulatedBackendTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/simulatedBackendTestRunner.o tests/simulatedBackendTestRunner.cpp
+
+${TESTDIR}/tests/latencyHistogramTest.o: tests/latencyHistogramTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/latencyHistogramTest.o tests/latencyHistogramTest.cpp
+
+${TESTDIR}/tests/latencyHistogramTestRunner.o: tests/latencyHistogramTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/latencyHistogramTestRunner.o tests/latencyHistogramTestRunner.cpp
+
+${TESTDIR}/tests/rtLogTest.o: tests/rtLogTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/rtLogTest.o tests/rtLogTest.cpp
+
+${TESTDIR}/tests/rtLogTestRunner.o: tests/rtLogTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/rtLogTestRunner.o tests/rtLogTestRunner.cpp
+
+${TESTDIR}/tests/midiProcessorTest.o: tests/midiProcessorTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/midiProcessorTest.o tests/midiProcessorTest.cpp
+
+${TESTDIR}/tests/midiProcessorTestRunner.o: tests/midiProcessorTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/midiProcessorTestRunner.o tests/midiProcessorTestRunner.cpp
+
+${TESTDIR}/tests/midiGraphTest.o: tests/midiGraphTest.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/midiGraphTest.o tests/midiGraphTest.cpp
+
+${TESTDIR}/tests/midiGraphTestRunner.o: tests/midiGraphTestRunner.cpp 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} $@.d
+	$(COMPILE.cc) -g -Werror -D${WITH_JUNIT} -DWITH_JACK -I${JNI_INCLUDE_OS} -I${JNI_INCLUDE_BASE} -I. `pkg-config --cflags jack` -std=c++11  -MMD -MP -MF $@.d -o ${TESTDIR}/tests/midiGraphTestRunner.o tests/midiGraphTestRunner.cpp
+
 
 ${OBJECTDIR}/jackNative_nomain.o: ${OBJECTDIR}/jackNative.o jackNative.cpp 
 	${MKDIR} -p ${OBJECTDIR}
@@ -186,6 +306,14 @@ ${OBJECTDIR}/windowsNative_nomain.o: ${OBJECTDIR}/windowsNative.o windowsNative.
 	    ${TESTDIR}/TestFiles/f3 || true; \
 	    ${TESTDIR}/TestFiles/f1 || true; \
 	    ${TESTDIR}/TestFiles/f4 || true; \
+	    ${TESTDIR}/TestFiles/f5 || true; \
+	    ${TESTDIR}/TestFiles/f6 || true; \
+	    ${TESTDIR}/TestFiles/f7 || true; \
+	    ${TESTDIR}/TestFiles/f8 || true; \
+	    ${TESTDIR}/TestFiles/f9 || true; \
+	    ${TESTDIR}/TestFiles/f10 || true; \
+	    ${TESTDIR}/TestFiles/f11 || true; \
+	    ${TESTDIR}/TestFiles/f12 || true; \
 	else  \
 	    ./${TEST} || true; \
 	fi
@@ -39,6 +39,8 @@
 #include <condition_variable>
 #include <mutex>
 #include <thread>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <iostream>
@@ -47,6 +49,12 @@
 #include <exception>
 #include "messages.hpp"
 #include "util.hpp"
+#include "cycleDescriptor.hpp"
+#include "latencyHistogram.hpp"
+#include "nativeError.hpp"
+#include "spscRing.hpp"
+#include "rtLog.hpp"
+#include "midiProcessor.hpp"
 
 /**
  * A value for the internalId that is used to mark ports a being dead 
@@ -56,6 +64,22 @@
 
 using namespace std;
 
+/**
+ * What the ports do when the java thread is late, that is when a new cycle
+ * starts before the java thread has finished the previous one (an "xrun").
+ * The policy only applies to the lock-free hand-shake, in the blocking
+ * hand-shake the native thread waits for the java thread.
+ * The values must match MidiIO4Java.Implementation.MidiJackNative.XrunPolicy.
+ */
+enum class XrunPolicy : int {
+  /** the output of the late cycle is written in a later cycle, the input of the missed cycles is lost. */
+  delay = 0,
+  /** the output of the late cycle is dropped (the port stays silent), the input of the missed cycles is lost. */
+  skip = 1,
+  /** as "skip", but the input of the missed cycles is handed to java together with the next cycle. */
+  merge = 2
+};
+
 /**
  * An input-port is responsible to transport data from a native-thread to
  * the Java-callback-thread, an output port does it the other way round.
@@ -91,6 +115,23 @@ private:
    */
   const chrono::milliseconds maxWaitingTime = chrono::milliseconds(500);
 
+  /**
+   * Lock-free mode: the number of polling rounds in which a waiting thread
+   * only yields before it starts to sleep.
+   */
+  static const int pollSpinRounds = 64;
+
+  /**
+   * Lock-free mode: the sleeping time between two polling rounds.
+   */
+  const chrono::microseconds pollInterval = chrono::microseconds(100);
+
+  /**
+   * Blocking mode: the longest time the native thread waits for the stateMutex
+   * (the other threads hold it only for short moments, see execJavaProcess). 
+   */
+  const chrono::microseconds nativeLockLimit = chrono::microseconds(500);
+
   /**
    * A unique identifier.
    */
@@ -112,7 +153,200 @@ private:
 
   /** The "lastCycle" flag is set to true when we are about to perform the 
    * last cycle before shutting down. */
-  bool lastCycle;
+  atomic<bool> lastCycle;
+
+  /**
+   * In lock-free mode the per-cycle functions (execNativeCycleInit, execNativeProcess
+   * and execJavaProcess) change the sub-state by compare-and-swap only and never
+   * touch the stateMutex nor the onStateChanged condition.
+   */
+  bool lockFree;
+
+  /**
+   * Lock-free mode only, owned by the native thread: a new cycle has been
+   * initiated on an output port whose previous output was not yet written.
+   * The port is handed to the java thread as soon as this output is written.
+   */
+  bool rearmAfterNativeProcess;
+
+  /**
+   * Lock-free mode only, owned by the native thread: a new cycle has been
+   * initiated while the java thread was still busy with the previous one.
+   */
+  bool javaLate;
+
+  /**
+   * Lock-free mode only: the exception of the worker thread that has moved
+   * the port into the "failed" sub-state. The next administrative function
+   * hands it over to processException.
+   */
+  exception_ptr pendingException;
+
+  /**
+   * Lock-free mode only: the number of cycles that could not be initiated because
+   * the previous cycle was still in progress.
+   */
+  atomic<unsigned long> lateCycleCount;
+
+  /**
+   * Lock-free mode only: what to do when the java thread is late.
+   */
+  XrunPolicy xrunPolicy;
+
+  /**
+   * Lock-free mode only: the number of cycles whose data has been lost
+   * because the java thread was late (output dropped, or input not read).
+   */
+  atomic<unsigned long> droppedCycleCount;
+
+  /**
+   * Lock-free mode only: the number of cycles whose input has been kept for the
+   * next java cycle (see XrunPolicy::merge).
+   */
+  atomic<unsigned long> mergedCycleCount;
+
+  /**
+   * Selects the skipping of the cycles in which the port has no connection
+   * (see setSkipWhenIdle).
+   */
+  atomic<bool> skipWhenIdle;
+
+  /**
+   * Owned by the native thread: the port is idle (has no connection and skips)
+   * in the cycle the native thread is in (see sampleConnections).
+   */
+  bool nativeIdle;
+
+  /**
+   * The number of cycles the port has skipped because it was idle.
+   */
+  atomic<unsigned long> idleCycleCount;
+
+  /**
+   * An asynchronous port decouples its native side from its java side through its
+   * own wait-free buffer; its native side is executed in every cycle, even while
+   * the java thread is still busy with an earlier cycle.
+   * Asynchronous ports always use the lock-free hand-shake.
+   */
+  bool asynchronous;
+
+  /**
+   * Lock-free mode only: set while the native thread executes one of the
+   * "_impl" functions, so that the administrative functions can wait until
+   * it has left the port.
+   */
+  atomic<bool> nativeActive;
+
+  /**
+   * Lock-free mode only: ensures that only the first failing worker thread
+   * writes the pendingException.
+   */
+  atomic<bool> failing;
+
+  /**
+   * Lock-free mode only: set (with release semantics) by the first failing 
+   * worker thread once it has written the pendingException (see takePendingException).
+   */
+  atomic<bool> pendingPublished;
+
+  /**
+   * Blocking mode only: the native thread has failed but could not stop the
+   * port itself; the next thread that holds the stateMutex completes the 
+   * stop (see completeNativeStop).
+   */
+  atomic<bool> nativeStopPending;
+
+  /**
+   * Owned by the native thread: the time-code values of the cycle the native 
+   * thread is currently executing (in lock-free mode the java thread might 
+   * still be working on an earlier cycle).
+   */
+  unsigned long nativeTimeCodeStart;
+  unsigned long nativeTimeCodeDuration;
+
+  /**
+   * The number of errors of the native thread that are kept until they are
+   * collected (the first errors are kept).
+   */
+  static const int nativeErrorCapacity = 4;
+
+  /**
+   * The errors of the native thread. Filled by the native thread without
+   * allocating anything; getProcessException turns them into an exception.
+   */
+  SpscRing<NativeErrorRecord> nativeErrors;
+
+  /**
+   * Owned by the native thread: an error has been reported (see reportNativeError)
+   * during the current native process.
+   */
+  bool nativeFailed;
+
+  typedef CycleTiming::Clock Clock;
+
+  /**
+   * The timing statistics of this port (see getCycleTiming).
+   */
+  unique_ptr<CycleTiming> timing;
+
+  /**
+   * The number of frames per second, zero if unknown (see setFrameRate).
+   */
+  atomic<unsigned long> frameRate;
+
+  /**
+   * Owned by the native thread: when the native thread has initiated the
+   * cycle it is currently executing.
+   */
+  Clock::time_point nativeCycleInitTime;
+
+  /**
+   * When the cycle handed to the java thread has been initiated (handed over
+   * together with timeCodeStart).
+   */
+  Clock::time_point cycleInitTime;
+
+  /**
+   * Owned by the java thread: when the java thread has started on the port.
+   */
+  Clock::time_point javaStartTime;
+
+  /**
+   * The java thread starts on the port.
+   */
+  void recordJavaStart() {
+    javaStartTime = Clock::now();
+    timing->record(CycleTiming::javaDelay, javaStartTime - cycleInitTime);
+  }
+
+  /**
+   * The java thread is done with the port.
+   */
+  void recordJavaEnd() {
+    timing->record(CycleTiming::javaProcess, Clock::now() - javaStartTime);
+  }
+
+  /**
+   * The native thread is done with the port.
+   * @param start when the native process has started.
+   * @param _timeCodeDuration the length of the cycle.
+   */
+  void recordNativeProcess(Clock::time_point start, unsigned long _timeCodeDuration) {
+    Clock::time_point end = Clock::now();
+    timing->record(CycleTiming::nativeProcess, end - start);
+    unsigned long rate = frameRate;
+    if (rate > 0) {
+      chrono::nanoseconds budget(_timeCodeDuration * 1000000000ULL / rate);
+      timing->record(CycleTiming::slack, budget - (end - nativeCycleInitTime));
+    }
+  }
+
+  /**
+   * Uses the lock-free version of the per-cycle functions.
+   */
+  bool isLockFreeHandshake() const {
+    return lockFree || asynchronous;
+  }
 
   /**
    * This procedure implements the functionality of the "shutdown"
@@ -156,6 +390,19 @@ private:
 
 protected:
 
+  /**
+   * Reports an error of the native thread (use the FAIL_NATIVE macro).
+   * Real-time safe: the error is recorded in a preallocated ring, the
+   * exception is only created when the administrative side collects the
+   * error (see getProcessException). After the current native process the 
+   * port stops on error.
+   */
+  void reportNativeError(NativeErrorCode code, const char* file, int line) {
+    NativeErrorRecord record = {code, internalId, file, line, nativeTimeCodeStart, 0, 0};
+    nativeErrors.push(record);
+    nativeFailed = true;
+  }
+
   /**
    * The time-code indicating when the current cycle started.
    */
@@ -166,6 +413,30 @@ protected:
    */
   unsigned long timeCodeDuration;
 
+  /**
+   * The cycle handed over together with timeCodeStart is idle: the port had
+   * no connection when the cycle started, so neither the java call-back nor the
+   * buffer of the audio system needs to be served (see setSkipWhenIdle).
+   */
+  bool idleCycle;
+
+  /**
+   * Native thread only: the port is idle in the cycle the native thread is in.
+   * (Differs from idleCycle when the java thread is late.)
+   */
+  bool isNativeIdle() const {
+    return nativeIdle;
+  }
+
+  /**
+   * Native thread: the number of connections the port has at the audio system
+   * in the current cycle. The default implementation returns -1 (unknown, a port
+   * that cannot tell is never idle).
+   */
+  virtual int getConnectionCount_impl(void * client) {
+    return -1;
+  }
+
   enum State {
     created, ///< the port is created.
     initialized, ///< the port is embeded in the java environment.
@@ -187,18 +458,21 @@ protected:
     cycleDone, ///< A complete cycle has been excuted.
     nativeToTerminate, ///< the Native thread should terminate the last cycle (only output ports).
     terminated, ///< the running state is terminated.
+    javaBusy, ///< the Java thread is executing (in blocking mode without holding the stateMutex).
+    nativeBusy, ///< lock-free mode: the Native thread is executing.
+    failed, ///< lock-free mode: a worker thread has failed, the port waits to be stopped.
     none ///< subState is not applicable (main state is not "running").
   };
 
   /**
    * The current main state.
    */
-  State state;
+  atomic<State> state;
 
   /**
    * The sub-state when in running state.
    */
-  RunningSubState substate;
+  atomic<RunningSubState> substate;
 
   /**
    * Indicates whether this is an output port or an input port.
@@ -266,6 +540,80 @@ protected:
    */
   virtual void execNativeProcess_impl(unsigned long timeCodeStart, unsigned long timeCodeDuration, void * client) = 0;
 
+  /**
+   * Lock-free mode only: this function is called instead of execNativeProcess_impl
+   * when the native thread finds nothing to process on this port in the current
+   * cycle (for example because the java thread is late). Output ports shall
+   * emit silence. The default implementation does nothing.
+   */
+  virtual void execNativeSkip_impl(unsigned long timeCodeDuration, void * client) {
+  }
+
+  /**
+   * Lock-free mode with the "merge" policy only: the java thread is still busy 
+   * with an earlier cycle of this input port. The implementation shall keep the 
+   * input of the given cycle and hand it to java together with the next cycle.
+   * Runs on the native thread, concurrently with the java thread.
+   * The default implementation does nothing.
+   */
+  virtual void execNativeLate_impl(unsigned long timeCodeStart, unsigned long timeCodeDuration, void * client) {
+  }
+
+  /**
+   * Output ports only (native thread): merges the events that the given input 
+   * ports have received in the current cycle into the output of this port, in
+   * time order (see PortChain::setRoute). Called after the native process of
+   * the cycle, also when the cycle has been skipped.
+   * The default implementation does nothing.
+   * @param sources the input ports.
+   * @param chains for every input port the processing of the route (nullptr for none).
+   * @param count the number of input ports (at most maxMergeSources).
+   */
+  virtual void execNativeMerge_impl(Port* const* sources, const ProcessorChain* const* chains, int count,
+          unsigned long timeCodeDuration, void * client) {
+  }
+
+  /**
+   * Output ports only: a route to this port is about to be set, the implementation
+   * shall allocate what execNativeMerge_impl needs. Runs on the administrative side.
+   * The default implementation does nothing.
+   */
+  virtual void prepareMerge_impl() {
+  }
+
+  /**
+   * Batched dispatch only: the part of execJavaProcess_impl that comes before
+   * the java call-back (for example filling "entry.eventCount").
+   * The default implementation does nothing.
+   */
+  virtual void beforeDispatch_impl(JNIEnv * env, CycleEntry& entry) {
+  }
+
+  /**
+   * Batched dispatch only: the part of execJavaProcess_impl that comes after
+   * the java call-back (for example taking over "entry.result").
+   * The default implementation does nothing.
+   */
+  virtual void afterDispatch_impl(JNIEnv * env, const CycleEntry& entry) {
+  }
+
+  /**
+   * Declares this port asynchronous (see "asynchronous"). Only a subclass knows
+   * whether its "_impl" functions can run concurrently on the native and the java
+   * thread. Must be called before the port is started.
+   * @param value true if the port is asynchronous.
+   */
+  void setAsynchronous(bool value) {
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in setAsynchronous.")
+    }
+    if ((state != created) && (state != initialized) && (state != registered)) {
+      throwCannot("set asynchronous mode", __LINE__, state);
+    }
+    asynchronous = value;
+  }
+
   /**
    * This function shall undo what initialize has done, it shall call
    * the "onClose" callback function of the associated
@@ -294,7 +642,31 @@ protected:
   internalId(_internalId),
   state(created),
   substate(none),
-  lastCycle(false) {
+  lastCycle(false),
+  lockFree(false),
+  rearmAfterNativeProcess(false),
+  javaLate(false),
+  lateCycleCount(0),
+  xrunPolicy(XrunPolicy::delay),
+  droppedCycleCount(0),
+  mergedCycleCount(0),
+  skipWhenIdle(false),
+  nativeIdle(false),
+  idleCycleCount(0),
+  asynchronous(false),
+  nativeActive(false),
+  failing(false),
+  pendingPublished(false),
+  nativeStopPending(false),
+  nativeTimeCodeStart(0),
+  nativeTimeCodeDuration(0),
+  nativeErrors(nativeErrorCapacity),
+  nativeFailed(false),
+  timing(new CycleTiming()),
+  frameRate(0),
+  timeCodeStart(0),
+  timeCodeDuration(0),
+  idleCycle(false) {
   }
 
   /**
@@ -308,12 +680,39 @@ protected:
   output(other.output),
   state(created),
   stateMutex(),
-  substate(none) {
+  substate(none),
+  lastCycle(false),
+  rearmAfterNativeProcess(false),
+  javaLate(false),
+  lateCycleCount(0),
+  droppedCycleCount(0),
+  mergedCycleCount(0),
+  skipWhenIdle(other.skipWhenIdle.load()),
+  nativeIdle(false),
+  idleCycleCount(0),
+  nativeActive(false),
+  failing(false),
+  pendingPublished(false),
+  nativeStopPending(false),
+  nativeErrors(nativeErrorCapacity),
+  nativeFailed(false),
+  frameRate(0),
+  idleCycle(false) {
     Lock lock(other.stateMutex); // we must wait until "other" is not busy.
     //take over the internal state of the other port
     processException = move(other.processException);
-    state = move(other.state);
-    substate = move(other.substate);
+    state = other.state.load();
+    substate = other.substate.load();
+    lastCycle = other.lastCycle.load();
+    lockFree = other.lockFree;
+    xrunPolicy = other.xrunPolicy;
+    asynchronous = other.asynchronous;
+    timing = move(other.timing);
+    frameRate = other.frameRate.load();
+    NativeErrorRecord record;
+    while (other.nativeErrors.pop(record)) {
+      nativeErrors.push(record);
+    }
 
     // invalidate the remains of the other port
     other.internalId = PortInvalidId;
@@ -328,6 +727,16 @@ private:
     throwCannot(attemptedAction, lineNumber, state, none);
   }
 
+  /**
+   * Native thread: hands the idle state over together with the cycle.
+   */
+  void latchIdle() {
+    idleCycle = nativeIdle;
+    if (nativeIdle) {
+      idleCycleCount++;
+    }
+  }
+
   void throwCannot(const string& attemptedAction, int lineNumber, State state, RunningSubState substate) {
 
     string stateStr;
@@ -366,48 +775,511 @@ private:
         break;
       case terminated: subStateStr = " (sub-state: terminated)";
         break;
+      case javaBusy: subStateStr = " (sub-state: javaBusy)";
+        break;
+      case nativeBusy: subStateStr = " (sub-state: nativeBusy)";
+        break;
+      case failed: subStateStr = " (sub-state: failed)";
+        break;
       case none: subStateStr = "(sub-state: none)";
         break;
       default:subStateStr = " (sub-state: ???)";
 
     }
-
-    ostringstream errorMessage;
-    errorMessage << __FILE__ << "(" << lineNumber << "):Port(" << internalId
-            << ") Cannot "
-            << attemptedAction
-            << stateStr
-            << subStateStr;
-    throw runtime_error(errorMessage.str());
+
+    ostringstream errorMessage;
+    errorMessage << __FILE__ << "(" << lineNumber << "):Port(" << internalId
+            << ") Cannot "
+            << attemptedAction
+            << stateStr
+            << subStateStr;
+    throw runtime_error(errorMessage.str());
+  }
+
+  /**
+   * This procedure is called when a problem in the native or the java thread occurred.
+   * @param cause an exception pointer
+   */
+  void emergencyStop(exception_ptr && cause) {
+    stop_impl();
+    state = stoppedOnError;
+    substate = none;
+    setProcessException(move(cause));
+    onStateChanged.notify_all();
+  }
+
+  /**
+   * Blocking mode: the native thread has reported an error (the error itself 
+   * is in nativeErrors, no exception object is created). The port is stopped 
+   * at once if the native thread holds the stateMutex, otherwise the next 
+   * thread that takes the stateMutex stops it.
+   * @param lock the lock of the native thread on the stateMutex (owned or not).
+   */
+  void failBlockingNative(Lock& lock) {
+    nativeFailed = false;
+    nativeStopPending = true;
+    if (lock.owns_lock()) {
+      completeNativeStop();
+    }
+  }
+
+  /**
+   * Blocking mode: the version of emergencyStop for a failed native thread.
+   * While the java thread executes its call-back ("javaBusy") the stop stays
+   * pending, the java thread completes it when the call-back has returned.
+   * Must be called with the stateMutex held.
+   */
+  void completeNativeStop() {
+    if ((!nativeStopPending) || (substate == javaBusy)) {
+      return;
+    }
+    nativeStopPending = false;
+    if (state != running) {
+      return;
+    }
+    stop_impl();
+    state = stoppedOnError;
+    substate = none;
+    onStateChanged.notify_all();
+  }
+
+  /**
+   * Blocking mode: the native thread could not take the stateMutex in time.
+   * This is an error, unless the port is about to stop (then an administrative
+   * function might hold the stateMutex while it stops the port).
+   * @param lock the lock of the native thread on the stateMutex (not owned).
+   * @param lineNumber where the timeout occurred.
+   */
+  void reportLockTimeout(Lock& lock, int lineNumber) {
+    if (!lastCycle) {
+      reportNativeError(NativeErrorCode::lockTimeout, __FILE__, lineNumber);
+      failBlockingNative(lock);
+    }
+  }
+
+  /**
+   * Blocking mode: waits until the java thread has returned from its 
+   * call-back (see execJavaProcess). Must be called with the stateMutex held.
+   * @throws TimeoutException if the call-back does not return in time.
+   */
+  void waitForJavaCallback(Lock& lock) {
+    auto deadline = chrono::steady_clock::now() + waitLimit;
+    while (substate == javaBusy) {
+      if (onStateChanged.wait_until(lock, deadline) == std::cv_status::timeout) {
+        THROW_TIMEOUT("Timeout in waitForJavaCallback().")
+      }
+    }
+  }
+
+  /**
+   * The native thread has found the port in an unexpected state.
+   */
+  void reportWrongState(int lineNumber, State _state, RunningSubState _substate) {
+    NativeErrorRecord record = {NativeErrorCode::wrongState, internalId, __FILE__, lineNumber,
+      nativeTimeCodeStart, static_cast<int> (_state), static_cast<int> (_substate)};
+    nativeErrors.push(record);
+    nativeFailed = true;
+  }
+
+  /**
+   * sets the process exception. If there is already a process exception
+   * the new exception object will be discarded, only the first exception will
+   * be kept.
+   * @param ex an exception pointer
+   */
+  void setProcessException(exception_ptr && ex) {
+    if (!processException) {
+      processException = move(ex);
+    }
+  }
+
+  /**
+   * The sub-state that follows the java process.
+   */
+  RunningSubState substateAfterJava() const {
+    if (lastCycle) {
+      // last cycle -> terminate the session
+      if (isOutput()) {
+        // on output ports the native thread must do the last actions of the session.
+        return nativeToTerminate;
+      } else {
+        // on an input port the session ends with the java process
+        return terminated;
+      }
+    } else {
+      if (isOutput()) {
+        // on output ports the native thread must follow the java thread
+        return nativeToExec;
+      } else {
+        // on an input port the cycle ends with the java process
+        return cycleDone;
+      }
+    }
+  }
+
+  /**
+   * Lets the calling thread pause for a moment while it polls the sub-state
+   * in lock-free mode. The first rounds only yield, later rounds sleep,
+   * so short waits stay short and long waits do not burn a processor.
+   * @param round the number of rounds polled so far.
+   */
+  void pollPause(int round) const {
+    if (round < pollSpinRounds) {
+      this_thread::yield();
+    } else {
+      this_thread::sleep_for(pollInterval);
+    }
+  }
+
+  /**
+   * Lock-free mode: the worker threads do not signal "onStateChanged", so
+   * the waiting threads poll the given condition.
+   * @param condition a callable returning true when the wait is over.
+   * @param timeout the maximum time to wait.
+   * @return false if the timeout has elapsed before the condition became true.
+   */
+  template<typename Condition>
+  bool pollUntil(Condition condition, chrono::milliseconds timeout) const {
+    auto deadline = chrono::steady_clock::now() + timeout;
+    for (int round = 0; !condition(); round++) {
+      if (chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      pollPause(round);
+    }
+    return true;
+  }
+
+  /**
+   * Lock-free mode: the native thread has failed. The exception is parked
+   * and the port is left in the "failed" sub-state until the next
+   * administrative function completes the emergency stop.
+   * While the java thread holds the port ("javaBusy") only the "failing" flag
+   * is set; the java thread moves the port into "failed" when it lets go
+   * of it (see releaseFromJava).
+   * @param cause an exception pointer
+   */
+  void failLockFree(exception_ptr && cause) {
+    bool expected = false;
+    if (failing.compare_exchange_strong(expected, true)) {
+      pendingException = move(cause);
+      pendingPublished.store(true, memory_order_release);
+    }
+    settleFailure();
+  }
+
+  /**
+   * Lock-free mode: the java thread has failed while it holds the port.
+   * @param cause an exception pointer
+   */
+  void failLockFreeJava(exception_ptr && cause) {
+    bool expected = false;
+    if (failing.compare_exchange_strong(expected, true)) {
+      pendingException = move(cause);
+      pendingPublished.store(true, memory_order_release);
+    }
+    substate = failed;
+  }
+
+  /**
+   * Lock-free mode: the native thread has reported an error (the error 
+   * itself is in nativeErrors). Does not allocate.
+   */
+  void failLockFreeNative() {
+    nativeFailed = false;
+    bool expected = false;
+    if (failing.compare_exchange_strong(expected, true)) {
+      pendingPublished.store(true, memory_order_release);
+    }
+    settleFailure();
+  }
+
+  /**
+   * Lock-free mode: moves a port whose "failing" flag is set into the
+   * "failed" sub-state, unless the java thread holds it or an administrative
+   * function has already taken it.
+   */
+  void settleFailure() {
+    RunningSubState current = substate;
+    while ((current != javaBusy) && (current != failed) && (current != none)) {
+      if (substate.compare_exchange_weak(current, failed)) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * Lock-free mode: hands the exception of the failed worker thread over
+   * (empty if the native thread has failed, its errors are in nativeErrors). 
+   * The failing thread sets "failing" before it writes the exception, so the 
+   * exception is only read once it has been published. 
+   * Must be called with the stateMutex held.
+   * @throws TimeoutException if the exception is not published in time.
+   */
+  exception_ptr takePendingException() {
+    if (!failing) {
+      return nullptr;
+    }
+    bool published = pollUntil([this]() {
+      return pendingPublished.load(memory_order_acquire);
+    }, waitLimit);
+    if (!published) {
+      THROW_TIMEOUT("Timeout in takePendingException().")
+    }
+    return move(pendingException);
+  }
+
+  /**
+   * Completes the emergency stop of a worker thread that has failed (in 
+   * blocking mode of a native thread that could not stop the port itself). 
+   * Must be called with the stateMutex held.
+   */
+  void collectFailure() {
+    if ((state == running) && (substate == failed)) {
+      emergencyStop(takePendingException());
+    }
+    completeNativeStop();
+  }
+
+  /**
+   * Lock-free mode: takes the port away from the worker threads. Waits until
+   * neither worker thread is busy and then atomically replaces the sub-state by
+   * "none", so no worker thread can pick up the port again. A port whose
+   * native side has failed while the java thread holds it stays busy until
+   * the java thread lets go of it.
+   * Must be called with the stateMutex held.
+   * @return the sub-state that has been replaced ("failed" if a worker
+   * thread has failed).
+   * @throws TimeoutException if a worker thread remains busy for too long.
+   */
+  RunningSubState releaseWorkers() {
+    auto deadline = chrono::steady_clock::now() + waitLimit;
+    RunningSubState current = substate;
+    for (int round = 0;; round++) {
+      if ((current != javaBusy) && (current != nativeBusy)) {
+        if (substate.compare_exchange_weak(current, none)) {
+          // the native thread might still be in an asynchronous or skipped cycle.
+          while (nativeActive) {
+            if (chrono::steady_clock::now() > deadline) {
+              THROW_TIMEOUT("Timeout in releaseWorkers().")
+            }
+            pollPause(round++);
+          }
+          return failing ? failed : current;
+        }
+        continue; // "current" has been reloaded
+      }
+      if (chrono::steady_clock::now() > deadline) {
+        THROW_TIMEOUT("Timeout in releaseWorkers().")
+      }
+      pollPause(round);
+      current = substate;
+    }
+  }
+
+  /**
+   * Lock-free version of execJavaProcess.
+   * The java thread polls until the native thread hands the port over.
+   */
+  void execJavaProcessLockFree(JNIEnv * env, bool _lastCycle) {
+    if (!claimForJava()) {
+      return;
+    }
+
+    // OK let's do the work.
+    try {
+      lastCycle = lastCycle || _lastCycle;
+      recordJavaStart();
+      execJavaProcess_impl(env, timeCodeStart, timeCodeDuration, lastCycle);
+      recordJavaEnd();
+      releaseFromJava();
+    } catch (...) {
+      failLockFreeJava(current_exception());
+    }
+  }
+
+  /**
+   * Lock-free mode: the java thread polls until the native thread hands the
+   * port over and then moves it into the "javaBusy" sub-state.
+   * @return false if there is nothing to do for java in this cycle.
+   */
+  bool claimForJava() {
+    RunningSubState current = substate;
+    for (int round = 0;; round++) {
+      if (current == javaToExec) {
+        if (substate.compare_exchange_weak(current, javaBusy)) {
+          return true;
+        }
+        continue; // "current" has been reloaded
+      }
+      if ((current == started) || (current == terminated) || (current == nativeToTerminate)
+              || (current == failed) || (current == none)) {
+        return false;
+      }
+      pollPause(round);
+      current = substate;
+    }
+  }
+
+  /**
+   * Lock-free mode: the java thread has done its work, hand the port on
+   * (or into the "failed" sub-state if the native thread has failed meanwhile).
+   */
+  void releaseFromJava() {
+    RunningSubState busy = javaBusy;
+    RunningSubState next = failing ? failed : substateAfterJava();
+    if (substate.compare_exchange_strong(busy, next) && (next != failed) && failing) {
+      // the native thread has failed while we were handing the port on.
+      substate.compare_exchange_strong(next, failed);
+    }
+  }
+
+  /**
+   * Lock-free version of execNativeCycleInit. 
+   * The native thread never waits; a cycle that cannot be initiated because 
+   * the previous cycle is still in progress is counted in lateCycleCount.
+   */
+  void execNativeCycleInitLockFree(unsigned long _timeCodeStart, unsigned long _timeCodeDuration) {
+    if (failing) {
+      settleFailure();
+      return;
+    }
+    nativeTimeCodeStart = _timeCodeStart;
+    nativeTimeCodeDuration = _timeCodeDuration;
+    nativeCycleInitTime = Clock::now();
+    RunningSubState current = substate;
+    switch (current) {
+      case started:
+      case cycleDone:
+        timeCodeStart = _timeCodeStart;
+        timeCodeDuration = _timeCodeDuration;
+        cycleInitTime = nativeCycleInitTime;
+        latchIdle();
+        // fails only if an administrative function has taken the port meanwhile.
+        substate.compare_exchange_strong(current, isInput() ? nativeToExec : javaToExec);
+        return;
+      case nativeToExec:
+      case nativeToTerminate:
+        // the java thread is done but the output has not been written yet.
+        // It will be written in this cycle, and then the port is handed to java.
+        rearmAfterNativeProcess = isOutput() && (current == nativeToExec);
+        return;
+      case javaToExec:
+      case javaBusy:
+        lateCycleCount++;
+        javaLate = true;
+        return;
+      default:
+        return;
+    }
+  }
+
+  /**
+   * Lock-free version of execNativeProcess.
+   * The native thread never waits; if the java thread has not yet served an
+   * output port, execNativeSkip_impl is called instead and the output is written 
+   * in a later cycle. An asynchronous port is processed even while the java
+   * thread is busy.
+   */
+  void execNativeProcessLockFree(void * client) {
+    nativeActive = true; // must be set before the sub-state is read (see releaseWorkers)
+    if (failing) {
+      settleFailure();
+      nativeActive = false;
+      return;
+    }
+    RunningSubState current = substate;
+    try {
+      if ((current == nativeToExec) || (current == nativeToTerminate)) {
+        execNativeProcessClaimed(current, client);
+      } else if (asynchronous && ((current == javaToExec) || (current == javaBusy))) {
+        // the java thread is behind; the port's own buffer keeps both sides apart.
+        Clock::time_point start = Clock::now();
+        execNativeProcess_impl(nativeTimeCodeStart, nativeTimeCodeDuration, client);
+        recordNativeProcess(start, nativeTimeCodeDuration);
+      } else if (isInput() && ((current == javaToExec) || (current == javaBusy))) {
+        // the java thread is still busy with the input of an earlier cycle.
+        if (xrunPolicy == XrunPolicy::merge) {
+          execNativeLate_impl(nativeTimeCodeStart, nativeTimeCodeDuration, client);
+          mergedCycleCount++;
+        } else {
+          droppedCycleCount++;
+        }
+      } else if (isOutput() && ((current == started) || (current == cycleDone)
+              || (current == javaToExec) || (current == javaBusy))) {
+        execNativeSkip_impl(nativeTimeCodeDuration, client);
+      }
+    } catch (...) {
+      failLockFree(current_exception());
+    }
+    if (nativeFailed) {
+      failLockFreeNative();
+    }
+    nativeActive = false;
   }
 
   /**
-   * This procedure is called when a problem in the native or the java thread occurred.
-   * @param cause an exception pointer
+   * Helper for execNativeProcessLockFree: the native thread takes the port
+   * from the given sub-state and processes it.
+   * @param current either "nativeToExec" or "nativeToTerminate".
    */
-  void emergencyStop(exception_ptr && cause) {
-    stop_impl();
-    state = stoppedOnError;
-    substate = none;
-    setProcessException(move(cause));
-    onStateChanged.notify_all();
+  void execNativeProcessClaimed(RunningSubState current, void * client) {
+    if (!substate.compare_exchange_strong(current, nativeBusy)) {
+      return; // an administrative function has taken the port meanwhile.
+    }
+    if (isInput() && (current == nativeToTerminate)) {
+      // an input port never processes the nativeToTerminate state
+      reportWrongState(__LINE__, state, current);
+      return;
+    }
+
+    // OK let's do the work.
+    if (rearmAfterNativeProcess && javaLate && (xrunPolicy != XrunPolicy::delay)) {
+      // the output belongs to a cycle before the previous one, it's too late for it.
+      execNativeSkip_impl(nativeTimeCodeDuration, client);
+      droppedCycleCount++;
+    } else {
+      Clock::time_point start = Clock::now();
+      execNativeProcess_impl(nativeTimeCodeStart, nativeTimeCodeDuration, client);
+      recordNativeProcess(start, nativeTimeCodeDuration);
+    }
+    if (nativeFailed) {
+      return; // execNativeProcessLockFree moves the port into the "failed" sub-state.
+    }
+
+    if (isInput()) {
+      substate = javaToExec;
+    } else if (current == nativeToTerminate) {
+      substate = terminated;
+    } else if (rearmAfterNativeProcess) {
+      // hand the port to java for the cycle the native thread is in.
+      timeCodeStart = nativeTimeCodeStart;
+      timeCodeDuration = nativeTimeCodeDuration;
+      cycleInitTime = nativeCycleInitTime;
+      latchIdle();
+      substate = javaToExec;
+    } else {
+      substate = cycleDone;
+    }
+    rearmAfterNativeProcess = false;
+    javaLate = false;
   }
 
   /**
-   * sets the process exception. If there is already a process exception
-   * the new exception object will be discarded, only the first exception will
-   * be kept.
-   * @param ex an exception pointer
+   * The port has completed a cycle; in lock-free mode an output port that 
+   * the java thread has served also counts as done.
    */
-  void setProcessException(exception_ptr && ex) {
-    if (!processException) {
-      processException = move(ex);
-    }
+  bool isCycleCompleted(RunningSubState s) const {
+    return (s == cycleDone)
+            || (isLockFreeHandshake() && isOutput() && ((s == nativeToExec) || (s == nativeToTerminate)));
   }
 
 public:
 
-
+  /**
+   * The maximum number of routes that can end at one output port (see execNativeMerge).
+   */
+  static const int maxMergeSources = 16;
 
   /**
    * The copy constructor is inhibited, ports must be unique.
@@ -418,7 +1290,7 @@ public:
     if ((state != created) && (state != deletable)) {
       // it is not wise to throw an exception in the destructor.
       // At least we can leave a message.
-      cerr << "### A Port is deleted in wrong state!" << endl;
+      rtLog().log(RtLogLevel::warning, "A Port is deleted in wrong state.", internalId);
     }
   }
 
@@ -486,12 +1358,17 @@ public:
    * operation, true when this port is about to shutdown.
    */
   void execJavaProcess(JNIEnv * env, bool _lastCycle) {
+    if (isLockFreeHandshake()) {
+      execJavaProcessLockFree(env, _lastCycle);
+      return;
+    }
 
     Lock lock(stateMutex, waitLimit);
     try {
       if (!lock.owns_lock()) {
         THROW("Timeout in execJavaProcess.")
       }
+      completeNativeStop();
       if (state != running) {
         return;
       }
@@ -510,29 +1387,26 @@ public:
       }
 
 
-      // OK let's do the work.
+      // OK let's do the work (without the stateMutex, so the native thread never waits for it).
       lastCycle = lastCycle || _lastCycle;
-      execJavaProcess_impl(env, timeCodeStart, timeCodeDuration, lastCycle);
+      substate = javaBusy;
+      lock.unlock();
+      exception_ptr failure;
+      try {
+        recordJavaStart();
+        execJavaProcess_impl(env, timeCodeStart, timeCodeDuration, lastCycle);
+        recordJavaEnd();
+      } catch (...) {
+        failure = current_exception();
+      }
+      lock.lock();
+      if (failure) {
+        rethrow_exception(failure);
+      }
 
       // awake the native process
-      if (lastCycle) {
-        // last cycle -> terminate the session
-        if (isOutput()) {
-          // on output ports the native thread must do the last actions of the session.
-          substate = nativeToTerminate;
-        } else {
-          // on an input port the session ends with the java process
-          substate = terminated;
-        }
-      } else {
-        if (isOutput()) {
-          // on output ports the native thread must follow the java thread
-          substate = nativeToExec;
-        } else {
-          // on an input port the cycle ends with the java process
-          substate = cycleDone;
-        }
-      }
+      substate = substateAfterJava();
+      completeNativeStop();
       onStateChanged.notify_all();
 
     } catch (...) {
@@ -541,14 +1415,109 @@ public:
     }
   }
 
+  /**
+   * Batched dispatch only: tells whether (and how) the java dispatcher shall
+   * serve this port (see CycleEntry::Kind). The default "notDispatched" lets the
+   * java thread serve the port through execJavaProcess_impl as usual.
+   */
+  virtual CycleEntry::Kind getDispatchKind() const {
+    return CycleEntry::notDispatched;
+  }
+
+  /**
+   * Batched dispatch only: the java object the dispatcher calls for this port.
+   */
+  virtual jobject getDispatchPeer() const {
+    return nullptr;
+  }
+
+  /**
+   * Batched dispatch, first half of execJavaProcess (lock-free hand-shake only).
+   * The java thread takes the port for the current cycle and describes the
+   * work for the java dispatcher in the given entry. A port that the
+   * dispatcher does not serve is processed here, as in execJavaProcess.
+   * @param env holds the java worker thread.
+   * @param _lastCycle indicates that this is the last cycle.
+   * @param entry receives the description of the port's cycle; its kind
+   * remains "notDispatched" unless the port has been taken for the dispatcher.
+   * @return true if the port waits for the dispatcher; endJavaDispatch must follow.
+   */
+  bool beginJavaDispatch(JNIEnv * env, bool _lastCycle, CycleEntry& entry) {
+    entry.kind = CycleEntry::notDispatched;
+    if (!isLockFreeHandshake()) {
+      THROW("Batched dispatch needs the lock-free hand-shake.")
+    }
+    if (!claimForJava()) {
+      return false;
+    }
+    try {
+      lastCycle = lastCycle || _lastCycle;
+      recordJavaStart();
+      // an idle port is not worth a place in the dispatcher's batch.
+      CycleEntry::Kind kind = idleCycle ? CycleEntry::notDispatched : getDispatchKind();
+      if (kind == CycleEntry::notDispatched) {
+        execJavaProcess_impl(env, timeCodeStart, timeCodeDuration, lastCycle);
+        recordJavaEnd();
+        releaseFromJava();
+        return false;
+      }
+      entry.timeCodeStart = timeCodeStart;
+      entry.timeCodeDuration = timeCodeDuration;
+      entry.flags = lastCycle ? CycleEntry::lastCycleFlag : 0;
+      entry.eventCount = 0;
+      entry.result = 0;
+      beforeDispatch_impl(env, entry);
+      entry.kind = kind;
+      return true;
+    } catch (...) {
+      failLockFreeJava(current_exception());
+      return false;
+    }
+  }
+
+  /**
+   * Batched dispatch, second half of execJavaProcess: the java dispatcher
+   * has served the port, hand it on to the native thread.
+   * @param env holds the java worker thread.
+   * @param entry the entry filled by beginJavaDispatch (and by the dispatcher).
+   * @param failure the exception raised while dispatching this port (if any).
+   */
+  void endJavaDispatch(JNIEnv * env, const CycleEntry& entry, exception_ptr failure) {
+    try {
+      if (failure) {
+        rethrow_exception(failure);
+      }
+      afterDispatch_impl(env, entry);
+      recordJavaEnd();
+      releaseFromJava();
+    } catch (...) {
+      failLockFreeJava(current_exception());
+    }
+  }
+
   /**
    * The native thread initiates with this event a new cycle.
    * @param timeCodeStart the time code value to be used for the java and the native processes
    * @param timeCodeDuration the duration to be used for the java and the native processes
    */
   void execNativeCycleInit(unsigned long _timeCodeStart, unsigned long _timeCodeDuration) {
-    Lock lock(stateMutex);
+    if (isLockFreeHandshake()) {
+      execNativeCycleInitLockFree(_timeCodeStart, _timeCodeDuration);
+      return;
+    }
+    if (state != running) {
+      return;
+    }
+    Lock lock(stateMutex, nativeLockLimit);
     try {
+      if (!lock.owns_lock()) {
+        reportLockTimeout(lock, __LINE__);
+        return;
+      }
+      if (nativeStopPending) {
+        completeNativeStop();
+        return;
+      }
       if (state != running) {
         return;
       }
@@ -556,13 +1525,27 @@ public:
         return;
       }
 
+      nativeTimeCodeStart = _timeCodeStart;
+      nativeTimeCodeDuration = _timeCodeDuration;
+      // the native thread waits until the java thread has finished the previous cycle.
+      while ((state == running) && (substate == javaBusy)) {
+        onStateChanged.wait(lock);
+      }
+      if (state != running) {
+        return;
+      }
       if ((substate != cycleDone) && (substate != started)) {
-        throwCannot("execNativeCycleInit", __LINE__, state, substate);
+        reportWrongState(__LINE__, state, substate);
+        failBlockingNative(lock);
+        return;
       }
 
       // 1) store the time-code values for latter use (by java and native thread)
       timeCodeStart = _timeCodeStart;
       timeCodeDuration = _timeCodeDuration;
+      nativeCycleInitTime = Clock::now();
+      cycleInitTime = nativeCycleInitTime;
+      latchIdle();
 
       // 2) determine whether native or java has to execute next.
       if (isInput()) {
@@ -573,7 +1556,7 @@ public:
       onStateChanged.notify_all();
 
     } catch (...) {
-      // something went wrong: capture the exception and stop the port
+      // last resort (the native thread reports its errors without exceptions).
       emergencyStop(move(current_exception()));
     }
   }
@@ -582,6 +1565,15 @@ public:
    * The calling thread will be blocked in "running" state until the "cycleDone" sub-state is reached.
    */
   void waitForCycleDone() {
+    if (isLockFreeHandshake()) {
+      for (int round = 0;; round++) {
+        RunningSubState s = substate;
+        if ((state != running) || isCycleCompleted(s) || (s == terminated) || (s == failed)) {
+          return;
+        }
+        pollPause(round);
+      }
+    }
     Lock lock(stateMutex);
     // as long as we are not in the "cycleDone"- state, we will wait for the state to change.
     while ((state == running) && (substate != cycleDone) && (substate != terminated)) {
@@ -594,10 +1586,22 @@ public:
    * "native worker thread" of the audio system callback.
    */
   void execNativeProcess(void * client) {
-    Lock lock(stateMutex, waitLimit);
+    if (isLockFreeHandshake()) {
+      execNativeProcessLockFree(client);
+      return;
+    }
+    if (state != running) {
+      return;
+    }
+    Lock lock(stateMutex, nativeLockLimit);
     try {
       if (!lock.owns_lock()) {
-        THROW("Timeout in execNativeProcess.")
+        reportLockTimeout(lock, __LINE__);
+        return;
+      }
+      if (nativeStopPending) {
+        completeNativeStop();
+        return;
       }
       if (state != running) {
         return;
@@ -607,9 +1611,11 @@ public:
       }
       while ((state == running) && (substate != nativeToExec) && (substate != nativeToTerminate)) {
         onStateChanged.wait(lock);
-        // if the state has changes to something unexpected, we throw an error.
+        // if the state has changes to something unexpected, we stop on error.
         if ((substate == terminated) || (substate == cycleDone) || (substate == started)) {
-          throwCannot("execNativeProcess", __LINE__, state, substate);
+          reportWrongState(__LINE__, state, substate);
+          failBlockingNative(lock);
+          return;
         }
       }
 
@@ -621,13 +1627,21 @@ public:
       if (isInput()) {
         if ((substate == nativeToTerminate)) {
           // an input port never processes the nativeToTerminate state
-          throwCannot("execNativeProcess on Input", __LINE__, state, substate);
+          reportWrongState(__LINE__, state, substate);
+          failBlockingNative(lock);
+          return;
         }
       }
 
 
       // OK let's do the work.
+      Clock::time_point start = Clock::now();
       execNativeProcess_impl(timeCodeStart, timeCodeDuration, client);
+      recordNativeProcess(start, timeCodeDuration);
+      if (nativeFailed) {
+        failBlockingNative(lock);
+        return;
+      }
 
       if (isInput()) {
         // on input port: awake the java process
@@ -643,7 +1657,7 @@ public:
       onStateChanged.notify_all();
 
     } catch (...) {
-      // something wrong: capture the exception and stop the port
+      // last resort (the native thread reports its errors without exceptions).
       emergencyStop(move(current_exception()));
     }
   }
@@ -656,6 +1670,7 @@ public:
    */
   void stop(bool force) {
     Lock lock(stateMutex);
+    collectFailure();
 
     if (state == stoppedOnError) {
       state = stopped;
@@ -669,18 +1684,39 @@ public:
 
     lastCycle = true;
 
-    // unless "force" is set, we'll wait for max. 500 milliseconds to get the port terminated.
-    while ((!force) && (state == running) && (substate != terminated) && (substate != none)) {
-      auto result = onStateChanged.wait_for(lock, maxWaitingTime);
-      if (result == std::cv_status::timeout) {
-        force = true;
+    if (isLockFreeHandshake()) {
+      if (!force) {
+        pollUntil([this]() {
+          RunningSubState s = substate;
+          return (s == terminated) || (s == none) || (s == failed);
+        }, maxWaitingTime);
+      }
+      RunningSubState last = releaseWorkers();
+      if (last == failed) {
+        emergencyStop(takePendingException());
+      } else if ((last != terminated) && (last != none)) {
+        emergencyStop(make_exception_ptr(runtime_error(AT "Port did not terminate.")));
+      } else {
+        stop_impl();
       }
-    }
-
-    if ((substate != terminated) && (substate != none)) {
-      emergencyStop(make_exception_ptr(runtime_error(AT "Port did not terminate.")));
     } else {
-      stop_impl();
+      // unless "force" is set, we'll wait for max. 500 milliseconds to get the port terminated.
+      while ((!force) && (state == running) && (substate != terminated) && (substate != none)) {
+        auto result = onStateChanged.wait_for(lock, maxWaitingTime);
+        if (result == std::cv_status::timeout) {
+          force = true;
+        }
+      }
+      waitForJavaCallback(lock);
+      collectFailure();
+
+      if (state == running) {
+        if ((substate != terminated) && (substate != none)) {
+          emergencyStop(make_exception_ptr(runtime_error(AT "Port did not terminate.")));
+        } else {
+          stop_impl();
+        }
+      }
     }
     state = stopped;
     substate = none;
@@ -733,13 +1769,27 @@ public:
     lastCycle = true;
 
     try {
+      if (isLockFreeHandshake()) {
+        if ((!force) && (state == running)) {
+          pollUntil([this]() {
+            RunningSubState s = substate;
+            return (s == terminated) || (s == none) || (s == failed);
+          }, maxWaitingTime);
+        }
+        if (releaseWorkers() == failed) {
+          setProcessException(takePendingException());
+        }
+      }
       // unless "force" is set, we'll wait for max. 500 milliseconds to get the port terminated.
-      while ((!force) && (state == running) && (substate != terminated) && (substate != none)) {
+      while ((!isLockFreeHandshake()) && (!force) && (state == running) && (substate != terminated) && (substate != none)) {
         auto result = onStateChanged.wait_for(lock, maxWaitingTime);
         if (result == std::cv_status::timeout) {
           force = true;
         }
       }
+      if (!isLockFreeHandshake()) {
+        waitForJavaCallback(lock);
+      }
 
 
       shutdown_impl(env, client);
@@ -755,37 +1805,30 @@ public:
   }
 
   bool isCreatedState() const {
-    Lock lock(stateMutex);
     return (state == created);
   }
 
   bool isInitializedState() const {
-    Lock lock(stateMutex);
     return (state == initialized);
   }
 
   bool isRegisteredState() const {
-    Lock lock(stateMutex);
     return (state == registered);
   }
 
   bool isRunningState() const {
-    Lock lock(stateMutex);
     return (state == running);
   }
 
   bool isStoppedState() const {
-    Lock lock(stateMutex);
     return (state == stopped);
   }
 
   bool isStoppedOnErrorState() const {
-    Lock lock(stateMutex);
-    return (state == stoppedOnError);
+    return (state == stoppedOnError) || ((state == running) && (substate == failed));
   }
 
   bool isUnregisteredState() const {
-    Lock lock(stateMutex);
     return (state == unregistered);
   }
 
@@ -799,50 +1842,37 @@ public:
    * @return true if the port can be deleted.
    */
   bool isDeletableState() const {
-    Lock lock(stateMutex);
-
     return (state == deletable);
   }
 
   /**
    * Indicates that the port is running and  in the "started" sub-state.
-   * (this function locks the state-mutex, not be used inside a function that
-   * has already acquired the state-mutex.
    * @return true if the port is in the "started" sub-state.
    */
   bool isStartedSubstate() const {
-    Lock lock(stateMutex);
     return (substate == started);
   }
 
   /**
    * Indicates that the port is running and  in the "JavaToExec" sub-state.
-   * (this function locks the state-mutex, not be used inside a function that
-   * has already acquired the state-mutex.
    * @return true if the port is in the "javaToExec" sub-state.
    */
   bool isJavaToExecSubstate() const {
-    Lock lock(stateMutex);
     return (substate == javaToExec);
   }
 
   /**
    * Indicates that the port is running and  in the "CycleDone" sub-state.
-   * (this function locks the state-mutex, not be used inside a function that
-   * has already acquired the state-mutex.
    * @return true if the port is in the "cycleDone" sub-state.
    */
   bool isCycleDoneSubstate() const {
-    Lock lock(stateMutex);
     return (substate == cycleDone);
   }
 
   /**
-   * Not synchronized; only for test. 
    * @return true if the port is in the "nativeToExec" sub-state.
    */
   bool isNativeToExecSubstate() const {
-    Lock lock(stateMutex);
     return (substate == nativeToExec);
   }
 
@@ -850,7 +1880,6 @@ public:
    * @return true if the port is in the "nativeToTerminate" sub-state.
    */
   bool isNativeToTerminateSubstate() const {
-    Lock lock(stateMutex);
     return (substate == nativeToTerminate);
   }
 
@@ -858,15 +1887,31 @@ public:
    * @return true if the port is in the "terminated" sub-state.
    */
   bool isTerminatedSubstate() const {
-    Lock lock(stateMutex);
     return (substate == terminated);
   }
 
+  /**
+   * @return true if the java thread holds the port (lock-free mode only).
+   */
+  bool isJavaBusySubstate() const {
+    return (substate == javaBusy);
+  }
+
   /**
    * Blocks the calling thread until the port is in terminated sub-state.
    * @throws TimeoutException if the waiting time exceeds a predefined limit.
    */
   void waitForTerminatedSubstate() const {
+    if (isLockFreeHandshake()) {
+      bool done = pollUntil([this]() {
+        RunningSubState s = substate;
+        return (state != running) || (s == terminated) || (s == failed);
+      }, maxWaitingTime);
+      if (!done) {
+        THROW_TIMEOUT("Timeout in waitForTerminatedSubstate().")
+      }
+      return;
+    }
     Lock lock(stateMutex);
     if (state != running) {
       return;
@@ -888,6 +1933,15 @@ public:
    * @throws TimeoutException if the waiting time exceeds a predefined limit.
    */
   void waitForCycleDone2() const {
+    if (isLockFreeHandshake()) {
+      bool done = pollUntil([this]() {
+        return (state > running) || isCycleCompleted(substate);
+      }, maxWaitingTime);
+      if (!done) {
+        THROW_TIMEOUT("Timeout in waitForCycleDone2().")
+      }
+      return;
+    }
     Lock lock(stateMutex);
     if (state > running) {
       return;
@@ -907,10 +1961,212 @@ public:
    * @return true if the port is in the "none" sub-state.
    */
   bool isNoneSubstate() const {
-    Lock lock(stateMutex);
     return (substate == none);
   }
 
+  /**
+   * Selects the lock-free hand-shake for the per-cycle functions 
+   * (execNativeCycleInit, execNativeProcess and execJavaProcess). In lock-free
+   * mode the sub-state is changed by compare-and-swap only, the native thread
+   * never waits and the stateMutex is only used by the administrative functions.
+   * An output port that the java thread has not served in time is written
+   * in a later cycle.
+   * The mode can only be changed before the port is started.
+   * @param value true to select the lock-free mode.
+   */
+  void setLockFree(bool value) {
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in setLockFree.")
+    }
+    if ((state != created) && (state != initialized) && (state != registered)) {
+      throwCannot("set lock-free mode", __LINE__, state);
+    }
+    lockFree = value;
+  }
+
+  bool isLockFree() const {
+    return lockFree;
+  }
+
+  /**
+   * Selects what the port does when the java thread is late (lock-free mode only).
+   * The policy can only be changed before the port is started.
+   * @param value the policy.
+   */
+  void setXrunPolicy(XrunPolicy value) {
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in setXrunPolicy.")
+    }
+    if ((state != created) && (state != initialized) && (state != registered)) {
+      throwCannot("set xrun policy", __LINE__, state);
+    }
+    xrunPolicy = value;
+  }
+
+  XrunPolicy getXrunPolicy() const {
+    return xrunPolicy;
+  }
+
+  bool isAsynchronous() const {
+    return asynchronous;
+  }
+
+  /**
+   * Lock-free mode only.
+   * @return the number of cycles that could not be initiated because the 
+   * previous cycle was still in progress.
+   */
+  unsigned long getLateCycleCount() const {
+    return lateCycleCount;
+  }
+
+  /**
+   * Lock-free mode only.
+   * @return the number of cycles whose output or input has been lost because
+   * the java thread was late.
+   */
+  unsigned long getDroppedCycleCount() const {
+    return droppedCycleCount;
+  }
+
+  /**
+   * Lets the port skip the cycles in which it has no connection at the audio
+   * system: the java call-back is not invoked and the buffer of the audio system
+   * is left alone. The hand-shake is not affected; an idle port still passes
+   * through all sub-states of the cycle. Takes effect with the next cycle.
+   * @param value true to skip idle cycles.
+   */
+  void setSkipWhenIdle(bool value) {
+    skipWhenIdle = value;
+  }
+
+  bool isSkippingWhenIdle() const {
+    return skipWhenIdle;
+  }
+
+  /**
+   * @return the number of cycles skipped because the port was idle.
+   */
+  unsigned long getIdleCycleCount() const {
+    return idleCycleCount;
+  }
+
+  /**
+   * Native thread, before execNativeCycleInit: finds out whether the port is
+   * idle in the coming cycle.
+   */
+  void sampleConnections(void * client) {
+    nativeIdle = skipWhenIdle.load(memory_order_relaxed) && (getConnectionCount_impl(client) == 0);
+  }
+
+  /**
+   * Lock-free mode only.
+   * @return the number of cycles whose input has been handed to java
+   * together with a later cycle (see XrunPolicy::merge).
+   */
+  unsigned long getMergedCycleCount() const {
+    return mergedCycleCount;
+  }
+
+  /**
+   * Input ports only (native thread): the buffer of the audio system that holds
+   * the events this port has received in the current cycle (see execNativeMerge_impl).
+   * @return nullptr if the port has no such buffer (the default).
+   */
+  virtual void* getNativeBuffer(unsigned long timeCodeDuration, void * client) {
+    return nullptr;
+  }
+
+  /**
+   * To be called before a route to this output port is set (see prepareMerge_impl).
+   */
+  void prepareMerge() {
+    if (isOutput()) {
+      prepareMerge_impl();
+    }
+  }
+
+  /**
+   * Merges the input of the routes that end at this output port (see 
+   * execNativeMerge_impl). To be called by the native thread at the end of each cycle.
+   */
+  void execNativeMerge(Port* const* sources, const ProcessorChain* const* chains, int count,
+          unsigned long _timeCodeDuration, void * client) {
+    if (isOutput() && (state == running)) {
+      execNativeMerge_impl(sources, chains, count, _timeCodeDuration, client);
+      if (nativeFailed) {
+        if (isLockFreeHandshake()) {
+          failLockFreeNative();
+        } else {
+          Lock lock(stateMutex, nativeLockLimit);
+          failBlockingNative(lock);
+        }
+      }
+    }
+  }
+
+  /**
+   * Emits silence on an output port for a cycle that the port does
+   * not take part in. To be called by the native thread instead of
+   * execNativeCycleInit and execNativeProcess.
+   * @param _timeCodeDuration the length of the cycle.
+   * @param client client-identity of this application.
+   */
+  void execNativeSkip(unsigned long _timeCodeDuration, void * client) {
+    if (isOutput() && (state == running)) {
+      execNativeSkip_impl(_timeCodeDuration, client);
+      if (nativeFailed) {
+        if (isLockFreeHandshake()) {
+          failLockFreeNative();
+        } else {
+          Lock lock(stateMutex, nativeLockLimit);
+          failBlockingNative(lock);
+        }
+      }
+    }
+  }
+
+  /**
+   * @return true if the port has finished its previous cycle (or has not 
+   * yet taken part in a cycle).
+   */
+  bool isReadyForNextCycle() const {
+    RunningSubState s = substate;
+    return (s == started) || isCycleCompleted(s);
+  }
+
+  /**
+   * Tells the port the frame rate of the time-code, so that the slack of
+   * the cycles (see CycleTiming::slack) can be determined. Can be changed at any time.
+   * @param value the number of frames per second, zero if unknown (no slack is recorded).
+   */
+  void setFrameRate(unsigned long value) {
+    frameRate = value;
+  }
+
+  unsigned long getFrameRate() const {
+    return frameRate;
+  }
+
+  /**
+   * The timing statistics of the cycles this port has processed. In batched
+   * dispatch the java process of a port that the dispatcher serves 
+   * lasts until the whole dispatch has returned.
+   * @return the histograms, they can be read from any thread.
+   */
+  const CycleTiming& getCycleTiming() const {
+    return *timing;
+  }
+
+  /**
+   * Clears the timing statistics (a cycle in progress might partly survive).
+   */
+  void resetCycleTiming() {
+    timing->reset();
+  }
+
   bool isOutput() const {
     return output;
   }
@@ -925,14 +2181,22 @@ public:
    * @return true if processException has been set.
    */
   bool hasProcessException() const {
-    return static_cast<bool> (processException);
+    return static_cast<bool> (processException) || (substate == failed) || !nativeErrors.isEmpty();
   }
 
   /**
-   * Permits to access the process exception.
+   * Permits to access the process exception. Errors reported by the native
+   * thread are turned into a NativeError here (the first error reported 
+   * becomes the process exception, the others are discarded).
    * @return a reference to the process exception pointer.
    */
   exception_ptr& getProcessException() {
+    NativeErrorRecord record;
+    if (nativeErrors.pop(record)) {
+      setProcessException(make_exception_ptr(NativeError(record)));
+      while (nativeErrors.pop(record)) {
+      }
+    }
     return processException;
   }
 
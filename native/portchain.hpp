@@ -37,17 +37,20 @@
 #endif
 
 
-#include <condition_variable>
 #include <mutex>
 #include <thread>
 #include <atomic>
 #include <memory>
 #include <exception>
+#include <vector>
+#include <algorithm>
 
 #include "port.hpp"
 #include "util.hpp"
 #include "messages.hpp"
 #include "ptrEnvelope.hpp"
+#include "cycleSignal.hpp"
+#include "cycleDescriptor.hpp"
 
 #define MAX_PORTS 512 // The maximum number of ports, a PortChain can manage.
 
@@ -84,13 +87,105 @@ private:
    */
   bool lastCycle;
 
+  /**
+   * indicates that the ports use the lock-free hand-shake (see Port::setLockFree).
+   */
+  bool lockFree;
 
+  /**
+   * indicates that the java thread serves the ports through one call into the
+   * java dispatcher per cycle (see setBatchedDispatch).
+   */
+  bool batched;
 
-  /** 
-   * The "onStateChanged" condition is signaled to awake waiting threads.
-   * @see runJavaLoop()
+  /**
+   * the frame rate handed to the ports (see setFrameRate).
    */
-  condition_variable_any onStateChanged;
+  unsigned long frameRate;
+
+  /**
+   * what the ports do when the java thread is late (see setXrunPolicy).
+   */
+  XrunPolicy xrunPolicy;
+
+public:
+  /**
+   * The number of xruns whose cycle numbers are remembered.
+   */
+  static const int recentXrunCapacity = 16;
+
+private:
+  /**
+   * The number of cycles the native thread has executed so far (written by the
+   * native thread only).
+   */
+  atomic<unsigned long> cycleCount;
+
+  /**
+   * The number of cycles that have started before the java thread had finished 
+   * the previous cycle (written by the native thread only).
+   */
+  atomic<unsigned long> xrunCount;
+
+  /**
+   * The cycle numbers of the latest xruns; the xrun number "n" is
+   * at index n % recentXrunCapacity.
+   */
+  atomic<unsigned long> recentXruns[recentXrunCapacity];
+
+  /**
+   * The errors the native thread has found on the port-chain itself (errors
+   * on a port are kept by the port), see retrieveProcessException.
+   */
+  SpscRing<NativeErrorRecord> nativeErrors;
+
+  /**
+   * Reports an error of the native thread (use the FAIL_NATIVE macro), does not allocate.
+   */
+  void reportNativeError(NativeErrorCode code, const char* file, int line) {
+    NativeErrorRecord record = {code, -1, file, line, nativeTimeCodeStart, 0, 0};
+    nativeErrors.push(record);
+  }
+
+  /**
+   * The time-code start of the cycle the native thread is executing.
+   */
+  unsigned long nativeTimeCodeStart;
+
+  /**
+   * The native thread records an xrun in the current cycle.
+   */
+  void recordXrun() {
+    unsigned long n = xrunCount;
+    recentXruns[n % recentXrunCapacity] = cycleCount.load();
+    xrunCount = n + 1; // publishes the cycle number.
+  }
+
+  /**
+   * The generation of the snapshot whose ports have last been handed to the
+   * java dispatcher (only used by the java thread).
+   */
+  unsigned long dispatchedGeneration;
+
+  /**
+   * The generation the next published snapshot gets (guarded by the stateMutex).
+   */
+  unsigned long nextGeneration;
+
+  /**
+   * The "javaWakeup" signal is raised by the native thread as soon as the start-control
+   * port has been handed to java, and whenever the state changes.
+   * The java thread waits on it without touching the stateMutex, so an administrative
+   * function holding the stateMutex can never block the java thread.
+   * @see waitAndExecJavaCycle()
+   */
+  CycleSignal javaWakeup;
+
+  /**
+   * The longest time the java thread sleeps without re-checking the port-chain
+   * (only a safety net, normally the java thread is woken by "javaWakeup").
+   */
+  const chrono::milliseconds javaWakeupCheck = chrono::milliseconds(10);
 
   /**
    * Transfers the given port into a state which is compatible with the
@@ -179,6 +274,67 @@ private:
     return -1;
   }
 
+  /**
+   * Builds a new snapshot from the portList and makes it the active one. The previous 
+   * snapshot is retired, it will be reclaimed as soon as no process thread uses it 
+   * any longer. Must be called with the stateMutex locked.
+   * @param excludedIdx a slot to be left out of the new snapshot (-1 to include all slots).
+   */
+  void publishSnapshot(int excludedIdx = -1, bool portsChanged = true) {
+    unique_ptr<PortSnapshot> fresh(new PortSnapshot());
+    fresh->count = 0;
+    fresh->generation = portsChanged ? ++nextGeneration : activeSnapshot.load()->generation;
+    for (int i = 0; i < MAX_PORTS; i++) {
+      if (i != excludedIdx) {
+        auto accessor = portList[i].makeAccessor();
+        if (accessor.hasItem()) {
+          fresh->ports[fresh->count] = accessor.get().get();
+          fresh->count++;
+        }
+      }
+    }
+    resolveRoutes(*fresh);
+    retiredSnapshots.push_back(activeSnapshot.exchange(fresh.release()));
+    reclaimSnapshots();
+  }
+
+  /**
+   * Deletes the retired snapshots no process thread uses any longer.
+   * Must be called with the stateMutex locked.
+   */
+  void reclaimSnapshots() {
+    auto inUse = [this](PortSnapshot * snapshot) {
+      for (auto &entry : readerSnapshot) {
+        if (entry.load() == snapshot) {
+          return true;
+        }
+      }
+      return false;
+    };
+    auto firstReclaimable = stable_partition(retiredSnapshots.begin(), retiredSnapshots.end(), inUse);
+    for (auto it = firstReclaimable; it != retiredSnapshots.end(); ++it) {
+      delete *it;
+    }
+    retiredSnapshots.erase(firstReclaimable, retiredSnapshots.end());
+  }
+
+  /**
+   * Blocks until both process threads have passed a cycle boundary, so that
+   * no port that is missing in the active snapshot is in use any longer.
+   * Must be called with the stateMutex locked.
+   */
+  void waitForRetiredSnapshots() {
+    auto deadline = chrono::steady_clock::now() + waitLimit;
+    reclaimSnapshots();
+    while (!retiredSnapshots.empty()) {
+      if (chrono::steady_clock::now() > deadline) {
+        THROW("Timeout in waitForRetiredSnapshots.")
+      }
+      this_thread::sleep_for(chrono::microseconds(100));
+      reclaimSnapshots();
+    }
+  }
+
   /**
    * This function puts the current thread to sleep as long as the
    * portList is empty. As soon as a port gets
@@ -188,33 +344,39 @@ private:
    * and immediately returns as soon as the state has reached the stopped-state.
    */
   void waitAndExecJavaCycle(JNIEnv * env) {
-    {
-      Lock lock(stateMutex, waitLimit);
-      if (!lock.owns_lock()) {
-        THROW("Timeout in waitForPorts.")
-      }
-
-      // as long as we are not started, we sleep (waiting for the state to become "running")
-      while ((state == registered) || (state == initialized) || (state == created)) {
-        onStateChanged.wait(lock);
+    // as long as we are not started, we sleep (waiting for the state to become "running")
+    while (true) {
+      uint32_t seen = javaWakeup.getSequence();
+      State current = state;
+      if ((current != registered) && (current != initialized) && (current != created)) {
+        break;
       }
+      javaWakeup.waitFor(seen, javaWakeupCheck);
     }
-    bool wait = true;
-    while ((state == running) && (wait)) {
+    waitForJavaCycle();
+  }
 
-      auto accessor = portList[0].makeAccessor();
-      if (!accessor.hasItem()) {
-        THROW("No Start-Control port in port-chain.")
-      }
-      // if the first port (the start-control port) has done nativeCycleInit we can start the java thread
-      if (!accessor.get()->isJavaToExecSubstate()) {
-        this_thread::sleep_for(std::chrono::milliseconds(1));
-        wait = true;
-      } else {
-        wait = false;
+  /**
+   * Puts the java thread to sleep until the start-control port has been
+   * handed to java (or has terminated), or until the port-chain leaves the running state.
+   * The native thread wakes us through "javaWakeup", so there is no polling delay.
+   */
+  void waitForJavaCycle() {
+    while (state == running) {
+      // read the sequence before checking, so a signal given meanwhile is not lost.
+      uint32_t seen = javaWakeup.getSequence();
+      {
+        SnapshotAccessor snapshot(*this, javaReader);
+        if (snapshot.count() == 0) {
+          THROW("No Start-Control port in port-chain.")
+        }
+        // if the first port (the start-control port) has done nativeCycleInit we can start the java thread
+        if (snapshot[0]->isJavaToExecSubstate() || snapshot[0]->isTerminatedSubstate()) {
+          return;
+        }
       }
+      javaWakeup.waitFor(seen, javaWakeupCheck);
     }
-
   }
 
   /**
@@ -424,6 +586,198 @@ protected:
 
   atomic<int> portCount;
 
+  /**
+   * A densely packed copy of the non-empty entries of "portList" (in the same order).
+   * A snapshot is never modified once it has been published; adding or removing
+   * a port publishes a new snapshot (read-copy-update). So the process threads
+   * can walk the live ports without touching the "portList" envelopes.
+   */
+  struct PortSnapshot {
+    int count;
+    /** distinguishes the snapshots, a new snapshot gets a higher generation. */
+    unsigned long generation;
+    Port* ports[MAX_PORTS];
+
+    /** the routes that end at one output port. */
+    struct RouteTarget {
+      int target; ///< the index of the output port in "ports".
+      int first; ///< the index of the first source in "routeSources".
+      int count; ///< the number of sources.
+    };
+    vector<RouteTarget> routeTargets;
+    /** the input ports of the routes, grouped by their output port. */
+    vector<Port*> routeSources;
+    /** the processing of the routes (nullptr for none), parallel to routeSources. */
+    vector<const ProcessorChain*> routeChains;
+    /** keeps the processing of the routes alive as long as the snapshot. */
+    vector<shared_ptr<ProcessorChain> > routeChainOwners;
+  };
+
+  /**
+   * A route from an input port to an output port (see setRoute).
+   */
+  struct RouteDefinition {
+    long from;
+    long to;
+    shared_ptr<ProcessorChain> chain;
+  };
+
+  /** The routes in the order they have been set (guarded by the stateMutex). */
+  vector<RouteDefinition> routeDefinitions;
+
+  /**
+   * @return the index of the port with the given identity in the snapshot, -1 if not found.
+   */
+  static int indexInSnapshot(const PortSnapshot& snapshot, long internalId) {
+    for (int i = 0; i < snapshot.count; i++) {
+      if (snapshot.ports[i]->getId() == internalId) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * Fills the route table of the given snapshot from the route definitions. The
+   * routes of ports that are no longer part of the snapshot are discarded.
+   * Must be called with the stateMutex locked.
+   */
+  void resolveRoutes(PortSnapshot& snapshot) {
+    routeDefinitions.erase(remove_if(routeDefinitions.begin(), routeDefinitions.end(),
+            [&snapshot](const RouteDefinition & route) {
+              return (indexInSnapshot(snapshot, route.from) < 0) || (indexInSnapshot(snapshot, route.to) < 0);
+            }), routeDefinitions.end());
+    for (int target = 0; target < snapshot.count; target++) {
+      PortSnapshot::RouteTarget entry = {target, static_cast<int> (snapshot.routeSources.size()), 0};
+      for (const RouteDefinition& route : routeDefinitions) {
+        if (route.to == snapshot.ports[target]->getId()) {
+          snapshot.routeSources.push_back(snapshot.ports[indexInSnapshot(snapshot, route.from)]);
+          snapshot.routeChains.push_back(route.chain.get());
+          if (route.chain) {
+            snapshot.routeChainOwners.push_back(route.chain);
+          }
+          entry.count++;
+        }
+      }
+      if (entry.count > 0) {
+        snapshot.routeTargets.push_back(entry);
+      }
+    }
+  }
+
+  /**
+   * The threads that read the active snapshot without holding the stateMutex.
+   */
+  enum SnapshotReader {
+    nativeReader = 0, ///< the native process thread (execNativeCycle).
+    javaReader = 1, ///< the java process thread (runJava).
+    snapshotReaderCount = 2
+  };
+
+  /** The snapshot of the ports currently hooked into the chain. */
+  atomic<PortSnapshot*> activeSnapshot;
+
+  /** The snapshot each reader currently uses (nullptr outside a cycle). */
+  atomic<PortSnapshot*> readerSnapshot[snapshotReaderCount];
+
+  /** Replaced snapshots that might still be in use by a reader (guarded by the stateMutex). */
+  vector<PortSnapshot*> retiredSnapshots;
+
+  /**
+   * Gives a process thread access to the active snapshot for the
+   * duration of its life-time (RAII), the snapshot will not be reclaimed meanwhile.
+   */
+  class SnapshotAccessor {
+  private:
+    PortChain& owner;
+    const SnapshotReader reader;
+    PortSnapshot* snapshot;
+  public:
+
+    SnapshotAccessor(PortChain& _owner, SnapshotReader _reader) :
+    owner(_owner),
+    reader(_reader),
+    snapshot(_owner.activeSnapshot.load()) {
+      // announce the snapshot, and make sure it has not been replaced meanwhile.
+      while (true) {
+        owner.readerSnapshot[reader].store(snapshot);
+        PortSnapshot* current = owner.activeSnapshot.load();
+        if (current == snapshot) {
+          break;
+        }
+        snapshot = current;
+      }
+    }
+
+    SnapshotAccessor(const SnapshotAccessor&) = delete;
+
+    ~SnapshotAccessor() {
+      owner.readerSnapshot[reader].store(nullptr);
+    }
+
+    int count() const {
+      return snapshot->count;
+    }
+
+    Port* operator[](int index) const {
+      return snapshot->ports[index];
+    }
+
+    unsigned long generation() const {
+      return snapshot->generation;
+    }
+
+    Port* const* ports() const {
+      return snapshot->ports;
+    }
+
+    const PortSnapshot& content() const {
+      return *snapshot;
+    }
+  };
+
+  /**
+   * Batched dispatch: the cycle entries shared with the java dispatcher, one
+   * for every slot of a snapshot (allocated by setBatchedDispatch).
+   */
+  unique_ptr<CycleEntry[] > dispatchEntries;
+
+  /**
+   * Batched dispatch: hands the java objects of the given ports (see
+   * Port::getDispatchPeer) to the java dispatcher. Called by the java thread
+   * before the first cycle and whenever the ports of the chain have changed.
+   * The implementation is deferred to a subclass.
+   * @param env holds the java worker thread.
+   * @param ports the ports of the active snapshot, in the order of the entries.
+   * @param count the number of ports.
+   */
+  virtual void dispatchPorts_impl(JNIEnv * env, Port* const* ports, int count) {
+    THROW("Batched dispatch is not supported.")
+  }
+
+  /**
+   * Batched dispatch: makes the single call into the java dispatcher, which
+   * serves all entries (of a kind other than "notDispatched").
+   * The implementation is deferred to a subclass.
+   * @param env holds the java worker thread.
+   * @param count the number of entries.
+   */
+  virtual void dispatchCycle_impl(JNIEnv * env, int count) {
+    THROW("Batched dispatch is not supported.")
+  }
+
+  /**
+   * Batched dispatch: retrieves the exception the listener of the given entry
+   * has thrown (the entry is flagged as failed).
+   * The implementation is deferred to a subclass.
+   * @param env holds the java worker thread.
+   * @param index the index of the entry.
+   * @return the exception to be handed to the port.
+   */
+  virtual exception_ptr dispatchFailure_impl(JNIEnv * env, int index) {
+    return make_exception_ptr(runtime_error(AT "Java dispatch failed."));
+  }
+
   enum State {
     created, ///< the portchain is created.
     initialized, ///< the portchain is embeded into the java enviroment (java -call-backs have been installed)
@@ -436,10 +790,33 @@ protected:
   State state;
 
   PortChain() :
-  state(created),
+  lastCycle(false),
+  lockFree(false),
+  batched(false),
+  frameRate(0),
+  xrunPolicy(XrunPolicy::delay),
+  cycleCount(0),
+  xrunCount(0),
+  nativeErrors(4),
+  nativeTimeCodeStart(0),
+  dispatchedGeneration(0),
+  nextGeneration(0),
   portCount(0),
-  lastCycle(false) {
+  activeSnapshot(new PortSnapshot()),
+  state(created) {
+    for (auto &entry : readerSnapshot) {
+      entry = nullptr;
+    }
+    for (auto &entry : recentXruns) {
+      entry = 0;
+    }
+  }
 
+  virtual ~PortChain() {
+    delete activeSnapshot.load();
+    for (PortSnapshot* retired : retiredSnapshots) {
+      delete retired;
+    }
   }
 
   /**
@@ -478,7 +855,7 @@ public:
       THROW("Timeout in initialize.")
     }
     initialize_impl(env, jSystemListener, move(startControl), move(endControl));
-    onStateChanged.notify_all();
+    javaWakeup.signal();
   }
 
   /**
@@ -492,7 +869,7 @@ public:
       THROW("Timeout in registerAtServer.")
     }
     registerAtServer_impl(client);
-    onStateChanged.notify_all();
+    javaWakeup.signal();
   }
 
   /**
@@ -504,7 +881,7 @@ public:
       THROW("Timeout in start.")
     }
     start_impl();
-    onStateChanged.notify_all();
+    javaWakeup.signal();
   }
 
   /**
@@ -516,63 +893,197 @@ public:
    */
   void execJavaCycle(JNIEnv * env, bool lastCycle) {
     // no lock! We rely upon the ports to manage their life cycle.
-    for (auto &entry : portList) {
-      auto accessor = entry.makeAccessor();
-      if (accessor.hasItem()) {
-        accessor.get()->execJavaProcess(env, lastCycle);
+    SnapshotAccessor snapshot(*this, javaReader);
+    if (batched) {
+      execJavaCycleBatched(env, lastCycle, snapshot);
+      return;
+    }
+    for (int i = 0; i < snapshot.count(); i++) {
+      snapshot[i]->execJavaProcess(env, lastCycle);
+    }
+  }
+
+  /**
+   * Batched version of execJavaCycle: the java thread takes all ports in
+   * order (waiting for the native thread where needed), makes one call into the
+   * java dispatcher and then hands all ports back. So the number of JNI
+   * transitions per cycle does not depend on the number of ports.
+   * @param env holds the java worker thread.
+   * @param lastCycle indicates that this is the last cycle.
+   * @param snapshot the ports of this cycle.
+   */
+  void execJavaCycleBatched(JNIEnv * env, bool lastCycle, const SnapshotAccessor& snapshot) {
+    const int count = snapshot.count();
+    if (snapshot.generation() != dispatchedGeneration) {
+      dispatchPorts_impl(env, snapshot.ports(), count);
+      dispatchedGeneration = snapshot.generation();
+    }
+    int dispatched = 0;
+    for (int i = 0; i < count; i++) {
+      if (snapshot[i]->beginJavaDispatch(env, lastCycle, dispatchEntries[i])) {
+        dispatched++;
       }
     }
+    if (dispatched == 0) {
+      return;
+    }
+    exception_ptr cycleFailure;
+    try {
+      dispatchCycle_impl(env, count);
+    } catch (...) {
+      cycleFailure = current_exception();
+    }
+    for (int i = 0; i < count; i++) {
+      CycleEntry& entry = dispatchEntries[i];
+      if (entry.kind == CycleEntry::notDispatched) {
+        continue;
+      }
+      exception_ptr failure = cycleFailure;
+      if ((!failure) && ((entry.flags & CycleEntry::failedFlag) != 0)) {
+        failure = dispatchFailure_impl(env, i);
+      }
+      snapshot[i]->endJavaDispatch(env, entry, failure);
+      entry.kind = CycleEntry::notDispatched;
+    }
   }
 
   /**
    * Calls the "execNativeCycleInit()" and execNativeProcess()"  functions on all ports.
-   * This function will block  on the first port that is waiting for the java thread.
+   * This function will block  on the first port that is waiting for the java thread,
+   * unless the lock-free mode is selected. In lock-free mode a late java thread
+   * is not an error, the ports catch up in a later cycle (see XrunPolicy).
+   * A cycle that starts before the java thread has finished the previous
+   * one is counted as an xrun (this only happens in lock-free mode, in the
+   * blocking mode the native thread has waited for the java thread).
    * @param env holds the java worker thread.
    */
   void execNativeCycle(unsigned long timeCodeStart, unsigned long timeCodeDuration, void * client) {
     // No lock! We rely upon the ports to manage their life cycle.
-
+    SnapshotAccessor snapshot(*this, nativeReader);
+    const int count = snapshot.count();
+    nativeTimeCodeStart = timeCodeStart;
+    if (count == 0) {
+      FAIL_NATIVE(noEndControl)
+    }
     {
       // first, let's verify that the last port (the end-control port) has finished the previous cycle
       // and if it is terminated we just return.
-      auto accessor = portList[MAX_PORTS - 1].makeAccessor();
-      if (accessor.hasItem()) {
-        if (!accessor.get()->isRunningState()) {
-          return;
-        }
-        if (accessor.get()->isTerminatedSubstate()) {
-          return;
-        }
+      Port* endControl = snapshot[count - 1];
+      if (!endControl->isRunningState()) {
+        return;
+      }
+      if (endControl->isTerminatedSubstate()) {
+        return;
+      }
 
-        if ((!accessor.get()->isCycleDoneSubstate()) && (!accessor.get()->isStartedSubstate())) {
-          if (accessor.get()->isRunningState()) {
-            THROW("XRUN.")
-          } else {
-            return; //oops has been stopped meanwhile
-          }
-        }
-      } else {
-        THROW("No End-Control port in port-chain.")
+      if (!endControl->isReadyForNextCycle()) {
+        recordXrun();
       }
     }
+    cycleCount++;
 
-    // initialize the new Cycle on all ports.
-    for (auto &entry : portList) {
-      auto accessor = entry.makeAccessor();
-      if (accessor.hasItem()) {
-        accessor.get()->execNativeCycleInit(timeCodeStart, timeCodeDuration);
-      }
+    // initialize the new Cycle on all ports (ports without connections may skip it).
+    for (int i = 0; i < count; i++) {
+      snapshot[i]->sampleConnections(client);
+      snapshot[i]->execNativeCycleInit(timeCodeStart, timeCodeDuration);
     }
     // perform the native work on all ports
-    for (auto &entry : portList) {
-      auto accessor = entry.makeAccessor();
-      if (accessor.hasItem()) {
-        // note: output ports will wait for "execJavaCycle" before
-        // executing the following statement, consequently there
-        // is a danger of dead-lock here.
-        accessor.get()->execNativeProcess(client);
+    for (int i = 0; i < count; i++) {
+      // note: output ports will wait for "execJavaCycle" before
+      // executing the following statement, consequently there
+      // is a danger of dead-lock here.
+      snapshot[i]->execNativeProcess(client);
+      if (i == 0) {
+        // the start-control port has been handed to java, let the java thread run.
+        javaWakeup.signal();
       }
     }
+    execNativeRoutes(snapshot, timeCodeDuration, client);
+  }
+
+  /**
+   * Forwards the input of the routes to their output ports (native thread).
+   */
+  void execNativeRoutes(const SnapshotAccessor& snapshot, unsigned long timeCodeDuration, void * client) {
+    const PortSnapshot& content = snapshot.content();
+    for (const PortSnapshot::RouteTarget& entry : content.routeTargets) {
+      content.ports[entry.target]->execNativeMerge(&content.routeSources[entry.first],
+              &content.routeChains[entry.first], entry.count, timeCodeDuration, client);
+    }
+  }
+
+  /**
+   * Forwards the events an input port receives to an output port, without any
+   * involvement of the java thread; the events are merged (in time order) with
+   * the output of the java thread and of other routes. Routes can be set
+   * at any time, they take effect with the next cycle. A route that already
+   * exists gets the new processing.
+   * @param from the internal identifier of the input port.
+   * @param to the internal identifier of the output port.
+   * @param chain the processing of the forwarded events (empty for none).
+   */
+  void setRoute(long from, long to, unique_ptr<ProcessorChain> && chain) {
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in setRoute.")
+    }
+    PortSnapshot* current = activeSnapshot.load();
+    int fromIdx = indexInSnapshot(*current, from);
+    int toIdx = indexInSnapshot(*current, to);
+    if ((fromIdx < 0) || (toIdx < 0)) {
+      THROW("Cannot setRoute, port not found.")
+    }
+    if (!current->ports[fromIdx]->isInput() || !current->ports[toIdx]->isOutput()) {
+      THROW("A route must lead from an input port to an output port.")
+    }
+    current->ports[toIdx]->prepareMerge();
+    shared_ptr<ProcessorChain> shared((chain && !chain->isEmpty()) ? chain.release() : nullptr);
+    int sources = 0;
+    for (RouteDefinition& route : routeDefinitions) {
+      if ((route.from == from) && (route.to == to)) {
+        route.chain = shared;
+        publishSnapshot(-1, false);
+        return;
+      }
+      if (route.to == to) {
+        sources++;
+      }
+    }
+    if (sources >= Port::maxMergeSources) {
+      THROW("Too many routes to one output port.")
+    }
+    routeDefinitions.push_back(RouteDefinition{from, to, shared});
+    publishSnapshot(-1, false);
+  }
+
+  /**
+   * Removes a route (see setRoute).
+   * @return false if there was no such route.
+   */
+  bool removeRoute(long from, long to) {
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in removeRoute.")
+    }
+    for (auto it = routeDefinitions.begin(); it != routeDefinitions.end(); ++it) {
+      if ((it->from == from) && (it->to == to)) {
+        routeDefinitions.erase(it);
+        publishSnapshot(-1, false);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @return the number of routes currently set.
+   */
+  int getRouteCount() {
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in getRouteCount.")
+    }
+    return static_cast<int> (routeDefinitions.size());
   }
 
   /**
@@ -585,7 +1096,7 @@ public:
       THROW("Timeout in stop.")
     }
     stop_impl();
-    onStateChanged.notify_all();
+    javaWakeup.signal();
     lock.unlock();
 
   }
@@ -602,7 +1113,7 @@ public:
       THROW("Timeout in unregisterAtServer.")
     }
     unregisterAtServer_impl(client);
-    onStateChanged.notify_all();
+    javaWakeup.signal();
   }
 
   /**
@@ -615,7 +1126,154 @@ public:
       THROW("Timeout in un-initialize.")
     }
     uninitialize_impl(env);
-    onStateChanged.notify_all();
+    javaWakeup.signal();
+  }
+
+  /**
+   * Selects the lock-free hand-shake (see Port::setLockFree) for all ports
+   * of this chain, including the ports that will be added later.
+   * The mode can only be changed before the port-chain is started.
+   * @param value true to select the lock-free mode.
+   */
+  void setLockFree(bool value) {
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in setLockFree.")
+    }
+    if ((state != created) && (state != initialized) && (state != registered)) {
+      THROW("Cannot change the lock-free mode in wrong state.")
+    }
+    if ((!value) && batched) {
+      THROW("Batched dispatch needs the lock-free hand-shake.")
+    }
+    if ((!value) && (xrunPolicy != XrunPolicy::delay)) {
+      THROW("The xrun policy needs the lock-free hand-shake.")
+    }
+    for (auto &entry : portList) {
+      auto accessor = entry.makeAccessor();
+      if (accessor.hasItem()) {
+        accessor.get()->setLockFree(value);
+      }
+    }
+    lockFree = value;
+  }
+
+  bool isLockFree() const {
+    return lockFree;
+  }
+
+  /**
+   * Selects the batched dispatch: instead of one JNI call per port, the java
+   * thread makes a single call per cycle into the java dispatcher (see
+   * dispatchCycle_impl). Ports that the dispatcher cannot serve (see
+   * Port::getDispatchKind) are still called one by one.
+   * Batched dispatch needs the lock-free hand-shake (see setLockFree) and can
+   * only be selected before the port-chain is started.
+   * @param value true to select the batched dispatch.
+   */
+  void setBatchedDispatch(bool value) {
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in setBatchedDispatch.")
+    }
+    if ((state != created) && (state != initialized) && (state != registered)) {
+      THROW("Cannot change the dispatch mode in wrong state.")
+    }
+    if (value && (!lockFree)) {
+      THROW("Batched dispatch needs the lock-free hand-shake.")
+    }
+    if (value && (!dispatchEntries)) {
+      dispatchEntries.reset(new CycleEntry[MAX_PORTS]());
+    }
+    dispatchedGeneration = ~0UL; // the dispatcher has not seen any ports yet.
+    batched = value;
+  }
+
+  bool isBatchedDispatch() const {
+    return batched;
+  }
+
+  /**
+   * Tells all ports of this chain, including the ports that will be added 
+   * later, the frame rate of the time-code (see Port::setFrameRate).
+   * @param value the number of frames per second, zero if unknown.
+   */
+  void setFrameRate(unsigned long value) {
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in setFrameRate.")
+    }
+    for (auto &entry : portList) {
+      auto accessor = entry.makeAccessor();
+      if (accessor.hasItem()) {
+        accessor.get()->setFrameRate(value);
+      }
+    }
+    frameRate = value;
+  }
+
+  unsigned long getFrameRate() const {
+    return frameRate;
+  }
+
+  /**
+   * Selects what the ports of this chain, including the ports that will be
+   * added later, do when the java thread is late (see XrunPolicy). 
+   * The policies other than "delay" need the lock-free hand-shake (see setLockFree).
+   * The policy can only be changed before the port-chain is started.
+   * @param value the policy.
+   */
+  void setXrunPolicy(XrunPolicy value) {
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in setXrunPolicy.")
+    }
+    if ((state != created) && (state != initialized) && (state != registered)) {
+      THROW("Cannot change the xrun policy in wrong state.")
+    }
+    if ((value != XrunPolicy::delay) && (!lockFree)) {
+      THROW("The xrun policy needs the lock-free hand-shake.")
+    }
+    for (auto &entry : portList) {
+      auto accessor = entry.makeAccessor();
+      if (accessor.hasItem()) {
+        accessor.get()->setXrunPolicy(value);
+      }
+    }
+    xrunPolicy = value;
+  }
+
+  XrunPolicy getXrunPolicy() const {
+    return xrunPolicy;
+  }
+
+  /**
+   * @return the number of cycles the native thread has executed so far.
+   */
+  unsigned long getCycleCount() const {
+    return cycleCount;
+  }
+
+  /**
+   * @return the number of cycles that started before the java thread had 
+   * finished the previous cycle.
+   */
+  unsigned long getXrunCount() const {
+    return xrunCount;
+  }
+
+  /**
+   * Retrieves the cycle numbers (counted from zero) of the latest xruns.
+   * @param cycles receives up to recentXrunCapacity cycle numbers, the oldest first.
+   * @return the number of cycle numbers stored.
+   */
+  int getRecentXruns(unsigned long (&cycles)[recentXrunCapacity]) const {
+    unsigned long n = xrunCount;
+    int stored = (n < recentXrunCapacity) ? static_cast<int> (n) : recentXrunCapacity;
+    for (int i = 0; i < stored; i++) {
+      cycles[i] = recentXruns[(n - stored + i) % recentXrunCapacity];
+    }
+    return stored;
   }
 
   bool isCreatedState() const {
@@ -676,7 +1334,7 @@ public:
     int newIdx = findSlotForNewPort(newPort);
     addPort_impl(move(newPort), newIdx, client);
 
-    onStateChanged.notify_all();
+    javaWakeup.signal();
   }
 private:
 
@@ -691,12 +1349,15 @@ private:
    */
   void addPort_impl(unique_ptr<Port> && newPort, int newIdx, void * client) {
 
+    newPort->setLockFree(lockFree);
+    newPort->setXrunPolicy(xrunPolicy);
+    newPort->setFrameRate(frameRate);
     registerAndStart(newPort, client);
 
     // try to insert the new port into the given slot, if the slot is for too long an exception is thrown.
 
     portList[newIdx].setItemWait(move(newPort));
-
+    publishSnapshot();
   }
 
 public:
@@ -721,6 +1382,9 @@ public:
       auto accessor = portList[removeIdx].makeAccessor();
       accessor.get()->shutdown(env, client, false);
     }
+    // the process threads must not see the port any longer before we can remove it.
+    publishSnapshot(removeIdx);
+    waitForRetiredSnapshots();
     // try to remove the given port. If the port is locked for too long an exception is thrown.
     auto portToRemove = portList[removeIdx].removeItemWait();
 
@@ -729,7 +1393,7 @@ public:
     }
 
     portCount--;
-    onStateChanged.notify_all();
+    javaWakeup.signal();
 
     return portToRemove;
   }
@@ -749,18 +1413,23 @@ public:
     waitAndExecJavaCycle(env);
 
     bool more = true;
+    bool isLastCycle = lastCycle;
 
     while ((state == running) && (more)) {
-
-      auto accessor = portList[0].makeAccessor();
-      if (!accessor.hasItem()) {
-        THROW("No Start-Control port in port-chain.")
+      {
+        SnapshotAccessor snapshot(*this, javaReader);
+        if (snapshot.count() == 0) {
+          THROW("No Start-Control port in port-chain.")
+        }
+        // if the first port (the start-control port) has terminated we'll end the java thread
+        more = !snapshot[0]->isTerminatedSubstate();
       }
-      // if the first port (the start-control port) has terminated we'll end the java thread
-      if (accessor.get()->isTerminatedSubstate()) {
-        more = false;
-      } else {
-        execJavaCycle(env, lastCycle);
+      if (more) {
+        execJavaCycle(env, isLastCycle);
+        // a stop requested from now on concerns the cycle we are going to wait for.
+        isLastCycle = lastCycle;
+        // between cycles, sleep until the native thread hands us the next one.
+        waitForJavaCycle();
       }
     }
   }
@@ -772,7 +1441,7 @@ public:
    */
   void shutdown(JNIEnv * env, void * client) {
     Lock lock(stateMutex, waitLimit);
-    onStateChanged.notify_all(); // make sure the java thread gets released whatever happens
+    javaWakeup.signal(); // make sure the java thread gets released whatever happens
     if (!lock.owns_lock()) {
       //force shutdown
       shutdown_impl(env, client);
@@ -794,6 +1463,28 @@ public:
 
   }
 
+  /**
+   * Executes the given function on the port with the given identity. While the 
+   * function executes, the port cannot be removed from the chain.
+   * @param internalId the identifier to search for
+   * @param function a callable taking a "Port&".
+   * @return false if no port with the given identity is part of the portchain.
+   */
+  template<typename Function>
+  bool withPort(long internalId, Function function) {
+    // no lock! The accessor protects the port.
+    for (auto &entry : portList) {
+      auto accessor = entry.makeAccessor();
+      if (accessor.hasItem()) {
+        if (accessor.get()->getId() == internalId) {
+          function(*accessor.get());
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
   void waitForCycleDone() {
 
     auto accessor = portList[MAX_PORTS - 1].makeAccessor();
@@ -810,12 +1501,21 @@ public:
    * the pointer will be empty.
    */
   exception_ptr retrieveProcessException() {
-    for (auto &entry : portList) {
-      auto accessor = entry.makeAccessor();
-      if (accessor.hasItem()) {
-        if (accessor.get()->hasProcessException()) {
-          return move(accessor.get()->getProcessException());
-        }
+    // the lock keeps the active snapshot (and its ports) alive.
+    Lock lock(stateMutex, waitLimit);
+    if (!lock.owns_lock()) {
+      THROW("Timeout in retrieveProcessException.")
+    }
+    NativeErrorRecord first, other;
+    if (nativeErrors.pop(first)) {
+      while (nativeErrors.pop(other)) {
+      }
+      return make_exception_ptr(NativeError(first));
+    }
+    PortSnapshot* snapshot = activeSnapshot.load();
+    for (int i = 0; i < snapshot->count; i++) {
+      if (snapshot->ports[i]->hasProcessException()) {
+        return move(snapshot->ports[i]->getProcessException());
       }
     }
     return nullptr;
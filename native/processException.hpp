@@ -80,7 +80,7 @@ public:
    */
   virtual void throwIntoJava(JNIEnv *env) {
 
-    jclass jexceptionCls = env->FindClass("java/lang/Exception");
+    jclass jexceptionCls = jniRegistry().exceptionClass;
     if (jexceptionCls == NULL) {
       // unable to find Java class, give up..
       return;
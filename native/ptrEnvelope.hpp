@@ -27,6 +27,7 @@
 #include <chrono>
 #include "port.hpp"
 #include "messages.hpp"
+#include "rtLog.hpp"
 
 /**
  * The class PtrEnvelope permits to use a "unique_ptr" in a thread save way.
@@ -120,7 +121,7 @@ public:
     if (useCount != 0) {
       // it is not wise to throw an exception in the destructor.
       // At least we can leave a message.
-      cerr << "### A PtrEnvelope is deleted in wrong state!" << endl;
+      rtLog().log(RtLogLevel::warning, "A PtrEnvelope is deleted in wrong state.");
     }
   }
   /**
@@ -0,0 +1,257 @@
+/*
+ * File:   rtLog.hpp
+ *
+ * Created on October 16, 2026, 9:05 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef RTLOG_HPP
+#define	RTLOG_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sstream>
+
+using namespace std;
+
+/**
+ * The ordinals must match "MidiJackNative.java".
+ */
+enum class RtLogLevel : int {
+  info = 0,
+  warning = 1,
+  severe = 2
+};
+
+/**
+ * One entry of the log. The message must be a string literal, so that
+ * nothing has to be copied or allocated when logging.
+ */
+struct RtLogRecord {
+  RtLogLevel level;
+  const char* message;
+  /** a number that completes the message (e.g. a port id). */
+  long argument;
+  /** how often the same message has been suppressed before this record (rate limit). */
+  unsigned long suppressed;
+
+  static const long noArgument = -1;
+
+  /**
+   * Not real-time safe.
+   * @return the text of the record.
+   */
+  string toString() const {
+    ostringstream text;
+    text << message;
+    if (argument != noArgument) {
+      text << " (" << argument << ")";
+    }
+    if (suppressed > 0) {
+      text << " [" << suppressed << " similar messages suppressed]";
+    }
+    return text.str();
+  }
+};
+
+/**
+ * A log that can be written from within the real-time thread. "log" never
+ * blocks, never allocates and never does any I/O: it puts a fixed-size record
+ * into a preallocated ring. Any thread may log (also destructors
+ * on the java thread), one thread at a time takes the records ("take") and
+ * forwards them (to java.util.logging, see jackNative.cpp).
+ * </p>
+ * <p>
+ * A message that repeats is logged at most once per "minimum interval"; the
+ * number of suppressed repetitions is passed with the next record of the
+ * same message. When the ring is full, records are dropped and counted.
+ * </p>
+ */
+class RtLog {
+public:
+  /** The number of records the ring can hold (a power of two). */
+  static const size_t capacity = 64;
+
+  /** The number of different messages that are rate limited. */
+  static const int limiterCapacity = 32;
+
+  /** The default of the shortest time (in milliseconds) between two records of the same message. */
+  static const int64_t defaultMinIntervalMillis = 1000;
+
+private:
+
+  /**
+   * A slot of the ring. The sequence tells whose turn it is: the producer of
+   * record "n" may write when sequence == n, the consumer may read when
+   * sequence == n + 1 (see D. Vyukov's bounded queue).
+   */
+  struct Slot {
+    atomic<size_t> sequence;
+    RtLogRecord record;
+  };
+
+  /** The rate limit of one message. */
+  struct Limiter {
+    atomic<const char*> message;
+    /** the time of the latest record of this message (nanoseconds, zero for never). */
+    atomic<int64_t> lastTime;
+    atomic<unsigned long> suppressed;
+  };
+
+  /** The shortest time (in nanoseconds) between two records of the same message. */
+  const int64_t minIntervalNanos;
+
+  Slot slots[capacity];
+  Limiter limiters[limiterCapacity];
+
+  /** The number of records ever reserved by the producers. */
+  atomic<size_t> head;
+
+  /** The number of records ever taken; only written by the consumer. */
+  atomic<size_t> tail;
+
+  /** The number of records lost because the ring was full. */
+  atomic<unsigned long> droppedCount;
+
+  static int64_t nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /**
+   * @return the limiter for the given message, nullptr if all limiters are taken.
+   */
+  Limiter* limiterFor(const char* message) {
+    size_t start = reinterpret_cast<uintptr_t> (message) % limiterCapacity;
+    for (int i = 0; i < limiterCapacity; i++) {
+      Limiter& limiter = limiters[(start + i) % limiterCapacity];
+      const char* current = limiter.message.load(memory_order_acquire);
+      if (current == message) {
+        return &limiter;
+      }
+      if ((current == nullptr)
+              && (limiter.message.compare_exchange_strong(current, message) || (current == message))) {
+        return &limiter;
+      }
+    }
+    return nullptr;
+  }
+
+  bool push(const RtLogRecord& record) {
+    size_t position = head.load(memory_order_relaxed);
+    for (;;) {
+      Slot& slot = slots[position % capacity];
+      size_t sequence = slot.sequence.load(memory_order_acquire);
+      intptr_t difference = static_cast<intptr_t> (sequence) - static_cast<intptr_t> (position);
+      if (difference == 0) {
+        if (head.compare_exchange_weak(position, position + 1, memory_order_relaxed)) {
+          slot.record = record;
+          slot.sequence.store(position + 1, memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        droppedCount.fetch_add(1, memory_order_relaxed);
+        return false;
+      } else {
+        position = head.load(memory_order_relaxed);
+      }
+    }
+  }
+
+public:
+
+  /**
+   * @param minIntervalMillis the shortest time between two records of the same message.
+   */
+  explicit RtLog(int64_t minIntervalMillis = defaultMinIntervalMillis) :
+  minIntervalNanos(minIntervalMillis * 1000000),
+  head(0),
+  tail(0),
+  droppedCount(0) {
+    for (size_t i = 0; i < capacity; i++) {
+      slots[i].sequence = i;
+    }
+    for (auto &limiter : limiters) {
+      limiter.message = nullptr;
+      limiter.lastTime = 0;
+      limiter.suppressed = 0;
+    }
+  }
+
+  RtLog(const RtLog&) = delete;
+
+  /**
+   * Logs a message (real-time safe, any thread).
+   * @param level the severity.
+   * @param message a string literal.
+   * @param argument a number that completes the message.
+   * @return false if the record has been suppressed or dropped.
+   */
+  bool log(RtLogLevel level, const char* message, long argument = RtLogRecord::noArgument) {
+    RtLogRecord record = {level, message, argument, 0};
+    Limiter* limiter = limiterFor(message);
+    if (limiter != nullptr) {
+      int64_t now = nowNanos();
+      int64_t last = limiter->lastTime.load(memory_order_relaxed);
+      if (((last != 0) && (now - last < minIntervalNanos))
+              || !limiter->lastTime.compare_exchange_strong(last, now, memory_order_relaxed)) {
+        limiter->suppressed.fetch_add(1, memory_order_relaxed);
+        return false;
+      }
+      record.suppressed = limiter->suppressed.exchange(0, memory_order_relaxed);
+    }
+    return push(record);
+  }
+
+  /**
+   * Takes the oldest record (one consumer thread at a time).
+   * @param record receives the record.
+   * @return false if there is no record.
+   */
+  bool take(RtLogRecord& record) {
+    size_t position = tail.load(memory_order_relaxed);
+    Slot& slot = slots[position % capacity];
+    if (slot.sequence.load(memory_order_acquire) != position + 1) {
+      return false;
+    }
+    record = slot.record;
+    slot.sequence.store(position + capacity, memory_order_release);
+    tail.store(position + 1, memory_order_relaxed);
+    return true;
+  }
+
+  /**
+   * @return the number of records lost so far because the ring was full.
+   */
+  unsigned long getDroppedCount() const {
+    return droppedCount.load(memory_order_relaxed);
+  }
+};
+
+/**
+ * @return the log of the native library. It is never destroyed, so
+ * destructors of static objects can still use it.
+ */
+inline RtLog& rtLog() {
+  static RtLog* log = new RtLog();
+  return *log;
+}
+
+#endif	/* RTLOG_HPP */
@@ -0,0 +1,499 @@
+/*
+ * File:   simulatedBackend.hpp
+ *
+ * Created on October 16, 2026, 10:45 PM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SIMULATEDBACKEND_HPP
+#define	SIMULATEDBACKEND_HPP
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include "midiBackend.hpp"
+#include "messages.hpp"
+
+using namespace std;
+
+/**
+ * An in-process driver that replaces the Jack server, so that the port-chain
+ * can be exercised (and benchmarked) on machines without an audio system.
+ * </p>
+ * <p>
+ * The simulated driver runs the native cycle from its own thread, at a given
+ * period and with a given number of frames per cycle. Events "injected" into an
+ * input port are delivered in the cycle their time-code falls into; the events
+ * written to an output port are "captured" together with their time-code.
+ * </p>
+ * <p>
+ * Alternatively, the cycles can be driven one by one through "runCycle"
+ * (without starting the thread).
+ * </p>
+ */
+class SimulatedBackend : public MidiBackend {
+public:
+
+  /**
+   * The native process function; called once per cycle with the
+   * time-code of the first frame and the number of frames of the cycle.
+   */
+  typedef function<void(unsigned long, unsigned long) > Process;
+
+  /**
+   * A Midi event with its absolute time-code.
+   */
+  struct TimedEvent {
+    unsigned long time;
+    vector<uint8_t> midi;
+  };
+
+  /** The maximum number of events a port buffer can hold per cycle. */
+  static const int maxEventsPerCycle = 1024;
+  /** The maximum number of Midi bytes a port buffer can hold per cycle. */
+  static const int maxBytesPerCycle = 32768;
+
+private:
+
+  /**
+   * The buffer of one port for one cycle (allocated once, when the port is registered).
+   */
+  struct Buffer {
+
+    struct Entry {
+      uint32_t time;
+      uint32_t offset;
+      uint32_t size;
+    };
+    unique_ptr<Entry[] > entries;
+    unique_ptr<uint8_t[] > bytes;
+    int eventCount;
+    int byteCount;
+
+    Buffer() :
+    entries(new Entry[maxEventsPerCycle]),
+    bytes(new uint8_t[maxBytesPerCycle]),
+    eventCount(0),
+    byteCount(0) {
+    }
+
+    uint8_t* reserve(uint32_t time, size_t size) {
+      if ((eventCount >= maxEventsPerCycle) || (size > static_cast<size_t> (maxBytesPerCycle - byteCount))) {
+        return nullptr;
+      }
+      if ((eventCount > 0) && (time < entries[eventCount - 1].time)) {
+        return nullptr; // out of order, as with Jack
+      }
+      Entry& entry = entries[eventCount];
+      entry.time = time;
+      entry.offset = byteCount;
+      entry.size = static_cast<uint32_t> (size);
+      eventCount++;
+      byteCount += static_cast<int> (size);
+      return bytes.get() + entry.offset;
+    }
+
+    void clear() {
+      eventCount = 0;
+      byteCount = 0;
+    }
+  };
+
+  struct SimulatedPort {
+    const string name;
+    const bool input;
+    Buffer buffer;
+    /** input ports: the injected events that wait for their cycle (ordered by time). */
+    deque<TimedEvent> script;
+    /** output ports: the events written so far. */
+    vector<TimedEvent> captured;
+    /** whether the port counts as connected (see setConnected). */
+    atomic<bool> connected;
+
+    SimulatedPort(const string& _name, bool _input) :
+    name(_name),
+    input(_input),
+    connected(true) {
+    }
+  };
+
+  const unsigned long bufferSize;
+  const chrono::microseconds period;
+
+  /** guards "ports" and the scripts and captures of all ports. */
+  mutable mutex portsMutex;
+  vector<unique_ptr<SimulatedPort> > ports;
+
+  /** the time-code of the next cycle (written by the cycle thread, guarded by the timeCodeMutex). */
+  unsigned long timeCode;
+  mutable mutex timeCodeMutex;
+  condition_variable timeCodeAdvanced;
+
+  atomic<bool> running;
+  thread cycleThread;
+
+  atomic<unsigned long> cycleCount;
+  atomic<long long> longestCycleNanos;
+  atomic<long long> totalCycleNanos;
+
+  typedef lock_guard<mutex> Lock;
+
+  SimulatedPort* findPort(const string& name) const {
+    for (auto &port : ports) {
+      if (port->name == name) {
+        return port.get();
+      }
+    }
+    return nullptr;
+  }
+
+  /**
+   * Moves the injected events of the coming cycle into the input buffers and
+   * empties the output buffers. Must be called with the portsMutex held.
+   */
+  void prepareCycle() {
+    const unsigned long cycleEnd = timeCode + bufferSize;
+    for (auto &port : ports) {
+      port->buffer.clear();
+      if (!port->input) {
+        continue;
+      }
+      while ((!port->script.empty()) && (port->script.front().time < cycleEnd)) {
+        const TimedEvent& event = port->script.front();
+        // events injected too late are delivered at the start of the cycle.
+        uint32_t offset = (event.time > timeCode) ? static_cast<uint32_t> (event.time - timeCode) : 0;
+        uint8_t* target = port->buffer.reserve(offset, event.midi.size());
+        if (target == nullptr) {
+          break; // the buffer is full, the remaining events wait for the next cycle.
+        }
+        memcpy(target, event.midi.data(), event.midi.size());
+        port->script.pop_front();
+      }
+    }
+  }
+
+  /**
+   * Captures the events written to the output buffers.
+   * Must be called with the portsMutex held.
+   */
+  void collectCycle() {
+    for (auto &port : ports) {
+      if (port->input) {
+        continue;
+      }
+      const Buffer& buffer = port->buffer;
+      for (int i = 0; i < buffer.eventCount; i++) {
+        const Buffer::Entry& entry = buffer.entries[i];
+        const uint8_t* midi = buffer.bytes.get() + entry.offset;
+        port->captured.push_back(TimedEvent{timeCode + entry.time, vector<uint8_t>(midi, midi + entry.size)});
+      }
+    }
+  }
+
+  void run(Process process) {
+    auto next = chrono::steady_clock::now();
+    while (running) {
+      runCycle(process);
+      if (period.count() > 0) {
+        next += period;
+        this_thread::sleep_until(next);
+      } else {
+        this_thread::yield();
+      }
+    }
+  }
+
+public:
+
+  /**
+   * @param _bufferSize the number of frames per cycle.
+   * @param _period the time between the start of two cycles; zero to run
+   * the cycles back-to-back.
+   * @param startTimeCode the time-code of the first cycle.
+   */
+  SimulatedBackend(unsigned long _bufferSize, chrono::microseconds _period, unsigned long startTimeCode = 0) :
+  bufferSize(_bufferSize),
+  period(_period),
+  timeCode(startTimeCode),
+  running(false),
+  cycleCount(0),
+  longestCycleNanos(0),
+  totalCycleNanos(0) {
+    if (_bufferSize == 0) {
+      THROW("Buffer size must be positive.")
+    }
+  }
+
+  SimulatedBackend(const SimulatedBackend&) = delete;
+
+  virtual ~SimulatedBackend() {
+    stop();
+  }
+
+  /**
+   * Starts the cycle thread.
+   * @param process the native process function.
+   */
+  void start(Process process) {
+    if (running) {
+      THROW("The simulated driver is already running.")
+    }
+    running = true;
+    cycleThread = thread([this, process] {
+      run(process);
+    });
+  }
+
+  /**
+   * Stops the cycle thread (returns when the thread has ended).
+   */
+  void stop() {
+    running = false;
+    if (cycleThread.joinable()) {
+      if (cycleThread.get_id() == this_thread::get_id()) {
+        cycleThread.detach();
+      } else {
+        cycleThread.join();
+      }
+    }
+  }
+
+  bool isRunning() const {
+    return running;
+  }
+
+  /**
+   * Executes one cycle in the calling thread.
+   * @param process the native process function.
+   */
+  void runCycle(const Process& process) {
+    {
+      Lock lock(portsMutex);
+      prepareCycle();
+    }
+    auto started = chrono::steady_clock::now();
+    process(timeCode, bufferSize);
+    long long elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count();
+    totalCycleNanos += elapsed;
+    if (elapsed > longestCycleNanos) {
+      longestCycleNanos = elapsed;
+    }
+    {
+      Lock lock(portsMutex);
+      collectCycle();
+    }
+    {
+      Lock lock(timeCodeMutex);
+      timeCode += bufferSize;
+    }
+    cycleCount++;
+    timeCodeAdvanced.notify_all();
+  }
+
+  /**
+   * @return the time-code of the next cycle (all earlier time-codes have been processed).
+   */
+  unsigned long getTimeCode() const {
+    Lock lock(timeCodeMutex);
+    return timeCode;
+  }
+
+  /**
+   * Blocks until the cycles up to the given time-code have been processed.
+   * @param until the time-code to wait for.
+   * @param timeout the maximum time to wait.
+   * @return false if the time-code has not been reached within the timeout.
+   */
+  bool waitForTimeCode(unsigned long until, chrono::microseconds timeout) {
+    unique_lock<mutex> lock(timeCodeMutex);
+    return timeCodeAdvanced.wait_for(lock, timeout, [this, until] {
+      return timeCode >= until;
+    });
+  }
+
+  /**
+   * @param input true to list the input ports, false for the output ports.
+   * @return the names of the registered ports, in the order of registration.
+   */
+  vector<string> getPortNames(bool input) const {
+    Lock lock(portsMutex);
+    vector<string> names;
+    for (auto &port : ports) {
+      if (port->input == input) {
+        names.push_back(port->name);
+      }
+    }
+    return names;
+  }
+
+  /**
+   * Schedules an event for an input port.
+   * @param portName the name the port was registered with.
+   * @param time the absolute time-code of the event.
+   * @param midi the Midi bytes.
+   * @param length the number of Midi bytes.
+   * @return false if there is no input port of this name.
+   */
+  bool inject(const string& portName, unsigned long time, const uint8_t* midi, size_t length) {
+    if ((length == 0) || (length > static_cast<size_t> (maxBytesPerCycle))) {
+      THROW("Invalid event length.")
+    }
+    Lock lock(portsMutex);
+    SimulatedPort* port = findPort(portName);
+    if ((port == nullptr) || (!port->input)) {
+      return false;
+    }
+    auto position = upper_bound(port->script.begin(), port->script.end(), time,
+            [](unsigned long t, const TimedEvent & event) {
+              return t < event.time;
+            });
+    port->script.insert(position, TimedEvent{time, vector<uint8_t>(midi, midi + length)});
+    return true;
+  }
+
+  /**
+   * Simulates connecting or disconnecting a port; a simulated port is
+   * connected when it is registered.
+   * @param portName the name the port was registered with.
+   * @param connected false to let the port appear without connections.
+   * @return false if there is no port of this name.
+   */
+  bool setConnected(const string& portName, bool connected) {
+    Lock lock(portsMutex);
+    SimulatedPort* port = findPort(portName);
+    if (port == nullptr) {
+      return false;
+    }
+    port->connected = connected;
+    return true;
+  }
+
+  /**
+   * Hands out (and forgets) the events written to an output port so far.
+   * @param portName the name the port was registered with.
+   * @return the events in the order they were written.
+   */
+  vector<TimedEvent> takeCaptured(const string& portName) {
+    Lock lock(portsMutex);
+    vector<TimedEvent> result;
+    SimulatedPort* port = findPort(portName);
+    if ((port != nullptr) && (!port->input)) {
+      result.swap(port->captured);
+    }
+    return result;
+  }
+
+  unsigned long getBufferSize() const {
+    return bufferSize;
+  }
+
+  /**
+   * @return the frames per second that result from the buffer size and the
+   * period, zero if the cycles run back-to-back.
+   */
+  virtual unsigned long getFrameRate() override {
+    if (period.count() <= 0) {
+      return 0;
+    }
+    return static_cast<unsigned long> (bufferSize * 1000000ULL / period.count());
+  }
+
+  /** @return the number of cycles executed so far. */
+  unsigned long getCycleCount() const {
+    return cycleCount;
+  }
+
+  /** @return the longest time the process function took. */
+  chrono::nanoseconds getLongestCycle() const {
+    return chrono::nanoseconds(longestCycleNanos.load());
+  }
+
+  /** @return the time all calls of the process function took together. */
+  chrono::nanoseconds getTotalCycleTime() const {
+    return chrono::nanoseconds(totalCycleNanos.load());
+  }
+
+  virtual PortHandle registerPort(const string& name, bool isInput) override {
+    Lock lock(portsMutex);
+    if (findPort(name) != nullptr) {
+      return nullptr; // names must be unique, as with Jack
+    }
+    ports.push_back(unique_ptr<SimulatedPort > (new SimulatedPort(name, isInput)));
+    return ports.back().get();
+  }
+
+  virtual int unregisterPort(PortHandle handle) override {
+    Lock lock(portsMutex);
+    auto found = find_if(ports.begin(), ports.end(), [handle](const unique_ptr<SimulatedPort>& port) {
+      return port.get() == handle;
+    });
+    if (found == ports.end()) {
+      return -1;
+    }
+    ports.erase(found);
+    return 0;
+  }
+
+  virtual void* getBuffer(PortHandle handle, unsigned long frames) override {
+    if (frames != bufferSize) {
+      THROW("Unexpected number of frames.")
+    }
+    return &static_cast<SimulatedPort*> (handle)->buffer;
+  }
+
+  virtual int getEventCount(void* buffer) override {
+    return static_cast<Buffer*> (buffer)->eventCount;
+  }
+
+  virtual int getEvent(Event& event, void* _buffer, int index) override {
+    Buffer* buffer = static_cast<Buffer*> (_buffer);
+    if ((index < 0) || (index >= buffer->eventCount)) {
+      return -1;
+    }
+    const Buffer::Entry& entry = buffer->entries[index];
+    event.time = entry.time;
+    event.size = entry.size;
+    event.buffer = buffer->bytes.get() + entry.offset;
+    return 0;
+  }
+
+  virtual void clearBuffer(void* buffer) override {
+    static_cast<Buffer*> (buffer)->clear();
+  }
+
+  virtual uint8_t* reserveEvent(void* buffer, uint32_t time, size_t size) override {
+    if (time >= bufferSize) {
+      return nullptr;
+    }
+    return static_cast<Buffer*> (buffer)->reserve(time, size);
+  }
+
+  virtual int getConnectionCount(PortHandle handle) override {
+    return static_cast<SimulatedPort*> (handle)->connected.load() ? 1 : 0;
+  }
+};
+
+#endif	/* SIMULATEDBACKEND_HPP */
+
@@ -0,0 +1,193 @@
+/*
+ * File:   spscRing.hpp
+ *
+ * Created on October 16, 2026, 10:12 AM
+ *
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SPSCRING_HPP
+#define	SPSCRING_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include "messages.hpp"
+
+using namespace std;
+
+/**
+ * A wait-free ring buffer for exactly one producer thread and exactly one
+ * consumer thread. Neither "push" nor "pop" ever block or allocate memory,
+ * so the native thread can safely hand items to the java thread.
+ * </p>
+ * <p>
+ * The ring also records how full it has ever been (the high-water mark) and
+ * how many items had to be rejected, so its capacity can be tuned.
+ * </p>
+ */
+template<typename T>
+class SpscRing {
+private:
+  const size_t capacity;
+  unique_ptr<T[] > items;
+
+  /** The number of items ever popped; only written by the consumer. */
+  atomic<size_t> head;
+
+  /** The number of items ever pushed; only written by the producer. */
+  atomic<size_t> tail;
+
+  /** The highest number of items that were stored at once; only written by the producer. */
+  atomic<size_t> highWaterMark;
+
+  /** The number of items rejected because the ring was full; only written by the producer. */
+  atomic<unsigned long> overflowCount;
+
+public:
+
+  /**
+   * Creates a ring. All memory is allocated here, so the ring should be
+   * created outside the real-time thread.
+   * @param _capacity the maximum number of items the ring can hold.
+   */
+  explicit SpscRing(size_t _capacity) :
+  capacity(_capacity),
+  items(new T[_capacity]),
+  head(0),
+  tail(0),
+  highWaterMark(0),
+  overflowCount(0) {
+    if (_capacity == 0) {
+      THROW("Ring capacity must be positive.")
+    }
+  }
+
+  SpscRing(const SpscRing&) = delete;
+
+  /**
+   * Appends an item (producer thread only).
+   * @param item the item to be copied into the ring.
+   * @return false if the ring was full and the item has been dropped.
+   */
+  bool push(const T& item) {
+    size_t currentTail = tail.load(memory_order_relaxed);
+    size_t used = currentTail - head.load(memory_order_acquire);
+    if (used >= capacity) {
+      overflowCount.fetch_add(1, memory_order_relaxed);
+      return false;
+    }
+    items[currentTail % capacity] = item;
+    tail.store(currentTail + 1, memory_order_release);
+    if (used + 1 > highWaterMark.load(memory_order_relaxed)) {
+      highWaterMark.store(used + 1, memory_order_relaxed);
+    }
+    return true;
+  }
+
+  /**
+   * Removes the oldest item (consumer thread only).
+   * @param item receives the removed item.
+   * @return false if the ring was empty.
+   */
+  bool pop(T& item) {
+    size_t currentHead = head.load(memory_order_relaxed);
+    if (currentHead == tail.load(memory_order_acquire)) {
+      return false;
+    }
+    item = items[currentHead % capacity];
+    head.store(currentHead + 1, memory_order_release);
+    return true;
+  }
+
+  /**
+   * Appends a block of items, either all of them or none (producer thread only).
+   * @param source the items to be copied into the ring.
+   * @param count the number of items.
+   * @return false if the ring had not enough space and the block has been dropped
+   * (counted as one overflow).
+   */
+  bool pushAll(const T* source, size_t count) {
+    size_t currentTail = tail.load(memory_order_relaxed);
+    size_t used = currentTail - head.load(memory_order_acquire);
+    if (count > capacity - used) {
+      overflowCount.fetch_add(1, memory_order_relaxed);
+      return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+      items[(currentTail + i) % capacity] = source[i];
+    }
+    tail.store(currentTail + count, memory_order_release);
+    if (used + count > highWaterMark.load(memory_order_relaxed)) {
+      highWaterMark.store(used + count, memory_order_relaxed);
+    }
+    return true;
+  }
+
+  /**
+   * Removes a block of the oldest items (consumer thread only).
+   * @param target receives the removed items.
+   * @param count the number of items to remove.
+   * @return false if fewer items were stored (nothing has been removed).
+   */
+  bool popAll(T* target, size_t count) {
+    size_t currentHead = head.load(memory_order_relaxed);
+    if (tail.load(memory_order_acquire) - currentHead < count) {
+      return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+      target[i] = items[(currentHead + i) % capacity];
+    }
+    head.store(currentHead + count, memory_order_release);
+    return true;
+  }
+
+  /**
+   * @return true if the ring cannot take a further item (a snapshot when
+   * called by the consumer).
+   */
+  bool isFull() const {
+    return size() >= capacity;
+  }
+
+  /**
+   * @return the number of items currently stored (a snapshot when called
+   * concurrently).
+   */
+  size_t size() const {
+    size_t currentHead = head.load(memory_order_acquire);
+    return tail.load(memory_order_acquire) - currentHead;
+  }
+
+  bool isEmpty() const {
+    return size() == 0;
+  }
+
+  size_t getCapacity() const {
+    return capacity;
+  }
+
+  size_t getHighWaterMark() const {
+    return highWaterMark.load(memory_order_relaxed);
+  }
+
+  unsigned long getOverflowCount() const {
+    return overflowCount.load(memory_order_relaxed);
+  }
+};
+
+#endif	/* SPSCRING_HPP */
+
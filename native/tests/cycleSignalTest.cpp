@@ -0,0 +1,143 @@
+/*
+ * File:   cycleSignalTest.cpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 2:31:38 PM
+ */
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include "cycleSignalTest.hpp"
+#include "../cycleSignal.hpp"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(cycleSignalTest);
+
+cycleSignalTest::cycleSignalTest() {
+}
+
+cycleSignalTest::~cycleSignalTest() {
+}
+
+void cycleSignalTest::setUp() {
+}
+
+void cycleSignalTest::tearDown() {
+}
+
+/**
+ * A signal given between reading the sequence and waiting must not get lost.
+ */
+void cycleSignalTest::testSignalBeforeWait() {
+  CycleSignal signal;
+  uint32_t seen = signal.getSequence();
+  signal.signal();
+  auto start = chrono::steady_clock::now();
+  CPPUNIT_ASSERT(signal.waitFor(seen, chrono::microseconds(500000)));
+  CPPUNIT_ASSERT(chrono::steady_clock::now() - start < chrono::milliseconds(100));
+}
+
+/**
+ * Without a signal, waitFor must return false after the timeout.
+ */
+void cycleSignalTest::testTimeout() {
+  CycleSignal signal;
+  uint32_t seen = signal.getSequence();
+  auto start = chrono::steady_clock::now();
+  bool signaled = false;
+  // a spurious wake-up is allowed, so we repeat until the time is over.
+  while (chrono::steady_clock::now() - start < chrono::milliseconds(5)) {
+    signaled = signaled || signal.waitFor(seen, chrono::microseconds(5000));
+  }
+  CPPUNIT_ASSERT(!signaled);
+}
+
+/**
+ * A waiting thread must be released by the signal.
+ */
+void cycleSignalTest::testWakeUp() {
+  CycleSignal signal;
+  atomic<bool> released(false);
+  uint32_t seen = signal.getSequence();
+  thread waiter([&]() {
+    while (!signal.waitFor(seen, chrono::microseconds(1000000))) {
+    }
+    released = true;
+  });
+  this_thread::sleep_for(chrono::milliseconds(10));
+  CPPUNIT_ASSERT(!released);
+  signal.signal();
+  waiter.join();
+  CPPUNIT_ASSERT(released);
+}
+
+/**
+ * Measures how long the java thread needs to notice a new cycle. A "native"
+ * thread starts a cycle every 1.3 milliseconds (64 frames at 48 kHz), the
+ * "java" thread waits for each cycle, either polling with a 1 millisecond
+ * sleep (as the port-chain formerly did) or waiting on a CycleSignal.
+ * @param useSignal true to wait on the CycleSignal.
+ * @return the wake-up latencies in microseconds, sorted.
+ */
+static vector<long> measureWakeUpLatency(bool useSignal) {
+  const int cycles = 300;
+  CycleSignal signal;
+  atomic<int> cycle(0);
+  atomic<long> cycleStart(0);
+  vector<long> latencies;
+
+  thread java([&]() {
+    for (int expected = 1; expected <= cycles; expected++) {
+      while (true) {
+        uint32_t seen = signal.getSequence();
+        if (cycle >= expected) {
+          break;
+        }
+        if (useSignal) {
+          signal.waitFor(seen, chrono::microseconds(10000));
+        } else {
+          this_thread::sleep_for(chrono::milliseconds(1));
+        }
+      }
+      long now = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+      latencies.push_back(now - cycleStart);
+    }
+  });
+
+  for (int i = 1; i <= cycles; i++) {
+    this_thread::sleep_for(chrono::microseconds(1333));
+    cycleStart = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    cycle = i;
+    signal.signal();
+  }
+  java.join();
+  sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+static void printLatencies(const char* title, const vector<long>& latencies) {
+  size_t n = latencies.size();
+  cerr << "  testWakeUpLatency: " << title
+          << " min " << latencies[0]
+          << " p50 " << latencies[n / 2]
+          << " p90 " << latencies[(n * 9) / 10]
+          << " p99 " << latencies[(n * 99) / 100]
+          << " max " << latencies[n - 1] << " (microseconds)\n";
+}
+
+/**
+ * Benchmark: wake-up latency distribution before (1 ms polling) and after 
+ * (CycleSignal). Only the completeness of the run is asserted, the
+ * figures depend on the machine.
+ */
+void cycleSignalTest::testWakeUpLatency() {
+  vector<long> polling = measureWakeUpLatency(false);
+  vector<long> signaled = measureWakeUpLatency(true);
+  printLatencies("polling ", polling);
+  printLatencies("signaled", signaled);
+  CPPUNIT_ASSERT_EQUAL(polling.size(), signaled.size());
+  CPPUNIT_ASSERT(signaled[0] >= 0);
+}
+
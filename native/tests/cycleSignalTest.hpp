@@ -0,0 +1,38 @@
+/*
+ * File:   cycleSignalTest.hpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 2:31:36 PM
+ */
+
+#ifndef CYCLESIGNALTEST_HPP
+#define	CYCLESIGNALTEST_HPP
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class cycleSignalTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(cycleSignalTest);
+
+  CPPUNIT_TEST(testSignalBeforeWait);
+  CPPUNIT_TEST(testTimeout);
+  CPPUNIT_TEST(testWakeUp);
+  CPPUNIT_TEST(testWakeUpLatency);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  cycleSignalTest();
+  virtual ~cycleSignalTest();
+  void setUp();
+  void tearDown();
+
+private:
+  void testSignalBeforeWait();
+  void testTimeout();
+  void testWakeUp();
+  void testWakeUpLatency();
+
+};
+
+#endif	/* CYCLESIGNALTEST_HPP */
+
@@ -0,0 +1,102 @@
+/*
+ * File:   latencyHistogramTest.cpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 6:52:12 PM
+ */
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "latencyHistogramTest.hpp"
+#include "../latencyHistogram.hpp"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(latencyHistogramTest);
+
+latencyHistogramTest::latencyHistogramTest() {
+}
+
+latencyHistogramTest::~latencyHistogramTest() {
+}
+
+void latencyHistogramTest::setUp() {
+}
+
+void latencyHistogramTest::tearDown() {
+}
+
+/**
+ * Every value falls into a bucket whose bound is at most 1/16 above the value,
+ * the buckets follow each other without gaps.
+ */
+void latencyHistogramTest::testBuckets() {
+  for (uint64_t value = 0; value < 32; value++) {
+    CPPUNIT_ASSERT_EQUAL(value, LatencyHistogram::highestEquivalent(LatencyHistogram::indexOf(value)));
+  }
+  for (uint64_t value = 1; value < (uint64_t(1) << 40); value = value * 3 / 2 + 1) {
+    int index = LatencyHistogram::indexOf(value);
+    uint64_t bound = LatencyHistogram::highestEquivalent(index);
+    CPPUNIT_ASSERT(bound >= value);
+    CPPUNIT_ASSERT(bound - value <= value / 16);
+    CPPUNIT_ASSERT_EQUAL(index + 1, LatencyHistogram::indexOf(bound + 1));
+  }
+  // huge values land in the last bucket.
+  int last = LatencyHistogram::bucketCount - 1;
+  CPPUNIT_ASSERT_EQUAL(last, LatencyHistogram::indexOf(UINT64_MAX));
+}
+
+void latencyHistogramTest::testPercentiles() {
+  LatencyHistogram histogram;
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 0, histogram.getPercentile(50.0));
+  for (uint64_t micros = 1; micros <= 1000; micros++) {
+    histogram.record(chrono::microseconds(micros));
+  }
+  histogram.record(chrono::nanoseconds(-5)); // counts as zero
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 1001, histogram.getCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 0, histogram.getMin());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 1000000, histogram.getMax());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 500000, histogram.getMean());
+
+  uint64_t median = histogram.getPercentile(50.0);
+  CPPUNIT_ASSERT(median >= 500000);
+  CPPUNIT_ASSERT(median <= 500000 + 500000 / 16);
+  uint64_t p99 = histogram.getPercentile(99.0);
+  CPPUNIT_ASSERT(p99 >= 990000);
+  CPPUNIT_ASSERT(p99 <= 1000000);
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 1000000, histogram.getPercentile(100.0));
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 0, histogram.getPercentile(0.0));
+}
+
+void latencyHistogramTest::testReset() {
+  LatencyHistogram histogram;
+  histogram.record(1234);
+  histogram.reset();
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 0, histogram.getCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 0, histogram.getMin());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 0, histogram.getMax());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 0, histogram.getMean());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 0, histogram.getPercentile(99.0));
+}
+
+/**
+ * No value gets lost when several threads record at the same time.
+ */
+void latencyHistogramTest::testConcurrentRecord() {
+  LatencyHistogram histogram;
+  const int threadCount = 4;
+  const int valuesPerThread = 100000;
+  vector<thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.push_back(thread([&histogram, t, valuesPerThread]() {
+      for (int i = 0; i < valuesPerThread; i++) {
+        histogram.record(static_cast<uint64_t> (t * valuesPerThread + i));
+      }
+    }));
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  CPPUNIT_ASSERT_EQUAL((uint64_t) threadCount * valuesPerThread, histogram.getCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) 0, histogram.getMin());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) threadCount * valuesPerThread - 1, histogram.getMax());
+}
@@ -0,0 +1,38 @@
+/*
+ * File:   latencyHistogramTest.hpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 6:52:10 PM
+ */
+
+#ifndef LATENCYHISTOGRAMTEST_HPP
+#define	LATENCYHISTOGRAMTEST_HPP
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class latencyHistogramTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(latencyHistogramTest);
+
+  CPPUNIT_TEST(testBuckets);
+  CPPUNIT_TEST(testPercentiles);
+  CPPUNIT_TEST(testReset);
+  CPPUNIT_TEST(testConcurrentRecord);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  latencyHistogramTest();
+  virtual ~latencyHistogramTest();
+  void setUp();
+  void tearDown();
+
+private:
+  void testBuckets();
+  void testPercentiles();
+  void testReset();
+  void testConcurrentRecord();
+
+};
+
+#endif	/* LATENCYHISTOGRAMTEST_HPP */
+
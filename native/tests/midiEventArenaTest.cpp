@@ -0,0 +1,147 @@
+/*
+ * File:   midiEventArenaTest.cpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 6:52:12 PM
+ */
+#include <stdexcept>
+#include <cstring>
+#include "midiEventArenaTest.hpp"
+#include "../midiEventArena.hpp"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(midiEventArenaTest);
+
+midiEventArenaTest::midiEventArenaTest() {
+}
+
+midiEventArenaTest::~midiEventArenaTest() {
+}
+
+void midiEventArenaTest::setUp() {
+}
+
+void midiEventArenaTest::tearDown() {
+}
+
+/**
+ * Events of one, two, three and many bytes must be stored without
+ * truncation and one after the other.
+ */
+void midiEventArenaTest::testVariableLength() {
+  MidiEventArena arena(8, 64);
+  const uint8_t clock[] = {0xF8};
+  const uint8_t programChange[] = {0xC0, 0x05};
+  const uint8_t noteOn[] = {0x90, 0x40, 0x7F};
+  const uint8_t sysex[] = {0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7};
+
+  CPPUNIT_ASSERT(arena.add(0, clock, 1));
+  CPPUNIT_ASSERT(arena.add(3, programChange, 2));
+  CPPUNIT_ASSERT(arena.add(7, noteOn, 3));
+  CPPUNIT_ASSERT(arena.add(9, sysex, 6));
+
+  CPPUNIT_ASSERT_EQUAL(4, arena.size());
+  CPPUNIT_ASSERT_EQUAL(12, arena.getByteCount());
+  CPPUNIT_ASSERT_EQUAL(2, arena.getLength(1));
+  CPPUNIT_ASSERT_EQUAL(7, arena.getDeltaTime(2));
+  CPPUNIT_ASSERT_EQUAL(6, arena.getLength(3));
+  CPPUNIT_ASSERT(memcmp(arena.getMidi(3), sysex, 6) == 0);
+  CPPUNIT_ASSERT(memcmp(arena.getMidi(1), programChange, 2) == 0);
+  CPPUNIT_ASSERT_EQUAL(arena.getMidi(0) + 1, arena.getMidi(1));
+  for (int i = 0; i < arena.size(); i++) {
+    CPPUNIT_ASSERT(arena.isValid(i));
+  }
+}
+
+/**
+ * An event that exceeds either the index or the byte capacity is refused
+ * without changing the arena.
+ */
+void midiEventArenaTest::testFull() {
+  MidiEventArena arena(2, 8);
+  const uint8_t sysex[] = {0xF0, 1, 2, 3, 4, 5, 6, 0xF7};
+  const uint8_t noteOn[] = {0x90, 0x40, 0x7F};
+
+  CPPUNIT_ASSERT(arena.add(0, noteOn, 3));
+  CPPUNIT_ASSERT(!arena.add(1, sysex, 8));
+  CPPUNIT_ASSERT_EQUAL(1, arena.size());
+  CPPUNIT_ASSERT_EQUAL(3, arena.getByteCount());
+  CPPUNIT_ASSERT(arena.add(1, sysex, 5));
+  CPPUNIT_ASSERT(arena.reserve(2, 0) == nullptr);
+  CPPUNIT_ASSERT_EQUAL(2, arena.size());
+  CPPUNIT_ASSERT_THROW(MidiEventArena empty(0, 8), std::runtime_error);
+}
+
+/**
+ * After "clear" the whole capacity is available again.
+ */
+void midiEventArenaTest::testClear() {
+  MidiEventArena arena(1, 4);
+  const uint8_t midi[] = {0xF0, 0x01, 0x02, 0xF7};
+  CPPUNIT_ASSERT(arena.add(0, midi, 4));
+  CPPUNIT_ASSERT(!arena.add(0, midi, 1));
+  arena.clear();
+  CPPUNIT_ASSERT_EQUAL(0, arena.size());
+  CPPUNIT_ASSERT(arena.add(0, midi, 4));
+}
+
+/**
+ * Entries written by someone else (java) must be checked before they are read.
+ */
+void midiEventArenaTest::testForeignEntries() {
+  MidiEventArena arena(4, 16);
+  MidiEventArena::Entry* entries = arena.getEntries();
+  entries[0] = {0, 0, 3};
+  entries[1] = {5, 14, 3}; // beyond the end of the arena
+  entries[2] = {6, 3, 0}; // empty
+  entries[3] = {7, -1, 1}; // before the start
+  arena.setEventCount(4);
+  CPPUNIT_ASSERT(arena.isValid(0));
+  CPPUNIT_ASSERT(!arena.isValid(1));
+  CPPUNIT_ASSERT(!arena.isValid(2));
+  CPPUNIT_ASSERT(!arena.isValid(3));
+  CPPUNIT_ASSERT_THROW(arena.setEventCount(5), std::runtime_error);
+}
+
+/**
+ * Spilled events are copied in order, with their delta-times shifted.
+ */
+void midiEventArenaTest::testAppendAll() {
+  MidiEventArena spill(4, 16);
+  MidiEventArena arena(2, 16);
+  const uint8_t noteOn[] = {0x90, 0x40, 0x7F};
+  const uint8_t clock[] = {0xF8};
+  CPPUNIT_ASSERT(spill.add(100, noteOn, 3));
+  CPPUNIT_ASSERT(spill.add(120, clock, 1));
+  CPPUNIT_ASSERT(arena.appendAll(spill, -128));
+  CPPUNIT_ASSERT_EQUAL(2, arena.size());
+  CPPUNIT_ASSERT_EQUAL(-28, arena.getDeltaTime(0));
+  CPPUNIT_ASSERT_EQUAL(-8, arena.getDeltaTime(1));
+  CPPUNIT_ASSERT(memcmp(arena.getMidi(0), noteOn, 3) == 0);
+  CPPUNIT_ASSERT(!arena.appendAll(spill, 0));
+}
+
+/**
+ * An arena grows when the demand crosses three quarters of its capacity,
+ * and never beyond the maximum.
+ */
+void midiEventArenaTest::testGrowth() {
+  EventOverflow overflow(OverflowPolicy::dropNewest);
+  unique_ptr<MidiEventArena> arena = EventOverflow::makeArena(16);
+  CPPUNIT_ASSERT_EQUAL(16 * EventOverflow::bytesPerEvent, arena->getByteCapacity());
+
+  overflow.recordDemand(12, 3 * 12);
+  CPPUNIT_ASSERT(!overflow.needsGrowth(*arena));
+  overflow.recordDemand(13, 3 * 13);
+  CPPUNIT_ASSERT(overflow.needsGrowth(*arena));
+  overflow.recordDemand(2, 6); // the high-water mark never decreases
+  CPPUNIT_ASSERT_EQUAL(13, overflow.getEventHighWaterMark());
+
+  arena = overflow.makeGrownArena(*arena);
+  CPPUNIT_ASSERT_EQUAL(32, arena->getEventCapacity());
+  CPPUNIT_ASSERT_EQUAL(1, overflow.getGrowCount());
+  CPPUNIT_ASSERT(!overflow.needsGrowth(*arena));
+
+  unique_ptr<MidiEventArena> largest = EventOverflow::makeArena(EventOverflow::maxEventCapacity);
+  overflow.recordDemand(EventOverflow::maxEventCapacity, 0);
+  CPPUNIT_ASSERT(!overflow.needsGrowth(*largest));
+}
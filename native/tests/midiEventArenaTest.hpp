@@ -0,0 +1,42 @@
+/*
+ * File:   midiEventArenaTest.hpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 6:52:10 PM
+ */
+
+#ifndef MIDIEVENTARENATEST_HPP
+#define	MIDIEVENTARENATEST_HPP
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class midiEventArenaTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(midiEventArenaTest);
+
+  CPPUNIT_TEST(testVariableLength);
+  CPPUNIT_TEST(testFull);
+  CPPUNIT_TEST(testClear);
+  CPPUNIT_TEST(testForeignEntries);
+  CPPUNIT_TEST(testAppendAll);
+  CPPUNIT_TEST(testGrowth);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  midiEventArenaTest();
+  virtual ~midiEventArenaTest();
+  void setUp();
+  void tearDown();
+
+private:
+  void testVariableLength();
+  void testFull();
+  void testClear();
+  void testForeignEntries();
+  void testAppendAll();
+  void testGrowth();
+
+};
+
+#endif	/* MIDIEVENTARENATEST_HPP */
+
@@ -0,0 +1,84 @@
+/*
+ * File:   midiGraphTest.cpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 17, 2026, 9:12:42 AM
+ */
+#include "midiGraphTest.hpp"
+#include "../midiGraph.hpp"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(midiGraphTest);
+
+midiGraphTest::midiGraphTest() {
+}
+
+midiGraphTest::~midiGraphTest() {
+}
+
+void midiGraphTest::setUp() {
+}
+
+void midiGraphTest::tearDown() {
+}
+
+void midiGraphTest::testNormalize() {
+  MidiGraph graph;
+  graph.ports.push_back("b:in");
+  graph.ports.push_back("a:out");
+  graph.ports.push_back("b:in");
+  graph.connections.push_back(MidiConnection("a:out", "c:in"));
+  graph.connections.push_back(MidiConnection("a:out", "b:in"));
+  graph.connections.push_back(MidiConnection("a:out", "c:in"));
+  graph.normalize();
+
+  CPPUNIT_ASSERT_EQUAL((size_t) 2, graph.ports.size());
+  CPPUNIT_ASSERT_EQUAL(string("a:out"), graph.ports[0]);
+  CPPUNIT_ASSERT_EQUAL(string("b:in"), graph.ports[1]);
+  CPPUNIT_ASSERT_EQUAL((size_t) 2, graph.connections.size());
+  CPPUNIT_ASSERT(graph.connections[0] == MidiConnection("a:out", "b:in"));
+  CPPUNIT_ASSERT(graph.connections[1] == MidiConnection("a:out", "c:in"));
+}
+
+void midiGraphTest::testDelta() {
+  MidiGraph before;
+  before.ports.push_back("a:out");
+  before.ports.push_back("b:in");
+  before.ports.push_back("c:in");
+  before.connections.push_back(MidiConnection("a:out", "b:in"));
+  before.connections.push_back(MidiConnection("a:out", "c:in"));
+  before.normalize();
+
+  MidiGraph after;
+  after.ports.push_back("a:out");
+  after.ports.push_back("b:in");
+  after.ports.push_back("d:in");
+  after.connections.push_back(MidiConnection("a:out", "b:in"));
+  after.connections.push_back(MidiConnection("a:out", "d:in"));
+  after.normalize();
+
+  MidiGraphDelta delta = MidiGraphDelta::between(before, after);
+  CPPUNIT_ASSERT(!delta.isEmpty());
+  CPPUNIT_ASSERT_EQUAL((size_t) 1, delta.addedPorts.size());
+  CPPUNIT_ASSERT_EQUAL(string("d:in"), delta.addedPorts[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t) 1, delta.removedPorts.size());
+  CPPUNIT_ASSERT_EQUAL(string("c:in"), delta.removedPorts[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t) 1, delta.addedConnections.size());
+  CPPUNIT_ASSERT(delta.addedConnections[0] == MidiConnection("a:out", "d:in"));
+  CPPUNIT_ASSERT_EQUAL((size_t) 1, delta.removedConnections.size());
+  CPPUNIT_ASSERT(delta.removedConnections[0] == MidiConnection("a:out", "c:in"));
+}
+
+/**
+ * A connection made and removed again within one batch leaves no delta.
+ */
+void midiGraphTest::testUnchanged() {
+  MidiGraph before;
+  before.ports.push_back("a:out");
+  before.ports.push_back("b:in");
+  before.normalize();
+  MidiGraph after = before;
+  after.version = before.version + 1;
+
+  CPPUNIT_ASSERT(MidiGraphDelta::between(before, after).isEmpty());
+  CPPUNIT_ASSERT(MidiGraphDelta::between(MidiGraph(), MidiGraph()).isEmpty());
+}
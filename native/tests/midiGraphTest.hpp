@@ -0,0 +1,36 @@
+/*
+ * File:   midiGraphTest.hpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 17, 2026, 9:12:40 AM
+ */
+
+#ifndef MIDIGRAPHTEST_HPP
+#define	MIDIGRAPHTEST_HPP
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class midiGraphTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(midiGraphTest);
+
+  CPPUNIT_TEST(testNormalize);
+  CPPUNIT_TEST(testDelta);
+  CPPUNIT_TEST(testUnchanged);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  midiGraphTest();
+  virtual ~midiGraphTest();
+  void setUp();
+  void tearDown();
+
+private:
+  void testNormalize();
+  void testDelta();
+  void testUnchanged();
+
+};
+
+#endif	/* MIDIGRAPHTEST_HPP */
+
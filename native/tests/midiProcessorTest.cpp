@@ -0,0 +1,178 @@
+/*
+ * File:   midiProcessorTest.cpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 10:40:01 PM
+ */
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include "midiProcessorTest.hpp"
+#include "../midiProcessor.hpp"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(midiProcessorTest);
+
+midiProcessorTest::midiProcessorTest() {
+}
+
+midiProcessorTest::~midiProcessorTest() {
+}
+
+void midiProcessorTest::setUp() {
+}
+
+void midiProcessorTest::tearDown() {
+}
+
+/**
+ * Runs a three byte event through the chain.
+ * @return false if the chain has dropped the event.
+ */
+static bool run(const ProcessorChain& chain, uint8_t(&midi)[3]) {
+  uint8_t scratch[3];
+  const uint8_t* result = chain.apply(midi, 3, scratch);
+  if (result == nullptr) {
+    return false;
+  }
+  memcpy(midi, result, 3);
+  return true;
+}
+
+void midiProcessorTest::testTranspose() {
+  ProcessorChain chain;
+  chain.add(unique_ptr<MidiProcessor>(new TransposeProcessor(12)));
+
+  uint8_t noteOn[3] = {0x90, 60, 100};
+  uint8_t original[3] = {0x90, 60, 100};
+  uint8_t scratch[3];
+  const uint8_t* result = chain.apply(noteOn, 3, scratch);
+  CPPUNIT_ASSERT(result == scratch);
+  CPPUNIT_ASSERT_EQUAL(72, static_cast<int> (result[1]));
+  CPPUNIT_ASSERT_EQUAL(0, memcmp(noteOn, original, 3)); // the source is left untouched
+
+  uint8_t controller[3] = {0xB0, 7, 100};
+  CPPUNIT_ASSERT(run(chain, controller));
+  CPPUNIT_ASSERT_EQUAL(7, static_cast<int> (controller[1]));
+
+  uint8_t tooHigh[3] = {0x80, 120, 0};
+  CPPUNIT_ASSERT(!run(chain, tooHigh));
+
+  // long events pass unchanged (not even copied).
+  uint8_t sysex[6] = {0xF0, 0x7E, 0x7F, 0x09, 0x01, 0xF7};
+  CPPUNIT_ASSERT(chain.apply(sysex, 6, scratch) == sysex);
+}
+
+void midiProcessorTest::testChannelMapAndSplit() {
+  int channels[16];
+  for (int i = 0; i < 16; i++) {
+    channels[i] = i;
+  }
+  channels[0] = 3;
+  channels[9] = -1;
+  ProcessorChain chain;
+  chain.add(unique_ptr<MidiProcessor>(new ChannelMapProcessor(channels)));
+
+  uint8_t program[3] = {0xC0, 5, 0};
+  CPPUNIT_ASSERT(run(chain, program));
+  CPPUNIT_ASSERT_EQUAL(0xC3, static_cast<int> (program[0]));
+  uint8_t drum[3] = {0x99, 36, 100};
+  CPPUNIT_ASSERT(!run(chain, drum));
+
+  channels[0] = 16;
+  CPPUNIT_ASSERT_THROW(ChannelMapProcessor invalid(channels), std::runtime_error);
+
+  ProcessorChain split;
+  split.add(unique_ptr<MidiProcessor>(new SplitProcessor(60, 1, 2)));
+  uint8_t low[3] = {0x90, 59, 100};
+  uint8_t high[3] = {0x80, 60, 0};
+  uint8_t pitchBend[3] = {0xE0, 0, 64};
+  CPPUNIT_ASSERT(run(split, low));
+  CPPUNIT_ASSERT(run(split, high));
+  CPPUNIT_ASSERT(run(split, pitchBend));
+  CPPUNIT_ASSERT_EQUAL(0x91, static_cast<int> (low[0]));
+  CPPUNIT_ASSERT_EQUAL(0x82, static_cast<int> (high[0]));
+  CPPUNIT_ASSERT_EQUAL(0xE0, static_cast<int> (pitchBend[0]));
+}
+
+void midiProcessorTest::testVelocityCurveAndFilter() {
+  int velocities[128];
+  for (int i = 0; i < 128; i++) {
+    velocities[i] = 127;
+  }
+  ProcessorChain chain;
+  chain.add(unique_ptr<MidiProcessor>(new VelocityCurveProcessor(velocities)));
+  // pass only note-on and note-off on channel 0.
+  chain.add(unique_ptr<MidiProcessor>(new FilterProcessor(0x03, 0x0001)));
+
+  uint8_t noteOn[3] = {0x90, 60, 10};
+  CPPUNIT_ASSERT(run(chain, noteOn));
+  CPPUNIT_ASSERT_EQUAL(127, static_cast<int> (noteOn[2]));
+  uint8_t noteOnAsOff[3] = {0x90, 60, 0};
+  CPPUNIT_ASSERT(run(chain, noteOnAsOff));
+  CPPUNIT_ASSERT_EQUAL(0, static_cast<int> (noteOnAsOff[2]));
+
+  uint8_t otherChannel[3] = {0x91, 60, 10};
+  CPPUNIT_ASSERT(!run(chain, otherChannel));
+  uint8_t controller[3] = {0xB0, 7, 100};
+  CPPUNIT_ASSERT(!run(chain, controller));
+  uint8_t sysex[6] = {0xF0, 0x7E, 0x7F, 0x09, 0x01, 0xF7};
+  uint8_t scratch[3];
+  CPPUNIT_ASSERT(chain.apply(sysex, 6, scratch) == nullptr);
+}
+
+void midiProcessorTest::testDescription() {
+  const int32_t description[] = {
+    ProcessorChain::transpose, -2,
+    ProcessorChain::filter, 0xFF, 0xFFFF,
+    ProcessorChain::split, 60, 4, 5
+  };
+  unique_ptr<ProcessorChain> chain = ProcessorChain::fromDescription(description, 9);
+  uint8_t note[3] = {0x90, 61, 100};
+  CPPUNIT_ASSERT(run(*chain, note));
+  CPPUNIT_ASSERT_EQUAL(59, static_cast<int> (note[1]));
+  CPPUNIT_ASSERT_EQUAL(0x94, static_cast<int> (note[0]));
+
+  CPPUNIT_ASSERT(ProcessorChain::fromDescription(description, 0)->isEmpty());
+  // incomplete or unknown stages are refused.
+  CPPUNIT_ASSERT_THROW(ProcessorChain::fromDescription(description, 4), std::runtime_error);
+  const int32_t unknown[] = {99, 0};
+  CPPUNIT_ASSERT_THROW(ProcessorChain::fromDescription(unknown, 2), std::runtime_error);
+}
+
+/**
+ * The chain can be replaced while another thread keeps processing events.
+ */
+void midiProcessorTest::testSlotSwap() {
+  ProcessorSlot slot;
+  atomic<bool> running(true);
+  atomic<long> processed(0);
+  atomic<long> wrong(0);
+  std::thread nativeThread([&]() {
+    uint8_t scratch[3];
+    while (running) {
+      ProcessorSlot::Accessor chain(slot);
+      uint8_t note[3] = {0x90, 60, 100};
+      const uint8_t* result = chain.apply(note, 3, scratch);
+      // either no chain, or one of the transpositions set below.
+      if ((result == nullptr) || (result[1] < 60) || (result[1] > 70)) {
+        wrong++;
+      }
+      processed++;
+    }
+  });
+  for (int i = 0; i < 1000; i++) {
+    const int32_t description[] = {ProcessorChain::transpose, i % 11};
+    slot.set(ProcessorChain::fromDescription(description, 2));
+    long seen = processed;
+    while (processed == seen) {
+      std::this_thread::yield();
+    }
+  }
+  CPPUNIT_ASSERT(slot.hasChain());
+  slot.set(unique_ptr<ProcessorChain>());
+  CPPUNIT_ASSERT(!slot.hasChain());
+  running = false;
+  nativeThread.join();
+  CPPUNIT_ASSERT(processed >= 1000);
+  CPPUNIT_ASSERT_EQUAL(0L, wrong.load());
+}
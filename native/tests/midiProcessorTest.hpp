@@ -0,0 +1,40 @@
+/*
+ * File:   midiProcessorTest.hpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 10:40:00 PM
+ */
+
+#ifndef MIDIPROCESSORTEST_HPP
+#define	MIDIPROCESSORTEST_HPP
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class midiProcessorTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(midiProcessorTest);
+
+  CPPUNIT_TEST(testTranspose);
+  CPPUNIT_TEST(testChannelMapAndSplit);
+  CPPUNIT_TEST(testVelocityCurveAndFilter);
+  CPPUNIT_TEST(testDescription);
+  CPPUNIT_TEST(testSlotSwap);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  midiProcessorTest();
+  virtual ~midiProcessorTest();
+  void setUp();
+  void tearDown();
+
+private:
+  void testTranspose();
+  void testChannelMapAndSplit();
+  void testVelocityCurveAndFilter();
+  void testDescription();
+  void testSlotSwap();
+
+};
+
+#endif	/* MIDIPROCESSORTEST_HPP */
+
@@ -42,10 +42,20 @@ public:
   int start_implCount;
   int execJavaProcess_implCount;
   int execNativeProcess_implCount;
+  int execNativeSkip_implCount = 0;
+  int execNativeLate_implCount = 0;
+  int idleJavaCount = 0;
+  int idleNativeCount = 0;
+  /** what getConnectionCount_impl reports (-1 unknown). */
+  int connectionCount = -1;
   int stop_implCount;
   int uninitialize_implCount;
   int unregister_implCount;
   bool failOnWrongState = false;
+  /** the java thread is inside execJavaProcess_impl. */
+  bool javaInside = false;
+  /** stop_impl or uninitialize_impl has been called while javaInside was set. */
+  bool closedWhileJavaInside = false;
 
   PortMock(bool isOutput, long internalId) :
   Port(isOutput, internalId),
@@ -111,6 +121,8 @@ public:
 private:
   bool exceptionInJava = false;
   bool exceptionInNative = false;
+  bool errorInNative = false;
+  bool errorInSkip = false;
   bool exceptionInInitialize = false;
 public:
 
@@ -137,6 +149,31 @@ public:
   void setExceptionInNative(bool value) {
     exceptionInNative = value;
   }
+
+  /**
+   * Setting to true will make the execNativeProcess_impl report a native error
+   * (the real-time safe way to fail).
+   * @param value
+   */
+  void setErrorInNative(bool value) {
+    errorInNative = value;
+  }
+
+  /**
+   * Setting to true will make the execNativeSkip_impl report a native error.
+   * @param value
+   */
+  void setErrorInSkip(bool value) {
+    errorInSkip = value;
+  }
+
+  /**
+   * Makes the mock behave like a port with its own buffer (see Port::setAsynchronous).
+   * @param value
+   */
+  void makeAsynchronous(bool value) {
+    setAsynchronous(value);
+  }
 protected:
 
   virtual void initialize_impl(JNIEnv * env, jstring name, jobject listener)override {
@@ -165,7 +202,13 @@ protected:
 
   virtual void execJavaProcess_impl(JNIEnv * env, unsigned long timeCodeStart, unsigned long timeCodeDuration, bool lastCycle)override {
     if (execJavaProcessDuration != 0) {
+      javaInside = true;
       std::this_thread::sleep_for(std::chrono::milliseconds(execJavaProcessDuration));
+      javaInside = false;
+    }
+    if (idleCycle) {
+      idleJavaCount++;
+      return;
     }
     execJavaProcess_implCount++;
     if (exceptionInJava) {
@@ -177,16 +220,39 @@ protected:
     if (execNativeProcessDuration != 0) {
       std::this_thread::sleep_for(std::chrono::milliseconds(execNativeProcessDuration));
     }
+    if (isNativeIdle()) {
+      idleNativeCount++;
+      return;
+    }
     execNativeProcess_implCount++;
     if (exceptionInNative) {
       throw TestException("Requested exception in execNativeProcess_impl");
     }
+    if (errorInNative) {
+      FAIL_NATIVE(invalidEvent)
+    }
+  }
+
+  virtual void execNativeSkip_impl(unsigned long timeCodeDuration, void * client)override {
+    execNativeSkip_implCount++;
+    if (errorInSkip) {
+      FAIL_NATIVE(invalidEvent)
+    }
+  }
+
+  virtual int getConnectionCount_impl(void * client)override {
+    return connectionCount;
+  }
+
+  virtual void execNativeLate_impl(unsigned long timeCodeStart, unsigned long timeCodeDuration, void * client)override {
+    execNativeLate_implCount++;
   }
 
   virtual void stop_impl()override {
     if (stopDuration != 0) {
       std::this_thread::sleep_for(std::chrono::milliseconds(stopDuration));
     }
+    closedWhileJavaInside = closedWhileJavaInside || javaInside;
     stop_implCount++;
   }
 
@@ -194,6 +260,7 @@ protected:
     if (uninitializeDuration != 0) {
       std::this_thread::sleep_for(std::chrono::milliseconds(uninitializeDuration));
     }
+    closedWhileJavaInside = closedWhileJavaInside || javaInside;
     uninitialize_implCount++;
   }
 
@@ -490,7 +557,7 @@ public:
  * threads the two processes must flip processing. The number of 
  * invocations shall not differ by more than one.
  */
-void portTest::testProcessFlipFlopAtMaxSpeed(bool isOutput) {
+void portTest::testProcessFlipFlopAtMaxSpeed(bool isOutput, bool lockFree) {
   PortMock port(//
           isOutput,
           newPortId++, // internalId,
@@ -505,6 +572,8 @@ void portTest::testProcessFlipFlopAtMaxSpeed(bool isOutput) {
 
   ThreadRunner runner;
 
+  port.setLockFree(lockFree);
+  port.setFrameRate(48000);
   port.initialize(nullptr, nullptr, nullptr);
   port.registerAtServer(nullptr);
   port.start();
@@ -539,6 +608,14 @@ void portTest::testProcessFlipFlopAtMaxSpeed(bool isOutput) {
   // the number of java invocations must equal the number of native invocations.
   CPPUNIT_ASSERT_EQUAL(port.execNativeProcess_implCount, port.execJavaProcess_implCount);
 
+  // every invocation has been timed; a 255 frame cycle at 48kHz leaves some slack.
+  const CycleTiming& timing = port.getCycleTiming();
+  CPPUNIT_ASSERT_EQUAL((uint64_t) port.execJavaProcess_implCount, timing.get(CycleTiming::javaDelay).getCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) port.execJavaProcess_implCount, timing.get(CycleTiming::javaProcess).getCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) port.execNativeProcess_implCount, timing.get(CycleTiming::nativeProcess).getCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t) port.execNativeProcess_implCount, timing.get(CycleTiming::slack).getCount());
+  CPPUNIT_ASSERT(timing.get(CycleTiming::slack).getMax() <= 255 * 1000000000ULL / 48000);
+
   port.shutdown(nullptr, nullptr, false);
   CPPUNIT_ASSERT(!port.hasProcessException());
   CPPUNIT_ASSERT(port.isDeletableState());
@@ -553,6 +630,237 @@ void portTest::testProcessFlipFlopAtMaxSpeed_Input() {
   testProcessFlipFlopAtMaxSpeed(false);
 }
 
+void portTest::testLockFreeFlipFlop_Output() {
+  testProcessFlipFlopAtMaxSpeed(true, true);
+}
+
+void portTest::testLockFreeFlipFlop_Input() {
+  testProcessFlipFlopAtMaxSpeed(false, true);
+}
+
+/**
+ * In lock-free mode the native thread never waits for the java thread. 
+ * An output port that the java thread has not served in time is
+ * skipped and written in the next cycle.
+ */
+void portTest::testLockFreeLiveCicle_Output() {
+
+  long id = newPortId++;
+  bool isOutputPort = true;
+  PortMock port(isOutputPort, id);
+  port.setLockFree(true);
+  CPPUNIT_ASSERT(port.isLockFree());
+
+  port.initialize(nullptr, nullptr, nullptr);
+  port.registerAtServer(nullptr);
+  port.start();
+  CPPUNIT_ASSERT(port.isStartedSubstate());
+
+  // the mode cannot be changed on a running port.
+  CPPUNIT_ASSERT_THROW(port.setLockFree(false), std::runtime_error);
+
+  // cycle 1: the java thread is late, the native thread does not wait.
+  port.execNativeCycleInit(123, 100);
+  CPPUNIT_ASSERT(port.isJavaToExecSubstate());
+
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT(port.isJavaToExecSubstate());
+  CPPUNIT_ASSERT_EQUAL(0, port.execNativeProcess_implCount);
+  CPPUNIT_ASSERT_EQUAL(1, port.execNativeSkip_implCount);
+
+  port.execJavaProcess(nullptr, false);
+  CPPUNIT_ASSERT(port.isNativeToExecSubstate());
+
+  // cycle 2: the output of cycle 1 is written, then the port is handed to java.
+  port.execNativeCycleInit(223, 100);
+  CPPUNIT_ASSERT(port.isNativeToExecSubstate());
+
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT(port.isJavaToExecSubstate());
+  CPPUNIT_ASSERT_EQUAL(1, port.execNativeProcess_implCount);
+
+  // cycle 3: the java thread has not yet processed cycle 2.
+  CPPUNIT_ASSERT_EQUAL(0UL, port.getLateCycleCount());
+  port.execNativeCycleInit(323, 100);
+  CPPUNIT_ASSERT(port.isJavaToExecSubstate());
+  CPPUNIT_ASSERT_EQUAL(1UL, port.getLateCycleCount());
+
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT_EQUAL(2, port.execNativeSkip_implCount);
+
+  port.execJavaProcess(nullptr, true); //<< last cycle
+  CPPUNIT_ASSERT(port.isNativeToTerminateSubstate());
+
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT(port.isTerminatedSubstate());
+
+  port.stop(false);
+  CPPUNIT_ASSERT(port.isStoppedState());
+  CPPUNIT_ASSERT(port.isNoneSubstate());
+
+  CPPUNIT_ASSERT_EQUAL(2, port.execJavaProcess_implCount);
+  CPPUNIT_ASSERT_EQUAL(2, port.execNativeProcess_implCount);
+  CPPUNIT_ASSERT_EQUAL(1, port.stop_implCount);
+
+  port.shutdown(nullptr, nullptr, false);
+  CPPUNIT_ASSERT(!port.hasProcessException());
+  CPPUNIT_ASSERT(port.isDeletableState());
+}
+
+/**
+ * With the "skip" xrun policy, the output that the java thread delivers too
+ * late is dropped instead of being written in the next cycle.
+ */
+void portTest::testXrunSkip_Output() {
+  PortMock port(true, newPortId++);
+  port.setLockFree(true);
+  port.setXrunPolicy(XrunPolicy::skip);
+  port.initialize(nullptr, nullptr, nullptr);
+  port.registerAtServer(nullptr);
+  port.start();
+
+  // the policy cannot be changed on a running port.
+  CPPUNIT_ASSERT_THROW(port.setXrunPolicy(XrunPolicy::delay), std::runtime_error);
+
+  // cycle 1: the java thread has not yet delivered when the native thread writes.
+  port.execNativeCycleInit(123, 100);
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT_EQUAL(1, port.execNativeSkip_implCount);
+
+  // cycle 2: the java thread is still busy with cycle 1 (an xrun).
+  port.execNativeCycleInit(223, 100);
+  CPPUNIT_ASSERT_EQUAL(1UL, port.getLateCycleCount());
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT_EQUAL(2, port.execNativeSkip_implCount);
+  port.execJavaProcess(nullptr, false);
+
+  // cycle 3: the output of cycle 1 is stale, the port stays silent
+  // and is handed to java for cycle 3.
+  port.execNativeCycleInit(323, 100);
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT(port.isJavaToExecSubstate());
+  CPPUNIT_ASSERT_EQUAL(0, port.execNativeProcess_implCount);
+  CPPUNIT_ASSERT_EQUAL(3, port.execNativeSkip_implCount);
+  CPPUNIT_ASSERT_EQUAL(1UL, port.getDroppedCycleCount());
+
+  // cycle 4: back in step, the output of cycle 3 is written as usual (one cycle later).
+  port.execJavaProcess(nullptr, false);
+  port.execNativeCycleInit(423, 100);
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT_EQUAL(3, port.execNativeSkip_implCount);
+  CPPUNIT_ASSERT_EQUAL(1, port.execNativeProcess_implCount);
+  CPPUNIT_ASSERT(port.isJavaToExecSubstate());
+
+  port.execJavaProcess(nullptr, true); //<< last cycle
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT(port.isTerminatedSubstate());
+  CPPUNIT_ASSERT_EQUAL(1UL, port.getDroppedCycleCount());
+
+  port.stop(false);
+  port.shutdown(nullptr, nullptr, false);
+  CPPUNIT_ASSERT(!port.hasProcessException());
+  CPPUNIT_ASSERT(port.isDeletableState());
+}
+
+/**
+ * With the "merge" xrun policy, the native thread keeps the input of the cycles
+ * the java thread has missed.
+ */
+void portTest::testXrunMerge_Input() {
+  PortMock port(false, newPortId++);
+  port.setLockFree(true);
+  port.setXrunPolicy(XrunPolicy::merge);
+  port.initialize(nullptr, nullptr, nullptr);
+  port.registerAtServer(nullptr);
+  port.start();
+
+  // cycle 1: regular hand-over to java.
+  port.execNativeCycleInit(123, 100);
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT(port.isJavaToExecSubstate());
+
+  // cycles 2 and 3: the java thread is late, the input is kept.
+  port.execNativeCycleInit(223, 100);
+  port.execNativeProcess(nullptr);
+  port.execNativeCycleInit(323, 100);
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT_EQUAL(2UL, port.getLateCycleCount());
+  CPPUNIT_ASSERT_EQUAL(2, port.execNativeLate_implCount);
+  CPPUNIT_ASSERT_EQUAL(2UL, port.getMergedCycleCount());
+  CPPUNIT_ASSERT_EQUAL(0UL, port.getDroppedCycleCount());
+  CPPUNIT_ASSERT_EQUAL(1, port.execNativeProcess_implCount);
+
+  // the java thread catches up, cycle 4 is regular again.
+  port.execJavaProcess(nullptr, false);
+  CPPUNIT_ASSERT(port.isCycleDoneSubstate());
+  port.execNativeCycleInit(423, 100);
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT_EQUAL(2, port.execNativeProcess_implCount);
+  port.execJavaProcess(nullptr, true); //<< last cycle
+  CPPUNIT_ASSERT(port.isTerminatedSubstate());
+  CPPUNIT_ASSERT_EQUAL(2, port.execNativeLate_implCount);
+
+  port.stop(false);
+  port.shutdown(nullptr, nullptr, false);
+  CPPUNIT_ASSERT(!port.hasProcessException());
+  CPPUNIT_ASSERT(port.isDeletableState());
+}
+
+/**
+ * An asynchronous input port is processed by the native thread in every cycle,
+ * even while the java thread is late.
+ */
+void portTest::testAsynchronousLiveCicle_Input() {
+
+  long id = newPortId++;
+  bool isOutputPort = false;
+  PortMock port(isOutputPort, id);
+  port.makeAsynchronous(true);
+  CPPUNIT_ASSERT(port.isAsynchronous());
+  CPPUNIT_ASSERT(!port.isLockFree());
+
+  port.initialize(nullptr, nullptr, nullptr);
+  port.registerAtServer(nullptr);
+  port.start();
+
+  // the mode cannot be changed on a running port.
+  CPPUNIT_ASSERT_THROW(port.makeAsynchronous(false), std::runtime_error);
+
+  // cycle 1: regular hand-over to java.
+  port.execNativeCycleInit(123, 100);
+  CPPUNIT_ASSERT(port.isNativeToExecSubstate());
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT(port.isJavaToExecSubstate());
+  CPPUNIT_ASSERT_EQUAL(1, port.execNativeProcess_implCount);
+
+  // cycle 2: the java thread is late, the native thread goes on anyway.
+  port.execNativeCycleInit(223, 100);
+  CPPUNIT_ASSERT_EQUAL(1UL, port.getLateCycleCount());
+  port.execNativeProcess(nullptr);
+  CPPUNIT_ASSERT(port.isJavaToExecSubstate());
+  CPPUNIT_ASSERT_EQUAL(2, port.execNativeProcess_implCount);
+
+  port.execJavaProcess(nullptr, false);
+  CPPUNIT_ASSERT(port.isCycleDoneSubstate());
+  CPPUNIT_ASSERT_EQUAL(1, port.execJavaProcess_implCount);
+
+  // cycle 3: back in step.
+  port.execNativeCycleInit(323, 100);
+  port.execNativeProcess(nullptr);
+  port.execJavaProcess(nullptr, true); //<< last cycle
+  CPPUNIT_ASSERT(port.isTerminatedSubstate());
+
+  port.stop(false);
+  CPPUNIT_ASSERT(port.isStoppedState());
+  CPPUNIT_ASSERT_EQUAL(3, port.execNativeProcess_implCount);
+  CPPUNIT_ASSERT_EQUAL(2, port.execJavaProcess_implCount);
+  CPPUNIT_ASSERT_EQUAL(0, port.execNativeSkip_implCount);
+
+  port.shutdown(nullptr, nullptr, false);
+  CPPUNIT_ASSERT(!port.hasProcessException());
+  CPPUNIT_ASSERT(port.isDeletableState());
+}
+
 /**
  * When an exception occurs in the native thread, the exception should be trapped
  * and the port should stop itself.
@@ -612,6 +920,139 @@ void portTest::testBadNativeProcess() {
   }
 }
 
+/**
+ * When the native thread fails while the java thread is still in a slow
+ * call-back, the port must not be stopped before the call-back returns.
+ */
+void portTest::testNativeFailsDuringJava() {
+  PortMock port(false, newPortId++, 0, 0, 0, 100, 0, 0, 0, 0);
+  port.makeAsynchronous(true);
+  port.initialize(nullptr, nullptr, nullptr);
+  port.registerAtServer(nullptr);
+  port.start();
+
+  port.execNativeCycleInit(123, 100);
+  port.execNativeProcess(nullptr);
+  std::thread javaThread([&]{port.execJavaProcess(nullptr, false);});
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  bool busyBefore = port.isJavaBusySubstate();
+
+  // the native thread fails in the next cycle, the java thread still holds the port.
+  port.setExceptionInNative(true);
+  port.execNativeCycleInit(223, 100);
+  port.execNativeProcess(nullptr);
+  bool busyAfter = port.isJavaBusySubstate();
+
+  port.stop(false);
+  bool closedEarly = port.closedWhileJavaInside;
+  int javaCount = port.execJavaProcess_implCount;
+  javaThread.join();
+  CPPUNIT_ASSERT(busyBefore);
+  CPPUNIT_ASSERT(busyAfter);
+  CPPUNIT_ASSERT(!closedEarly);
+  CPPUNIT_ASSERT_EQUAL(1, javaCount);
+
+  port.shutdown(nullptr, nullptr, false);
+  CPPUNIT_ASSERT(!port.closedWhileJavaInside);
+  CPPUNIT_ASSERT(port.isDeletableState());
+  try {
+    std::rethrow_exception(port.getProcessException());
+  } catch (const TestException& e) {
+  } catch (...) {
+    CPPUNIT_FAIL("Unexpected Exception.");
+  }
+}
+
+/**
+ * In the blocking hand-shake the java thread executes its call-back without
+ * holding the stateMutex. When the native thread fails meanwhile, it neither
+ * waits for the java thread nor stops the port under its feet; the java thread
+ * completes the stop when the call-back has returned.
+ */
+void portTest::testNativeFailsDuringBlockingJava() {
+  PortMock port(true, newPortId++, 0, 0, 0, 100, 0, 0, 0, 0);
+  port.initialize(nullptr, nullptr, nullptr);
+  port.registerAtServer(nullptr);
+  port.start();
+
+  port.execNativeCycleInit(123, 100);
+  std::thread javaThread([&]{port.execJavaProcess(nullptr, false);});
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  bool busyBefore = port.isJavaBusySubstate();
+
+  port.setErrorInSkip(true);
+  auto start = std::chrono::steady_clock::now();
+  port.execNativeSkip(100, nullptr);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  bool busyAfter = port.isJavaBusySubstate();
+  bool runningAfter = port.isRunningState();
+
+  javaThread.join();
+  CPPUNIT_ASSERT(busyBefore);
+  CPPUNIT_ASSERT(busyAfter);
+  CPPUNIT_ASSERT(runningAfter);
+  CPPUNIT_ASSERT(elapsed < std::chrono::milliseconds(50));
+  CPPUNIT_ASSERT(port.isStoppedOnErrorState());
+  CPPUNIT_ASSERT(!port.closedWhileJavaInside);
+  CPPUNIT_ASSERT_EQUAL(1, port.stop_implCount);
+
+  port.stop(false);
+  CPPUNIT_ASSERT(port.isStoppedState());
+  CPPUNIT_ASSERT_EQUAL(1, port.stop_implCount);
+  port.shutdown(nullptr, nullptr, false);
+  CPPUNIT_ASSERT(port.isDeletableState());
+  try {
+    std::rethrow_exception(port.getProcessException());
+  } catch (const NativeError& e) {
+    CPPUNIT_ASSERT(NativeErrorCode::invalidEvent == e.getRecord().code);
+  } catch (...) {
+    CPPUNIT_FAIL("Unexpected Exception.");
+  }
+}
+
+/**
+ * An error reported by the native thread stops the port (in both hand-shake modes),
+ * it becomes an exception only when it is retrieved.
+ */
+void portTest::testNativeErrorRecord() {
+  for (int lockFree = 0; lockFree < 2; lockFree++) {
+    long id = newPortId++;
+    PortMock port(true, id);
+    port.setLockFree(lockFree == 1);
+    port.initialize(nullptr, nullptr, nullptr);
+    port.registerAtServer(nullptr);
+    port.start();
+    port.setErrorInNative(true);
+
+    port.execNativeCycleInit(123, 100);
+    port.execJavaProcess(nullptr, false);
+    if (lockFree == 1) {
+      port.execNativeCycleInit(223, 100); // the output is written one cycle later
+    }
+    port.execNativeProcess(nullptr);
+    CPPUNIT_ASSERT(port.hasProcessException());
+    if (lockFree == 1) {
+      CPPUNIT_ASSERT(port.isRunningState()); // stopped by the administrative side.
+    } else {
+      CPPUNIT_ASSERT(port.isStoppedOnErrorState());
+    }
+
+    port.stop(false);
+    CPPUNIT_ASSERT(port.isStoppedState());
+    port.shutdown(nullptr, nullptr, false);
+    CPPUNIT_ASSERT(port.isDeletableState());
+    try {
+      std::rethrow_exception(port.getProcessException());
+    } catch (const NativeError& e) {
+      CPPUNIT_ASSERT(NativeErrorCode::invalidEvent == e.getRecord().code);
+      CPPUNIT_ASSERT_EQUAL(id, e.getRecord().portId);
+      CPPUNIT_ASSERT_EQUAL(123UL + lockFree * 100, e.getRecord().timeCodeStart);
+    } catch (...) {
+      CPPUNIT_FAIL("Unexpected Exception.");
+    }
+  }
+}
+
 /**
  * When an exception occurs during the opening of a port, the exception should be thrown
  * and the port should transit into the deletable state.
@@ -848,3 +1289,52 @@ void portTest::testTimeoutExceptionInStop() {
   CPPUNIT_ASSERT_THROW(port.stop(false), std::runtime_error);
 
 }
+
+/**
+ * A port without connections skips the work of its cycles, but passes through
+ * the hand-shake as usual.
+ */
+void portTest::testSkipWhenIdle() {
+  PortMock port(false, newPortId++);
+  port.initialize(nullptr, nullptr, nullptr);
+  port.registerAtServer(nullptr);
+  port.start();
+  port.connectionCount = 0;
+
+  // not selected: the connection count does not matter.
+  port.sampleConnections(nullptr);
+  port.execNativeCycleInit(0, 100);
+  port.execNativeProcess(nullptr);
+  port.execJavaProcess(nullptr, false);
+  CPPUNIT_ASSERT(port.isCycleDoneSubstate());
+  CPPUNIT_ASSERT_EQUAL(1, port.execJavaProcess_implCount);
+
+  port.setSkipWhenIdle(true);
+  for (int cycle = 1; cycle <= 3; cycle++) {
+    port.sampleConnections(nullptr);
+    port.execNativeCycleInit(cycle * 100, 100);
+    CPPUNIT_ASSERT(port.isNativeToExecSubstate());
+    port.execNativeProcess(nullptr);
+    CPPUNIT_ASSERT(port.isJavaToExecSubstate());
+    port.execJavaProcess(nullptr, false);
+    CPPUNIT_ASSERT(port.isCycleDoneSubstate());
+  }
+  CPPUNIT_ASSERT_EQUAL(3, port.idleJavaCount);
+  CPPUNIT_ASSERT_EQUAL(3, port.idleNativeCount);
+  CPPUNIT_ASSERT_EQUAL(1, port.execJavaProcess_implCount);
+  CPPUNIT_ASSERT_EQUAL(3UL, port.getIdleCycleCount());
+
+  // connected again: the cycle is served.
+  port.connectionCount = 1;
+  port.sampleConnections(nullptr);
+  port.execNativeCycleInit(400, 100);
+  port.execNativeProcess(nullptr);
+  port.execJavaProcess(nullptr, true);
+  CPPUNIT_ASSERT(port.isTerminatedSubstate());
+  CPPUNIT_ASSERT_EQUAL(2, port.execJavaProcess_implCount);
+  CPPUNIT_ASSERT_EQUAL(2, port.execNativeProcess_implCount);
+  CPPUNIT_ASSERT_EQUAL(3UL, port.getIdleCycleCount());
+
+  port.shutdown(nullptr, nullptr, false);
+  CPPUNIT_ASSERT(!port.hasProcessException());
+}
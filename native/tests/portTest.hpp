@@ -19,10 +19,20 @@ class portTest : public CPPUNIT_NS::TestFixture {
   CPPUNIT_TEST(testFullLiveCicle_Output);
   CPPUNIT_TEST(testProcessFlipFlopAtMaxSpeed_Output);
   CPPUNIT_TEST(testProcessFlipFlopAtMaxSpeed_Input);
+  CPPUNIT_TEST(testLockFreeLiveCicle_Output);
+  CPPUNIT_TEST(testAsynchronousLiveCicle_Input);
+  CPPUNIT_TEST(testXrunSkip_Output);
+  CPPUNIT_TEST(testXrunMerge_Input);
+  CPPUNIT_TEST(testLockFreeFlipFlop_Output);
+  CPPUNIT_TEST(testLockFreeFlipFlop_Input);
   CPPUNIT_TEST(testBadNativeProcess);
+  CPPUNIT_TEST(testNativeErrorRecord);
+  CPPUNIT_TEST(testNativeFailsDuringJava);
+  CPPUNIT_TEST(testNativeFailsDuringBlockingJava);
   CPPUNIT_TEST(testBadJavaProcess);
   CPPUNIT_TEST(testBadOpen);
   CPPUNIT_TEST(testRandomTiming);
+  CPPUNIT_TEST(testSkipWhenIdle);
   //  CPPUNIT_TEST(testTimeoutExceptionInStop);
 
   CPPUNIT_TEST_SUITE_END();
@@ -33,13 +43,23 @@ private:
   void testMoveConstructorOnBusyPort();
   void testFullLiveCicle_Input();
   void testFullLiveCicle_Output();
-  void testProcessFlipFlopAtMaxSpeed(bool isOutput);
+  void testProcessFlipFlopAtMaxSpeed(bool isOutput, bool lockFree = false);
   void testProcessFlipFlopAtMaxSpeed_Output();
   void testProcessFlipFlopAtMaxSpeed_Input();
+  void testLockFreeLiveCicle_Output();
+  void testAsynchronousLiveCicle_Input();
+  void testXrunSkip_Output();
+  void testXrunMerge_Input();
+  void testLockFreeFlipFlop_Output();
+  void testLockFreeFlipFlop_Input();
   void testBadNativeProcess();
+  void testNativeErrorRecord();
+  void testNativeFailsDuringJava();
+  void testNativeFailsDuringBlockingJava();
   void testBadJavaProcess();
   void testBadOpen();
   void testRandomTiming();
+  void testSkipWhenIdle();
   void doTestRandomTiming(//
           bool isOutput,
           int initializeDuration,
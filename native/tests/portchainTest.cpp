@@ -129,6 +129,68 @@ public:
   OutputPortMock(OutputPortMock &&) = default;
 };
 
+/**
+ * A port that is served by the (mocked) java dispatcher.
+ */
+class DispatchedPortMock : public PortMock {
+public:
+  int beforeDispatchCount = 0;
+  int afterDispatchCount = 0;
+
+  DispatchedPortMock(bool isOutput, long internalId) :
+  PortMock(isOutput, internalId) {
+  }
+
+  virtual CycleEntry::Kind getDispatchKind() const override {
+    return isOutput() ? CycleEntry::outputPort : CycleEntry::inputPort;
+  }
+
+protected:
+
+  virtual void beforeDispatch_impl(JNIEnv * env, CycleEntry& entry) override {
+    beforeDispatchCount++;
+    entry.eventCount = 1;
+  }
+
+  virtual void afterDispatch_impl(JNIEnv * env, const CycleEntry& entry) override {
+    afterDispatchCount++;
+    if ((entry.flags & CycleEntry::lastCycleFlag) != 0) {
+      lastCycleCount++;
+    }
+  }
+};
+
+/**
+ * An output port that records the routes merged into it.
+ */
+class RouteOutputPortMock : public PortMock {
+public:
+  int mergeCount = 0;
+  int lastSourceCount = 0;
+  int lastChainCount = 0;
+  vector<long> lastSources;
+
+  RouteOutputPortMock(long internalId) :
+  PortMock(true, internalId) {
+  }
+
+protected:
+
+  virtual void execNativeMerge_impl(Port* const* sources, const ProcessorChain* const* chains, int count,
+          unsigned long timeCodeDuration, void * client)override {
+    mergeCount++;
+    lastSourceCount = count;
+    lastChainCount = 0;
+    lastSources.clear();
+    for (int i = 0; i < count; i++) {
+      lastSources.push_back(sources[i]->getId());
+      if (chains[i] != nullptr) {
+        lastChainCount++;
+      }
+    }
+  }
+};
+
 static int portChainMockDestructorCount = 0;
 
 class PortChainMock : public PortChain {
@@ -147,8 +209,38 @@ public:
   int findSlotForNewPort(const unique_ptr<Port>& newPort) {
     return PortChain::findSlotForNewPort(newPort);
   }
+
+  int getSnapshotCount() {
+    return activeSnapshot.load()->count;
+  }
+
+  long getSnapshotPortId(int index) {
+    return activeSnapshot.load()->ports[index]->getId();
+  }
+
+  int getRetiredSnapshotCount() {
+    return retiredSnapshots.size();
+  }
+
+  int dispatchPortsCount = 0;
+  int dispatchCycleCount = 0;
+  int dispatchedEntryCount = 0;
 protected:
 
+  virtual void dispatchPorts_impl(JNIEnv * env, Port* const* ports, int count) override {
+    dispatchPortsCount++;
+  }
+
+  /** plays the java dispatcher. */
+  virtual void dispatchCycle_impl(JNIEnv * env, int count) override {
+    dispatchCycleCount++;
+    for (int i = 0; i < count; i++) {
+      if (dispatchEntries[i].kind != CycleEntry::notDispatched) {
+        dispatchedEntryCount++;
+      }
+    }
+  }
+
 
 };
 
@@ -810,6 +902,8 @@ public:
 
   int nativeCyclecount = 0;
   bool nativeLoopEnded = false;
+  /** the pause between two native cycles (zero for full speed).*/
+  std::chrono::microseconds period = std::chrono::microseconds(0);
 
   ThreadRunner() {
   }
@@ -825,6 +919,9 @@ public:
     while (portChain.isRunningState()) {
       nativeCyclecount++;
       portChain.execNativeCycle((timeCodeStart += timeCodeDuration), timeCodeDuration, client);
+      if (period.count() != 0) {
+        std::this_thread::sleep_for(period);
+      }
     }
     nativeLoopEnded = true;
   }
@@ -896,6 +993,145 @@ void portchainTest::testFullSpeed() {
   CPPUNIT_ASSERT_EQUAL(0, portCount);
 }
 
+/**
+ * Testing the portchain in lock-free mode.
+ * Specification:
+ * The native thread never waits for the java thread and a late java
+ * thread does not stop the chain.
+ */
+void portchainTest::testFullSpeed_LockFree() {
+  void * dummyClient = (void*) - 1;
+  portCount = 0;
+  {
+    PortChainMock portChain;
+    portChain.setLockFree(true);
+    portChain.initialize(nullptr, nullptr,
+            unique_ptr<InputPortMock > (new InputPortMock(-2)), //start control
+            unique_ptr<OutputPortMock > (new OutputPortMock(-1))); //end control
+
+    long inputId = newPortId++;
+    long outputId = newPortId++;
+    unique_ptr<Port> port_i = unique_ptr<Port > (new InputPortMock(inputId));
+    unique_ptr<Port> port_o = unique_ptr<Port > (new OutputPortMock(outputId));
+    port_i->initialize(nullptr, nullptr, nullptr);
+    port_o->initialize(nullptr, nullptr, nullptr);
+
+    portChain.addPort(move(port_i), nullptr);
+    portChain.addPort(move(port_o), nullptr);
+
+    portChain.registerAtServer(dummyClient);
+    portChain.start();
+    CPPUNIT_ASSERT(portChain.isRunningState());
+
+    ThreadRunner nativeRunner;
+    nativeRunner.period = std::chrono::microseconds(100);
+    thread nativeThread([&]{nativeRunner.runNativeLoop(portChain, dummyClient);});
+    nativeThread.detach();
+
+    bool javaTreadHasEnded = false;
+    std::thread javaThread([&]{portChain.runJava(nullptr); javaTreadHasEnded = true;});
+    javaThread.detach();
+
+    const int runningMilliSec = 200;
+    std::this_thread::sleep_for(std::chrono::milliseconds(runningMilliSec));
+
+    portChain.stop();
+    CPPUNIT_ASSERT(portChain.isStoppedState());
+    CPPUNIT_ASSERT(javaTreadHasEnded);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CPPUNIT_ASSERT(nativeRunner.nativeLoopEnded);
+    CPPUNIT_ASSERT(!portChain.retrieveProcessException());
+
+    unique_ptr<Port> removed_o = portChain.removePort(nullptr, dummyClient, outputId);
+    OutputPortMock* outputPort = (OutputPortMock*) removed_o.get();
+    CPPUNIT_ASSERT(outputPort->isLockFree());
+    CPPUNIT_ASSERT(outputPort->execJavaProcess_implCount > 0);
+    // every output delivered by the java thread has been written by the native thread.
+    CPPUNIT_ASSERT_EQUAL(outputPort->execJavaProcess_implCount, outputPort->execNativeProcess_implCount);
+    CPPUNIT_ASSERT_EQUAL(1, outputPort->lastCycleCount);
+
+    portChain.shutdown(nullptr, dummyClient);
+    CPPUNIT_ASSERT(nativeRunner.nativeCyclecount > 100);
+  }
+  CPPUNIT_ASSERT_EQUAL(0, portCount);
+}
+
+/**
+ * Testing the portchain in batched dispatch mode.
+ * Specification:
+ * The java thread makes one dispatch per cycle, the dispatched ports are not
+ * called one by one, the other ports still are.
+ */
+void portchainTest::testFullSpeed_Batched() {
+  void * dummyClient = (void*) - 1;
+  portCount = 0;
+  {
+    PortChainMock portChain;
+    CPPUNIT_ASSERT_THROW(portChain.setBatchedDispatch(true), std::runtime_error);
+    portChain.setLockFree(true);
+    portChain.setBatchedDispatch(true);
+    CPPUNIT_ASSERT_THROW(portChain.setLockFree(false), std::runtime_error);
+    portChain.initialize(nullptr, nullptr,
+            unique_ptr<InputPortMock > (new InputPortMock(-2)), //start control
+            unique_ptr<OutputPortMock > (new OutputPortMock(-1))); //end control
+
+    long inputId = newPortId++;
+    long outputId = newPortId++;
+    long plainId = newPortId++;
+    unique_ptr<Port> port_i = unique_ptr<Port > (new DispatchedPortMock(false, inputId));
+    unique_ptr<Port> port_o = unique_ptr<Port > (new DispatchedPortMock(true, outputId));
+    unique_ptr<Port> port_p = unique_ptr<Port > (new OutputPortMock(plainId));
+    port_i->initialize(nullptr, nullptr, nullptr);
+    port_o->initialize(nullptr, nullptr, nullptr);
+    port_p->initialize(nullptr, nullptr, nullptr);
+
+    portChain.addPort(move(port_i), nullptr);
+    portChain.addPort(move(port_o), nullptr);
+    portChain.addPort(move(port_p), nullptr);
+
+    portChain.registerAtServer(dummyClient);
+    portChain.start();
+
+    ThreadRunner nativeRunner;
+    nativeRunner.period = std::chrono::microseconds(100);
+    thread nativeThread([&]{nativeRunner.runNativeLoop(portChain, dummyClient);});
+    nativeThread.detach();
+
+    bool javaTreadHasEnded = false;
+    std::thread javaThread([&]{portChain.runJava(nullptr); javaTreadHasEnded = true;});
+    javaThread.detach();
+
+    const int runningMilliSec = 200;
+    std::this_thread::sleep_for(std::chrono::milliseconds(runningMilliSec));
+
+    portChain.stop();
+    CPPUNIT_ASSERT(portChain.isStoppedState());
+    CPPUNIT_ASSERT(javaTreadHasEnded);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CPPUNIT_ASSERT(nativeRunner.nativeLoopEnded);
+    CPPUNIT_ASSERT(!portChain.retrieveProcessException());
+    CPPUNIT_ASSERT_EQUAL(1, portChain.dispatchPortsCount);
+    CPPUNIT_ASSERT(portChain.dispatchCycleCount > 0);
+
+    unique_ptr<Port> removed_o = portChain.removePort(nullptr, dummyClient, outputId);
+    DispatchedPortMock* outputPort = (DispatchedPortMock*) removed_o.get();
+    CPPUNIT_ASSERT_EQUAL(0, outputPort->execJavaProcess_implCount);
+    CPPUNIT_ASSERT(outputPort->afterDispatchCount > 0);
+    CPPUNIT_ASSERT_EQUAL(outputPort->beforeDispatchCount, outputPort->afterDispatchCount);
+    // every output delivered through the dispatcher has been written by the native thread.
+    CPPUNIT_ASSERT_EQUAL(outputPort->afterDispatchCount, outputPort->execNativeProcess_implCount);
+    CPPUNIT_ASSERT_EQUAL(1, outputPort->lastCycleCount);
+    // one dispatch per cycle, at most two entries (the dispatched ports) per dispatch.
+    CPPUNIT_ASSERT(portChain.dispatchedEntryCount <= 2 * portChain.dispatchCycleCount);
+
+    unique_ptr<Port> removed_p = portChain.removePort(nullptr, dummyClient, plainId);
+    CPPUNIT_ASSERT(((OutputPortMock*) removed_p.get())->execJavaProcess_implCount > 0);
+
+    portChain.shutdown(nullptr, dummyClient);
+  }
+  CPPUNIT_ASSERT_EQUAL(0, portCount);
+}
+
 /**
  * A helper class for the "testRanomAddRemovePorts()" test below.
  */
@@ -1109,6 +1345,47 @@ void portchainTest::testRandomAddRemovePorts() {
  * Specification:
  * At least (MAX_PORTS - 2) ports can be added to a port- chain.
  */
+/**
+ * The active snapshot must list exactly the live ports, densely packed and in
+ * processing order (start-control, input ports, output ports, end-control).
+ */
+void portchainTest::testActivePortSnapshot() {
+  void * dummyClient = (void*) - 1;
+  PortChainMock portChain;
+  CPPUNIT_ASSERT_EQUAL(0, portChain.getSnapshotCount());
+
+  portChain.initialize(nullptr, nullptr,
+          unique_ptr<InputPortMock > (new InputPortMock(-2)), //start control
+          unique_ptr<OutputPortMock > (new OutputPortMock(-1))); //end control
+  portChain.registerAtServer(dummyClient);
+  CPPUNIT_ASSERT_EQUAL(2, portChain.getSnapshotCount());
+
+  long outputId = newPortId++;
+  unique_ptr<Port> outputPort = unique_ptr<Port > (new OutputPortMock(outputId));
+  outputPort->initialize(nullptr, nullptr, nullptr);
+  portChain.addPort(move(outputPort), dummyClient);
+
+  long inputId = newPortId++;
+  unique_ptr<Port> inputPort = unique_ptr<Port > (new InputPortMock(inputId));
+  inputPort->initialize(nullptr, nullptr, nullptr);
+  portChain.addPort(move(inputPort), dummyClient);
+
+  CPPUNIT_ASSERT_EQUAL(4, portChain.getSnapshotCount());
+  CPPUNIT_ASSERT_EQUAL(-2L, portChain.getSnapshotPortId(0));
+  CPPUNIT_ASSERT_EQUAL(inputId, portChain.getSnapshotPortId(1));
+  CPPUNIT_ASSERT_EQUAL(outputId, portChain.getSnapshotPortId(2));
+  CPPUNIT_ASSERT_EQUAL(-1L, portChain.getSnapshotPortId(3));
+  // no process thread is running, so replaced snapshots are reclaimed at once.
+  CPPUNIT_ASSERT_EQUAL(0, portChain.getRetiredSnapshotCount());
+
+  unique_ptr<Port> removed = portChain.removePort(nullptr, dummyClient, inputId);
+  CPPUNIT_ASSERT_EQUAL(3, portChain.getSnapshotCount());
+  CPPUNIT_ASSERT_EQUAL(outputId, portChain.getSnapshotPortId(1));
+  CPPUNIT_ASSERT_EQUAL(0, portChain.getRetiredSnapshotCount());
+
+  portChain.shutdown(nullptr, dummyClient);
+}
+
 void portchainTest::testAddMaximumPorts() {
   void * dummyClient = (void*) - 1;
   portCount = 0;
@@ -1232,3 +1509,169 @@ void portchainTest::testAddMaximumPorts() {
   CPPUNIT_ASSERT_EQUAL(0, portCount);
 }
 
+
+/**
+ * Specification: during each cycle the native thread merges the routes into
+ * their output port; routes can be set and removed while the port-chain runs
+ * and they are discarded together with their ports.
+ */
+void portchainTest::testRoutes() {
+  void * dummyClient = (void*) - 1;
+  unsigned long timeCodeStart = 12345;
+  const unsigned long timeCodeDuration = 123;
+  PortChainMock portChain;
+  portChain.initialize(nullptr, nullptr,
+          unique_ptr<InputPortMock > (new InputPortMock(-2)), //start control
+          unique_ptr<OutputPortMock > (new OutputPortMock(-1))); //end control
+  portChain.registerAtServer(dummyClient);
+
+  bool javaTreadHasEnded = false;
+  std::thread javaThread([&]{portChain.runJava(nullptr); javaTreadHasEnded = true;});
+  javaThread.detach();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  portChain.start();
+
+  long inputId1 = newPortId++;
+  long inputId2 = newPortId++;
+  long outputId = newPortId++;
+  unique_ptr<Port> input1 = unique_ptr<Port > (new InputPortMock(inputId1));
+  unique_ptr<Port> input2 = unique_ptr<Port > (new InputPortMock(inputId2));
+  RouteOutputPortMock* output = new RouteOutputPortMock(outputId);
+  unique_ptr<Port> outputPort = unique_ptr<Port > (output);
+  input1->initialize(nullptr, nullptr, nullptr);
+  input2->initialize(nullptr, nullptr, nullptr);
+  outputPort->initialize(nullptr, nullptr, nullptr);
+  portChain.addPort(move(input1), dummyClient);
+  portChain.addPort(move(input2), dummyClient);
+  portChain.addPort(move(outputPort), dummyClient);
+
+  // a route leads from an existing input port to an existing output port.
+  CPPUNIT_ASSERT_THROW(portChain.setRoute(outputId, inputId1, nullptr), std::runtime_error);
+  CPPUNIT_ASSERT_THROW(portChain.setRoute(inputId1, newPortId++, nullptr), std::runtime_error);
+  CPPUNIT_ASSERT_EQUAL(0, portChain.getRouteCount());
+
+  portChain.execNativeCycle(timeCodeStart, timeCodeDuration, dummyClient);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  CPPUNIT_ASSERT_EQUAL(0, output->mergeCount);
+
+  unique_ptr<ProcessorChain> transpose(new ProcessorChain());
+  transpose->add(unique_ptr<MidiProcessor > (new TransposeProcessor(12)));
+  portChain.setRoute(inputId1, outputId, nullptr);
+  portChain.setRoute(inputId2, outputId, move(transpose));
+  portChain.setRoute(inputId1, outputId, nullptr); // replaces the first route
+  CPPUNIT_ASSERT_EQUAL(2, portChain.getRouteCount());
+
+  portChain.execNativeCycle((timeCodeStart += timeCodeDuration), timeCodeDuration, dummyClient);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  CPPUNIT_ASSERT_EQUAL(1, output->mergeCount);
+  CPPUNIT_ASSERT_EQUAL(2, output->lastSourceCount);
+  CPPUNIT_ASSERT_EQUAL(1, output->lastChainCount);
+  CPPUNIT_ASSERT_EQUAL(inputId1, output->lastSources[0]);
+  CPPUNIT_ASSERT_EQUAL(inputId2, output->lastSources[1]);
+
+  CPPUNIT_ASSERT(portChain.removeRoute(inputId2, outputId));
+  CPPUNIT_ASSERT(!portChain.removeRoute(inputId2, outputId));
+  portChain.execNativeCycle((timeCodeStart += timeCodeDuration), timeCodeDuration, dummyClient);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  CPPUNIT_ASSERT_EQUAL(2, output->mergeCount);
+  CPPUNIT_ASSERT_EQUAL(1, output->lastSourceCount);
+  CPPUNIT_ASSERT_EQUAL(0, output->lastChainCount);
+
+  // removing the input port discards its route.
+  bool removeReturned = false;
+  unique_ptr<Port> removedPort;
+  std::thread removingThread([&]{
+    removedPort = portChain.removePort(nullptr, dummyClient, inputId1);
+    removeReturned = true;
+  });
+  removingThread.detach();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  portChain.execNativeCycle((timeCodeStart += timeCodeDuration), timeCodeDuration, dummyClient);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  portChain.execNativeCycle((timeCodeStart += timeCodeDuration), timeCodeDuration, dummyClient);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  CPPUNIT_ASSERT(removeReturned);
+  CPPUNIT_ASSERT_EQUAL(0, portChain.getRouteCount());
+  int mergesBefore = output->mergeCount;
+  portChain.execNativeCycle((timeCodeStart += timeCodeDuration), timeCodeDuration, dummyClient);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  CPPUNIT_ASSERT_EQUAL(mergesBefore, output->mergeCount);
+
+  bool stopReturned = false;
+  std::thread stoppingThread([&]{portChain.stop(); stopReturned = true;});
+  stoppingThread.detach();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  portChain.execNativeCycle((timeCodeStart += timeCodeDuration), timeCodeDuration, dummyClient);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  portChain.execNativeCycle((timeCodeStart += timeCodeDuration), timeCodeDuration, dummyClient);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  CPPUNIT_ASSERT(stopReturned);
+  CPPUNIT_ASSERT(javaTreadHasEnded);
+  CPPUNIT_ASSERT(!portChain.retrieveProcessException());
+  portChain.shutdown(nullptr, dummyClient);
+}
+
+/**
+ * Testing the xrun statistics.
+ * Specification:
+ * In lock-free mode a cycle that starts before the java thread has finished
+ * the previous one is counted as an xrun (with its cycle number), the
+ * ports catch up once the java thread is back.
+ */
+void portchainTest::testXruns() {
+  void * dummyClient = (void*) - 1;
+  portCount = 0;
+  {
+    PortChainMock portChain;
+    portChain.setLockFree(true);
+    portChain.setXrunPolicy(XrunPolicy::skip);
+    portChain.initialize(nullptr, nullptr,
+            unique_ptr<InputPortMock > (new InputPortMock(-2)), //start control
+            unique_ptr<OutputPortMock > (new OutputPortMock(-1))); //end control
+    long outputId = newPortId++;
+    unique_ptr<Port> port_o = unique_ptr<Port > (new OutputPortMock(outputId));
+    port_o->initialize(nullptr, nullptr, nullptr);
+    portChain.addPort(move(port_o), nullptr);
+    portChain.registerAtServer(dummyClient);
+    portChain.start();
+
+    // cycle 0 is handed to java, but the java thread is late for cycles 1 and 2.
+    portChain.execNativeCycle(0, 100, dummyClient);
+    CPPUNIT_ASSERT_EQUAL(0UL, portChain.getXrunCount());
+    portChain.execNativeCycle(100, 100, dummyClient);
+    portChain.execNativeCycle(200, 100, dummyClient);
+    CPPUNIT_ASSERT_EQUAL(2UL, portChain.getXrunCount());
+
+    // the java thread catches up, cycles 3 and 4 are regular.
+    portChain.execJavaCycle(nullptr, false);
+    portChain.execNativeCycle(300, 100, dummyClient);
+    portChain.execJavaCycle(nullptr, false);
+    portChain.execNativeCycle(400, 100, dummyClient);
+    CPPUNIT_ASSERT_EQUAL(2UL, portChain.getXrunCount());
+    CPPUNIT_ASSERT_EQUAL(5UL, portChain.getCycleCount());
+
+    unsigned long cycles[PortChain::recentXrunCapacity];
+    CPPUNIT_ASSERT_EQUAL(2, portChain.getRecentXruns(cycles));
+    CPPUNIT_ASSERT_EQUAL(1UL, cycles[0]);
+    CPPUNIT_ASSERT_EQUAL(2UL, cycles[1]);
+
+    // let the threads finish the session.
+    ThreadRunner nativeRunner;
+    nativeRunner.period = std::chrono::microseconds(100);
+    thread nativeThread([&]{nativeRunner.runNativeLoop(portChain, dummyClient);});
+    thread javaThread([&]{portChain.runJava(nullptr);});
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    portChain.stop();
+    javaThread.join();
+    nativeThread.join();
+    CPPUNIT_ASSERT(portChain.isStoppedState());
+    CPPUNIT_ASSERT(!portChain.retrieveProcessException());
+
+    unique_ptr<Port> removed_o = portChain.removePort(nullptr, dummyClient, outputId);
+    OutputPortMock* outputPort = (OutputPortMock*) removed_o.get();
+    CPPUNIT_ASSERT(outputPort->getLateCycleCount() >= 2);
+    CPPUNIT_ASSERT(outputPort->getDroppedCycleCount() >= 1);
+    portChain.shutdown(nullptr, dummyClient);
+  }
+  CPPUNIT_ASSERT_EQUAL(0, portCount);
+}
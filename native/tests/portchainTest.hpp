@@ -26,8 +26,13 @@ class portchainTest : public CPPUNIT_NS::TestFixture {
   CPPUNIT_TEST(testAddInputPort);
   CPPUNIT_TEST(testAddOutputPort);
   CPPUNIT_TEST(testFullSpeed);
+  CPPUNIT_TEST(testFullSpeed_LockFree);
+  CPPUNIT_TEST(testFullSpeed_Batched);
   CPPUNIT_TEST(testRandomAddRemovePorts);
   CPPUNIT_TEST(testAddMaximumPorts);
+  CPPUNIT_TEST(testActivePortSnapshot);
+  CPPUNIT_TEST(testRoutes);
+  CPPUNIT_TEST(testXruns);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -50,8 +55,13 @@ private:
   void testAddInputPort();
   void testAddOutputPort();
   void testFullSpeed();
+  void testFullSpeed_LockFree();
+  void testFullSpeed_Batched();
   void testRandomAddRemovePorts();
   void testAddMaximumPorts();
+  void testActivePortSnapshot();
+  void testRoutes();
+  void testXruns();
 
 
 
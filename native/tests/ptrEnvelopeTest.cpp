@@ -7,8 +7,10 @@
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <atomic>
 #include "ptrEnvelopeTest.hpp"
 #include "../ptrEnvelope.hpp"
+#include "../epochEnvelope.hpp"
 #include "../port.hpp"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(ptrEnvelopeTest);
@@ -334,4 +336,112 @@ void ptrEnvelopeTest::testTimeoutIn_setItemWait() {
   CPPUNIT_ASSERT(port != false);
   CPPUNIT_ASSERT(envelope.isEmpty());
 
-}
\ No newline at end of file
+}
+
+/**
+ * The EpochEnvelope shall move items in and out like the PtrEnvelope.
+ */
+void ptrEnvelopeTest::testEpochMoveRemoveSemantic() {
+  portCount = 0;
+  long id = newPortId++;
+  auto originalPtr = unique_ptr<Port > (new PortMock(id));
+  {
+    EpochEnvelope envelope;
+    CPPUNIT_ASSERT(envelope.isEmpty());
+    CPPUNIT_ASSERT(envelope.makeAccessor().isEmpty());
+    envelope.setItemWait(move(originalPtr));
+    CPPUNIT_ASSERT(originalPtr == false);
+    CPPUNIT_ASSERT(envelope.hasItem());
+    {
+      auto accessor = envelope.makeAccessor();
+      CPPUNIT_ASSERT(accessor.hasItem());
+      CPPUNIT_ASSERT_EQUAL(id, accessor.get()->getId());
+    }
+
+    auto receivingPtr = envelope.removeItemWait();
+    CPPUNIT_ASSERT(envelope.isEmpty());
+    CPPUNIT_ASSERT_EQUAL(id, receivingPtr->getId());
+    CPPUNIT_ASSERT_EQUAL(1, portCount);
+
+    // an envelope going out of scope deletes its item.
+    envelope.setItemWait(move(receivingPtr));
+  }
+  CPPUNIT_ASSERT_EQUAL(0, portCount);
+}
+
+/**
+ * Helper procedure that holds an Accessor of an EpochEnvelope for about 100 milliseconds.
+ */
+void accessAndHoldEpochPointer(EpochEnvelope& envelope, bool hasItem) {
+  auto accessor = envelope.makeAccessor();
+  for (int i = 0; i < 33; i++) {
+    CPPUNIT_ASSERT_EQUAL(accessor.hasItem(), hasItem);
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+  }
+}
+
+/**
+ * Specification: removeItemWait() on an EpochEnvelope will fail with a "timeoutException"
+ * if a reader stays longer than "maxWaitingTime"; the envelope keeps the item.
+ */
+void ptrEnvelopeTest::testEpochTimeoutIn_removeItemWait() {
+  EpochEnvelope envelope(5); // we set the maxWaitingTime time to 5 milliseconds to speed up the test.
+  portCount = 0;
+
+  envelope.setItemWait(unique_ptr<Port > (new PortMock(newPortId++)));
+
+  std::thread readAccessTread([&]{accessAndHoldEpochPointer(envelope, true);});
+  std::this_thread::sleep_for(std::chrono::milliseconds(5)); // make sure the thread has started
+
+  bool timeoutDetected = false;
+  try {
+    envelope.removeItemWait();
+  } catch (TimeoutException& ex) {
+    timeoutDetected = true;
+  }
+  readAccessTread.join();
+  CPPUNIT_ASSERT(timeoutDetected);
+  CPPUNIT_ASSERT_EQUAL(1, portCount);
+  CPPUNIT_ASSERT(envelope.hasItem());
+
+  // once the reader has gone, the item can be removed.
+  envelope.removeItemWait();
+  CPPUNIT_ASSERT_EQUAL(0, portCount);
+}
+
+/**
+ * Measures how many accesses (makeAccessor, get, ~Accessor) per second the
+ * PtrEnvelope and the EpochEnvelope permit, each read by two threads concurrently.
+ * Only the completeness of the run is asserted, the figures depend on the machine.
+ */
+template<typename Envelope>
+static double measureAccessThroughput() {
+  const int accessCount = 1000000;
+  Envelope envelope;
+  envelope.setItemWait(unique_ptr<Port > (new PortMock(newPortId++)));
+  atomic<long> idSum(0);
+  auto reader = [&]() {
+    long sum = 0;
+    for (int i = 0; i < accessCount; i++) {
+      auto accessor = envelope.makeAccessor();
+      sum += accessor.get()->getId();
+    }
+    idSum += sum;
+  };
+  auto start = chrono::steady_clock::now();
+  std::thread reader1(reader);
+  std::thread reader2(reader);
+  reader1.join();
+  reader2.join();
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  CPPUNIT_ASSERT(idSum != 0);
+  return (2.0 * accessCount) / seconds;
+}
+
+void ptrEnvelopeTest::testThroughputComparison() {
+  double locking = measureAccessThroughput<PtrEnvelope>();
+  double epoch = measureAccessThroughput<EpochEnvelope>();
+  std::cerr << "  testThroughputComparison: PtrEnvelope   " << (long) locking << " accesses/s\n";
+  std::cerr << "  testThroughputComparison: EpochEnvelope " << (long) epoch << " accesses/s\n";
+  CPPUNIT_ASSERT_EQUAL(0, portCount);
+}
@@ -24,6 +24,10 @@ class ptrEnvelopeTest : public CPPUNIT_NS::TestFixture {
   CPPUNIT_TEST(testTimeoutIn_removeItemWait);
   CPPUNIT_TEST(testTimeoutIn_setItemWait);
 
+  CPPUNIT_TEST(testEpochMoveRemoveSemantic);
+  CPPUNIT_TEST(testEpochTimeoutIn_removeItemWait);
+  CPPUNIT_TEST(testThroughputComparison);
+
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -42,6 +46,10 @@ private:
   void testTimeoutIn_removeItemWait();
   void testTimeoutIn_setItemWait();
 
+  void testEpochMoveRemoveSemantic();
+  void testEpochTimeoutIn_removeItemWait();
+  void testThroughputComparison();
+
 };
 
 #endif	/* PTRENVELOPETEST_HPP */
@@ -0,0 +1,134 @@
+/*
+ * File:   rtLogTest.cpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 9:30:01 PM
+ */
+#include <thread>
+#include <vector>
+#include "rtLogTest.hpp"
+#include "../rtLog.hpp"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(rtLogTest);
+
+rtLogTest::rtLogTest() {
+}
+
+rtLogTest::~rtLogTest() {
+}
+
+void rtLogTest::setUp() {
+}
+
+void rtLogTest::tearDown() {
+}
+
+void rtLogTest::testLogAndTake() {
+  RtLog log;
+  RtLogRecord record;
+  CPPUNIT_ASSERT(!log.take(record));
+
+  CPPUNIT_ASSERT(log.log(RtLogLevel::warning, "first message", 42));
+  CPPUNIT_ASSERT(log.log(RtLogLevel::severe, "second message"));
+
+  CPPUNIT_ASSERT(log.take(record));
+  CPPUNIT_ASSERT(RtLogLevel::warning == record.level);
+  CPPUNIT_ASSERT_EQUAL(string("first message (42)"), record.toString());
+  CPPUNIT_ASSERT(log.take(record));
+  CPPUNIT_ASSERT(RtLogLevel::severe == record.level);
+  CPPUNIT_ASSERT_EQUAL(string("second message"), record.toString());
+  CPPUNIT_ASSERT(!log.take(record));
+}
+
+/**
+ * A repeating message is logged once per interval, the next record tells
+ * how many have been suppressed.
+ */
+void rtLogTest::testRateLimit() {
+  RtLog log(20);
+  RtLogRecord record;
+  for (int i = 0; i < 10; i++) {
+    log.log(RtLogLevel::warning, "repeating message");
+  }
+  log.log(RtLogLevel::info, "other message");
+  CPPUNIT_ASSERT(log.take(record));
+  CPPUNIT_ASSERT_EQUAL(0UL, record.suppressed);
+  CPPUNIT_ASSERT(log.take(record));
+  CPPUNIT_ASSERT_EQUAL(string("other message"), record.toString());
+  CPPUNIT_ASSERT(!log.take(record));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  CPPUNIT_ASSERT(log.log(RtLogLevel::warning, "repeating message"));
+  CPPUNIT_ASSERT(log.take(record));
+  CPPUNIT_ASSERT_EQUAL(9UL, record.suppressed);
+  CPPUNIT_ASSERT_EQUAL(string("repeating message [9 similar messages suppressed]"), record.toString());
+}
+
+/**
+ * When nobody takes the records, the log drops and counts the new ones.
+ */
+void rtLogTest::testFullLog() {
+  RtLog log;
+  const char* messages[RtLog::capacity + 1];
+  static char text[RtLog::capacity + 1][8];
+  for (size_t i = 0; i <= RtLog::capacity; i++) {
+    // distinct messages (the rate limit does not apply).
+    messages[i] = text[i];
+  }
+  for (size_t i = 0; i < RtLog::capacity; i++) {
+    CPPUNIT_ASSERT(log.log(RtLogLevel::info, messages[i], static_cast<long> (i)));
+  }
+  CPPUNIT_ASSERT(!log.log(RtLogLevel::info, messages[RtLog::capacity]));
+  CPPUNIT_ASSERT_EQUAL(1UL, log.getDroppedCount());
+
+  RtLogRecord record;
+  for (size_t i = 0; i < RtLog::capacity; i++) {
+    CPPUNIT_ASSERT(log.take(record));
+    CPPUNIT_ASSERT_EQUAL(static_cast<long> (i), record.argument);
+  }
+  CPPUNIT_ASSERT(!log.take(record));
+  // there is room again.
+  CPPUNIT_ASSERT(log.log(RtLogLevel::info, "after full"));
+  CPPUNIT_ASSERT(log.take(record));
+}
+
+/**
+ * Several threads log at the same time, while one thread takes the records:
+ * no record is lost or taken twice.
+ */
+void rtLogTest::testConcurrentLog() {
+  RtLog log(0);
+  static const char* messages[] = {"thread 0", "thread 1", "thread 2", "thread 3"};
+  const int threadCount = 4;
+  const long recordsPerThread = 20000;
+  vector<thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.push_back(thread([&log, t, recordsPerThread]() {
+      for (long i = 0; i < recordsPerThread;) {
+        if (log.log(RtLogLevel::info, messages[t], i)) {
+          i++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    }));
+  }
+  long next[threadCount] = {0, 0, 0, 0};
+  long taken = 0;
+  RtLogRecord record;
+  while (taken < threadCount * recordsPerThread) {
+    if (!log.take(record)) {
+      std::this_thread::yield();
+      continue;
+    }
+    int t = static_cast<int> (record.message[7] - '0');
+    // the records of one thread arrive in order.
+    CPPUNIT_ASSERT_EQUAL(next[t], record.argument);
+    next[t]++;
+    taken++;
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  CPPUNIT_ASSERT(!log.take(record));
+}
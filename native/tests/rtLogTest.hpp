@@ -0,0 +1,38 @@
+/*
+ * File:   rtLogTest.hpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 9:30:00 PM
+ */
+
+#ifndef RTLOGTEST_HPP
+#define	RTLOGTEST_HPP
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class rtLogTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(rtLogTest);
+
+  CPPUNIT_TEST(testLogAndTake);
+  CPPUNIT_TEST(testRateLimit);
+  CPPUNIT_TEST(testFullLog);
+  CPPUNIT_TEST(testConcurrentLog);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  rtLogTest();
+  virtual ~rtLogTest();
+  void setUp();
+  void tearDown();
+
+private:
+  void testLogAndTake();
+  void testRateLimit();
+  void testFullLog();
+  void testConcurrentLog();
+
+};
+
+#endif	/* RTLOGTEST_HPP */
+
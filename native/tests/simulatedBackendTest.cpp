@@ -0,0 +1,581 @@
+/*
+ * File:   simulatedBackendTest.cpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 11:20:14 PM
+ */
+
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include "simulatedBackendTest.hpp"
+#include "simulatedBackend.hpp"
+#include "portchain.hpp"
+#include "port.hpp"
+#include "JackInputPort.hpp"
+#include "JackOutputPort.hpp"
+#include "midiProcessor.hpp"
+
+using namespace std;
+
+CPPUNIT_TEST_SUITE_REGISTRATION(simulatedBackendTest);
+
+simulatedBackendTest::simulatedBackendTest() {
+}
+
+simulatedBackendTest::~simulatedBackendTest() {
+}
+
+void simulatedBackendTest::setUp() {
+}
+
+void simulatedBackendTest::tearDown() {
+}
+
+/**
+ * A process function that copies all events from one port to another.
+ */
+static SimulatedBackend::Process thru(SimulatedBackend& backend, MidiBackend::PortHandle in, MidiBackend::PortHandle out) {
+  return [&backend, in, out](unsigned long timeCodeStart, unsigned long timeCodeDuration) {
+    void* inBuffer = backend.getBuffer(in, timeCodeDuration);
+    void* outBuffer = backend.getBuffer(out, timeCodeDuration);
+    backend.clearBuffer(outBuffer);
+    for (int i = 0; i < backend.getEventCount(inBuffer); i++) {
+      MidiBackend::Event event;
+      CPPUNIT_ASSERT_EQUAL(0, backend.getEvent(event, inBuffer, i));
+      uint8_t* target = backend.reserveEvent(outBuffer, event.time, event.size);
+      CPPUNIT_ASSERT(target != nullptr);
+      memcpy(target, event.buffer, event.size);
+    }
+  };
+}
+
+/**
+ * Specification: port names are unique, only registered ports can be unregistered.
+ */
+void simulatedBackendTest::testRegisterPorts() {
+  SimulatedBackend backend(64, chrono::microseconds(0));
+  MidiBackend::PortHandle in = backend.registerPort("in", true);
+  CPPUNIT_ASSERT(in != nullptr);
+  CPPUNIT_ASSERT(backend.registerPort("in", false) == nullptr);
+  CPPUNIT_ASSERT(backend.registerPort("out", false) != nullptr);
+
+  CPPUNIT_ASSERT_EQUAL(0, backend.unregisterPort(in));
+  CPPUNIT_ASSERT_EQUAL(-1, backend.unregisterPort(in));
+  CPPUNIT_ASSERT(backend.registerPort("in", true) != nullptr);
+  CPPUNIT_ASSERT_THROW(SimulatedBackend(0, chrono::microseconds(0)), std::runtime_error);
+}
+
+/**
+ * Specification: an injected event is delivered in the cycle its time-code
+ * falls into, with the offset of the time-code in the cycle; the events written
+ * to an output port are captured with their absolute time-code.
+ */
+void simulatedBackendTest::testInjectAndCapture() {
+  const unsigned long bufferSize = 64;
+  SimulatedBackend backend(bufferSize, chrono::microseconds(0), 1000);
+  MidiBackend::PortHandle in = backend.registerPort("in", true);
+  MidiBackend::PortHandle out = backend.registerPort("out", false);
+  const uint8_t noteOn[] = {0x90, 60, 100};
+  const uint8_t sysex[] = {0xF0, 0x7E, 0x7F, 0x09, 0x01, 0xF7};
+  CPPUNIT_ASSERT(backend.inject("in", 1010, noteOn, sizeof (noteOn)));
+  CPPUNIT_ASSERT(backend.inject("in", 1100, sysex, sizeof (sysex)));
+  CPPUNIT_ASSERT(!backend.inject("out", 1100, noteOn, sizeof (noteOn)));
+  CPPUNIT_ASSERT(!backend.inject("unknown", 1100, noteOn, sizeof (noteOn)));
+
+  vector<int> eventCounts;
+  auto process = thru(backend, in, out);
+  for (int cycle = 0; cycle < 3; cycle++) {
+    backend.runCycle([&](unsigned long timeCodeStart, unsigned long timeCodeDuration) {
+      CPPUNIT_ASSERT_EQUAL(1000 + cycle * bufferSize, timeCodeStart);
+      CPPUNIT_ASSERT_EQUAL(bufferSize, timeCodeDuration);
+      eventCounts.push_back(backend.getEventCount(backend.getBuffer(in, timeCodeDuration)));
+      process(timeCodeStart, timeCodeDuration);
+    });
+  }
+  CPPUNIT_ASSERT_EQUAL(1, eventCounts[0]);
+  CPPUNIT_ASSERT_EQUAL(1, eventCounts[1]);
+  CPPUNIT_ASSERT_EQUAL(0, eventCounts[2]);
+  CPPUNIT_ASSERT_EQUAL(3UL, backend.getCycleCount());
+
+  vector<SimulatedBackend::TimedEvent> captured = backend.takeCaptured("out");
+  CPPUNIT_ASSERT_EQUAL(2, (int) captured.size());
+  CPPUNIT_ASSERT_EQUAL(1010UL, captured[0].time);
+  CPPUNIT_ASSERT(captured[0].midi == vector<uint8_t>(noteOn, noteOn + sizeof (noteOn)));
+  CPPUNIT_ASSERT_EQUAL(1100UL, captured[1].time);
+  CPPUNIT_ASSERT(captured[1].midi == vector<uint8_t>(sysex, sysex + sizeof (sysex)));
+  // taken events are forgotten
+  CPPUNIT_ASSERT(backend.takeCaptured("out").empty());
+}
+
+/**
+ * Specification: events are delivered in the order of their time-codes,
+ * events scheduled for a past cycle are delivered at the start of the next cycle.
+ */
+void simulatedBackendTest::testLateAndUnorderedEvents() {
+  SimulatedBackend backend(64, chrono::microseconds(0), 640);
+  MidiBackend::PortHandle in = backend.registerPort("in", true);
+  MidiBackend::PortHandle out = backend.registerPort("out", false);
+  const uint8_t first[] = {0x90, 60, 100};
+  const uint8_t second[] = {0x80, 60, 0};
+  const uint8_t late[] = {0xFE};
+  CPPUNIT_ASSERT(backend.inject("in", 650, second, sizeof (second)));
+  CPPUNIT_ASSERT(backend.inject("in", 645, first, sizeof (first)));
+  CPPUNIT_ASSERT(backend.inject("in", 10, late, sizeof (late)));
+
+  backend.runCycle(thru(backend, in, out));
+  vector<SimulatedBackend::TimedEvent> captured = backend.takeCaptured("out");
+  CPPUNIT_ASSERT_EQUAL(3, (int) captured.size());
+  CPPUNIT_ASSERT_EQUAL(640UL, captured[0].time);
+  CPPUNIT_ASSERT_EQUAL(1, (int) captured[0].midi.size());
+  CPPUNIT_ASSERT_EQUAL(645UL, captured[1].time);
+  CPPUNIT_ASSERT_EQUAL(650UL, captured[2].time);
+  CPPUNIT_ASSERT_EQUAL((uint8_t) 0x80, captured[2].midi[0]);
+}
+
+/**
+ * Specification: a full input buffer defers the remaining events to the next cycle;
+ * a full output buffer refuses further events.
+ */
+void simulatedBackendTest::testBufferFull() {
+  SimulatedBackend backend(64, chrono::microseconds(0));
+  MidiBackend::PortHandle in = backend.registerPort("in", true);
+  MidiBackend::PortHandle out = backend.registerPort("out", false);
+  const uint8_t clock[] = {0xF8};
+  const int injected = SimulatedBackend::maxEventsPerCycle + 10;
+  for (int i = 0; i < injected; i++) {
+    CPPUNIT_ASSERT(backend.inject("in", 5, clock, sizeof (clock)));
+  }
+  vector<int> eventCounts;
+  for (int cycle = 0; cycle < 2; cycle++) {
+    backend.runCycle([&](unsigned long timeCodeStart, unsigned long timeCodeDuration) {
+      eventCounts.push_back(backend.getEventCount(backend.getBuffer(in, timeCodeDuration)));
+    });
+  }
+  CPPUNIT_ASSERT_EQUAL(SimulatedBackend::maxEventsPerCycle, eventCounts[0]);
+  CPPUNIT_ASSERT_EQUAL(10, eventCounts[1]);
+
+  backend.runCycle([&](unsigned long timeCodeStart, unsigned long timeCodeDuration) {
+    void* buffer = backend.getBuffer(out, timeCodeDuration);
+    backend.clearBuffer(buffer);
+    CPPUNIT_ASSERT(backend.reserveEvent(buffer, 10, 1) != nullptr);
+    // out of order, beyond the cycle, too big
+    CPPUNIT_ASSERT(backend.reserveEvent(buffer, 9, 1) == nullptr);
+    CPPUNIT_ASSERT(backend.reserveEvent(buffer, 64, 1) == nullptr);
+    CPPUNIT_ASSERT(backend.reserveEvent(buffer, 11, SimulatedBackend::maxBytesPerCycle) == nullptr);
+  });
+  CPPUNIT_ASSERT_EQUAL(1, (int) backend.takeCaptured("out").size());
+}
+
+/**
+ * Specification: the back-to-back driver runs the cycles as fast as the process
+ * function returns, waitForTimeCode returns once a time-code has been processed.
+ */
+void simulatedBackendTest::testWaitForTimeCode() {
+  SimulatedBackend backend(64, chrono::microseconds(0));
+  backend.registerPort("b", true);
+  backend.registerPort("out", false);
+  backend.registerPort("a", true);
+  CPPUNIT_ASSERT(backend.getPortNames(true) == vector<string>({"b", "a"}));
+  CPPUNIT_ASSERT(backend.getPortNames(false) == vector<string>({"out"}));
+
+  CPPUNIT_ASSERT(!backend.waitForTimeCode(64, chrono::microseconds(1000)));
+  backend.start([](unsigned long timeCodeStart, unsigned long timeCodeDuration) {
+  });
+  CPPUNIT_ASSERT(backend.waitForTimeCode(64 * 1000, chrono::microseconds(5000000)));
+  CPPUNIT_ASSERT(backend.getTimeCode() >= 64 * 1000);
+  backend.stop();
+  CPPUNIT_ASSERT(backend.getCycleCount() >= 1000);
+  CPPUNIT_ASSERT_EQUAL(backend.getCycleCount() * 64, backend.getTimeCode());
+}
+
+/**
+ * A port that does nothing but (optionally) copying events through the backend.
+ */
+class BackendPortMock : public Port {
+public:
+
+  BackendPortMock(bool isOutput, long internalId) :
+  Port(isOutput, internalId) {
+  }
+
+protected:
+
+  virtual void initialize_impl(JNIEnv * env, jstring name, jobject listener)override {
+  }
+
+  virtual void register_impl(void * client)override {
+  }
+
+  virtual void start_impl()override {
+  }
+
+  virtual void execJavaProcess_impl(JNIEnv * env, unsigned long timeCodeStart, unsigned long timeCodeDuration, bool lastCycle)override {
+  }
+
+  virtual void execNativeProcess_impl(unsigned long timeCodeStart, unsigned long timeCodeDuration, void * client)override {
+  }
+
+  virtual void stop_impl()override {
+  }
+
+  virtual void uninitialize_impl(JNIEnv * env) override {
+  }
+
+  virtual void unregister_impl(void * client)override {
+  }
+};
+
+/**
+ * The events an input port has read in the current cycle (handed to the
+ * output port by the native thread).
+ */
+struct ThruEvent {
+  uint32_t time;
+  vector<uint8_t> midi;
+};
+
+/**
+ * Reads its backend port like JackInputPort does.
+ */
+class ThruInputPort : public BackendPortMock {
+public:
+  vector<ThruEvent>& events;
+  MidiBackend::PortHandle handle = nullptr;
+
+  ThruInputPort(long internalId, vector<ThruEvent>& _events) :
+  BackendPortMock(false, internalId),
+  events(_events) {
+  }
+
+protected:
+
+  virtual void register_impl(void * client)override {
+    handle = static_cast<MidiBackend*> (client)->registerPort("thru_in", true);
+    CPPUNIT_ASSERT(handle != nullptr);
+  }
+
+  virtual void execNativeProcess_impl(unsigned long timeCodeStart, unsigned long timeCodeDuration, void * client)override {
+    MidiBackend* backend = static_cast<MidiBackend*> (client);
+    void* buffer = backend->getBuffer(handle, timeCodeDuration);
+    events.clear();
+    for (int i = 0; i < backend->getEventCount(buffer); i++) {
+      MidiBackend::Event event;
+      backend->getEvent(event, buffer, i);
+      events.push_back(ThruEvent{event.time, vector<uint8_t>(event.buffer, event.buffer + event.size)});
+    }
+  }
+
+  virtual void unregister_impl(void * client)override {
+    CPPUNIT_ASSERT_EQUAL(0, static_cast<MidiBackend*> (client)->unregisterPort(handle));
+  }
+};
+
+/**
+ * Writes its backend port like JackOutputPort does.
+ */
+class ThruOutputPort : public BackendPortMock {
+public:
+  const vector<ThruEvent>& events;
+  MidiBackend::PortHandle handle = nullptr;
+
+  ThruOutputPort(long internalId, const vector<ThruEvent>& _events) :
+  BackendPortMock(true, internalId),
+  events(_events) {
+  }
+
+protected:
+
+  virtual void register_impl(void * client)override {
+    handle = static_cast<MidiBackend*> (client)->registerPort("thru_out", false);
+    CPPUNIT_ASSERT(handle != nullptr);
+  }
+
+  virtual void execNativeProcess_impl(unsigned long timeCodeStart, unsigned long timeCodeDuration, void * client)override {
+    MidiBackend* backend = static_cast<MidiBackend*> (client);
+    void* buffer = backend->getBuffer(handle, timeCodeDuration);
+    backend->clearBuffer(buffer);
+    for (const ThruEvent& event : events) {
+      uint8_t* target = backend->reserveEvent(buffer, event.time, event.midi.size());
+      memcpy(target, event.midi.data(), event.midi.size());
+    }
+  }
+
+  virtual void unregister_impl(void * client)override {
+    CPPUNIT_ASSERT_EQUAL(0, static_cast<MidiBackend*> (client)->unregisterPort(handle));
+  }
+};
+
+class SimulatedPortChain : public PortChain {
+public:
+
+  SimulatedPortChain() :
+  PortChain() {
+  }
+};
+
+/**
+ * Testing a port-chain driven by the simulated driver.
+ * Specification: the events injected into the input port come out of the
+ * output port with the same time-code (the ports work in the same cycle).
+ */
+void simulatedBackendTest::testPortChainThru() {
+  SimulatedBackend backend(64, chrono::microseconds(100));
+  vector<ThruEvent> events;
+  {
+    SimulatedPortChain portChain;
+    portChain.initialize(nullptr, nullptr,
+            unique_ptr<Port > (new BackendPortMock(false, -1)), //start control
+            unique_ptr<Port > (new BackendPortMock(true, -2))); //end control
+    unique_ptr<Port> port_i = unique_ptr<Port > (new ThruInputPort(1, events));
+    unique_ptr<Port> port_o = unique_ptr<Port > (new ThruOutputPort(2, events));
+    port_i->initialize(nullptr, nullptr, nullptr);
+    port_o->initialize(nullptr, nullptr, nullptr);
+    portChain.addPort(move(port_i), &backend);
+    portChain.addPort(move(port_o), &backend);
+    portChain.registerAtServer(&backend);
+
+    const int eventCount = 50;
+    for (int i = 0; i < eventCount; i++) {
+      const uint8_t noteOn[] = {0x90, static_cast<uint8_t> (i), 100};
+      CPPUNIT_ASSERT(backend.inject("thru_in", 100 + 37 * i, noteOn, sizeof (noteOn)));
+    }
+
+    portChain.start();
+    backend.start([&portChain, &backend](unsigned long timeCodeStart, unsigned long timeCodeDuration) {
+      portChain.execNativeCycle(timeCodeStart, timeCodeDuration, &backend);
+    });
+    thread javaThread([&portChain] {
+      portChain.runJava(nullptr);
+    });
+
+    vector<SimulatedBackend::TimedEvent> captured;
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while ((captured.size() < eventCount) && (chrono::steady_clock::now() < deadline)) {
+      this_thread::sleep_for(chrono::milliseconds(5));
+      for (auto &event : backend.takeCaptured("thru_out")) {
+        captured.push_back(event);
+      }
+    }
+
+    portChain.stop();
+    javaThread.join();
+    backend.stop();
+    CPPUNIT_ASSERT(!portChain.retrieveProcessException());
+    portChain.shutdown(nullptr, &backend);
+
+    CPPUNIT_ASSERT_EQUAL(eventCount, (int) captured.size());
+    for (int i = 0; i < eventCount; i++) {
+      CPPUNIT_ASSERT_EQUAL(100UL + 37 * i, captured[i].time);
+      CPPUNIT_ASSERT_EQUAL((uint8_t) i, captured[i].midi[1]);
+    }
+    CPPUNIT_ASSERT(backend.getCycleCount() > 0);
+    CPPUNIT_ASSERT(backend.getLongestCycle() <= backend.getTotalCycleTime());
+  }
+}
+
+/**
+ * A JackInputPort without a java side: the java cycle only drains the ring
+ * (of an asynchronous port).
+ */
+class EchoInputPort : public JackInputPort {
+public:
+
+  EchoInputPort(long internalId, int ringCapacity, int eventCapacity = 0,
+          OverflowPolicy policy = OverflowPolicy::dropNewest) :
+  JackInputPort("echo_in", internalId, ringCapacity, eventCapacity, policy) {
+  }
+
+  const MidiEventArena& events() const {
+    return getEvents();
+  }
+
+protected:
+
+  virtual void initialize_impl(JNIEnv * env, jstring name, jobject listener)override {
+  }
+
+  virtual void execJavaProcess_impl(JNIEnv * env, unsigned long timeCodeStart, unsigned long timeCodeDuration, bool lastCycle)override {
+    if (getRingCapacity() > 0) {
+      drainRing(timeCodeStart, timeCodeDuration);
+    }
+  }
+
+  virtual void uninitialize_impl(JNIEnv * env) override {
+  }
+};
+
+/**
+ * A JackOutputPort whose java cycle echoes the events of an input port
+ * unchanged, like a pass-through listener does.
+ */
+class EchoOutputPort : public JackOutputPort {
+public:
+  const EchoInputPort& input;
+
+  EchoOutputPort(long internalId, const EchoInputPort& _input) :
+  JackOutputPort("echo_out", internalId),
+  input(_input) {
+  }
+
+protected:
+
+  virtual void initialize_impl(JNIEnv * env, jstring name, jobject listener)override {
+  }
+
+  virtual void execJavaProcess_impl(JNIEnv * env, unsigned long timeCodeStart, unsigned long timeCodeDuration, bool lastCycle)override {
+    MidiEventArena& events = getEvents();
+    events.clear();
+    const MidiEventArena& received = input.events();
+    for (int i = 0; i < received.size(); i++) {
+      CPPUNIT_ASSERT(received.getDeltaTime(i) >= 0);
+      CPPUNIT_ASSERT(static_cast<unsigned long> (received.getDeltaTime(i)) < timeCodeDuration);
+      events.add(received.getDeltaTime(i), received.getMidi(i), received.getLength(i));
+    }
+  }
+
+  virtual void uninitialize_impl(JNIEnv * env) override {
+  }
+};
+
+/**
+ * Echoes two events across a late java cycle.
+ * @param ringCapacity the input port is asynchronous if positive, otherwise
+ * it uses the lock-free hand-shake with the "merge" xrun policy.
+ */
+static void echoAcrossLateCycle(int ringCapacity) {
+  SimulatedBackend backend(64, chrono::microseconds(0));
+  EchoInputPort input(1, ringCapacity);
+  EchoOutputPort output(2, input);
+  if (ringCapacity == 0) {
+    input.setLockFree(true);
+    input.setXrunPolicy(XrunPolicy::merge);
+  }
+  output.setLockFree(true);
+  for (Port* port :{static_cast<Port*> (&input), static_cast<Port*> (&output)}) {
+    port->initialize(nullptr, nullptr, nullptr);
+    port->registerAtServer(&backend);
+    port->start();
+  }
+  auto nativeCycle = [&](unsigned long timeCodeStart, unsigned long timeCodeDuration) {
+    input.execNativeCycleInit(timeCodeStart, timeCodeDuration);
+    output.execNativeCycleInit(timeCodeStart, timeCodeDuration);
+    input.execNativeProcess(&backend);
+    output.execNativeProcess(&backend);
+  };
+  const uint8_t first[] = {0x90, 60, 100};
+  const uint8_t second[] = {0x80, 60, 0};
+  CPPUNIT_ASSERT(backend.inject("echo_in", 10, first, sizeof (first)));
+  CPPUNIT_ASSERT(backend.inject("echo_in", 70, second, sizeof (second)));
+
+  // cycles 0 and 64: the java thread is late.
+  backend.runCycle(nativeCycle);
+  backend.runCycle(nativeCycle);
+  CPPUNIT_ASSERT_EQUAL(1UL, input.getLateCycleCount());
+  // java processes cycle 0; the event of cycle 64 waits.
+  input.execJavaProcess(nullptr, false);
+  CPPUNIT_ASSERT_EQUAL(1, input.events().size());
+  CPPUNIT_ASSERT_EQUAL(10, input.events().getDeltaTime(0));
+  output.execJavaProcess(nullptr, false);
+
+  // cycle 128: the output of cycle 0 is written one cycle late.
+  backend.runCycle(nativeCycle);
+  // java processes cycle 128; the event of cycle 64 comes at its start.
+  input.execJavaProcess(nullptr, false);
+  CPPUNIT_ASSERT_EQUAL(1, input.events().size());
+  CPPUNIT_ASSERT_EQUAL(0, input.events().getDeltaTime(0));
+  output.execJavaProcess(nullptr, false);
+  backend.runCycle(nativeCycle);
+
+  CPPUNIT_ASSERT(input.isRunningState());
+  CPPUNIT_ASSERT(output.isRunningState());
+  CPPUNIT_ASSERT(!input.hasProcessException());
+  CPPUNIT_ASSERT(!output.hasProcessException());
+  vector<SimulatedBackend::TimedEvent> captured = backend.takeCaptured("echo_out");
+  CPPUNIT_ASSERT_EQUAL(2, (int) captured.size());
+  CPPUNIT_ASSERT_EQUAL(138UL, captured[0].time);
+  CPPUNIT_ASSERT(captured[0].midi == vector<uint8_t>(first, first + sizeof (first)));
+  CPPUNIT_ASSERT_EQUAL(192UL, captured[1].time);
+  CPPUNIT_ASSERT(captured[1].midi == vector<uint8_t>(second, second + sizeof (second)));
+
+  for (Port* port :{static_cast<Port*> (&input), static_cast<Port*> (&output)}) {
+    port->stop(true);
+    port->shutdown(nullptr, &backend, false);
+    CPPUNIT_ASSERT(port->isDeletableState());
+  }
+}
+
+/**
+ * Specification: when the java thread is late, an asynchronous input port
+ * delivers every event in the cycle java is processing (events of later
+ * cycles wait, events of earlier cycles come at the start of the cycle), so
+ * echoing them to an output port never fails.
+ */
+void simulatedBackendTest::testAsynchronousEcho() {
+  echoAcrossLateCycle(16);
+}
+
+/**
+ * Specification: with the "merge" xrun policy the events of the cycles java
+ * has missed come at the start of the next cycle, so echoing them to an
+ * output port never fails.
+ */
+void simulatedBackendTest::testMergeEcho() {
+  echoAcrossLateCycle(0);
+}
+
+/**
+ * Specification: with the "dropOldest" policy only the events that pass the
+ * processing chain of an input port take room in the arena; the oldest of
+ * them are dropped when they do not fit.
+ */
+void simulatedBackendTest::testDropOldestAfterProcessing() {
+  SimulatedBackend backend(64, chrono::microseconds(0));
+  EchoInputPort input(1, 0, 4, OverflowPolicy::dropOldest);
+  input.setLockFree(true);
+  // the chain drops all messages on the second channel.
+  int32_t description[17] = {ProcessorChain::channelMap};
+  for (int i = 0; i < 16; i++) {
+    description[1 + i] = (i == 1) ? -1 : i;
+  }
+  input.setProcessors(ProcessorChain::fromDescription(description, 17));
+  input.initialize(nullptr, nullptr, nullptr);
+  input.registerAtServer(&backend);
+  input.start();
+  auto nativeCycle = [&](unsigned long timeCodeStart, unsigned long timeCodeDuration) {
+    input.execNativeCycleInit(timeCodeStart, timeCodeDuration);
+    input.execNativeProcess(&backend);
+  };
+
+  // cycle 0: eight events, four of them pass the chain and fit.
+  for (int i = 0; i < 8; i++) {
+    const uint8_t noteOn[] = {static_cast<uint8_t> (0x90 | (i % 2)), static_cast<uint8_t> (i), 100};
+    CPPUNIT_ASSERT(backend.inject("echo_in", i, noteOn, sizeof (noteOn)));
+  }
+  backend.runCycle(nativeCycle);
+  input.execJavaProcess(nullptr, false);
+  CPPUNIT_ASSERT_EQUAL(4, input.events().size());
+  for (int i = 0; i < 4; i++) {
+    CPPUNIT_ASSERT_EQUAL(2 * i, input.events().getDeltaTime(i));
+  }
+  CPPUNIT_ASSERT_EQUAL(0UL, input.getOverflow().getDroppedCount());
+
+  // cycle 64: six events pass the chain, the two oldest of them are dropped.
+  for (int i = 0; i < 12; i++) {
+    const uint8_t noteOn[] = {static_cast<uint8_t> (0x90 | (i % 2)), static_cast<uint8_t> (i), 100};
+    CPPUNIT_ASSERT(backend.inject("echo_in", 64 + i, noteOn, sizeof (noteOn)));
+  }
+  backend.runCycle(nativeCycle);
+  input.execJavaProcess(nullptr, false);
+  CPPUNIT_ASSERT_EQUAL(4, input.events().size());
+  for (int i = 0; i < 4; i++) {
+    CPPUNIT_ASSERT_EQUAL(4 + 2 * i, input.events().getDeltaTime(i));
+  }
+  CPPUNIT_ASSERT_EQUAL(2UL, input.getOverflow().getDroppedCount());
+
+  CPPUNIT_ASSERT(!input.hasProcessException());
+  input.stop(true);
+  input.shutdown(nullptr, &backend, false);
+  CPPUNIT_ASSERT(input.isDeletableState());
+}
@@ -0,0 +1,48 @@
+/*
+ * File:   simulatedBackendTest.hpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 11:20:12 PM
+ */
+
+#ifndef SIMULATEDBACKENDTEST_HPP
+#define	SIMULATEDBACKENDTEST_HPP
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class simulatedBackendTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(simulatedBackendTest);
+
+  CPPUNIT_TEST(testRegisterPorts);
+  CPPUNIT_TEST(testInjectAndCapture);
+  CPPUNIT_TEST(testLateAndUnorderedEvents);
+  CPPUNIT_TEST(testBufferFull);
+  CPPUNIT_TEST(testWaitForTimeCode);
+  CPPUNIT_TEST(testPortChainThru);
+  CPPUNIT_TEST(testAsynchronousEcho);
+  CPPUNIT_TEST(testMergeEcho);
+  CPPUNIT_TEST(testDropOldestAfterProcessing);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  simulatedBackendTest();
+  virtual ~simulatedBackendTest();
+  void setUp();
+  void tearDown();
+
+private:
+  void testRegisterPorts();
+  void testInjectAndCapture();
+  void testLateAndUnorderedEvents();
+  void testBufferFull();
+  void testWaitForTimeCode();
+  void testPortChainThru();
+  void testAsynchronousEcho();
+  void testMergeEcho();
+  void testDropOldestAfterProcessing();
+
+};
+
+#endif	/* SIMULATEDBACKENDTEST_HPP */
+
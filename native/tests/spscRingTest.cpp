@@ -0,0 +1,172 @@
+/*
+ * File:   spscRingTest.cpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 11:02:12 AM
+ */
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include "spscRingTest.hpp"
+#include "../spscRing.hpp"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(spscRingTest);
+
+spscRingTest::spscRingTest() {
+}
+
+spscRingTest::~spscRingTest() {
+}
+
+void spscRingTest::setUp() {
+}
+
+void spscRingTest::tearDown() {
+}
+
+/**
+ * Items must come out in the order they went in.
+ */
+void spscRingTest::testPushPop() {
+  SpscRing<int> ring(4);
+  int item = -1;
+  CPPUNIT_ASSERT(ring.isEmpty());
+  CPPUNIT_ASSERT(!ring.pop(item));
+  CPPUNIT_ASSERT(ring.push(1));
+  CPPUNIT_ASSERT(ring.push(2));
+  CPPUNIT_ASSERT_EQUAL((size_t) 2, ring.size());
+  CPPUNIT_ASSERT(ring.pop(item));
+  CPPUNIT_ASSERT_EQUAL(1, item);
+  CPPUNIT_ASSERT(ring.pop(item));
+  CPPUNIT_ASSERT_EQUAL(2, item);
+  CPPUNIT_ASSERT(ring.isEmpty());
+}
+
+/**
+ * A full ring must reject new items and count them.
+ */
+void spscRingTest::testOverflow() {
+  SpscRing<int> ring(3);
+  for (int i = 0; i < 3; i++) {
+    CPPUNIT_ASSERT(ring.push(i));
+  }
+  CPPUNIT_ASSERT(!ring.push(3));
+  CPPUNIT_ASSERT(!ring.push(4));
+  CPPUNIT_ASSERT_EQUAL(2UL, ring.getOverflowCount());
+  CPPUNIT_ASSERT_EQUAL((size_t) 3, ring.size());
+
+  // the oldest items have survived
+  int item = -1;
+  CPPUNIT_ASSERT(ring.pop(item));
+  CPPUNIT_ASSERT_EQUAL(0, item);
+  CPPUNIT_ASSERT(ring.push(5));
+}
+
+/**
+ * The high-water mark must record the maximum fill level.
+ */
+void spscRingTest::testHighWaterMark() {
+  SpscRing<int> ring(8);
+  int item;
+  CPPUNIT_ASSERT_EQUAL((size_t) 0, ring.getHighWaterMark());
+  ring.push(1);
+  ring.push(2);
+  ring.push(3);
+  ring.pop(item);
+  ring.pop(item);
+  ring.push(4);
+  CPPUNIT_ASSERT_EQUAL((size_t) 3, ring.getHighWaterMark());
+  CPPUNIT_ASSERT_EQUAL((size_t) 8, ring.getCapacity());
+}
+
+/**
+ * The ring must keep working after the indices have wrapped around many times.
+ */
+void spscRingTest::testWrapAround() {
+  SpscRing<int> ring(3);
+  int item;
+  for (int i = 0; i < 1000; i++) {
+    CPPUNIT_ASSERT(ring.push(i));
+    CPPUNIT_ASSERT(ring.push(-i));
+    CPPUNIT_ASSERT(ring.pop(item));
+    CPPUNIT_ASSERT_EQUAL(i, item);
+    CPPUNIT_ASSERT(ring.pop(item));
+    CPPUNIT_ASSERT_EQUAL(-i, item);
+  }
+  CPPUNIT_ASSERT_EQUAL(0UL, ring.getOverflowCount());
+}
+
+/**
+ * One producer and one consumer thread run at full speed. Every item 
+ * must either arrive in order or be counted as overflow.
+ */
+void spscRingTest::testConcurrent() {
+  const long itemCount = 200000;
+  SpscRing<long> ring(64);
+  long accepted = 0;
+  atomic<bool> producerDone(false);
+
+  thread producer([&ring, &accepted, &producerDone, itemCount]() {
+    for (long i = 0; i < itemCount; i++) {
+      if (ring.push(i)) {
+        accepted++;
+      }
+    }
+    producerDone = true;
+  });
+
+  long received = 0;
+  long last = -1;
+  bool inOrder = true;
+  bool done = false;
+  while (!done) {
+    // read the flag before popping, so nothing pushed before the flag is missed
+    done = producerDone;
+    long item;
+    while (ring.pop(item)) {
+      inOrder = inOrder && (item > last);
+      last = item;
+      received++;
+    }
+    this_thread::yield();
+  }
+  producer.join();
+
+  CPPUNIT_ASSERT(inOrder);
+  CPPUNIT_ASSERT_EQUAL(accepted, received);
+  CPPUNIT_ASSERT_EQUAL((unsigned long) (itemCount - accepted), ring.getOverflowCount());
+  CPPUNIT_ASSERT(ring.getHighWaterMark() <= 64);
+}
+
+/**
+ * A ring without capacity is useless and must be refused.
+ */
+void spscRingTest::testZeroCapacity() {
+  CPPUNIT_ASSERT_THROW(SpscRing<int> ring(0), std::runtime_error);
+}
+
+
+/**
+ * A block goes in and comes out as a whole, also across the wrap-around;
+ * a block that does not fit is dropped completely.
+ */
+void spscRingTest::testBlocks() {
+  SpscRing<char> ring(8);
+  char out[8];
+  CPPUNIT_ASSERT(ring.pushAll("abcde", 5));
+  CPPUNIT_ASSERT(!ring.pushAll("fghi", 4));
+  CPPUNIT_ASSERT_EQUAL(1UL, ring.getOverflowCount());
+  CPPUNIT_ASSERT_EQUAL((size_t) 5, ring.size());
+  CPPUNIT_ASSERT(!ring.popAll(out, 6));
+  CPPUNIT_ASSERT(ring.popAll(out, 5));
+  CPPUNIT_ASSERT_EQUAL(string("abcde"), string(out, 5));
+
+  // this block wraps around the end of the item array
+  CPPUNIT_ASSERT(ring.pushAll("fghijklm", 8));
+  CPPUNIT_ASSERT(ring.isFull());
+  CPPUNIT_ASSERT(ring.popAll(out, 8));
+  CPPUNIT_ASSERT_EQUAL(string("fghijklm"), string(out, 8));
+  CPPUNIT_ASSERT(ring.isEmpty());
+  CPPUNIT_ASSERT_EQUAL((size_t) 8, ring.getHighWaterMark());
+}
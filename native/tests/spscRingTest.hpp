@@ -0,0 +1,44 @@
+/*
+ * File:   spscRingTest.hpp
+ * Author: Harald Postner
+ *
+ * Created on Oct 16, 2026, 11:02:10 AM
+ */
+
+#ifndef SPSCRINGTEST_HPP
+#define	SPSCRINGTEST_HPP
+
+#include <cppunit/extensions/HelperMacros.h>
+
+class spscRingTest : public CPPUNIT_NS::TestFixture {
+  CPPUNIT_TEST_SUITE(spscRingTest);
+
+  CPPUNIT_TEST(testPushPop);
+  CPPUNIT_TEST(testOverflow);
+  CPPUNIT_TEST(testHighWaterMark);
+  CPPUNIT_TEST(testWrapAround);
+  CPPUNIT_TEST(testConcurrent);
+  CPPUNIT_TEST(testZeroCapacity);
+  CPPUNIT_TEST(testBlocks);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  spscRingTest();
+  virtual ~spscRingTest();
+  void setUp();
+  void tearDown();
+
+private:
+  void testPushPop();
+  void testOverflow();
+  void testHighWaterMark();
+  void testWrapAround();
+  void testConcurrent();
+  void testZeroCapacity();
+  void testBlocks();
+
+};
+
+#endif	/* SPSCRINGTEST_HPP */
+
@@ -28,6 +28,7 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include "jniRegistry.hpp"
 
 using namespace std;
 
@@ -50,21 +51,16 @@ public:
    */
   static jthrowable makeProcessException(JNIEnv * env, const string& cppMessage,
           jthrowable cause) {
-    jclass cls = env->FindClass("MidiIO4Java/MidiProcessException");
-    if (cls == NULL) {
-      return NULL; //give up
-    }
-    jmethodID cid =
-            env->GetMethodID(cls, "<init>",
-            "(Ljava/lang/String;Ljava/lang/Throwable;)V");
-    if (cid == NULL) {
+    const JniRegistry& registry = jniRegistry();
+    if (!registry.loaded) {
       return NULL; //give up
     }
     jstring jmessage = env->NewStringUTF(cppMessage.c_str());
-    jthrowable exception = (jthrowable) env->NewObject(cls, cid,
+    jthrowable exception = (jthrowable) env->NewObject(registry.processExceptionClass,
+            registry.processExceptionInit,
             (jobject) jmessage,
             (jobject) cause);
-    env->DeleteLocalRef(cls);
+    env->DeleteLocalRef(jmessage);
     return exception;
   }
 
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package MidiIO4Java.Implementation;
+
+import MidiIO4Java.MidiSystemListener;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * Serves all ports of one process cycle from a single native call (batched
+ * dispatch, see MidiJackNative.setBatchedDispatch). The native side describes
+ * the cycle of every port in an entry of a direct byte buffer (see
+ * "native/cycleDescriptor.hpp") and then calls "dispatch" once; the dispatcher
+ * fans out to the listeners. So the number of JNI transitions per cycle does
+ * not depend on the number of ports.
+ * <p>
+ * An entry has 32 bytes (native byte order):
+ * <pre>
+ *  offset  0: the time-code at the start of the cycle (64 bit)
+ *  offset  8: the duration of the cycle (32 bit)
+ *  offset 12: the kind of the entry (32 bit)
+ *  offset 16: flags (32 bit)
+ *  offset 20: input ports: the number of events (32 bit)
+ *  offset 24: output ports: the events produced (high 32 bit) and stored
+ *             (low 32 bit), written by the dispatcher (64 bit)
+ * </pre>
+ * </p>
+ * All methods are called by the java process thread only.
+ *
+ * @author Harald Postner <Harald at free_creations.de>
+ */
+final class CycleDispatcher {
+
+  /**
+   * A port the dispatcher can serve.
+   */
+  interface Target {
+
+    /**
+     * Processes one cycle of the port.
+     *
+     * @param timeCodeStart the time-tick at the start of this cycle
+     * @param timeCodeDuration the number of time-ticks in this process-cycle
+     * @param lastCycle true when this is the last cycle before shutdown.
+     * @param eventCount input ports: the number of events in the buffer.
+     * @return output ports: the events produced (high 32 bits) and stored
+     * (low 32 bits); input ports: zero.
+     * @throws Throwable
+     */
+    long dispatch(long timeCodeStart, long timeCodeDuration, boolean lastCycle, int eventCount)
+            throws Throwable;
+  }
+  private static final int entrySize = 32;
+  private static final int timeCodeStartOffset = 0;
+  private static final int timeCodeDurationOffset = 8;
+  private static final int kindOffset = 12;
+  private static final int flagsOffset = 16;
+  private static final int eventCountOffset = 20;
+  private static final int resultOffset = 24;
+  // the kinds of entries, see CycleEntry::Kind
+  private static final int notDispatched = 0;
+  private static final int cycleStart = 1;
+  private static final int cycleEnd = 2;
+  // the flags, see CycleEntry::Flags
+  private static final int lastCycleFlag = 1;
+  private static final int failedFlag = 2;
+  private ByteBuffer descriptor = null;
+  private Object[] peers = new Object[0];
+  private Throwable[] failures = new Throwable[0];
+
+  // Signature: (Ljava/nio/ByteBuffer;)V
+  void setDescriptor(ByteBuffer descriptor) {
+    this.descriptor = descriptor.order(ByteOrder.nativeOrder());
+  }
+
+  /**
+   * Takes the java objects of the ports of the chain (called whenever ports
+   * have been added or removed).
+   *
+   * @param peers the listeners (for the control ports) and the ports, in the
+   * order of the entries; null for ports that are not dispatched.
+   */
+  // Signature: ([Ljava/lang/Object;)V
+  void setPorts(Object[] peers) {
+    this.peers = peers;
+    this.failures = new Throwable[peers.length];
+  }
+
+  /**
+   * Serves all entries of the cycle. An exception thrown by a listener only
+   * stops the port concerned; it is kept until the native side collects it
+   * through "getFailure".
+   *
+   * @param count the number of entries.
+   */
+  // Signature: (I)V
+  void dispatch(int count) {
+    for (int i = 0; i < count; i++) {
+      int entry = i * entrySize;
+      int kind = descriptor.getInt(entry + kindOffset);
+      if (kind == notDispatched) {
+        continue;
+      }
+      long timeCodeStart = descriptor.getLong(entry + timeCodeStartOffset);
+      long timeCodeDuration = descriptor.getInt(entry + timeCodeDurationOffset) & 0xFFFFFFFFL;
+      int flags = descriptor.getInt(entry + flagsOffset);
+      boolean lastCycle = (flags & lastCycleFlag) != 0;
+      try {
+        switch (kind) {
+          case cycleStart:
+            ((MidiSystemListener) peers[i]).onCycleStart(timeCodeStart, timeCodeDuration, lastCycle);
+            break;
+          case cycleEnd:
+            ((MidiSystemListener) peers[i]).onCycleEnd(timeCodeStart, timeCodeDuration, lastCycle);
+            break;
+          default:
+            long result = ((Target) peers[i]).dispatch(timeCodeStart, timeCodeDuration, lastCycle,
+                    descriptor.getInt(entry + eventCountOffset));
+            descriptor.putLong(entry + resultOffset, result);
+        }
+      } catch (Throwable th) {
+        failures[i] = th;
+        descriptor.putInt(entry + flagsOffset, flags | failedFlag);
+      }
+    }
+  }
+
+  /**
+   * Hands out (and forgets) the exception of a failed entry.
+   *
+   * @param index the index of the entry.
+   * @return the exception thrown by the listener.
+   */
+  // Signature: (I)Ljava/lang/Throwable;
+  Throwable getFailure(int index) {
+    Throwable failure = failures[index];
+    failures[index] = null;
+    return failure;
+  }
+}
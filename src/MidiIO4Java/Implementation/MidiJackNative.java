@@ -16,6 +16,10 @@
 package MidiIO4Java.Implementation;
 
 import MidiIO4Java.CreationException;
+import MidiIO4Java.DirectMidiInputPortListener;
+import MidiIO4Java.DirectMidiOutputPortListener;
+import MidiIO4Java.MidiEventBuffer;
+import MidiIO4Java.MidiGraph.Connection;
 import MidiIO4Java.MidiInputPortListener;
 import MidiIO4Java.MidiOutputPortListener;
 import MidiIO4Java.MidiPort;
@@ -25,11 +29,26 @@ import MidiIO4Java.MidiSystemListener;
 import MidiIO4Java.MidiSystemManager.Architecture;
 import MidiIO4Java.StateException;
 import MidiIO4Java.UnavailableException;
+import java.io.File;
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
 import java.util.concurrent.ExecutionException;
 import java.util.concurrent.Executors;
 import java.util.concurrent.ThreadFactory;
+import java.util.logging.Level;
+import java.util.logging.Logger;
+import javax.sound.midi.InvalidMidiDataException;
+import javax.sound.midi.MetaMessage;
 import javax.sound.midi.MidiEvent;
+import javax.sound.midi.MidiMessage;
+import javax.sound.midi.Sequence;
 import javax.sound.midi.ShortMessage;
+import javax.sound.midi.SysexMessage;
+import javax.sound.midi.Track;
 
 /**
  *
@@ -46,8 +65,60 @@ public class MidiJackNative implements MidiSystem {
   static final int errorConnectionFailed = -3;
   static final int errorClosingPort = -4;
   private static final Architecture thisArchitecture = Architecture.JACK;
+  /**
+   * The meta-event type of a track name (see renderOffline).
+   */
+  private static final int trackNameType = 0x03;
   private static final Object openCloseLock = new Object();
+  private static final Logger logger = Logger.getLogger(MidiJackNative.class.getName());
+  /**
+   * The java levels of the native log levels. The order must match
+   * "rtLog.hpp".
+   */
+  private static final Level[] nativeLogLevels = {Level.INFO, Level.WARNING, Level.SEVERE};
+  /**
+   * How often the native log is forwarded (in milliseconds).
+   */
+  private static final long logForwardingPeriod = 200;
+  /**
+   * Serializes the calls to _takeLogRecord (the native log has only one
+   * reader).
+   */
+  private static final Object logLock = new Object();
+  /**
+   * The daemon thread that forwards the native log (started with the first
+   * open).
+   */
+  private static Thread logForwarder = null;
   private ThreadFactory processThreadFactory = Executors.defaultThreadFactory();
+  /**
+   * Selects the batched dispatch for the next session (see
+   * setBatchedDispatch).
+   */
+  private boolean batchedDispatch = false;
+  /**
+   * The hand-shake selected for the next session (see setLockFreeHandshake).
+   */
+  private boolean lockFreeHandshake = false;
+  /**
+   * The xrun policy selected for the next session (see setXrunPolicy).
+   */
+  private XrunPolicy xrunPolicy = XrunPolicy.DELAY;
+  /**
+   * The debounce window of the graph notification for the next session (see
+   * setGraphDebounce).
+   */
+  private long graphDebounceMillis = 0;
+  /**
+   * The number of xruns whose cycle numbers are remembered (see
+   * "portchain.hpp").
+   */
+  private static final int recentXrunCapacity = 16;
+  /**
+   * The number of time-code units per second of the offline driver, zero
+   * unless the offline driver is selected (see setOfflineDriver).
+   */
+  private long offlineFrameRate = 0;
   /**
    * Every port will get its own internal identifier. This variable stores the
    * identifier to be used for the next new port and must be incremented each
@@ -59,9 +130,98 @@ public class MidiJackNative implements MidiSystem {
 
   private static native boolean _isOpen();
 
-  private static native int _createInputPort(long portID, InfoImpl emptyTemplate, String name, MidiInputPort port);
+  /**
+   * Takes the oldest record of the native log. See: "jackNative.cpp"
+   *
+   * @param level receives the ordinal of the native log level.
+   * @return the text of the record, null if the log is empty.
+   */
+  private static native String _takeLogRecord(int[] level);
+
+  /**
+   * Creates a native input port. See: "jackNative.cpp"
+   *
+   * @param ringCapacity if positive, the port runs asynchronously and buffers
+   * up to this number of events; if zero, the port runs synchronously.
+   * @param eventCapacity the number of events per cycle the port can take
+   * initially (zero for the default); the capacity grows when needed.
+   * @param overflowPolicy the ordinal of an OverflowPolicy.
+   */
+  private static native int _createInputPort(long portID, InfoImpl emptyTemplate, String name, AbstractInputPort port,
+          int ringCapacity, int eventCapacity, int overflowPolicy);
+
+  /**
+   * Retrieves the ring statistics of an input port. See: "jackNative.cpp"
+   *
+   * @param portId the internal identifier of the port.
+   * @param statistics receives the capacity, the high-water mark and the
+   * overflow count (all zero for a synchronous port).
+   */
+  private static native void _getRingStatistics(long portId, long[] statistics);
+
+  /**
+   * Retrieves the overflow statistics of a port. See: "jackNative.cpp"
+   *
+   * @param portId the internal identifier of the port.
+   * @param statistics receives the event capacity, the high-water mark of
+   * the events per cycle, the dropped events, the spilled events and the
+   * number of times the capacity has grown.
+   */
+  private static native void _getOverflowStatistics(long portId, long[] statistics);
+
+  /**
+   * Retrieves the timing statistics of the cycles of a port. See:
+   * "jackNative.cpp"
+   *
+   * @param portId the internal identifier of the port.
+   * @param statistics receives, for every TimingPhase, the count, the mean,
+   * the minimum, the median, the 99th percentile and the maximum.
+   * @param reset if true, the statistics are cleared after being read.
+   */
+  private static native void _getCycleTiming(long portId, long[] statistics, boolean reset);
+
+  /**
+   * Replaces the native processing chain of a port. See: "jackNative.cpp"
+   *
+   * @param description the stages (see NativeProcessor.describe).
+   */
+  private static native void _setProcessors(long portId, int[] description);
+
+  /**
+   * Lets a port skip the cycles in which it has no connection. See:
+   * "jackNative.cpp"
+   */
+  private static native void _setSkipWhenIdle(long portId, boolean value);
+
+  /**
+   * @return the number of cycles a port has skipped as idle. See:
+   * "jackNative.cpp"
+   */
+  private static native long _getIdleCycleCount(long portId);
+
+  /**
+   * Sets a native thru-route. See: "jackNative.cpp"
+   *
+   * @param description the processing of the routed events (see
+   * NativeProcessor.describe).
+   */
+  private static native void _setRoute(long inputPortId, long outputPortId, int[] description);
+
+  /**
+   * Removes a native thru-route. See: "jackNative.cpp"
+   *
+   * @return false if there was no such route.
+   */
+  private static native boolean _removeRoute(long inputPortId, long outputPortId);
 
-  private static native int _createOutputPort(long portID, InfoImpl emptyTemplate, String name, MidiOutputPort port);
+  /**
+   * Creates a native output port. See: "jackNative.cpp"
+   *
+   * @param eventCapacity the number of events per cycle the port can take
+   * initially (zero for the default); the capacity grows when needed.
+   */
+  private static native int _createOutputPort(long portID, InfoImpl emptyTemplate, String name, AbstractOutputPort port,
+          int eventCapacity);
 
   private static native Info _getMidiInputPortInfo(int index, InfoImpl emptyTemplate);
 
@@ -71,10 +231,86 @@ public class MidiJackNative implements MidiSystem {
 
   private static native int _getMidiOutputPortCount();
 
-  private static native int _open(String clientName, MidiSystemListener listener);
+  /**
+   * Lists the Midi ports of the Jack server in one call. See: "jackNative.cpp"
+   *
+   * @param input true for the ports an input port can connect to.
+   * @return the names of the ports.
+   */
+  private static native String[] _getMidiPortNames(boolean input);
+
+  /**
+   * Connects or disconnects pairs of ports in one call. See: "jackNative.cpp"
+   *
+   * @param pairs the port names: source, destination, source, destination...
+   * @param connect true to connect, false to disconnect.
+   * @return the result of each pair, zero on success.
+   */
+  private static native int[] _connectAll(String[] pairs, boolean connect);
+
+  /**
+   * Connects to the Jack server. See: "jackNative.cpp"
+   *
+   * @param dispatcher selects the batched dispatch, null to call every port
+   * through its own native call.
+   */
+  private static native int _open(String clientName, MidiSystemListener listener, CycleDispatcher dispatcher);
 
   private static native void _run();
 
+  /**
+   * Selects the lock-free hand-shake between the native and the java process
+   * thread for the next session. See: "jackNative.cpp"
+   *
+   * @param value true to select the lock-free hand-shake.
+   */
+  private static native void _setLockFreeHandshake(boolean value);
+
+  /**
+   * Selects what the ports do when the Java process thread is late, for the
+   * next session. See: "jackNative.cpp"
+   *
+   * @param policy the ordinal of an XrunPolicy.
+   */
+  private static native void _setXrunPolicy(int policy);
+
+  /**
+   * Selects the debounce window of the connection notifications for the next
+   * session. See: "jackNative.cpp"
+   *
+   * @param micros the window in microseconds, zero for no debouncing.
+   */
+  private static native void _setGraphDebounce(long micros);
+
+  /**
+   * Retrieves the xrun statistics of the current session. See:
+   * "jackNative.cpp"
+   *
+   * @param statistics receives the number of cycles, the number of xruns and
+   * the cycle numbers of the latest xruns (-1 for unused elements).
+   */
+  private static native void _getXrunStatistics(long[] statistics);
+
+  /**
+   * Selects the simulated driver for the next session. See: "jackNative.cpp"
+   *
+   * @param bufferSize the number of frames per cycle, zero to connect to the
+   * Jack server.
+   * @param periodMicros the time between two cycles in microseconds, zero to
+   * run the cycles back-to-back.
+   */
+  private static native void _setSimulatedDriver(int bufferSize, long periodMicros);
+
+  private static native boolean _injectSimulatedEvent(String portName, long timeCode, byte[] midi);
+
+  private static native byte[] _takeSimulatedOutput(String portName);
+
+  private static native void _getSimulatedStatistics(long[] statistics);
+
+  private static native String[] _getSimulatedPortNames(boolean input);
+
+  private static native boolean _waitForSimulatedTimeCode(long timeCode, long timeoutMillis);
+
   /**
    * Indicates whether the portchain is processing native callbacks. If the
    * portchain is about to start, the calling thread will be blocked until the
@@ -139,6 +375,84 @@ public class MidiJackNative implements MidiSystem {
     return _getMidiOutputPortCount();
   }
 
+  /**
+   * Lists all ports an input port can connect to, in the order of their
+   * index (see getMidiInputPortInfo). Other than counting the ports and
+   * asking for each index, this takes a consistent snapshot with a single
+   * native call.
+   *
+   * @return the infos of the ports.
+   */
+  public Info[] getMidiInputPortInfos() {
+    assumeOpen();
+    return toInfos(_getMidiPortNames(true), true, "MIDI_In");
+  }
+
+  /**
+   * Lists all ports an output port can connect to (see
+   * getMidiInputPortInfos).
+   *
+   * @return the infos of the ports.
+   */
+  public Info[] getMidiOutputPortInfos() {
+    assumeOpen();
+    return toInfos(_getMidiPortNames(false), false, "MIDI_Out");
+  }
+
+  /**
+   * The result of connectAll for a pair that was already connected
+   * (EEXIST).
+   */
+  public static final int alreadyConnected = 17;
+
+  /**
+   * Connects a whole patch with a single native call. A MidiSystemListener
+   * hears of the patch as one change (see setGraphDebounce), not as one
+   * change per connection.
+   *
+   * @param connections the connections to make; the ports are named as the
+   * server names them ("client:port").
+   * @return for each connection zero if it has been made,
+   * {@link #alreadyConnected} if it existed already, otherwise the error code
+   * of the Jack server.
+   * @throws StateException if the system is not open.
+   */
+  public int[] connectAll(Connection... connections) throws StateException {
+    return wireAll(connections, true);
+  }
+
+  /**
+   * Removes a whole patch with a single native call (see connectAll).
+   *
+   * @param connections the connections to remove.
+   * @return for each connection zero if it has been removed, otherwise the
+   * error code of the Jack server.
+   * @throws StateException if the system is not open.
+   */
+  public int[] disconnectAll(Connection... connections) throws StateException {
+    return wireAll(connections, false);
+  }
+
+  private int[] wireAll(Connection[] connections, boolean connect) throws StateException {
+    String[] pairs = new String[2 * connections.length];
+    for (int i = 0; i < connections.length; i++) {
+      pairs[2 * i] = connections[i].getSource();
+      pairs[2 * i + 1] = connections[i].getDestination();
+    }
+    synchronized (openCloseLock) {
+      assumeOpen();
+      return _connectAll(pairs, connect);
+    }
+  }
+
+  private static Info[] toInfos(String[] names, boolean input, String description) {
+    Info[] infos = new Info[names.length];
+    for (int i = 0; i < names.length; i++) {
+      infos[i] = new InfoImpl(names[i], input, "Jack Audio", description, "0.0", i, thisArchitecture);
+    }
+    return infos;
+  }
+
   /**
    * Currently this function returns true if the native library has been
    * compiled with Jack support.
@@ -154,6 +468,42 @@ public class MidiJackNative implements MidiSystem {
     }
   }
 
+  /**
+   * Forwards the records that the native library has logged (possibly from
+   * within the Jack process thread) to java.util.logging.
+   */
+  private static void forwardNativeLog() {
+    synchronized (logLock) {
+      int[] level = new int[1];
+      String message = _takeLogRecord(level);
+      while (message != null) {
+        logger.log(nativeLogLevels[level[0]], message);
+        message = _takeLogRecord(level);
+      }
+    }
+  }
+
+  private static void startLogForwarder() {
+    if (logForwarder != null) {
+      return;
+    }
+    logForwarder = new Thread(new Runnable() {
+      @Override
+      public void run() {
+        try {
+          while (true) {
+            Thread.sleep(logForwardingPeriod);
+            forwardNativeLog();
+          }
+        } catch (InterruptedException ex) {
+          // the thread ends.
+        }
+      }
+    }, "MidiIO4Java native log");
+    logForwarder.setDaemon(true);
+    logForwarder.start();
+  }
+
   private void assumeOpen() {
     assumeAvailable();
     if (!isOpen()) {
@@ -187,104 +537,763 @@ public class MidiJackNative implements MidiSystem {
     if (listener == null) {
       throw new IllegalArgumentException("listner shall not be null.");
     }
-    if (name == null) {
-      throw new IllegalArgumentException("name shall not be null.");
-    }
     synchronized (openCloseLock) {
-      assumeAvailable();
+      long thisPortID = newPortID;
       InfoImpl template = new InfoImpl(thisArchitecture);
+      return registerOutputPort(new DirectMidiOutputPort(thisPortID, new MidiEventOutputAdapter(listener),
+              template, name), 0);
+    }
+  }
+
+  /**
+   * Creates a new output-port (see createOutputPort) with a given initial
+   * capacity. Events that the listener produces beyond the capacity are
+   * dropped and counted; the capacity grows for the following cycles.
+   *
+   * @param name non-empty short name for the new port.
+   * @param listener the listener will receive call-backs when the system is
+   * ready to accept the next buffer of Midi Data.
+   * @param eventCapacity the number of events per cycle the port can take
+   * initially.
+   * @return the newly created port.
+   * @throws CreationException if the creation fails.
+   */
+  public MonitoredMidiPort createOutputPort(String name, MidiOutputPortListener listener, int eventCapacity)
+          throws CreationException {
+    if (listener == null) {
+      throw new IllegalArgumentException("listner shall not be null.");
+    }
+    if (eventCapacity <= 0) {
+      throw new IllegalArgumentException("eventCapacity must be positive.");
+    }
+    synchronized (openCloseLock) {
       long thisPortID = newPortID;
-      newPortID++;
-      MidiOutputPort port = new MidiOutputPort(thisPortID, listener, template, name);
-      int err = _createOutputPort(thisPortID, template, name, port);
-      if (err < 0) {
-        throw new RuntimeException("Error(" + err + ") while creating an OutputPort.");
-      }
-      return port;
+      InfoImpl template = new InfoImpl(thisArchitecture);
+      return registerOutputPort(new DirectMidiOutputPort(thisPortID, new MidiEventOutputAdapter(listener),
+              template, name), eventCapacity);
     }
   }
 
   /**
-   * Creates a new input-port for this client. An input-port is an object used
-   * for moving Midi-data from other applications into client.
+   * Creates a new output-port whose listener writes the events directly into
+   * a buffer shared with the native code. No objects are created per event
+   * and only the bytes actually produced are copied into the Jack buffer.
    *
    * @param name non-empty short name for the new port (not including the
    * leading "client_name:"). Must be unique among all ports owned by this
    * client.
-   * @param listener the listener will receive call-backs when the system has
-   * new Midi Data.
+   * @param listener the listener will receive call-backs when the system is
+   * ready to accept the next buffer of Midi Data.
    * @return the newly created port.
    * @throws CreationException if the creation fails.
    */
-  @Override
-  public MidiPort createInputPort(String name, MidiInputPortListener listener)
+  public MidiPort createDirectOutputPort(String name, DirectMidiOutputPortListener listener)
+          throws CreationException {
+    return createDirectOutputPort(name, listener, 0);
+  }
+
+  /**
+   * Creates a new direct output-port (see createDirectOutputPort) with a
+   * given initial capacity (zero for the default). Events that do not fit are
+   * refused by MidiEventBuffer.add and counted; the capacity grows for the
+   * following cycles.
+   *
+   * @param name non-empty short name for the new port.
+   * @param listener the listener will receive call-backs when the system is
+   * ready to accept the next buffer of Midi Data.
+   * @param eventCapacity the number of events per cycle the port can take
+   * initially.
+   * @return the newly created port.
+   * @throws CreationException if the creation fails.
+   */
+  public MonitoredMidiPort createDirectOutputPort(String name, DirectMidiOutputPortListener listener, int eventCapacity)
           throws CreationException {
     if (listener == null) {
       throw new IllegalArgumentException("listner shall not be null.");
     }
-    if (name == null) {
-      throw new IllegalArgumentException("name shall not be null.");
+    if (eventCapacity < 0) {
+      throw new IllegalArgumentException("eventCapacity must not be negative.");
     }
     synchronized (openCloseLock) {
-      assumeAvailable();
-      InfoImpl template = new InfoImpl(thisArchitecture);
       long thisPortID = newPortID;
-      newPortID++;
-      MidiInputPort port = new MidiInputPort(thisPortID, listener, template, name);
-      int err = _createInputPort(thisPortID, template, name, port);
-      if (err < 0) {
-        throw new RuntimeException("Error(" + err + ") while creating an InputPort.");
-      }
-      return port;
+      InfoImpl template = new InfoImpl(thisArchitecture);
+      return registerOutputPort(new DirectMidiOutputPort(thisPortID, listener, template, name), eventCapacity);
     }
   }
 
-  @Override
-  public void close() throws ExecutionException {
+  private MonitoredMidiPort registerOutputPort(AbstractOutputPort port, int eventCapacity)
+          throws CreationException {
+    if (port.name == null) {
+      throw new IllegalArgumentException("name shall not be null.");
+    }
     synchronized (openCloseLock) {
-      isRunnable = false;
       assumeAvailable();
-      int error = noError;
-      try {
-        error = _close();
-      } catch (Throwable th) {
-        throw new ExecutionException("Error in process thread", th);
-      }
-      switch (error) {
-        case noError:
-          return;
-        case errorNotOpen:
-          throw new StateException("Attempt to close the Jack-Audio Server twice, but was not open.");
-        default:
-          throw new RuntimeException("Error(" + error + ") while disconnecting from the Jack-Audio Server.");
+      newPortID++;
+      int err = _createOutputPort(port.portId, port.info, port.name, port, eventCapacity);
+      if (err < 0) {
+        throw new RuntimeException("Error(" + err + ") while creating an OutputPort.");
       }
+      return port;
     }
   }
 
+  /**
+   * Creates a new input-port for this client. An input-port is an object used
+   * for moving Midi-data from other applications into client.
+   *
+   * @param name non-empty short name for the new port (not including the
+   * leading "client_name:"). Must be unique among all ports owned by this
+   * client.
+   * @param listener the listener will receive call-backs when the system has
+   * new Midi Data.
+   * @return the newly created port.
+   * @throws CreationException if the creation fails.
+   */
   @Override
-  public void open(String clientName, MidiSystemListener listener, ThreadFactory processThreadFactory) throws StateException, UnavailableException {
-    if (clientName == null) {
-      throw new IllegalArgumentException("clientName may not be null.");
-    }
-    if (processThreadFactory == null) {
-      throw new NullPointerException();
-    }
-    synchronized (openCloseLock) {
-      assumeAvailable();
-      this.processThreadFactory = processThreadFactory;
-      int error = _open(clientName, listener);
-      switch (error) {
-        case noError:
-          isRunnable = true;
-          return;
-        case errorAlreadyOpen:
-          throw new StateException("Attempt to open the Jack-Audio Server twice.");
-        case errorConnectionFailed:
-          throw new RuntimeException("Could not connect to the Jack-Audio Server.");
-        default:
-          throw new RuntimeException("Could not open the Jack-Audio Server (" + error + ")");
-      }
-    }
+  public MidiPort createInputPort(String name, MidiInputPortListener listener)
+          throws CreationException {
+    return createInputPort(name, listener, 0, 0, OverflowPolicy.DROP_NEWEST);
+  }
+
+  /**
+   * Creates a new input-port (see createInputPort) with a given initial
+   * capacity and overflow policy. When more events arrive in one cycle than
+   * the port can take, the policy decides which events are lost (or
+   * delayed); the capacity then grows for the following cycles.
+   *
+   * @param name non-empty short name for the new port.
+   * @param listener the listener will receive call-backs when the system has
+   * new Midi Data.
+   * @param eventCapacity the number of events per cycle the port can take
+   * initially.
+   * @param policy what to do with the events that do not fit.
+   * @return the newly created port.
+   * @throws CreationException if the creation fails.
+   */
+  public MonitoredMidiPort createInputPort(String name, MidiInputPortListener listener,
+          int eventCapacity, OverflowPolicy policy)
+          throws CreationException {
+    if (eventCapacity <= 0) {
+      throw new IllegalArgumentException("eventCapacity must be positive.");
+    }
+    return createInputPort(name, listener, 0, eventCapacity, policy);
+  }
+
+  /**
+   * Creates a new asynchronous input-port for this client. The Jack process
+   * thread stores incoming events in a ring buffer and never waits for the
+   * listener; the listener receives the buffered events in its next call-back.
+   * An event that is delivered in a later cycle than the one it was received
+   * in is time-stamped at the start of that cycle (delta-time 0), so the
+   * delta-times always lie within the cycle.
+   * Events that do not fit into the ring are dropped and counted.
+   *
+   * @param name non-empty short name for the new port (not including the
+   * leading "client_name:"). Must be unique among all ports owned by this
+   * client.
+   * @param listener the listener will receive call-backs when the system has
+   * new Midi Data.
+   * @param ringCapacity the maximum number of events that can be buffered.
+   * @return the newly created port.
+   * @throws CreationException if the creation fails.
+   */
+  public AsyncMidiPort createAsyncInputPort(String name, MidiInputPortListener listener, int ringCapacity)
+          throws CreationException {
+    if (ringCapacity <= 0) {
+      throw new IllegalArgumentException("ringCapacity must be positive.");
+    }
+    return createInputPort(name, listener, ringCapacity, 0, OverflowPolicy.DROP_NEWEST);
+  }
+
+  /**
+   * Creates a new input-port whose listener reads the events directly from
+   * a buffer shared with the native code. No objects are created per event;
+   * the MidiEventBuffer is only valid during the call-back.
+   *
+   * @param name non-empty short name for the new port (not including the
+   * leading "client_name:"). Must be unique among all ports owned by this
+   * client.
+   * @param listener the listener will receive call-backs when the system has
+   * new Midi Data.
+   * @return the newly created port.
+   * @throws CreationException if the creation fails.
+   */
+  public MidiPort createDirectInputPort(String name, DirectMidiInputPortListener listener)
+          throws CreationException {
+    return createDirectInputPort(name, listener, 0);
+  }
+
+  /**
+   * Creates a new input-port that passes its events through a direct buffer
+   * (see createDirectInputPort) and, if ringCapacity is positive, runs
+   * asynchronously (see createAsyncInputPort).
+   *
+   * @param name non-empty short name for the new port.
+   * @param listener the listener will receive call-backs when the system has
+   * new Midi Data.
+   * @param ringCapacity the maximum number of events that can be buffered,
+   * zero for a synchronous port.
+   * @return the newly created port.
+   * @throws CreationException if the creation fails.
+   */
+  public AsyncMidiPort createDirectInputPort(String name, DirectMidiInputPortListener listener, int ringCapacity)
+          throws CreationException {
+    return createDirectInputPort(name, listener, ringCapacity, 0, OverflowPolicy.DROP_NEWEST);
+  }
+
+  /**
+   * Creates a new direct input-port (see createDirectInputPort) with a given
+   * initial capacity and overflow policy (see createInputPort).
+   *
+   * @param name non-empty short name for the new port.
+   * @param listener the listener will receive call-backs when the system has
+   * new Midi Data.
+   * @param ringCapacity the maximum number of events that can be buffered,
+   * zero for a synchronous port.
+   * @param eventCapacity the number of events per cycle the port can take
+   * initially, zero for the default.
+   * @param policy what to do with the events that do not fit (only used by a
+   * synchronous port; an asynchronous port drops the events that do not fit
+   * into its ring).
+   * @return the newly created port.
+   * @throws CreationException if the creation fails.
+   */
+  public AsyncMidiPort createDirectInputPort(String name, DirectMidiInputPortListener listener,
+          int ringCapacity, int eventCapacity, OverflowPolicy policy)
+          throws CreationException {
+    if (listener == null) {
+      throw new IllegalArgumentException("listner shall not be null.");
+    }
+    if ((ringCapacity < 0) || (eventCapacity < 0)) {
+      throw new IllegalArgumentException("capacities must not be negative.");
+    }
+    synchronized (openCloseLock) {
+      long thisPortID = newPortID;
+      InfoImpl template = new InfoImpl(thisArchitecture);
+      return registerInputPort(new DirectMidiInputPort(thisPortID, listener, template, name),
+              ringCapacity, eventCapacity, policy);
+    }
+  }
+
+  private DirectMidiInputPort createInputPort(String name, MidiInputPortListener listener,
+          int ringCapacity, int eventCapacity, OverflowPolicy policy)
+          throws CreationException {
+    if (listener == null) {
+      throw new IllegalArgumentException("listner shall not be null.");
+    }
+    synchronized (openCloseLock) {
+      long thisPortID = newPortID;
+      InfoImpl template = new InfoImpl(thisArchitecture);
+      return registerInputPort(new DirectMidiInputPort(thisPortID, new MidiEventInputAdapter(listener),
+              template, name), ringCapacity, eventCapacity, policy);
+    }
+  }
+
+  private <T extends AbstractInputPort> T registerInputPort(T port, int ringCapacity,
+          int eventCapacity, OverflowPolicy policy)
+          throws CreationException {
+    if (port.name == null) {
+      throw new IllegalArgumentException("name shall not be null.");
+    }
+    if (policy == null) {
+      throw new IllegalArgumentException("policy shall not be null.");
+    }
+    synchronized (openCloseLock) {
+      assumeAvailable();
+      newPortID++;
+      int err = _createInputPort(port.portId, port.info, port.name, port, ringCapacity,
+              eventCapacity, policy.ordinal());
+      if (err < 0) {
+        throw new RuntimeException("Error(" + err + ") while creating an InputPort.");
+      }
+      return port;
+    }
+  }
+
+  @Override
+  public void close() throws ExecutionException {
+    synchronized (openCloseLock) {
+      isRunnable = false;
+      assumeAvailable();
+      int error = noError;
+      try {
+        error = _close();
+      } catch (Throwable th) {
+        throw new ExecutionException("Error in process thread", th);
+      } finally {
+        forwardNativeLog();
+      }
+      switch (error) {
+        case noError:
+          return;
+        case errorNotOpen:
+          throw new StateException("Attempt to close the Jack-Audio Server twice, but was not open.");
+        default:
+          throw new RuntimeException("Error(" + error + ") while disconnecting from the Jack-Audio Server.");
+      }
+    }
+  }
+
+  /**
+   * Selects the lock-free hand-shake between the Jack process thread and the
+   * Java process thread. In lock-free mode the Jack process thread never
+   * waits for the Java process thread; output that the Java process thread
+   * could not deliver in time is written in a later cycle instead of
+   * stopping the system.
+   *
+   * @param value true to select the lock-free hand-shake.
+   * @throws StateException if the system is already open.
+   */
+  public void setLockFreeHandshake(boolean value) throws StateException {
+    synchronized (openCloseLock) {
+      assumeAvailable();
+      if (isOpen()) {
+        throw new StateException("Cannot change the hand-shake while Jack Audio is open.");
+      }
+      _setLockFreeHandshake(value);
+      lockFreeHandshake = value;
+    }
+  }
+
+  /**
+   * Selects what happens when the Java process thread is late, that is when
+   * a new cycle starts before the Java process thread has finished the
+   * previous one (for example during a garbage collection). Whatever the
+   * policy, the ports are back in step as soon as the Java process thread has
+   * caught up. The policies other than DELAY imply the lock-free hand-shake
+   * (see setLockFreeHandshake).
+   *
+   * @param policy the policy for the next session.
+   * @throws StateException if the system is already open.
+   */
+  public void setXrunPolicy(XrunPolicy policy) throws StateException {
+    if (policy == null) {
+      throw new NullPointerException();
+    }
+    synchronized (openCloseLock) {
+      assumeAvailable();
+      if (isOpen()) {
+        throw new StateException("Cannot change the xrun policy while Jack Audio is open.");
+      }
+      _setXrunPolicy(policy.ordinal());
+      xrunPolicy = policy;
+    }
+  }
+
+  /**
+   * Selects the debounced graph notification for the next session. The
+   * connection changes and port registrations of the given window (counted
+   * from the first change) are collected and reported with one call: a
+   * MidiGraphListener receives "onGraphChanged" with a snapshot of the MIDI
+   * connection graph and the delta to the previous snapshot, any other
+   * listener receives one "onConnectionChanged".
+   *
+   * @param millis the window in milliseconds, zero (the default) to report
+   * the connection changes as soon as possible.
+   * @throws StateException if the system is already open.
+   */
+  public void setGraphDebounce(long millis) throws StateException {
+    if (millis < 0) {
+      throw new IllegalArgumentException("Negative debounce window.");
+    }
+    synchronized (openCloseLock) {
+      assumeAvailable();
+      if (isOpen()) {
+        throw new StateException("Cannot change the graph notification while Jack Audio is open.");
+      }
+      _setGraphDebounce(millis * 1000);
+      graphDebounceMillis = millis;
+    }
+  }
+
+  /**
+   * @return the debounce window (in milliseconds) selected for the next
+   * session (see setGraphDebounce).
+   */
+  public long getGraphDebounce() {
+    synchronized (openCloseLock) {
+      return graphDebounceMillis;
+    }
+  }
+
+  /**
+   * @return the number of cycles of the current session.
+   * @throws StateException if the system is not open.
+   */
+  public long getCycleCount() throws StateException {
+    return getXrunStatistics()[0];
+  }
+
+  /**
+   * Xruns only occur with the lock-free hand-shake (see setLockFreeHandshake),
+   * with the blocking hand-shake the Jack process thread waits for the Java
+   * process thread.
+   *
+   * @return the number of cycles of the current session that started before
+   * the Java process thread had finished the previous cycle.
+   * @throws StateException if the system is not open.
+   */
+  public long getXrunCount() throws StateException {
+    return getXrunStatistics()[1];
+  }
+
+  /**
+   * @return the cycle numbers (counted from zero) of the latest xruns, the
+   * oldest first (at most 16).
+   * @throws StateException if the system is not open.
+   */
+  public long[] getRecentXrunCycles() throws StateException {
+    long[] statistics = getXrunStatistics();
+    int count = (int) Math.min(statistics[1], recentXrunCapacity);
+    return Arrays.copyOfRange(statistics, 2, 2 + count);
+  }
+
+  private long[] getXrunStatistics() throws StateException {
+    long[] statistics = new long[2 + recentXrunCapacity];
+    synchronized (openCloseLock) {
+      assumeOpen();
+      _getXrunStatistics(statistics);
+    }
+    return statistics;
+  }
+
+  /**
+   * Routes the events of an input port to an output port inside the Jack
+   * process thread, without a detour through Java (a "thru" connection). The
+   * routed events are merged, in time order, with the events that Java writes
+   * to the output port in the same cycle. Routes can be set and removed at
+   * any time while the system is open; setting an existing route again
+   * replaces its processing. A route ends when one of its ports is closed.
+   *
+   * @param input an input port created by this system.
+   * @param output an output port created by this system.
+   * @param processors the processing of the routed events (none to route
+   * them unchanged); the processing of the input port does not apply.
+   * @throws StateException if the system is not open.
+   */
+  public void setRoute(MidiPort input, MidiPort output, NativeProcessor... processors) throws StateException {
+    long inputPortId = inputPortIdOf(input);
+    long outputPortId = outputPortIdOf(output);
+    int[] description = NativeProcessor.describe(processors);
+    synchronized (openCloseLock) {
+      assumeOpen();
+      _setRoute(inputPortId, outputPortId, description);
+    }
+  }
+
+  /**
+   * Removes a route set by setRoute.
+   *
+   * @param input the input port of the route.
+   * @param output the output port of the route.
+   * @return false if there was no such route.
+   * @throws StateException if the system is not open.
+   */
+  public boolean removeRoute(MidiPort input, MidiPort output) throws StateException {
+    long inputPortId = inputPortIdOf(input);
+    long outputPortId = outputPortIdOf(output);
+    synchronized (openCloseLock) {
+      assumeOpen();
+      return _removeRoute(inputPortId, outputPortId);
+    }
+  }
+
+  private static long inputPortIdOf(MidiPort port) {
+    if (!(port instanceof AbstractInputPort)) {
+      throw new IllegalArgumentException("Not an input port of this system.");
+    }
+    return ((AbstractInputPort) port).portId;
+  }
+
+  private static long outputPortIdOf(MidiPort port) {
+    if (!(port instanceof AbstractOutputPort)) {
+      throw new IllegalArgumentException("Not an output port of this system.");
+    }
+    return ((AbstractOutputPort) port).portId;
+  }
+
+  /**
+   * Selects the batched dispatch. Normally the Jack process thread calls the
+   * Java process thread once per port and cycle; in batched mode it makes a
+   * single call per cycle, and the calls to the listeners are made on the
+   * Java side. This saves the cost of many native calls when there are many
+   * ports. All ports and the system listener are dispatched in a batch. The
+   * batched dispatch implies the lock-free hand-shake (see
+   * setLockFreeHandshake).
+   *
+   * @param value true to select the batched dispatch.
+   * @throws StateException if the system is already open.
+   */
+  public void setBatchedDispatch(boolean value) throws StateException {
+    synchronized (openCloseLock) {
+      assumeAvailable();
+      if (isOpen()) {
+        throw new StateException("Cannot change the dispatch mode while Jack Audio is open.");
+      }
+      batchedDispatch = value;
+    }
+  }
+
+  /**
+   * Selects the simulated driver. Instead of connecting to the Jack server,
+   * the next session runs the process cycles from a thread of its own, at the
+   * given period and with the given number of time-ticks per cycle. Nothing
+   * reaches the outside world: events for the input ports are injected
+   * through injectSimulatedEvent, the events written to the output ports are
+   * retrieved through takeSimulatedOutput. The simulated driver has no
+   * connection graph, so no foreign ports are listed and onConnectionChanged
+   * is never called.
+   *
+   * @param bufferSize the number of time-ticks per cycle, zero to connect to
+   * the Jack server again.
+   * @param periodMicros the time between the start of two cycles in
+   * microseconds, zero to run the cycles back-to-back (for throughput
+   * measurements).
+   * @throws StateException if the system is already open.
+   */
+  public void setSimulatedDriver(int bufferSize, long periodMicros) throws StateException {
+    if ((bufferSize < 0) || (periodMicros < 0)) {
+      throw new IllegalArgumentException("bufferSize and periodMicros may not be negative.");
+    }
+    synchronized (openCloseLock) {
+      assumeAvailable();
+      if (isOpen()) {
+        throw new StateException("Cannot change the driver while Jack Audio is open.");
+      }
+      _setSimulatedDriver(bufferSize, periodMicros);
+      offlineFrameRate = 0;
+    }
+  }
+
+  /**
+   * Selects the offline driver: a simulated driver (see setSimulatedDriver)
+   * that runs the process cycles back-to-back, as fast as the Java process
+   * thread keeps up, in order to replay a recorded session through
+   * renderOffline. The offline driver needs the blocking hand-shake (no
+   * lock-free hand-shake, no batched dispatch), so that no cycle is skipped.
+   *
+   * @param bufferSize the number of time-ticks per cycle.
+   * @param frameRate the number of time-ticks per second (the sample rate of
+   * the replayed session).
+   * @throws StateException if the system is already open.
+   */
+  public void setOfflineDriver(int bufferSize, long frameRate) throws StateException {
+    if ((bufferSize <= 0) || (frameRate <= 0)) {
+      throw new IllegalArgumentException("bufferSize and frameRate must be positive.");
+    }
+    synchronized (openCloseLock) {
+      assumeAvailable();
+      if (isOpen()) {
+        throw new StateException("Cannot change the driver while Jack Audio is open.");
+      }
+      _setSimulatedDriver(bufferSize, 0);
+      offlineFrameRate = frameRate;
+    }
+  }
+
+  /**
+   * Replays a Standard Midi File through the ports and records what the
+   * output ports write into another Standard Midi File. This method takes the
+   * place of "start": the system must be opened with the offline driver (see
+   * setOfflineDriver) and the ports must be created, but the system must not
+   * have been started. The method returns when the whole file has been
+   * processed; the system keeps running until "close" (events written after
+   * the end of the file are not recorded).
+   * <p>
+   * Each track of the file is fed into the input port named like the track
+   * (meta-event "track name"); the other tracks are fed into the given default
+   * port. The output file has the division and the tempo changes of the input
+   * file, a first track with the tempo changes and one track per output port,
+   * named like the port.
+   * </p>
+   *
+   * @param midiIn the file to replay.
+   * @param midiOut the file to write (format 1).
+   * @param defaultInputPort the port for the tracks without a port of their
+   * own; null to skip such tracks.
+   * @throws StateException if the system is not open with the offline driver
+   * or has already been started.
+   * @throws IOException if a file cannot be read or written.
+   * @throws InvalidMidiDataException if the input file is invalid or an
+   * output port has written an invalid event.
+   */
+  public void renderOffline(File midiIn, File midiOut, String defaultInputPort)
+          throws StateException, IOException, InvalidMidiDataException {
+    Sequence input = javax.sound.midi.MidiSystem.getSequence(midiIn);
+    TempoMap tempoMap;
+    long endTimeCode;
+    synchronized (openCloseLock) {
+      assumeOpen();
+      if (offlineFrameRate == 0) {
+        throw new StateException("The offline driver is not selected.");
+      }
+      if (getSimulatedStatistics()[0] > 0) {
+        throw new StateException("Cannot render, the system has already been started.");
+      }
+      tempoMap = new TempoMap(input, offlineFrameRate);
+      List<String> inputPorts = Arrays.asList(_getSimulatedPortNames(true));
+      long lastTick = 0;
+      for (Track track : input.getTracks()) {
+        lastTick = Math.max(lastTick, track.ticks());
+        String portName = getTrackName(track);
+        if (!inputPorts.contains(portName)) {
+          portName = defaultInputPort;
+        }
+        if (portName == null) {
+          continue;
+        }
+        for (int i = 0; i < track.size(); i++) {
+          MidiMessage message = track.get(i).getMessage();
+          if (message instanceof MetaMessage) {
+            continue;
+          }
+          _injectSimulatedEvent(portName, tempoMap.toTimeCode(track.get(i).getTick()),
+                  Arrays.copyOf(message.getMessage(), message.getLength()));
+        }
+      }
+      // all cycles before this time-code cover the file.
+      endTimeCode = tempoMap.toTimeCode(lastTick) + 1;
+      start();
+    }
+    // not synchronized, the listeners may call into the system meanwhile.
+    while (!_waitForSimulatedTimeCode(endTimeCode, 1000)) {
+      // the Java process thread is still busy.
+    }
+    synchronized (openCloseLock) {
+      Sequence output = new Sequence(input.getDivisionType(), input.getResolution());
+      Track tempoTrack = output.createTrack();
+      for (Track track : input.getTracks()) {
+        for (int i = 0; i < track.size(); i++) {
+          MidiMessage message = track.get(i).getMessage();
+          if ((message instanceof MetaMessage) && (((MetaMessage) message).getType() == TempoMap.tempoType)) {
+            tempoTrack.add(track.get(i));
+          }
+        }
+      }
+      for (String portName : _getSimulatedPortNames(false)) {
+        Track track = output.createTrack();
+        byte[] name = portName.getBytes(StandardCharsets.ISO_8859_1);
+        track.add(new MidiEvent(new MetaMessage(trackNameType, name, name.length), 0));
+        for (MidiEvent event : takeSimulatedOutput(portName)) {
+          if (event.getTick() < endTimeCode) {
+            track.add(new MidiEvent(event.getMessage(), tempoMap.toTick(event.getTick())));
+          }
+        }
+      }
+      javax.sound.midi.MidiSystem.write(output, 1, midiOut);
+    }
+  }
+
+  /**
+   * @return the name of the track, null if the track has no name.
+   */
+  private static String getTrackName(Track track) {
+    for (int i = 0; i < track.size(); i++) {
+      MidiMessage message = track.get(i).getMessage();
+      if ((message instanceof MetaMessage) && (((MetaMessage) message).getType() == trackNameType)) {
+        return new String(((MetaMessage) message).getData(), StandardCharsets.ISO_8859_1);
+      }
+    }
+    return null;
+  }
+
+  /**
+   * Schedules an event for an input port of the simulated driver. The event
+   * is delivered in the cycle its time-code falls into (events scheduled too
+   * late are delivered in the next cycle).
+   *
+   * @param portName the name the input port has been created with.
+   * @param timeCode the time-code of the event.
+   * @param midi the Midi bytes of the event.
+   * @return false if there is no input port of this name.
+   * @throws StateException if the simulated driver is not open.
+   */
+  public boolean injectSimulatedEvent(String portName, long timeCode, byte[] midi) throws StateException {
+    if ((portName == null) || (midi == null)) {
+      throw new NullPointerException();
+    }
+    synchronized (openCloseLock) {
+      assumeOpen();
+      return _injectSimulatedEvent(portName, timeCode, midi);
+    }
+  }
+
+  /**
+   * Retrieves the events the simulated driver has received on an output port
+   * since the last call.
+   *
+   * @param portName the name the output port has been created with.
+   * @return the events, their tick is the time-code at which they were
+   * written.
+   * @throws StateException if the simulated driver is not open.
+   * @throws InvalidMidiDataException if the port has written an invalid
+   * event.
+   */
+  public MidiEvent[] takeSimulatedOutput(String portName) throws StateException, InvalidMidiDataException {
+    if (portName == null) {
+      throw new NullPointerException();
+    }
+    byte[] packed;
+    synchronized (openCloseLock) {
+      assumeOpen();
+      packed = _takeSimulatedOutput(portName);
+    }
+    ArrayList<MidiEvent> events = new ArrayList<MidiEvent>();
+    ByteBuffer buffer = ByteBuffer.wrap(packed); // big endian, see "jackNative.cpp"
+    while (buffer.hasRemaining()) {
+      long timeCode = buffer.getLong();
+      int length = buffer.getInt();
+      byte[] midi = new byte[length];
+      buffer.get(midi);
+      events.add(new MidiEvent(toMidiMessage(midi, 0, length), timeCode));
+    }
+    return events.toArray(new MidiEvent[events.size()]);
+  }
+
+  /**
+   * Retrieves the cycle statistics of the simulated driver.
+   *
+   * @return the number of cycles executed, the longest and the total time
+   * (in nanoseconds) spent in the native part of the cycles.
+   * @throws StateException if the simulated driver is not open.
+   */
+  public long[] getSimulatedStatistics() throws StateException {
+    long[] statistics = new long[3];
+    synchronized (openCloseLock) {
+      assumeOpen();
+      _getSimulatedStatistics(statistics);
+    }
+    return statistics;
+  }
+
+  @Override
+  public void open(String clientName, MidiSystemListener listener, ThreadFactory processThreadFactory) throws StateException, UnavailableException {
+    if (clientName == null) {
+      throw new IllegalArgumentException("clientName may not be null.");
+    }
+    if (processThreadFactory == null) {
+      throw new NullPointerException();
+    }
+    synchronized (openCloseLock) {
+      assumeAvailable();
+      if ((offlineFrameRate > 0) && (lockFreeHandshake || batchedDispatch || (xrunPolicy != XrunPolicy.DELAY))) {
+        throw new StateException("The offline driver needs the blocking hand-shake.");
+      }
+      this.processThreadFactory = processThreadFactory;
+      startLogForwarder();
+      int error = _open(clientName, listener, batchedDispatch ? new CycleDispatcher() : null);
+      switch (error) {
+        case noError:
+          isRunnable = true;
+          return;
+        case errorAlreadyOpen:
+          throw new StateException("Attempt to open the Jack-Audio Server twice.");
+        case errorConnectionFailed:
+          throw new RuntimeException("Could not connect to the Jack-Audio Server.");
+        default:
+          throw new RuntimeException("Could not open the Jack-Audio Server (" + error + ")");
+      }
+    }
   }
 
   @Override
@@ -304,48 +1313,380 @@ public class MidiJackNative implements MidiSystem {
       public void onClose() {
       }
 
-      @Override
-      public void onOpen() throws Throwable {
-      }
+      @Override
+      public void onOpen() throws Throwable {
+      }
+
+      @Override
+      public void onCycleStart(long timeCodeStart, long timeCodeDuration, boolean lastCycle) throws Throwable {
+      }
+
+      @Override
+      public void onCycleEnd(long timeCodeStart, long timeCodeDuration, boolean lastCycle) throws Throwable {
+      }
+    };
+    open(clientName, dummyListener);
+  }
+
+  @Override
+  public void start() {
+    synchronized (openCloseLock) {
+      if (!isRunnable) {
+        throw new StateException("Cannot run, system is not runnable.");
+      }
+      Thread processThread = processThreadFactory.newThread(
+              new Runnable() {
+                @Override
+                public void run() {
+                  _run();
+                }
+              });
+      processThread.start();
+      _waitForCycleDone();
+    }
+  }
+
+  /**
+   * What an input port does with the events that arrive in one cycle
+   * beyond its capacity. The ordinals must match "midiEventArena.hpp".
+   */
+  public enum OverflowPolicy {
+
+    /**
+     * the events that arrive when the port is full are dropped.
+     */
+    DROP_NEWEST,
+    /**
+     * the oldest events of the cycle are dropped so that the newest fit.
+     */
+    DROP_OLDEST,
+    /**
+     * the events that do not fit are delivered at the start of the next
+     * cycle (with delta-time 0).
+     */
+    SPILL
+  }
+
+  /**
+   * What happens when the Java process thread is late (see setXrunPolicy).
+   * The ordinals must match "port.hpp".
+   */
+  public enum XrunPolicy {
+
+    /**
+     * the output of the late cycle is written in a later cycle; the input of
+     * the cycles the Java process thread has missed is lost.
+     */
+    DELAY,
+    /**
+     * the output of the late cycle is dropped (the port stays silent); the
+     * input of the cycles the Java process thread has missed is lost.
+     */
+    SKIP,
+    /**
+     * as SKIP, but the input of the cycles the Java process thread has missed
+     * is delivered at the start of the next cycle (with delta-time 0).
+     */
+    MERGE
+  }
+
+  /**
+   * The phases of a cycle whose durations are recorded for every port. The
+   * ordinals must match "latencyHistogram.hpp".
+   */
+  public enum TimingPhase {
+
+    /**
+     * from the start of the cycle until the java thread starts on the port.
+     */
+    JAVA_DELAY,
+    /**
+     * the duration of the java callback.
+     */
+    JAVA_PROCESS,
+    /**
+     * the duration of the native process.
+     */
+    NATIVE_PROCESS,
+    /**
+     * the time left in the cycle when the native process of the port has
+     * ended (only recorded when the frame rate is known, not in offline mode).
+     */
+    SLACK
+  }
+
+  /**
+   * A snapshot of the timing statistics of a port. All durations are in
+   * nanoseconds; the percentiles are exact within about 6 percent.
+   */
+  public static final class CycleTiming {
+
+    private static final int valuesPerPhase = 6;
+    private final long[] values;
+
+    private CycleTiming(long[] values) {
+      this.values = values;
+    }
+
+    private long get(TimingPhase phase, int index) {
+      return values[phase.ordinal() * valuesPerPhase + index];
+    }
+
+    /**
+     * @return the number of cycles in which the phase was recorded.
+     */
+    public long getCount(TimingPhase phase) {
+      return get(phase, 0);
+    }
+
+    public long getMean(TimingPhase phase) {
+      return get(phase, 1);
+    }
+
+    public long getMin(TimingPhase phase) {
+      return get(phase, 2);
+    }
+
+    public long getMedian(TimingPhase phase) {
+      return get(phase, 3);
+    }
+
+    public long get99thPercentile(TimingPhase phase) {
+      return get(phase, 4);
+    }
+
+    public long getMax(TimingPhase phase) {
+      return get(phase, 5);
+    }
+  }
+
+  private static CycleTiming getCycleTiming(long portId, boolean reset) {
+    long[] statistics = new long[CycleTiming.valuesPerPhase * TimingPhase.values().length];
+    _getCycleTiming(portId, statistics, reset);
+    return new CycleTiming(statistics);
+  }
+
+  /**
+   * A stage of the native processing of a port (see
+   * MonitoredMidiPort.setProcessors). The stages run inside the Jack process
+   * thread, so simple transformations need no Java code at all. Only channel
+   * messages are modified; SysEx and other long events pass unchanged (unless
+   * a filter drops them).
+   */
+  public static final class NativeProcessor {
+
+    /**
+     * The kinds of stages, the ordinals must match "midiProcessor.hpp".
+     */
+    private static final int transposeKind = 0;
+    private static final int channelMapKind = 1;
+    private static final int velocityCurveKind = 2;
+    private static final int filterKind = 3;
+    private static final int splitKind = 4;
+    private final int[] description;
+
+    private NativeProcessor(int kind, int... parameters) {
+      description = new int[parameters.length + 1];
+      description[0] = kind;
+      System.arraycopy(parameters, 0, description, 1, parameters.length);
+    }
+
+    /**
+     * Shifts the key of note-on, note-off and polyphonic aftertouch
+     * messages. Notes shifted out of the Midi range are dropped.
+     *
+     * @param semitones the number of semitones to shift (negative to shift
+     * down).
+     */
+    public static NativeProcessor transpose(int semitones) {
+      return new NativeProcessor(transposeKind, semitones);
+    }
+
+    /**
+     * Moves the channel messages to other channels.
+     *
+     * @param channels for each of the 16 channels the new channel (0 to 15),
+     * or -1 to drop the messages of the channel.
+     */
+    public static NativeProcessor channelMap(int[] channels) {
+      if (channels.length != 16) {
+        throw new IllegalArgumentException("A channel map needs 16 channels.");
+      }
+      for (int channel : channels) {
+        if ((channel < -1) || (channel > 15)) {
+          throw new IllegalArgumentException("Invalid channel " + channel + ".");
+        }
+      }
+      return new NativeProcessor(channelMapKind, channels);
+    }
+
+    /**
+     * Replaces the velocity of the note-on messages.
+     *
+     * @param velocities for each velocity (0 to 127) the new velocity (1 to
+     * 127); the first element is ignored, because a note-on with zero
+     * velocity is a note-off.
+     */
+    public static NativeProcessor velocityCurve(int[] velocities) {
+      if (velocities.length != 128) {
+        throw new IllegalArgumentException("A velocity curve needs 128 velocities.");
+      }
+      int[] curve = velocities.clone();
+      curve[0] = 1;
+      for (int velocity : curve) {
+        if ((velocity < 1) || (velocity > 127)) {
+          throw new IllegalArgumentException("Invalid velocity " + velocity + ".");
+        }
+      }
+      return new NativeProcessor(velocityCurveKind, curve);
+    }
+
+    /**
+     * Lets pass only selected messages.
+     *
+     * @param statusMask bit n lets pass the messages with status 0x80 + n *
+     * 0x10 (bit 0 note-off, bit 1 note-on ... bit 7 system messages).
+     * @param channelMask bit n lets pass the channel messages on channel n.
+     */
+    public static NativeProcessor filter(int statusMask, int channelMask) {
+      return new NativeProcessor(filterKind, statusMask, channelMask);
+    }
+
+    /**
+     * Splits the keyboard: the note messages below the split key are moved
+     * to one channel, the others to another channel.
+     *
+     * @param splitKey the lowest key of the upper part.
+     * @param lowerChannel the channel of the lower part (0 to 15).
+     * @param upperChannel the channel of the upper part (0 to 15).
+     */
+    public static NativeProcessor split(int splitKey, int lowerChannel, int upperChannel) {
+      if ((lowerChannel < 0) || (lowerChannel > 15) || (upperChannel < 0) || (upperChannel > 15)) {
+        throw new IllegalArgumentException("Invalid channel.");
+      }
+      return new NativeProcessor(splitKind, splitKey, lowerChannel, upperChannel);
+    }
+
+    /**
+     * @return the descriptions of the given stages, one after the other.
+     */
+    static int[] describe(NativeProcessor... processors) {
+      int length = 0;
+      for (NativeProcessor processor : processors) {
+        length += processor.description.length;
+      }
+      int[] result = new int[length];
+      int position = 0;
+      for (NativeProcessor processor : processors) {
+        System.arraycopy(processor.description, 0, result, position, processor.description.length);
+        position += processor.description.length;
+      }
+      return result;
+    }
+  }
+
+  /**
+   * A port whose capacity per cycle can be monitored. The capacity grows
+   * (up to 8192 events) when the demand comes close to it; events that
+   * arrive before the capacity has grown are counted.
+   */
+  public interface MonitoredMidiPort extends MidiPort {
+
+    /**
+     * @return the number of events per cycle the port can currently take.
+     */
+    long getEventCapacity();
+
+    /**
+     * @return the highest number of events that were offered in one cycle.
+     */
+    long getEventHighWaterMark();
+
+    /**
+     * @return the number of events that were lost because the port was full.
+     */
+    long getDroppedEventCount();
+
+    /**
+     * @return the number of events that were delayed to the next cycle
+     * (see OverflowPolicy.SPILL).
+     */
+    long getSpilledEventCount();
+
+    /**
+     * @return how often the capacity has grown.
+     */
+    long getGrowCount();
+
+    /**
+     * @param reset if true, the statistics are cleared, so the next snapshot
+     * covers only the cycles from now on.
+     * @return the timing statistics of the cycles this port has processed.
+     */
+    CycleTiming getCycleTiming(boolean reset);
 
-      @Override
-      public void onCycleStart(long timeCodeStart, long timeCodeDuration, boolean lastCycle) throws Throwable {
-      }
+    /**
+     * Replaces the native processing of this port. The events of an input
+     * port run through the stages before they reach the listener, the events
+     * of an output port after they have left the listener. Can be called at
+     * any time, the new stages apply from the next cycle on.
+     *
+     * @param processors the stages in the order they shall run, none to let
+     * all events pass unchanged.
+     */
+    void setProcessors(NativeProcessor... processors);
 
-      @Override
-      public void onCycleEnd(long timeCodeStart, long timeCodeDuration, boolean lastCycle) throws Throwable {
-      }
-    };
-    open(clientName, dummyListener);
+    /**
+     * Lets the port skip the cycles in which it has no connection at the Jack
+     * server: the listener is not called and the Jack buffer is not touched.
+     * An input port still hands over events received before it lost its last
+     * connection. Can be called at any time, applies from the next cycle on.
+     *
+     * @param value true to skip idle cycles (the default is false).
+     */
+    void setSkipWhenIdle(boolean value);
+
+    /**
+     * @return the number of cycles skipped because the port had no
+     * connection (see setSkipWhenIdle).
+     */
+    long getIdleCycleCount();
   }
 
-  @Override
-  public void start() {
-    synchronized (openCloseLock) {
-      if (!isRunnable) {
-        throw new StateException("Cannot run, system is not runnable.");
-      }
-      Thread processThread = processThreadFactory.newThread(
-              new Runnable() {
-                @Override
-                public void run() {
-                  _run();
-                }
-              });
-      processThread.start();
-      _waitForCycleDone();
-    }
+  /**
+   * An input port that buffers incoming events in a ring (see
+   * createAsyncInputPort). The statistics help to tune the ring capacity.
+   */
+  public interface AsyncMidiPort extends MonitoredMidiPort {
+
+    /**
+     * @return the maximum number of events the ring can hold (zero for a
+     * synchronous port).
+     */
+    long getRingCapacity();
+
+    /**
+     * @return the highest number of events that were buffered at once.
+     */
+    long getRingHighWaterMark();
+
+    /**
+     * @return the number of events that were dropped because the ring was
+     * full.
+     */
+    long getRingOverflowCount();
   }
 
-  private static class MidiInputPort implements MidiPort {
+  /**
+   * The parts common to all kinds of input ports.
+   */
+  private static abstract class AbstractInputPort implements AsyncMidiPort {
 
     final long portId;
     final InfoImpl info;
     final String name;
-    final MidiInputPortListener listener;
 
-    protected MidiInputPort(long portId, MidiInputPortListener listener, InfoImpl info, String name) {
-      this.listener = listener;
+    protected AbstractInputPort(long portId, InfoImpl info, String name) {
       this.portId = portId;
       this.info = info;
       this.name = name;
@@ -379,65 +1720,244 @@ public class MidiJackNative implements MidiSystem {
       return _isClosedPort(portId);
     }
 
+    private long getRingStatistic(int index) {
+      long[] statistics = new long[3];
+      _getRingStatistics(portId, statistics);
+      return statistics[index];
+    }
+
+    @Override
+    public long getRingCapacity() {
+      return getRingStatistic(0);
+    }
+
+    @Override
+    public long getRingHighWaterMark() {
+      return getRingStatistic(1);
+    }
+
+    @Override
+    public long getRingOverflowCount() {
+      return getRingStatistic(2);
+    }
+
+    private long getOverflowStatistic(int index) {
+      long[] statistics = new long[5];
+      _getOverflowStatistics(portId, statistics);
+      return statistics[index];
+    }
+
+    @Override
+    public long getEventCapacity() {
+      return getOverflowStatistic(0);
+    }
+
+    @Override
+    public long getEventHighWaterMark() {
+      return getOverflowStatistic(1);
+    }
+
+    @Override
+    public long getDroppedEventCount() {
+      return getOverflowStatistic(2);
+    }
+
+    @Override
+    public long getSpilledEventCount() {
+      return getOverflowStatistic(3);
+    }
+
+    @Override
+    public long getGrowCount() {
+      return getOverflowStatistic(4);
+    }
+
+    @Override
+    public CycleTiming getCycleTiming(boolean reset) {
+      return MidiJackNative.getCycleTiming(portId, reset);
+    }
+
+    @Override
+    public void setProcessors(NativeProcessor... processors) {
+      _setProcessors(portId, NativeProcessor.describe(processors));
+    }
+
+    @Override
+    public void setSkipWhenIdle(boolean value) {
+      _setSkipWhenIdle(portId, value);
+    }
+
+    @Override
+    public long getIdleCycleCount() {
+      return _getIdleCycleCount(portId);
+    }
+
+    // Signature: ()V
+    public abstract void onClose() throws Throwable;
+
+    // Signature: ()V
+    public abstract void onOpen() throws Throwable;
+  }
+
+  /**
+   * Makes a MidiMessage from raw Midi bytes.
+   *
+   * @param raw the Midi bytes.
+   * @param offset the index of the status byte.
+   * @param size the number of Midi bytes.
+   * @return a SysexMessage or a ShortMessage.
+   * @throws InvalidMidiDataException
+   */
+  private static MidiMessage toMidiMessage(byte[] raw, int offset, int size) throws InvalidMidiDataException {
+    int status = raw[offset] & 0xFF;
+    if ((status == SysexMessage.SYSTEM_EXCLUSIVE) || (status == SysexMessage.SPECIAL_SYSTEM_EXCLUSIVE)) {
+      SysexMessage sysex = new SysexMessage();
+      sysex.setMessage(Arrays.copyOfRange(raw, offset, offset + size), size);
+      return sysex;
+    }
+    ShortMessage shortMessage = new ShortMessage();
+    shortMessage.setMessage(
+            status,
+            (size > 1) ? raw[offset + 1] & 0xFF : 0, // data1
+            (size > 2) ? raw[offset + 2] & 0xFF : 0); // data2
+    return shortMessage;
+  }
+
+  /**
+   * Lets a MidiInputPortListener receive the events of a direct input port
+   * (see DirectMidiInputPort). The MidiEvents are only created for the events
+   * actually received; a cycle without events costs no allocation.
+   */
+  private static final class MidiEventInputAdapter implements DirectMidiInputPortListener {
+
+    private static final MidiEvent[] noEvents = new MidiEvent[0];
+    final MidiInputPortListener listener;
+
+    MidiEventInputAdapter(MidiInputPortListener listener) {
+      this.listener = listener;
+    }
+
+    @Override
+    public void process(long timeCodeStart, long timeCodeDuration,
+            MidiEventBuffer events, boolean lastCycle) throws Throwable {
+      MidiEvent[] midiEvents = noEvents;
+      if (events.size() > 0) {
+        midiEvents = new MidiEvent[events.size()];
+        MidiEventBuffer.Cursor event = events.cursor();
+        while (event.next()) {
+          midiEvents[event.getIndex()] = new MidiEvent(toMidiMessage(event), event.getDeltaTime());
+        }
+      }
+      listener.process(timeCodeStart, timeCodeDuration, midiEvents, lastCycle);
+    }
+
+    @Override
+    public void onClose() throws Throwable {
+      listener.onClose();
+    }
+
+    @Override
+    public void onOpen() throws Throwable {
+      listener.onOpen();
+    }
+  }
+
+  /**
+   * Converts the event a cursor stands on.
+   *
+   * @return a SysexMessage or a ShortMessage.
+   * @throws InvalidMidiDataException
+   */
+  private static MidiMessage toMidiMessage(MidiEventBuffer.Cursor event) throws InvalidMidiDataException {
+    int status = event.getStatus();
+    if ((status == SysexMessage.SYSTEM_EXCLUSIVE) || (status == SysexMessage.SPECIAL_SYSTEM_EXCLUSIVE)) {
+      byte[] raw = new byte[event.getLength()];
+      event.getMessage(raw, 0);
+      SysexMessage sysex = new SysexMessage();
+      sysex.setMessage(raw, raw.length);
+      return sysex;
+    }
+    ShortMessage shortMessage = new ShortMessage();
+    shortMessage.setMessage(status, event.getData1(), event.getData2());
+    return shortMessage;
+  }
+
+  /**
+   * An input port that receives its events through direct byte buffers
+   * allocated by the native code (see "JackInputPort.hpp"). The buffers are
+   * handed over once, when the port is initialized; per cycle only the
+   * number of events crosses the JNI boundary.
+   */
+  private static class DirectMidiInputPort extends AbstractInputPort implements CycleDispatcher.Target {
+
+    final DirectMidiInputPortListener listener;
+    private MidiEventBuffer events = null;
+
+    protected DirectMidiInputPort(long portId, DirectMidiInputPortListener listener, InfoImpl info, String name) {
+      super(portId, info, name);
+      this.listener = listener;
+    }
+
+    // Signature: (Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;)V
+    public void setEventBuffers(ByteBuffer index, ByteBuffer bytes) {
+      events = new MidiEventBuffer(index, bytes);
+    }
+
     /**
-     * Process callback of an input port.
+     * Process callback of a direct input port.
      *
      * @param timeCodeStart
      * @param timeCodeDuration
      * @param lastCycle
-     * @param rawEvents
-     * @param deltaTimes
+     * @param eventCount the number of events the native code has written
+     * into the buffer.
      * @throws Throwable
      */
-    public void process(long timeCodeStart,
+    public void processDirect(long timeCodeStart,
             long timeCodeDuration,
             boolean lastCycle,
-            int[] rawEvents,
-            int[] deltaTimes)
+            int eventCount)
             throws Throwable {
-
-      //Signature: (JJZ[I[I)V
-
-
-      int eventCount = deltaTimes.length;
-      if (eventCount * 3 != rawEvents.length) {
-        throw new RuntimeException("Array length missmatch.");
-      }
-      MidiEvent[] events = new MidiEvent[eventCount];
-      for (int i = 0; i < eventCount; i++) {
-        ShortMessage message = new ShortMessage();
-        int rawIdx = 3 * i;
-        message.setMessage(
-                rawEvents[rawIdx], // status
-                rawEvents[rawIdx + 1], // data1
-                rawEvents[rawIdx + 2]); // data2
-
-        MidiEvent event = new MidiEvent(message, deltaTimes[i]);
-        events[i] = event;
-      }
+      // Signature: (JJZI)V
+      events.setEventCount(eventCount);
       listener.process(timeCodeStart, timeCodeDuration, events, lastCycle);
     }
 
+    @Override
+    public long dispatch(long timeCodeStart, long timeCodeDuration, boolean lastCycle, int eventCount)
+            throws Throwable {
+      processDirect(timeCodeStart, timeCodeDuration, lastCycle, eventCount);
+      return 0;
+    }
+
     // Signature: ()V
+    @Override
     public void onClose() throws Throwable {
-      listener.onClose();
+      try {
+        listener.onClose();
+      } finally {
+        // the native memory is released after this call.
+        events = null;
+      }
     }
 
     // Signature: ()V
+    @Override
     public void onOpen() throws Throwable {
       listener.onOpen();
     }
   }
 
-  private static class MidiOutputPort implements MidiPort {
+  /**
+   * The parts common to all kinds of output ports.
+   */
+  private static abstract class AbstractOutputPort implements MonitoredMidiPort {
 
     final long portId;
     final InfoImpl info;
     final String name;
-    final MidiOutputPortListener listener;
 
-    protected MidiOutputPort(long portId, MidiOutputPortListener listener, InfoImpl info, String name) {
-      this.listener = listener;
+    protected AbstractOutputPort(long portId, InfoImpl info, String name) {
       this.portId = portId;
       this.info = info;
       this.name = name;
@@ -471,83 +1991,180 @@ public class MidiJackNative implements MidiSystem {
       return _isClosedPort(portId);
     }
 
+    private long getOverflowStatistic(int index) {
+      long[] statistics = new long[5];
+      _getOverflowStatistics(portId, statistics);
+      return statistics[index];
+    }
+
+    @Override
+    public long getEventCapacity() {
+      return getOverflowStatistic(0);
+    }
+
+    @Override
+    public long getEventHighWaterMark() {
+      return getOverflowStatistic(1);
+    }
+
+    @Override
+    public long getDroppedEventCount() {
+      return getOverflowStatistic(2);
+    }
+
+    @Override
+    public long getSpilledEventCount() {
+      return getOverflowStatistic(3);
+    }
+
+    @Override
+    public long getGrowCount() {
+      return getOverflowStatistic(4);
+    }
+
+    @Override
+    public CycleTiming getCycleTiming(boolean reset) {
+      return MidiJackNative.getCycleTiming(portId, reset);
+    }
+
+    @Override
+    public void setProcessors(NativeProcessor... processors) {
+      _setProcessors(portId, NativeProcessor.describe(processors));
+    }
+
+    @Override
+    public void setSkipWhenIdle(boolean value) {
+      _setSkipWhenIdle(portId, value);
+    }
+
+    @Override
+    public long getIdleCycleCount() {
+      return _getIdleCycleCount(portId);
+    }
+
+    // Signature: ()V
+    public abstract void onClose() throws Throwable;
+
+    // Signature: ()V
+    public abstract void onOpen() throws Throwable;
+  }
+
+  /**
+   * Lets a MidiOutputPortListener write the events of a direct output port
+   * (see DirectMidiOutputPort). Short messages are written field by field,
+   * so apart from what the listener itself creates nothing is allocated.
+   */
+  private static final class MidiEventOutputAdapter implements DirectMidiOutputPortListener {
+
+    final MidiOutputPortListener listener;
+
+    MidiEventOutputAdapter(MidiOutputPortListener listener) {
+      this.listener = listener;
+    }
+
+    @Override
+    public void process(long timeCodeStart, long timeCodeDuration,
+            MidiEventBuffer events, boolean lastCycle) throws Throwable {
+      // ask the listener to produce new events
+      MidiEvent[] midiEvents = listener.process(timeCodeStart, timeCodeDuration, lastCycle);
+      if (midiEvents == null) {
+        return;
+      }
+      for (MidiEvent event : midiEvents) {
+        MidiMessage message = event.getMessage();
+        // Meta messages only exist in files, they are not sent.
+        if (message instanceof MetaMessage) {
+          continue;
+        }
+        int deltaTime = (int) event.getTick();
+        if (deltaTime < 0) {
+          throw new IllegalArgumentException("Negative delta-time " + deltaTime + " in " + event);
+        }
+        if (deltaTime >= timeCodeDuration) {
+          throw new IllegalArgumentException("Invalid delta-time " + deltaTime + " in " + event);
+        }
+        // events that do not fit are counted by the native side.
+        if (message instanceof ShortMessage) {
+          ShortMessage shortMessage = (ShortMessage) message;
+          events.add(deltaTime, shortMessage.getStatus(), shortMessage.getData1(),
+                  shortMessage.getData2(), shortMessage.getLength());
+        } else {
+          events.add(deltaTime, message.getMessage(), 0, message.getLength());
+        }
+      }
+    }
+
+    @Override
+    public void onClose() throws Throwable {
+      listener.onClose();
+    }
+
+    @Override
+    public void onOpen() throws Throwable {
+      listener.onOpen();
+    }
+  }
+
+  /**
+   * An output port that passes its events through direct byte buffers
+   * allocated by the native code (see "JackOutputPort.hpp"). The buffers are
+   * handed over once, when the port is initialized; per cycle only the
+   * number of events crosses the JNI boundary.
+   */
+  private static class DirectMidiOutputPort extends AbstractOutputPort implements CycleDispatcher.Target {
+
+    final DirectMidiOutputPortListener listener;
+    private MidiEventBuffer events = null;
+
+    protected DirectMidiOutputPort(long portId, DirectMidiOutputPortListener listener, InfoImpl info, String name) {
+      super(portId, info, name);
+      this.listener = listener;
+    }
+
+    // Signature: (Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;)V
+    public void setEventBuffers(ByteBuffer index, ByteBuffer bytes) {
+      events = new MidiEventBuffer(index, bytes);
+    }
+
     /**
-     * Process callback of an output port.
+     * Process callback of a direct output port.
      *
      * @param timeCodeStart the time-tick at the start of this cycle
      * @param timeCodeDuration the number of time-ticks in this process-cycle
-     * (the value is equal to the number of audio-frames per period).
-     * @param rawEventsOut an array that should be filled with midi data.
-     * @param deltaTimesOut an array that should be filled with the delta times
-     * corresponding to the rawEvents.
-     * @param eventSizeOut an array that should be filled with the sizes of the
-     * rawEvents.
-     * @return the number of events generated in this cycle
+     * @param lastCycle
+     * @return the number of events the listener has tried to add (high 32
+     * bits) and the number of events added to the buffer (low 32 bits).
      * @throws Throwable
      */
-    public int process(long timeCodeStart,
+    public long processDirect(long timeCodeStart,
             long timeCodeDuration,
-            boolean lastCycle,
-            int[] rawEventsOut,
-            int[] deltaTimesOut,
-            int[] eventSizeOut)
+            boolean lastCycle)
             throws Throwable {
-      // Signature: (JJZ[I[I[I)I
-
-      int maxEvents = eventSizeOut.length;
-
-      if (deltaTimesOut.length != maxEvents) {
-        throw new IllegalArgumentException("Array length missmatch.");
-      }
-      if (rawEventsOut.length != 3 * maxEvents) {
-        throw new IllegalArgumentException("Array length missmatch.");
-      }
-
-      // ask the listener to produce new events
-      MidiEvent[] midiEvents = listener.process(timeCodeStart, timeCodeDuration, lastCycle);
+      // Signature: (JJZ)J
+      events.clear();
+      listener.process(timeCodeStart, timeCodeDuration, events, lastCycle);
+      return ((long) events.getRequestCount() << 32) | events.size();
+    }
 
-      // transfer the event-data into the output arrays
-      int eventCount = 0;
-      if (midiEvents != null) {
-        for (MidiEvent event : midiEvents) {
-          // We are currently only treating short messages
-          if (event.getMessage() instanceof ShortMessage) {
-            if (eventCount >= maxEvents) {
-              throw new RuntimeException("Too many midi events, array overflow.");
-            }
-            // handle delta time
-            int deltaTime = (int) event.getTick();
-            if (deltaTime < 0) {
-              throw new IllegalArgumentException("Negative delta-time " + deltaTime + " in " + event);
-            }
-            if (deltaTime >= timeCodeDuration) {
-              throw new IllegalArgumentException("Invalid delta-time " + deltaTime + " in " + event);
-            }
-            deltaTimesOut[eventCount] = deltaTime;
-
-            // Handle the message
-            ShortMessage message = (ShortMessage) event.getMessage();
-            eventSizeOut[eventCount] = message.getLength();
-
-            int rawEventBase = 3 * eventCount;
-            rawEventsOut[rawEventBase] = message.getStatus();
-            rawEventsOut[rawEventBase + 1] = message.getData1();
-            rawEventsOut[rawEventBase + 2] = message.getData2();
-
-            // increment event count
-            eventCount++;
-          }
-        }
-      }
-      return eventCount;
+    @Override
+    public long dispatch(long timeCodeStart, long timeCodeDuration, boolean lastCycle, int eventCount)
+            throws Throwable {
+      return processDirect(timeCodeStart, timeCodeDuration, lastCycle);
     }
 
     // Signature: ()V
+    @Override
     public void onClose() throws Throwable {
-      listener.onClose();
+      try {
+        listener.onClose();
+      } finally {
+        // the native memory is released after this call.
+        events = null;
+      }
     }
 
     // Signature: ()V
+    @Override
     public void onOpen() throws Throwable {
       listener.onOpen();
     }
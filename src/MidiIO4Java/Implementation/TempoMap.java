@@ -0,0 +1,143 @@
+/*
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package MidiIO4Java.Implementation;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.List;
+import javax.sound.midi.MetaMessage;
+import javax.sound.midi.MidiEvent;
+import javax.sound.midi.MidiMessage;
+import javax.sound.midi.Sequence;
+import javax.sound.midi.Track;
+
+/**
+ * Converts between the ticks of a Standard Midi File and the time-code (the
+ * frames) of the process cycles, following the tempo changes of the file.
+ *
+ * @author Harald Postner <Harald at free_creations.de>
+ */
+final class TempoMap {
+
+  /**
+   * The meta-event type of a tempo change.
+   */
+  static final int tempoType = 0x51;
+  /**
+   * The tempo of a file without tempo changes (120 beats per minute).
+   */
+  private static final long defaultMicrosPerQuarter = 500000;
+
+  /**
+   * A segment of constant tempo.
+   */
+  private static final class Segment {
+
+    final long tick;
+    final double micros;
+    final double microsPerTick;
+
+    Segment(long tick, double micros, double microsPerTick) {
+      this.tick = tick;
+      this.micros = micros;
+      this.microsPerTick = microsPerTick;
+    }
+  }
+  private final List<Segment> segments = new ArrayList<>();
+  private final double framesPerMicro;
+
+  /**
+   * @param sequence the file.
+   * @param frameRate the number of frames (time-code units) per second.
+   */
+  TempoMap(Sequence sequence, long frameRate) {
+    if (frameRate <= 0) {
+      throw new IllegalArgumentException("frameRate must be positive.");
+    }
+    framesPerMicro = frameRate / 1.0E6;
+    int resolution = sequence.getResolution();
+    if (sequence.getDivisionType() != Sequence.PPQ) {
+      // SMPTE: the ticks have a fixed length, tempo changes do not apply.
+      segments.add(new Segment(0, 0, 1.0E6 / (sequence.getDivisionType() * resolution)));
+      return;
+    }
+    List<MidiEvent> tempoChanges = new ArrayList<>();
+    for (Track track : sequence.getTracks()) {
+      for (int i = 0; i < track.size(); i++) {
+        MidiMessage message = track.get(i).getMessage();
+        if ((message instanceof MetaMessage) && (((MetaMessage) message).getType() == tempoType)) {
+          tempoChanges.add(track.get(i));
+        }
+      }
+    }
+    Collections.sort(tempoChanges, new Comparator<MidiEvent>() {
+      @Override
+      public int compare(MidiEvent e1, MidiEvent e2) {
+        return Long.compare(e1.getTick(), e2.getTick());
+      }
+    });
+    Segment current = new Segment(0, 0, defaultMicrosPerQuarter / (double) resolution);
+    segments.add(current);
+    for (MidiEvent change : tempoChanges) {
+      byte[] data = ((MetaMessage) change.getMessage()).getData();
+      if (data.length < 3) {
+        continue;
+      }
+      long microsPerQuarter = ((data[0] & 0xFF) << 16) | ((data[1] & 0xFF) << 8) | (data[2] & 0xFF);
+      long tick = change.getTick();
+      double micros = current.micros + (tick - current.tick) * current.microsPerTick;
+      current = new Segment(tick, micros, microsPerQuarter / (double) resolution);
+      if (segments.get(segments.size() - 1).tick == tick) {
+        segments.set(segments.size() - 1, current);
+      } else {
+        segments.add(current);
+      }
+    }
+  }
+
+  /**
+   * @param tick a position in the file.
+   * @return the time-code of the position.
+   */
+  long toTimeCode(long tick) {
+    Segment segment = segments.get(0);
+    for (Segment s : segments) {
+      if (s.tick > tick) {
+        break;
+      }
+      segment = s;
+    }
+    double micros = segment.micros + (tick - segment.tick) * segment.microsPerTick;
+    return Math.round(micros * framesPerMicro);
+  }
+
+  /**
+   * @param timeCode a time-code.
+   * @return the nearest position in the file.
+   */
+  long toTick(long timeCode) {
+    double micros = timeCode / framesPerMicro;
+    Segment segment = segments.get(0);
+    for (Segment s : segments) {
+      if (s.micros > micros) {
+        break;
+      }
+      segment = s;
+    }
+    return segment.tick + Math.round((micros - segment.micros) / segment.microsPerTick);
+  }
+}
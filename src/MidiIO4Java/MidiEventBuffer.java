@@ -0,0 +1,383 @@
+/*
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package MidiIO4Java;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * A view onto the Midi events of one process cycle, kept in direct byte
+ * buffers shared with the native process thread. Input ports hand the events
+ * written by the native side to the listener; output ports let the listener
+ * "add" the events that the native side shall send. The same view object is
+ * reused in every cycle, so neither reading nor adding events allocates any
+ * memory.
+ * <p>
+ * Events may have any length: one-byte real-time messages (like the Midi
+ * clock), two- and three-byte channel messages and SysEx messages.
+ * </p>
+ * <p>
+ * The view is only valid during the call-back it is handed to; its content is
+ * overwritten in the next cycle.
+ * </p>
+ * The events are kept in two buffers (see "native/midiEventArena.hpp"): the
+ * Midi bytes of all events follow each other in the byte buffer, and the index
+ * buffer holds an entry of 12 bytes per event:
+ * <pre>
+ *  offset 0: the delta-time (32 bit, native byte order)
+ *  offset 4: the offset of the first Midi byte in the byte buffer (32 bit)
+ *  offset 8: the number of Midi bytes (32 bit)
+ * </pre>
+ *
+ * @author Harald Postner <Harald at free_creations.de>
+ */
+public final class MidiEventBuffer {
+
+  private static final int entrySize = 12;
+  private static final int deltaTimeOffset = 0;
+  private static final int byteOffsetOffset = 4;
+  private static final int lengthOffset = 8;
+  private final ByteBuffer index;
+  private final ByteBuffer bytes;
+  private int eventCount = 0;
+  private int byteCount = 0;
+  private int requestCount = 0;
+  private final Cursor cursor = new Cursor();
+
+  /**
+   * Wraps the buffers shared with the native side.
+   *
+   * @param index a direct byte buffer for the index entries (the byte order
+   * will be set to the native order).
+   * @param bytes a direct byte buffer for the Midi bytes.
+   */
+  public MidiEventBuffer(ByteBuffer index, ByteBuffer bytes) {
+    this.index = index.order(ByteOrder.nativeOrder());
+    this.bytes = bytes;
+  }
+
+  /**
+   * Sets the number of valid events (called before each input cycle).
+   *
+   * @param eventCount the number of events written in this cycle.
+   */
+  public void setEventCount(int eventCount) {
+    if ((eventCount < 0) || (eventCount > getCapacity())) {
+      throw new IllegalArgumentException("Invalid event count " + eventCount);
+    }
+    this.eventCount = eventCount;
+  }
+
+  /**
+   * Removes all events (called before an output cycle).
+   */
+  public void clear() {
+    eventCount = 0;
+    byteCount = 0;
+    requestCount = 0;
+  }
+
+  /**
+   * Appends a short event. Events must be added in ascending order of their
+   * delta-times.
+   *
+   * @param deltaTime the time of the event relative to the start of the
+   * cycle.
+   * @param status the status byte.
+   * @param data1 the first data byte (ignored if length is less than 2).
+   * @param data2 the second data byte (ignored if length is less than 3).
+   * @param length the number of valid Midi bytes (1 to 3).
+   * @return false if the buffer is full; the event is dropped (and counted
+   * by the port, whose capacity will grow for the following cycles).
+   */
+  public boolean add(int deltaTime, int status, int data1, int data2, int length) {
+    if ((length < 1) || (length > 3)) {
+      throw new IllegalArgumentException("Invalid event length " + length);
+    }
+    int offset = reserve(deltaTime, length);
+    if (offset < 0) {
+      return false;
+    }
+    bytes.put(offset, (byte) status);
+    if (length > 1) {
+      bytes.put(offset + 1, (byte) data1);
+    }
+    if (length > 2) {
+      bytes.put(offset + 2, (byte) data2);
+    }
+    return true;
+  }
+
+  /**
+   * Appends an event of any length (for example a SysEx message). Events must
+   * be added in ascending order of their delta-times.
+   *
+   * @param deltaTime the time of the event relative to the start of the
+   * cycle.
+   * @param message an array holding the Midi bytes.
+   * @param messageOffset the index of the first Midi byte in the array.
+   * @param length the number of Midi bytes.
+   * @return false if the buffer is full; the event is dropped (and counted
+   * by the port, whose capacity will grow for the following cycles).
+   */
+  public boolean add(int deltaTime, byte[] message, int messageOffset, int length) {
+    if ((length < 1) || (messageOffset < 0) || (messageOffset + length > message.length)) {
+      throw new IllegalArgumentException("Invalid event length " + length);
+    }
+    int offset = reserve(deltaTime, length);
+    if (offset < 0) {
+      return false;
+    }
+    for (int i = 0; i < length; i++) {
+      bytes.put(offset + i, message[messageOffset + i]);
+    }
+    return true;
+  }
+
+  /**
+   * @return the number of events that were added in this output cycle,
+   * including those that did not fit.
+   */
+  public int getRequestCount() {
+    return requestCount;
+  }
+
+  /**
+   * @return the number of events in this cycle.
+   */
+  public int size() {
+    return eventCount;
+  }
+
+  /**
+   * @return the maximum number of events the buffer can hold.
+   */
+  public int getCapacity() {
+    return index.capacity() / entrySize;
+  }
+
+  /**
+   * @return the maximum number of Midi bytes the buffer can hold.
+   */
+  public int getByteCapacity() {
+    return bytes.capacity();
+  }
+
+  /**
+   * @param i the index of the event (0 to size()-1).
+   * @return the time of the event relative to the start of the cycle.
+   */
+  public int getDeltaTime(int i) {
+    return index.getInt(entry(i) + deltaTimeOffset);
+  }
+
+  /**
+   * @param i the index of the event (0 to size()-1).
+   * @return the number of Midi bytes of the event.
+   */
+  public int getLength(int i) {
+    return index.getInt(entry(i) + lengthOffset);
+  }
+
+  /**
+   * @param i the index of the event (0 to size()-1).
+   * @return the status byte (0 to 255).
+   */
+  public int getStatus(int i) {
+    return getByte(i, 0);
+  }
+
+  /**
+   * @param i the index of the event (0 to size()-1).
+   * @return the first data byte (0 if the event has no data bytes).
+   */
+  public int getData1(int i) {
+    return (getLength(i) > 1) ? getByte(i, 1) : 0;
+  }
+
+  /**
+   * @param i the index of the event (0 to size()-1).
+   * @return the second data byte (0 if the event has less than two data
+   * bytes).
+   */
+  public int getData2(int i) {
+    return (getLength(i) > 2) ? getByte(i, 2) : 0;
+  }
+
+  /**
+   * @param i the index of the event (0 to size()-1).
+   * @param position the position of the byte within the event (0 to
+   * getLength(i)-1).
+   * @return the Midi byte (0 to 255).
+   */
+  public int getByte(int i, int position) {
+    if ((position < 0) || (position >= getLength(i))) {
+      throw new IndexOutOfBoundsException("Byte position " + position);
+    }
+    return bytes.get(index.getInt(entry(i) + byteOffsetOffset) + position) & 0xFF;
+  }
+
+  /**
+   * Copies the Midi bytes of an event into an array.
+   *
+   * @param i the index of the event (0 to size()-1).
+   * @param target the array to be filled.
+   * @param targetOffset where the first Midi byte shall be stored.
+   * @return the number of bytes copied (the length of the event).
+   */
+  public int getMessage(int i, byte[] target, int targetOffset) {
+    int length = getLength(i);
+    int offset = index.getInt(entry(i) + byteOffsetOffset);
+    for (int k = 0; k < length; k++) {
+      target[targetOffset + k] = bytes.get(offset + k);
+    }
+    return length;
+  }
+
+  /**
+   * Returns the cursor of this buffer, positioned before the first event. The
+   * same cursor object is returned on every call, so iterating the events
+   * does not allocate anything:
+   * <pre>
+   *   MidiEventBuffer.Cursor event = events.cursor();
+   *   while (event.next()) {
+   *     if (event.getStatus() == ShortMessage.NOTE_ON) ...
+   *   }
+   * </pre>
+   *
+   * @return the cursor, rewound.
+   */
+  public Cursor cursor() {
+    cursor.position = -1;
+    return cursor;
+  }
+
+  /**
+   * A movable view onto one event of the buffer (a flyweight): the getters
+   * read the event the cursor currently stands on, straight from the buffer.
+   * Like the buffer, the cursor is only valid during the call-back.
+   */
+  public final class Cursor {
+
+    private int position = -1;
+
+    private Cursor() {
+    }
+
+    /**
+     * Moves the cursor to the next event.
+     *
+     * @return false if there are no more events.
+     */
+    public boolean next() {
+      if (position + 1 >= eventCount) {
+        position = eventCount;
+        return false;
+      }
+      position++;
+      return true;
+    }
+
+    /**
+     * @return the index of the current event in the buffer.
+     */
+    public int getIndex() {
+      return position;
+    }
+
+    /**
+     * @return the time of the event relative to the start of the cycle.
+     */
+    public int getDeltaTime() {
+      return MidiEventBuffer.this.getDeltaTime(position);
+    }
+
+    /**
+     * @return the number of Midi bytes of the event.
+     */
+    public int getLength() {
+      return MidiEventBuffer.this.getLength(position);
+    }
+
+    /**
+     * @return the status byte (0 to 255).
+     */
+    public int getStatus() {
+      return MidiEventBuffer.this.getStatus(position);
+    }
+
+    /**
+     * @return the first data byte (0 if the event has no data bytes).
+     */
+    public int getData1() {
+      return MidiEventBuffer.this.getData1(position);
+    }
+
+    /**
+     * @return the second data byte (0 if the event has less than two data
+     * bytes).
+     */
+    public int getData2() {
+      return MidiEventBuffer.this.getData2(position);
+    }
+
+    /**
+     * @param bytePosition the position of the byte within the event.
+     * @return the Midi byte (0 to 255).
+     */
+    public int getByte(int bytePosition) {
+      return MidiEventBuffer.this.getByte(position, bytePosition);
+    }
+
+    /**
+     * Copies the Midi bytes of the event into an array.
+     *
+     * @param target the array to be filled.
+     * @param targetOffset where the first Midi byte shall be stored.
+     * @return the number of bytes copied (the length of the event).
+     */
+    public int getMessage(byte[] target, int targetOffset) {
+      return MidiEventBuffer.this.getMessage(position, target, targetOffset);
+    }
+  }
+
+  private int entry(int i) {
+    if ((i < 0) || (i >= eventCount)) {
+      throw new IndexOutOfBoundsException("Event index " + i + " of " + eventCount);
+    }
+    return i * entrySize;
+  }
+
+  /**
+   * Appends an index entry and reserves the space for its Midi bytes.
+   *
+   * @return the offset of the first Midi byte, -1 if the buffer is full.
+   */
+  private int reserve(int deltaTime, int length) {
+    requestCount++;
+    if ((eventCount >= getCapacity()) || (length > bytes.capacity() - byteCount)) {
+      return -1;
+    }
+    int offset = byteCount;
+    int entry = eventCount * entrySize;
+    index.putInt(entry + deltaTimeOffset, deltaTime);
+    index.putInt(entry + byteOffsetOffset, offset);
+    index.putInt(entry + lengthOffset, length);
+    eventCount++;
+    byteCount += length;
+    return offset;
+  }
+}
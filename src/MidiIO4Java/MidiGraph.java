@@ -0,0 +1,167 @@
+/*
+ * Copyright 2012 Harald Postner.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package MidiIO4Java;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.List;
+
+/**
+ * A snapshot of the MIDI connection graph of the server, together with the
+ * changes since the previous snapshot (see MidiGraphListener). Ports are named
+ * as the server names them ("client:port"). Snapshots are immutable.
+ *
+ * @author Harald Postner
+ */
+public final class MidiGraph {
+
+  /**
+   * A connection from an output port to an input port.
+   */
+  public static final class Connection {
+
+    private final String source;
+    private final String destination;
+
+    public Connection(String source, String destination) {
+      if ((source == null) || (destination == null)) {
+        throw new NullPointerException();
+      }
+      this.source = source;
+      this.destination = destination;
+    }
+
+    /**
+     * @return the name of the output port.
+     */
+    public String getSource() {
+      return source;
+    }
+
+    /**
+     * @return the name of the input port.
+     */
+    public String getDestination() {
+      return destination;
+    }
+
+    @Override
+    public boolean equals(Object obj) {
+      if (!(obj instanceof Connection)) {
+        return false;
+      }
+      Connection other = (Connection) obj;
+      return source.equals(other.source) && destination.equals(other.destination);
+    }
+
+    @Override
+    public int hashCode() {
+      return 31 * source.hashCode() + destination.hashCode();
+    }
+
+    @Override
+    public String toString() {
+      return source + " -> " + destination;
+    }
+  }
+  private final long version;
+  private final List<String> ports;
+  private final List<Connection> connections;
+  private final List<String> addedPorts;
+  private final List<String> removedPorts;
+  private final List<Connection> addedConnections;
+  private final List<Connection> removedConnections;
+
+  /**
+   * Called by the native library (see "JackSystemListener.hpp"). The
+   * connections are given as flat arrays: source, destination, source...
+   */
+  MidiGraph(long version, String[] ports, String[] connections,
+          String[] addedPorts, String[] removedPorts,
+          String[] addedConnections, String[] removedConnections) {
+    this.version = version;
+    this.ports = toList(ports);
+    this.connections = toConnections(connections);
+    this.addedPorts = toList(addedPorts);
+    this.removedPorts = toList(removedPorts);
+    this.addedConnections = toConnections(addedConnections);
+    this.removedConnections = toConnections(removedConnections);
+  }
+
+  private static List<String> toList(String[] names) {
+    return Collections.unmodifiableList(Arrays.asList(names));
+  }
+
+  private static List<Connection> toConnections(String[] names) {
+    ArrayList<Connection> result = new ArrayList<Connection>(names.length / 2);
+    for (int i = 0; i + 1 < names.length; i += 2) {
+      result.add(new Connection(names[i], names[i + 1]));
+    }
+    return Collections.unmodifiableList(result);
+  }
+
+  /**
+   * @return the number of this snapshot, counting up from one within a
+   * session.
+   */
+  public long getVersion() {
+    return version;
+  }
+
+  /**
+   * @return the names of all MIDI ports of the server, sorted.
+   */
+  public List<String> getPorts() {
+    return ports;
+  }
+
+  /**
+   * @return all connections between MIDI ports, sorted by source and
+   * destination.
+   */
+  public List<Connection> getConnections() {
+    return connections;
+  }
+
+  /**
+   * @return the ports registered since the previous snapshot.
+   */
+  public List<String> getAddedPorts() {
+    return addedPorts;
+  }
+
+  /**
+   * @return the ports unregistered since the previous snapshot.
+   */
+  public List<String> getRemovedPorts() {
+    return removedPorts;
+  }
+
+  /**
+   * @return the connections made since the previous snapshot.
+   */
+  public List<Connection> getAddedConnections() {
+    return addedConnections;
+  }
+
+  /**
+   * @return the connections removed since the previous snapshot.
+   */
+  public List<Connection> getRemovedConnections() {
+    return removedConnections;
+  }
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2012 Harald Postner.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package MidiIO4Java;
+
+/**
+ * A system listener that wants to know how the MIDI connection graph has
+ * changed, not only that it has changed.
+ *
+ * When the graph notification is debounced (see
+ * MidiJackNative.setGraphDebounce) a listener implementing this interface
+ * receives "onGraphChanged" instead of "onConnectionChanged": once per
+ * debounce window, with a complete snapshot of the graph and the delta to the
+ * previous snapshot. So a burst of connection changes does not have to be
+ * answered by a burst of port list queries.
+ *
+ * @author Harald Postner
+ */
+public interface MidiGraphListener extends MidiSystemListener {
+
+  /**
+   * The "onGraphChanged" event happens after ports have been registered,
+   * unregistered, connected or disconnected. The calling thread is the
+   * notifier thread of the midi system (neither the java-process-thread nor a
+   * thread of the application). Exceptions thrown by this handler are logged
+   * and otherwise ignored.
+   *
+   * @param graph the new snapshot of the graph with the changes since the
+   * previous one.
+   * @throws Throwable an implementation may throw any kind of exception.
+   */
+  public void onGraphChanged(MidiGraph graph) throws Throwable;
+  // Signature: (LMidiIO4Java/MidiGraph;)V
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2012 Harald Postner <Harald at free_creations.de>.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package MidiIO4Java.Implementation;
+
+import javax.sound.midi.MetaMessage;
+import javax.sound.midi.MidiEvent;
+import javax.sound.midi.Sequence;
+import javax.sound.midi.Track;
+import static org.junit.Assert.*;
+import org.junit.Test;
+
+/**
+ *
+ * @author Harald Postner <Harald at free_creations.de>
+ */
+public class TempoMapTest {
+
+  private static final long frameRate = 48000;
+
+  public TempoMapTest() {
+  }
+
+  /**
+   * Without tempo changes a quarter lasts half a second.
+   */
+  @Test
+  public void testDefaultTempo() throws Exception {
+    Sequence sequence = new Sequence(Sequence.PPQ, 480);
+    sequence.createTrack();
+    TempoMap tempoMap = new TempoMap(sequence, frameRate);
+    assertEquals(0, tempoMap.toTimeCode(0));
+    assertEquals(24000, tempoMap.toTimeCode(480));
+    assertEquals(480, tempoMap.toTick(24000));
+  }
+
+  /**
+   * A tempo change applies from its tick on, in whatever track it is.
+   */
+  @Test
+  public void testTempoChange() throws Exception {
+    Sequence sequence = new Sequence(Sequence.PPQ, 480);
+    sequence.createTrack();
+    Track track = sequence.createTrack();
+    // one second per quarter (0x0F4240 microseconds) from the third quarter on.
+    track.add(new MidiEvent(new MetaMessage(TempoMap.tempoType, new byte[]{0x0F, 0x42, 0x40}, 3), 960));
+    TempoMap tempoMap = new TempoMap(sequence, frameRate);
+    assertEquals(48000, tempoMap.toTimeCode(960));
+    assertEquals(96000, tempoMap.toTimeCode(1440));
+    assertEquals(960, tempoMap.toTick(48000));
+    assertEquals(1440, tempoMap.toTick(96000));
+  }
+
+  /**
+   * SMPTE ticks have a fixed length.
+   */
+  @Test
+  public void testSmpte() throws Exception {
+    // 25 frames per second, 40 ticks per frame: one millisecond per tick.
+    Sequence sequence = new Sequence(Sequence.SMPTE_25, 40);
+    Track track = sequence.createTrack();
+    track.add(new MidiEvent(new MetaMessage(TempoMap.tempoType, new byte[]{0x0F, 0x42, 0x40}, 3), 0));
+    TempoMap tempoMap = new TempoMap(sequence, frameRate);
+    assertEquals(48000, tempoMap.toTimeCode(1000));
+    assertEquals(1000, tempoMap.toTick(48000));
+  }
+}